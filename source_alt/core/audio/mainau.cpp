@@ -28,6 +28,9 @@ extern "C" {
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstdio> // For mkstemp, unlink
+#include "core/remote/transport_trace.h"
+#include "core/trace/perf_trace.h"
+#include "core/trace/metrics.h"
 
 // Use int16_t for audio buffer to save memory
 // std::vector<int16_t> audio_buffer;
@@ -67,6 +70,26 @@ std::atomic<int> current_audio_device_index(0);
 std::atomic<int> selected_audio_device_index(-1); // Index of user-selected audio card
 std::mutex audio_device_mutex;
 PaStream* stream = nullptr;
+// A file switch stops the stream without closing it (release_audio_source); the
+// next start_audio restarts it when the rate and device still match
+static bool portaudio_initialized = false;
+static int stream_sample_rate = 0;
+static int stream_device = paNoDevice;
+
+// Null audio sink (headless mode): drives the stream callback from a thread in
+// real time instead of a device, so the audio clock and transport keep working
+extern std::atomic<bool> headless_mode;
+std::thread null_sink_thread;
+std::atomic<bool> null_sink_running(false);
+
+// The stream callback runs on a real-time thread and must not allocate its
+// trace ring; it records into one made when a stream starts
+static std::atomic<PerfTrace::Ring*> audio_trace_ring{nullptr};
+
+static void prepare_audio_trace_ring() {
+    static PerfTrace::Ring* ring = PerfTrace::prepareRing("audio");
+    audio_trace_ring.store(ring, std::memory_order_release);
+}
 
 // Map to store the actual device indices for each menu item index
 std::map<int, int> menu_to_device_index;
@@ -282,10 +305,15 @@ static int patestCallback(const void *inputBuffer, void *outputBuffer,
                           const PaStreamCallbackTimeInfo* timeInfo,
                           PaStreamCallbackFlags statusFlags,
                           void *userData) {
+    PERF_SPAN_RING(audio_trace_ring.load(std::memory_order_acquire), "audio.callback");
+    ScopedLatency callbackLatency(playerMetrics.audioCallback);
+    playerMetrics.audioCallbacks.fetch_add(1, std::memory_order_relaxed);
+    if (statusFlags & (paOutputUnderflow | paOutputOverflow)) {
+        playerMetrics.audioXruns.fetch_add(1, std::memory_order_relaxed);
+    }
     float *out = (float*)outputBuffer;
     (void) inputBuffer; 
     (void) timeInfo;
-    (void) statusFlags;
     (void) userData;
 
     static double beep_phase = 0.0;
@@ -807,6 +835,26 @@ void decode_audio(const char* filename) {
     std::cout << "decode_audio finished execution." << std::endl;
 }
 
+static void null_sink_loop(int rate) {
+    const unsigned long framesPerBuffer = 256; // Same as the PortAudio stream
+    std::vector<float> scratch(framesPerBuffer * 2);
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(framesPerBuffer) / rate));
+    auto next = std::chrono::steady_clock::now();
+    while (null_sink_running.load()) {
+        patestCallback(nullptr, scratch.data(), framesPerBuffer, nullptr, 0, nullptr);
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+static void stop_null_sink() {
+    null_sink_running.store(false);
+    if (null_sink_thread.joinable()) {
+        null_sink_thread.join();
+    }
+}
+
 void start_audio(const char* filename) {
     // --- No need to clear vector --- 
     // audio_buffer.clear();
@@ -818,49 +866,57 @@ void start_audio(const char* filename) {
     try {
         std::cout << "Starting audio initialization..." << std::endl;
 
+        const bool useNullSink = headless_mode.load();
         PaError err;
-        err = Pa_Initialize();
-        if (err != paNoError) {
-            throw std::runtime_error("PortAudio error: " + std::string(Pa_GetErrorText(err)));
-        }
-
         PaStreamParameters outputParameters;
 
-        // Use selected device if set, otherwise use default
-        int deviceIndex;
-        if (selected_audio_device_index.load() >= 0) {
-            deviceIndex = selected_audio_device_index.load();
-            std::cout << "Using previously selected audio device (index " << deviceIndex << ")" << std::endl;
+        if (useNullSink) {
+            std::cout << "Headless mode: using the null audio sink" << std::endl;
         } else {
-            deviceIndex = Pa_GetDefaultOutputDevice();
-            std::cout << "Using default audio device (index " << deviceIndex << ")" << std::endl;
-        }
-        
-        if (deviceIndex == paNoDevice) {
-            throw std::runtime_error("No default output device.");
-        }
+            if (!portaudio_initialized) {
+                err = Pa_Initialize();
+                if (err != paNoError) {
+                    throw std::runtime_error("PortAudio error: " + std::string(Pa_GetErrorText(err)));
+                }
+                portaudio_initialized = true;
+            }
+
+            // Use selected device if set, otherwise use default
+            int deviceIndex;
+            if (selected_audio_device_index.load() >= 0) {
+                deviceIndex = selected_audio_device_index.load();
+                std::cout << "Using previously selected audio device (index " << deviceIndex << ")" << std::endl;
+            } else {
+                deviceIndex = Pa_GetDefaultOutputDevice();
+                std::cout << "Using default audio device (index " << deviceIndex << ")" << std::endl;
+            }
         
-        // Check if device supports output
-        const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(deviceIndex);
-        if (!deviceInfo || deviceInfo->maxOutputChannels <= 0) {
-            std::cerr << "Selected device does not support output, falling back to default" << std::endl;
-            deviceIndex = Pa_GetDefaultOutputDevice();
             if (deviceIndex == paNoDevice) {
                 throw std::runtime_error("No default output device.");
             }
-        }
         
-        // Store the current device index
-        current_audio_device_index.store(deviceIndex);
+            // Check if device supports output
+            const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(deviceIndex);
+            if (!deviceInfo || deviceInfo->maxOutputChannels <= 0) {
+                std::cerr << "Selected device does not support output, falling back to default" << std::endl;
+                deviceIndex = Pa_GetDefaultOutputDevice();
+                if (deviceIndex == paNoDevice) {
+                    throw std::runtime_error("No default output device.");
+                }
+            }
+        
+            // Store the current device index
+            current_audio_device_index.store(deviceIndex);
         
-        // Make sure the menu_to_device_index map is initialized
-        get_audio_output_devices();
+            // Make sure the menu_to_device_index map is initialized
+            get_audio_output_devices();
         
-        outputParameters.device = deviceIndex;
-        outputParameters.channelCount = 2;
-        outputParameters.sampleFormat = paFloat32;
-        outputParameters.suggestedLatency = Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
-        outputParameters.hostApiSpecificStreamInfo = NULL;
+            outputParameters.device = deviceIndex;
+            outputParameters.channelCount = 2;
+            outputParameters.sampleFormat = paFloat32;
+            outputParameters.suggestedLatency = Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
+            outputParameters.hostApiSpecificStreamInfo = NULL;
+        }
 
         // --- Start decoding audio in a separate thread --- 
         // Decoder thread now CREATES the mmap file
@@ -916,13 +972,6 @@ void start_audio(const char* filename) {
         // Give the decoding thread a moment to start writing data
         // std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Maybe not needed?
 
-        // Close any existing stream
-        if (stream) {
-            Pa_StopStream(stream);
-            Pa_CloseStream(stream);
-            stream = nullptr;
-        }
-
         // Get the sample rate determined during decoding
         int pa_sample_rate = sample_rate.load(); 
         if(pa_sample_rate <= 0) {
@@ -930,33 +979,57 @@ void start_audio(const char* filename) {
              pa_sample_rate = 44100;
         }
 
-        err = Pa_OpenStream(
-            &stream,
-            NULL, 
-            &outputParameters,
-            pa_sample_rate, 
-            256, // framesPerBuffer - keep relatively small for low latency
-            paClipOff,
-            patestCallback,
-            NULL); 
-
-        if (err != paNoError) {
-            // Cleanup mmap before throwing
-            if (audio_read_ptr) { munmap((void*)audio_read_ptr, expected_bytes); audio_read_ptr = nullptr; }
-            if (audio_read_fd != -1) { close(audio_read_fd); audio_read_fd = -1; }
-            throw std::runtime_error("PortAudio error opening stream: " + std::string(Pa_GetErrorText(err)));
+        // Keep a stream stopped by release_audio_source if it fits the new source, close any other
+        const bool reuseStream = !useNullSink && stream && stream_sample_rate == pa_sample_rate &&
+                                 stream_device == outputParameters.device;
+        if (stream && !reuseStream) {
+            Pa_StopStream(stream);
+            Pa_CloseStream(stream);
+            stream = nullptr;
         }
+        stop_null_sink();
 
-        err = Pa_StartStream(stream);
-        if (err != paNoError) {
-             // Cleanup mmap before throwing
-            Pa_CloseStream(stream); stream = nullptr;
-            if (audio_read_ptr) { munmap((void*)audio_read_ptr, expected_bytes); audio_read_ptr = nullptr; }
-            if (audio_read_fd != -1) { close(audio_read_fd); audio_read_fd = -1; }
-            throw std::runtime_error("PortAudio error starting stream: " + std::string(Pa_GetErrorText(err)));
-        }
+        prepare_audio_trace_ring();
+        if (useNullSink) {
+            null_sink_running.store(true);
+            null_sink_thread = std::thread(null_sink_loop, pa_sample_rate);
+        } else {
+            if (!reuseStream) {
+                err = Pa_OpenStream(
+                    &stream,
+                    NULL, 
+                    &outputParameters,
+                    pa_sample_rate, 
+                    256, // framesPerBuffer - keep relatively small for low latency
+                    paClipOff,
+                    patestCallback,
+                    NULL); 
+
+                if (err != paNoError) {
+                    // Cleanup mmap before throwing
+                    if (audio_read_ptr) { munmap((void*)audio_read_ptr, expected_bytes); audio_read_ptr = nullptr; }
+                    if (audio_read_fd != -1) { close(audio_read_fd); audio_read_fd = -1; }
+                    throw std::runtime_error("PortAudio error opening stream: " + std::string(Pa_GetErrorText(err)));
+                }
+                stream_sample_rate = pa_sample_rate;
+                stream_device = outputParameters.device;
+            }
+
+            err = Pa_StartStream(stream);
+            if (err != paNoError) {
+                 // Cleanup mmap before throwing
+                Pa_CloseStream(stream); stream = nullptr;
+                if (audio_read_ptr) { munmap((void*)audio_read_ptr, expected_bytes); audio_read_ptr = nullptr; }
+                if (audio_read_fd != -1) { close(audio_read_fd); audio_read_fd = -1; }
+                throw std::runtime_error("PortAudio error starting stream: " + std::string(Pa_GetErrorText(err)));
+            }
 
-        std::cout << "Audio device opened successfully, PortAudio stream started." << std::endl;
+            if (reuseStream) {
+                std::cout << "PortAudio stream restarted for the new file." << std::endl;
+            } else {
+                std::cout << "Audio device opened successfully, PortAudio stream started." << std::endl;
+            }
+        }
 
         audio_buffer_index = 0.0; // Reset playback position
         current_audio_time.store(0.0);
@@ -1121,6 +1194,10 @@ void stop_jog() {
 }
 
 void seek_to_time(double target_time) {
+    PERF_SPAN("seek");
+    transportTrace.recordSeek(target_time);
+    playerMetrics.markSeek();
+
     // Ensure mmap is ready before seeking
     if (audio_read_ptr == nullptr || audio_total_samples == 0) {
         std::cerr << "Warning: Attempted to seek before audio mmap is ready." << std::endl;
@@ -1365,6 +1442,7 @@ bool switch_audio_device(int menuIndex) {
     outputParameters.hostApiSpecificStreamInfo = NULL;
     
     // Open and start the new stream
+    prepare_audio_trace_ring();
     PaError err = Pa_OpenStream(
         &stream,
         NULL, 
@@ -1379,6 +1457,8 @@ bool switch_audio_device(int menuIndex) {
         std::cerr << "Failed to open new audio device: " << Pa_GetErrorText(err) << std::endl;
         return false;
     }
+    stream_sample_rate = sample_rate.load();
+    stream_device = deviceIndex;
     
     err = Pa_StartStream(stream);
     if (err != paNoError) {
@@ -1402,6 +1482,75 @@ bool switch_audio_device(int menuIndex) {
     return true;
 }
 
+// Unmaps and deletes the decoded audio of the current file
+static void release_audio_mmap() {
+    // --- Cleanup mmap resources --- 
+    std::lock_guard<std::mutex> lock(mmap_init_mutex); // Protect concurrent access
+
+    // Unmap read region if mapped
+    if (audio_read_ptr) {
+        if (munmap((void*)audio_read_ptr, audio_total_bytes) == -1) {
+             std::cerr << "Error unmapping read region: " << strerror(errno) << std::endl;
+        }
+        audio_read_ptr = nullptr;
+    }
+    // Unmap write region if mapped (should normally be done by decoder thread, but cleanup just in case)
+    if (audio_write_ptr) {
+        // Note: might already be unmapped by decoder thread
+        munmap(audio_write_ptr, audio_total_bytes); // Ignore error here, might already be gone
+        audio_write_ptr = nullptr;
+    }
+
+    // Close file descriptors
+    if (audio_read_fd != -1) {
+        if (close(audio_read_fd) == -1) {
+             std::cerr << "Error closing read fd: " << strerror(errno) << std::endl;
+        }
+        audio_read_fd = -1;
+    }
+    if (audio_write_fd != -1) {
+        if (close(audio_write_fd) == -1) {
+            // Might already be closed by decoder thread
+        }
+        audio_write_fd = -1;
+    }
+
+    // Delete the temporary file
+    if (!audio_temp_filename.empty()) {
+        if (unlink(audio_temp_filename.c_str()) == -1) {
+             std::cerr << "Error deleting temporary audio file: " << strerror(errno) << std::endl;
+        }
+         std::cout << "Deleted temporary audio file: " << audio_temp_filename << std::endl;
+        audio_temp_filename.clear();
+    }
+
+    // Reset size/count variables
+    audio_total_bytes = 0;
+    audio_total_samples = 0;
+    audio_decoded_samples_count.store(0);
+    audio_buffer_index = 0.0; // Reset playback position
+    // --- End mmap cleanup --- 
+}
+
+// Switching files: the device stream is stopped but stays open, and PortAudio
+// stays initialized; start_audio restarts the stream for the next file
+void release_audio_source() {
+    std::lock_guard<std::mutex> lock(audio_device_mutex);
+
+    volume.store(0.0f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (stream) {
+        PaError err = Pa_StopStream(stream); // Returns once the callback is done with the mapping
+        if (err != paNoError && err != paStreamIsStopped) {
+            std::cerr << "Error stopping stream: " << Pa_GetErrorText(err) << std::endl;
+        }
+    }
+    stop_null_sink();
+    release_audio_mmap();
+    std::cout << "Audio source released, output kept open" << std::endl;
+}
+
 void cleanup_audio() {
     std::lock_guard<std::mutex> lock(audio_device_mutex);
     
@@ -1413,7 +1562,7 @@ void cleanup_audio() {
     try {
         if (stream) {
             PaError err = Pa_StopStream(stream);
-            if (err != paNoError) {
+            if (err != paNoError && err != paStreamIsStopped) { // Already stopped after a file switch
                 std::cerr << "Error stopping stream: " << Pa_GetErrorText(err) << std::endl;
             }
             
@@ -1423,57 +1572,18 @@ void cleanup_audio() {
             }
             stream = nullptr;
         }
+        stop_null_sink();
         
-        // --- Cleanup mmap resources --- 
-        std::lock_guard<std::mutex> lock(mmap_init_mutex); // Protect concurrent access
-
-        // Unmap read region if mapped
-        if (audio_read_ptr) {
-            if (munmap((void*)audio_read_ptr, audio_total_bytes) == -1) {
-                 std::cerr << "Error unmapping read region: " << strerror(errno) << std::endl;
-            }
-            audio_read_ptr = nullptr;
-        }
-        // Unmap write region if mapped (should normally be done by decoder thread, but cleanup just in case)
-        if (audio_write_ptr) {
-            // Note: might already be unmapped by decoder thread
-            munmap(audio_write_ptr, audio_total_bytes); // Ignore error here, might already be gone
-            audio_write_ptr = nullptr;
-        }
-
-        // Close file descriptors
-        if (audio_read_fd != -1) {
-            if (close(audio_read_fd) == -1) {
-                 std::cerr << "Error closing read fd: " << strerror(errno) << std::endl;
-            }
-            audio_read_fd = -1;
-        }
-        if (audio_write_fd != -1) {
-            if (close(audio_write_fd) == -1) {
-                // Might already be closed by decoder thread
-            }
-            audio_write_fd = -1;
-        }
-
-        // Delete the temporary file
-        if (!audio_temp_filename.empty()) {
-            if (unlink(audio_temp_filename.c_str()) == -1) {
-                 std::cerr << "Error deleting temporary audio file: " << strerror(errno) << std::endl;
-            }
-             std::cout << "Deleted temporary audio file: " << audio_temp_filename << std::endl;
-            audio_temp_filename.clear();
-        }
-
-        // Reset size/count variables
-        audio_total_bytes = 0;
-        audio_total_samples = 0;
-        audio_decoded_samples_count.store(0);
-        audio_buffer_index = 0.0; // Reset playback position
-        // --- End mmap cleanup --- 
+        release_audio_mmap();
         
-        PaError err = Pa_Terminate();
-        if (err != paNoError) {
-            std::cerr << "Error terminating PortAudio: " << Pa_GetErrorText(err) << std::endl;
+        stream_sample_rate = 0;
+        stream_device = paNoDevice;
+        if (portaudio_initialized) {
+            PaError err = Pa_Terminate();
+            if (err != paNoError) {
+                std::cerr << "Error terminating PortAudio: " << Pa_GetErrorText(err) << std::endl;
+            }
+            portaudio_initialized = false;
         }
         
         std::cout << "Audio system cleaned up successfully" << std::endl;
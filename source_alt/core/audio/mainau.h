@@ -18,6 +18,7 @@ extern void start_jog_backward();
 extern void stop_jog();
 extern void start_audio(const char* filename);
 extern void cleanup_audio();
+extern void release_audio_source(); // File switch: frees the source, keeps the output open
 extern void seek_to_time(double target_time);
 extern void increase_volume();
 extern void decrease_volume();
@@ -0,0 +1,404 @@
+#include "cache_manager.h"
+#include "low_res_decoder.h"
+#include "../log/logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#if defined(__APPLE__)
+#include <sys/resource.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+CacheManager cacheManager;
+
+namespace {
+
+constexpr const char* kDatabaseHeader = "# tapexplayer cache v1";
+constexpr const char* kDownloadDir = "temp_downloads/";
+
+int64_t nowSeconds() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string formatBytes(uint64_t bytes) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    if (bytes >= (1ull << 30)) out << bytes / double(1ull << 30) << " GB";
+    else out << bytes / double(1ull << 20) << " MB";
+    return out.str();
+}
+
+// Maintenance must not compete with the decoders for the disk
+void lowerIoPriority() {
+#if defined(__APPLE__)
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, IOPOL_THROTTLE);
+#elif defined(__linux__)
+    constexpr int kWhoProcess = 1;    // IOPRIO_WHO_PROCESS; id 0 is the calling thread
+    constexpr int kClassIdle = 3;     // IOPRIO_CLASS_IDLE
+    syscall(SYS_ioprio_set, kWhoProcess, 0, kClassIdle << 13);
+#endif
+}
+
+} // namespace
+
+const char* CacheManager::kindName(Kind kind) {
+    switch (kind) {
+        case Kind::Proxy: return "proxy";
+        case Kind::ProxyLevel: return "proxy_level";
+        case Kind::Thumbnails: return "thumbnails";
+        case Kind::Download: return "download";
+        case Kind::Other: break;
+    }
+    return "other";
+}
+
+CacheManager::Kind CacheManager::classify(const std::string& name) {
+    if (name.compare(0, std::strlen(kDownloadDir), kDownloadDir) == 0) return Kind::Download;
+    if (endsWith(name, ".txs")) return Kind::Thumbnails;
+    if (name.find("_lowres") != std::string::npos && endsWith(name, ".mp4")) {
+        // Pyramid levels are <base>_d<divisor>.mp4 (ProxyPyramid::levelFilename)
+        size_t d = name.rfind("_d");
+        bool level = d != std::string::npos && d + 2 < name.size() - 4 &&
+                     std::all_of(name.begin() + d + 2, name.end() - 4, [](char c) { return c >= '0' && c <= '9'; });
+        return level ? Kind::ProxyLevel : Kind::Proxy;
+    }
+    return Kind::Other;
+}
+
+std::string CacheManager::fingerprintOf(const std::string& name) {
+    std::string base = name.substr(name.rfind('/') + 1);
+    return base.substr(0, base.find_first_of("_."));
+}
+
+CacheManager::~CacheManager() {
+    stop();
+}
+
+void CacheManager::setLimits(const Limits& limits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+}
+
+void CacheManager::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) return;
+    stopping_ = false;
+    thread_ = std::thread(&CacheManager::run, this);
+}
+
+void CacheManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) return;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loaded_) save(); // Access times since the last pass
+}
+
+void CacheManager::touch(const std::string& artifactPath, const std::string& sourcePath) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ensureLoaded()) return;
+        std::string name = relativeName(artifactPath);
+        if (name.empty()) return;
+        std::string fingerprint = fingerprintOf(name);
+        int64_t now = nowSeconds();
+        bool known = false;
+        for (Artifact& a : artifacts_) {
+            if (a.fingerprint != fingerprint) continue;
+            a.lastAccess = now;
+            a.source = sourcePath;
+            known = known || a.name == name;
+        }
+        if (known) return;
+        struct stat st;
+        if (stat(artifactPath.c_str(), &st) != 0) return;
+        Artifact artifact;
+        artifact.name = name;
+        artifact.kind = classify(name);
+        artifact.size = static_cast<uint64_t>(st.st_size);
+        artifact.lastAccess = now;
+        artifact.fingerprint = fingerprint;
+        artifact.source = sourcePath;
+        artifacts_.push_back(artifact);
+        passRequested_ = true; // The directory grew; check the limits
+    }
+    cv_.notify_all();
+}
+
+void CacheManager::setInUse(const std::vector<std::string>& artifactPaths) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureLoaded()) return;
+    inUse_.clear();
+    for (const auto& path : artifactPaths) {
+        std::string name = relativeName(path);
+        if (!name.empty()) inUse_.insert(fingerprintOf(name));
+    }
+}
+
+std::vector<CacheManager::Artifact> CacheManager::snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensureLoaded()) return {};
+    reconcile();
+    return artifacts_;
+}
+
+std::vector<CacheManager::Artifact> CacheManager::maintain() {
+    std::vector<Artifact> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ensureLoaded()) return victims;
+        reconcile();
+
+        struct Group {
+            uint64_t bytes = 0;
+            int64_t lastAccess = 0;
+        };
+        std::map<std::string, Group> groups;
+        uint64_t total = 0;
+        for (const Artifact& a : artifacts_) {
+            total += a.size;
+            if (a.kind == Kind::Other || a.fingerprint.empty() || inUse_.count(a.fingerprint)) continue;
+            Group& g = groups[a.fingerprint];
+            g.bytes += a.size;
+            g.lastAccess = std::max(g.lastAccess, a.lastAccess);
+        }
+
+        // Expired sources first, then the least recently used until under the size limit
+        std::vector<std::pair<std::string, Group>> order(groups.begin(), groups.end());
+        std::sort(order.begin(), order.end(),
+                  [](const auto& a, const auto& b) { return a.second.lastAccess < b.second.lastAccess; });
+        std::set<std::string> evict;
+        int64_t expiry = nowSeconds() - limits_.maxAgeSeconds;
+        for (const auto& [fingerprint, group] : order) {
+            if (group.lastAccess >= expiry && total <= limits_.maxBytes) break;
+            evict.insert(fingerprint);
+            total -= group.bytes;
+        }
+        for (const Artifact& a : artifacts_) {
+            if (evict.count(a.fingerprint) && a.kind != Kind::Other) victims.push_back(a);
+        }
+    }
+    if (victims.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        save();
+        return victims;
+    }
+
+    std::vector<Artifact> removed;
+    for (const Artifact& a : victims) {
+        std::error_code ec;
+        fs::remove(dir_ + "/" + a.name, ec);
+        if (ec) {
+            TX_LOG_WARN("Cache", "Cannot remove " << a.name << ": " << ec.message());
+            continue;
+        }
+        TX_LOG_INFO("Cache", "Evicted " << a.name << " (" << formatBytes(a.size) << ")");
+        removed.push_back(a);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Artifact& r : removed) {
+        artifacts_.erase(std::remove_if(artifacts_.begin(), artifacts_.end(),
+                                        [&](const Artifact& a) { return a.name == r.name; }),
+                         artifacts_.end());
+    }
+    save();
+    return removed;
+}
+
+void CacheManager::run() {
+    lowerIoPriority();
+    std::unique_lock<std::mutex> lock(mutex_);
+    // The first pass waits out startup; artifacts added before then are covered by it
+    cv_.wait_for(lock, kStartDelay, [this] { return stopping_; });
+    while (!stopping_) {
+        passRequested_ = false;
+        lock.unlock();
+        maintain();
+        lock.lock();
+        cv_.wait_for(lock, kPassInterval, [this] { return stopping_ || passRequested_; });
+    }
+}
+
+bool CacheManager::ensureLoaded() {
+    if (loaded_) return true;
+    dir_ = LowResDecoder::getCachePath();
+    if (dir_.empty()) return false;
+    load();
+    reconcile(); // So a touch finds every artifact of its source
+    loaded_ = true;
+    return true;
+}
+
+void CacheManager::load() {
+    artifacts_.clear();
+    std::ifstream in(dir_ + "/" + kDatabaseName);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        // kind \t size \t last access \t fingerprint \t source \t name
+        std::vector<std::string> fields;
+        std::istringstream row(line);
+        for (std::string field; std::getline(row, field, '\t');) fields.push_back(field);
+        if (fields.size() != 6) continue;
+        Artifact a;
+        a.kind = classify(fields[5]); // The name decides; the stored kind is for readers of the file
+        a.size = std::strtoull(fields[1].c_str(), nullptr, 10);
+        a.lastAccess = std::strtoll(fields[2].c_str(), nullptr, 10);
+        a.fingerprint = fields[3];
+        a.source = fields[4] == "-" ? "" : fields[4];
+        a.name = fields[5];
+        artifacts_.push_back(a);
+    }
+}
+
+void CacheManager::reconcile() {
+    std::map<std::string, size_t> known;
+    for (size_t i = 0; i < artifacts_.size(); ++i) known[artifacts_[i].name] = i;
+
+    std::vector<bool> seen(artifacts_.size(), false);
+    std::vector<Artifact> added;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        std::string name = it->path().lexically_relative(dir_).string();
+        // The database and files still being written (.tmp) are not artifacts
+        if (name == kDatabaseName || endsWith(name, ".tmp")) continue;
+        struct stat st;
+        if (stat(it->path().c_str(), &st) != 0) continue;
+        auto found = known.find(name);
+        if (found != known.end()) {
+            artifacts_[found->second].size = static_cast<uint64_t>(st.st_size);
+            seen[found->second] = true;
+            continue;
+        }
+        Artifact a;
+        a.name = name;
+        a.kind = classify(name);
+        a.size = static_cast<uint64_t>(st.st_size);
+        a.lastAccess = static_cast<int64_t>(st.st_mtime); // Best guess for files the database never saw
+        a.fingerprint = fingerprintOf(name);
+        added.push_back(a);
+    }
+
+    std::vector<Artifact> current;
+    for (size_t i = 0; i < artifacts_.size(); ++i) {
+        if (seen[i]) current.push_back(std::move(artifacts_[i]));
+    }
+    current.insert(current.end(), added.begin(), added.end());
+    artifacts_.swap(current);
+}
+
+bool CacheManager::save() {
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    std::string path = dir_ + "/" + kDatabaseName;
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) {
+            TX_LOG_WARN("Cache", "Cannot write " << tmpPath);
+            return false;
+        }
+        out << kDatabaseHeader << "\n";
+        for (const Artifact& a : artifacts_) {
+            out << kindName(a.kind) << '\t' << a.size << '\t' << a.lastAccess << '\t' << a.fingerprint << '\t'
+                << (a.source.empty() ? "-" : a.source) << '\t' << a.name << '\n';
+        }
+        if (!out) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+std::string CacheManager::relativeName(const std::string& path) const {
+    std::error_code ec;
+    std::string absolute = fs::absolute(path, ec).lexically_normal().string();
+    if (ec || absolute.compare(0, dir_.size() + 1, dir_ + "/") != 0) return "";
+    return absolute.substr(dir_.size() + 1);
+}
+
+int CacheManager::runStats(const Limits& limits) {
+    CacheManager manager;
+    manager.setLimits(limits);
+    std::vector<Artifact> artifacts = manager.snapshot();
+    if (manager.dir_.empty()) {
+        std::cerr << "[Cache] Cannot determine the cache directory" << std::endl;
+        return 1;
+    }
+
+    struct Totals {
+        int files = 0;
+        uint64_t bytes = 0;
+    };
+    std::map<Kind, Totals> byKind;
+    std::set<std::string> sources;
+    uint64_t total = 0;
+    int64_t oldest = nowSeconds();
+    for (const Artifact& a : artifacts) {
+        byKind[a.kind].files++;
+        byKind[a.kind].bytes += a.size;
+        total += a.size;
+        if (a.kind != Kind::Other) {
+            sources.insert(a.fingerprint);
+            oldest = std::min(oldest, a.lastAccess);
+        }
+    }
+
+    std::cout << "Cache: " << manager.dir_ << std::endl;
+    for (const auto& [kind, totals] : byKind) {
+        std::cout << "  " << std::left << std::setw(12) << kindName(kind) << std::right << std::setw(6) << totals.files
+                  << " files  " << std::setw(10) << formatBytes(totals.bytes) << std::endl;
+    }
+    std::cout << "  Total " << artifacts.size() << " files from " << sources.size() << " sources, " << formatBytes(total)
+              << " (limit " << formatBytes(limits.maxBytes) << ")" << std::endl;
+    if (!sources.empty()) {
+        std::cout << "  Least recently used source: " << (nowSeconds() - oldest) / 86400 << " days ago (limit "
+                  << limits.maxAgeSeconds / 86400 << " days)" << std::endl;
+    }
+    return 0;
+}
+
+int CacheManager::runPrune(const Limits& limits) {
+    CacheManager manager;
+    manager.setLimits(limits);
+    std::vector<Artifact> removed = manager.maintain();
+    if (manager.dir_.empty()) {
+        std::cerr << "[Cache] Cannot determine the cache directory" << std::endl;
+        return 1;
+    }
+    uint64_t freed = 0;
+    for (const Artifact& a : removed) {
+        std::cout << "Removed " << a.name << " (" << kindName(a.kind) << ", " << formatBytes(a.size) << ")" << std::endl;
+        freed += a.size;
+    }
+    uint64_t remaining = 0;
+    for (const Artifact& a : manager.snapshot()) remaining += a.size;
+    std::cout << "Freed " << formatBytes(freed) << " in " << removed.size() << " files; " << formatBytes(remaining)
+              << " left in " << manager.dir_ << std::endl;
+    return 0;
+}
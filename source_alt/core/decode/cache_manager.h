@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps the cache directory (~/.cache/tapexplayer) within size and age limits.
+//
+// Every artifact in the directory has an entry in a small metadata database
+// (cache.db, tab-separated text): kind, size, last access, the fingerprint
+// of the source it was made from (the MD5 or URL id its name starts with)
+// and, once the player has opened it, the source path. Artifacts of one
+// source are used and evicted together: a proxy is useless without its
+// source's other files and vice versa. Sources are evicted least recently
+// used first once the directory is over its size limit, and regardless of
+// size once unused for longer than the age limit. Files of unknown kind are
+// listed but never removed, and the files the player has open are never
+// removed.
+//
+// In the player the maintenance runs on a background thread at idle I/O
+// priority: shortly after startup, when new artifacts appear and then
+// periodically. --cache-stats and --cache-prune run the same pass from the
+// command line.
+class CacheManager {
+public:
+    enum class Kind { Proxy, ProxyLevel, Thumbnails, Download, Other };
+
+    struct Artifact {
+        std::string name;        // Relative to the cache directory
+        Kind kind = Kind::Other;
+        uint64_t size = 0;
+        int64_t lastAccess = 0;  // Unix seconds
+        std::string fingerprint;
+        std::string source;      // Source path, empty until the player opens it
+    };
+
+    struct Limits {
+        uint64_t maxBytes = 20ull << 30;
+        int64_t maxAgeSeconds = 30 * 24 * 3600;
+    };
+
+    static constexpr const char* kDatabaseName = "cache.db";
+
+    static const char* kindName(Kind kind);
+    static Kind classify(const std::string& name);
+    static std::string fingerprintOf(const std::string& name);
+
+    ~CacheManager();
+
+    void setLimits(const Limits& limits);
+
+    void start();
+    // Stops the thread and saves the database
+    void stop();
+
+    // The artifacts of `artifactPath`'s source were just used. An artifact not
+    // in the database yet is added. Paths outside the cache directory are ignored.
+    void touch(const std::string& artifactPath, const std::string& sourcePath);
+    // Sources whose artifacts must not be evicted: the open file's
+    void setInUse(const std::vector<std::string>& artifactPaths);
+
+    // One maintenance pass: reconcile with the directory, apply the limits, save.
+    // Returns the artifacts that were removed.
+    std::vector<Artifact> maintain();
+    // Reconciles with the directory and returns the current artifacts
+    std::vector<Artifact> snapshot();
+
+    static int runStats(const Limits& limits);
+    static int runPrune(const Limits& limits);
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::seconds kStartDelay{10};
+    static constexpr std::chrono::minutes kPassInterval{30};
+
+    void run();
+    // Callers hold mutex_
+    bool ensureLoaded();
+    void load();
+    void reconcile();
+    bool save();
+    std::string relativeName(const std::string& path) const;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::string dir_;
+    bool loaded_ = false;
+    std::vector<Artifact> artifacts_;
+    std::set<std::string> inUse_;     // Fingerprints
+    Limits limits_;
+    bool passRequested_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+extern CacheManager cacheManager;
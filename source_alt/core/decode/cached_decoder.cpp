@@ -1,5 +1,8 @@
 #include "cached_decoder.h"
 #include "decode.h"
+#include "../trace/perf_trace.h"
+#include "../log/logger.h"
+#include "../trace/metrics.h"
 #include <iostream>
 #include <thread>
 #include <algorithm> // For std::max, std::min
@@ -19,12 +22,12 @@ CachedDecoder::CachedDecoder(const std::string& filename, std::vector<FrameInfo>
     adaptedStep_(10), // Default value
     initialized_(false)
 {
-    std::cout << "CachedDecoder created for: " << sourceFilename_ << std::endl;
+    TX_LOG_INFO("CachedDecoder", "created for: " << sourceFilename_);
     initialized_ = initialize(); // Call initialize on construction
 }
 
 CachedDecoder::~CachedDecoder() {
-    std::cout << "CachedDecoder destroyed for: " << sourceFilename_ << std::endl;
+    TX_LOG_INFO("CachedDecoder", "destroyed for: " << sourceFilename_);
     cleanup(); // Call cleanup on destruction
 }
 
@@ -35,14 +38,14 @@ bool CachedDecoder::initialize() {
 
     // Open input file
     if (avformat_open_input(&formatCtx_, sourceFilename_.c_str(), nullptr, nullptr) != 0) {
-        std::cerr << "CachedDecoder Error: Failed to open file " << sourceFilename_ << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "Failed to open file " << sourceFilename_);
         cleanup();
         return false;
     }
 
     // Find stream info
     if (avformat_find_stream_info(formatCtx_, nullptr) < 0) {
-        std::cerr << "CachedDecoder Error: Failed to find stream information for " << sourceFilename_ << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "Failed to find stream information for " << sourceFilename_);
         cleanup();
         return false;
     }
@@ -51,7 +54,7 @@ bool CachedDecoder::initialize() {
     const AVCodec* codec = nullptr; 
     videoStreamIndex_ = av_find_best_stream(formatCtx_, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
     if (videoStreamIndex_ < 0 || !codec) {
-        std::cerr << "CachedDecoder Error: Video stream not found or codec could not be found in " << sourceFilename_ << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "Video stream not found or codec could not be found in " << sourceFilename_);
         cleanup();
         return false;
     }
@@ -66,7 +69,7 @@ bool CachedDecoder::initialize() {
         fps_ = av_q2d(videoStream_->r_frame_rate);
     } else {
         fps_ = 25.0; // Fallback FPS
-        std::cerr << "CachedDecoder Warning: Could not determine FPS, using default: " << fps_ << std::endl;
+        TX_LOG_WARN("CachedDecoder", "Could not determine FPS, using default: " << fps_);
     }
     
     // Get adaptive step based on FPS
@@ -75,14 +78,14 @@ bool CachedDecoder::initialize() {
     // Allocate codec context
     codecCtx_ = avcodec_alloc_context3(codec);
     if (!codecCtx_) {
-        std::cerr << "CachedDecoder Error: Failed to allocate codec context" << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "Failed to allocate codec context");
         cleanup();
         return false;
     }
 
     // Copy codec parameters to context
     if (avcodec_parameters_to_context(codecCtx_, codecParams_) < 0) {
-        std::cerr << "CachedDecoder Error: Failed to copy codec parameters to context" << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "Failed to copy codec parameters to context");
         cleanup();
         return false;
     }
@@ -92,15 +95,15 @@ bool CachedDecoder::initialize() {
     codecCtx_->thread_type = FF_THREAD_FRAME;
 
     if (avcodec_open2(codecCtx_, codec, nullptr) < 0) {
-        std::cerr << "CachedDecoder Error: Failed to open codec" << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "Failed to open codec");
         cleanup();
         return false;
     }
 
-    std::cout << "CachedDecoder initialized successfully for " << sourceFilename_ << std::endl;
-    std::cout << "  Resolution: " << codecCtx_->width << "x" << codecCtx_->height << std::endl;
-    std::cout << "  FPS: " << fps_ << ", Adapted Step: " << adaptedStep_ << std::endl;
-    std::cout << "  Time Base: " << timeBase_.num << "/" << timeBase_.den << std::endl;
+    TX_LOG_INFO("CachedDecoder", "initialized successfully for " << sourceFilename_);
+    TX_LOG_INFO("CachedDecoder", "  Resolution: " << codecCtx_->width << "x" << codecCtx_->height);
+    TX_LOG_INFO("CachedDecoder", "  FPS: " << fps_ << ", Adapted Step: " << adaptedStep_);
+    TX_LOG_INFO("CachedDecoder", "  Time Base: " << timeBase_.num << "/" << timeBase_.den);
     
     initialized_ = true;
     return true;
@@ -124,7 +127,7 @@ void CachedDecoder::cleanup() {
     adaptedStep_ = 10;
     timeBase_ = {0, 1};
     // frameIndex_ is a reference, not owned by this class
-    std::cout << "CachedDecoder cleaned up." << std::endl;
+    TX_LOG_INFO("CachedDecoder", "cleaned up.");
 }
 
 // --- Static Methods --- 
@@ -151,7 +154,7 @@ int CachedDecoder::getAdaptiveStep(double fps) {
             adaptiveStep = std::min(15, adaptiveStep); // Максимум 15 кадров
         }
         
-        std::cout << "Video FPS: " << fps << ", adapted cache step: " << adaptiveStep << std::endl;
+        TX_LOG_INFO("CachedDecoder", "Video FPS: " << fps << ", adapted cache step: " << adaptiveStep);
     }
     
     return adaptiveStep;
@@ -160,12 +163,13 @@ int CachedDecoder::getAdaptiveStep(double fps) {
 // --- Instance Methods ---
 
 bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
+    PERF_SPAN("decode.cached");
     if (!initialized_) {
-        std::cerr << "CachedDecoder::decodeRange Error: Not initialized." << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "decodeRange: Not initialized.");
         return false;
     }
     if (frameIndex_.empty() || startFrame > endFrame || startFrame >= frameIndex_.size()) {
-         std::cerr << "CachedDecoder::decodeRange Error: Invalid range or empty index." << std::endl;
+         TX_LOG_ERROR("CachedDecoder", "decodeRange: Invalid range or empty index.");
         return false; // Invalid range or index
     }
     
@@ -176,7 +180,7 @@ bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
     // Get the target timestamp for seeking (use time_ms from the startFrame)
     int64_t seekTargetTimeMs = frameIndex_[startFrame].time_ms;
     if (seekTargetTimeMs < 0) {
-        std::cerr << "CachedDecoder Warning: Invalid timestamp for seek target frame " << startFrame << ". Seeking near beginning." << std::endl;
+        TX_LOG_WARN("CachedDecoder", "Invalid timestamp for seek target frame " << startFrame << ". Seeking near beginning.");
         // Fallback: Seek near the beginning or use PTS if time_ms is invalid?
         // For simplicity, let's try seeking to a very small timestamp
         seekTargetTimeMs = 0; 
@@ -190,7 +194,7 @@ bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
     // Use AVSEEK_FLAG_BACKWARD to find the nearest keyframe before or at the target PTS
     int seek_ret = av_seek_frame(formatCtx_, videoStreamIndex_, seekTargetPts, AVSEEK_FLAG_BACKWARD);
     if (seek_ret < 0) {
-        std::cerr << "CachedDecoder Warning: Seek to pts " << seekTargetPts << " (ms ~" << seekTargetTimeMs << ") failed: " << av_err2str(seek_ret) << std::endl;
+        TX_LOG_WARN("CachedDecoder", "Seek to pts " << seekTargetPts << " (ms ~" << seekTargetTimeMs << ") failed: " << av_err2str(seek_ret));
     } else {
         avcodec_flush_buffers(codecCtx_); // Flush decoder after successful seek
         // std::cout << "CachedDecoder Seek successful to ~" << seekTargetTimeMs << " ms" << std::endl;
@@ -224,7 +228,7 @@ bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
     AVPacket* packet = av_packet_alloc();
     AVFrame* frame = av_frame_alloc();
     if (!packet || !frame) { 
-        std::cerr << "CachedDecoder Error: Failed to allocate packet/frame." << std::endl;
+        TX_LOG_ERROR("CachedDecoder", "Failed to allocate packet/frame.");
         if(packet) av_packet_free(&packet);
         if(frame) av_frame_free(&frame);
         return false;
@@ -233,13 +237,14 @@ bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
     int decodedFramesSinceFirstStore = 0; // Счетчик для шага
     bool firstFrameStoredInRange = false;  // Флаг для первого кадра
     int firstStoredFrameIndex = -1;       // Индекс первого сохраненного кадра в этом вызове
+    auto lastStoredTime = std::chrono::steady_clock::now(); // Per-frame decode latency: between stored frames
 
     while (av_read_frame(formatCtx_, packet) >= 0) {
         if (packet->stream_index == videoStreamIndex_) {
             int ret = avcodec_send_packet(codecCtx_, packet);
             if (ret < 0) {
                 if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) { 
-                     std::cerr << "CachedDecoder Error sending packet: " << av_err2str(ret) << std::endl;
+                     TX_LOG_ERROR("CachedDecoder", "Error sending packet: " << av_err2str(ret));
                 }
                 av_packet_unref(packet);
                 continue;
@@ -252,13 +257,13 @@ bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
                 } else if (ret == AVERROR_EOF) {
                     goto decode_loop_end; // End of stream
                 } else if (ret < 0) {
-                    std::cerr << "CachedDecoder Error receiving frame: " << av_err2str(ret) << std::endl;
+                    TX_LOG_ERROR("CachedDecoder", "Error receiving frame: " << av_err2str(ret));
                     break; // Error receiving frame
                 }
 
                 // --- Check for decode errors in the frame itself ---
                 if (frame->decode_error_flags) {
-                    std::cerr << "CachedDecoder Warning: Frame (PTS: " << frame->pts << ") has decode_error_flags: " << frame->decode_error_flags << ". Skipping." << std::endl;
+                    TX_LOG_WARN("CachedDecoder", "Frame (PTS: " << frame->pts << ") has decode_error_flags: " << frame->decode_error_flags << ". Skipping.");
                     av_frame_unref(frame); // Unref problematic frame
                     continue; // Skip this frame
                 }
@@ -383,12 +388,12 @@ bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
                                                           temp_clone->data[2] != nullptr && temp_clone->linesize[2] > 0;
 
                                     if (!is_frame_valid) {
-                                        std::cerr << "CachedDecoder Warning: Cloned frame for index " << currentFrameIndex
-                                                   << " appears invalid or incomplete (w:" << temp_clone->width << " h:" << temp_clone->height
-                                                   << " data[0]:" << (void*)temp_clone->data[0] << " ls[0]:" << temp_clone->linesize[0]
-                                                   << " data[1]:" << (void*)temp_clone->data[1] << " ls[1]:" << temp_clone->linesize[1]
-                                                   << " data[2]:" << (void*)temp_clone->data[2] << " ls[2]:" << temp_clone->linesize[2]
-                                                   << "). Discarding clone." << std::endl;
+                                        TX_LOG_WARN("CachedDecoder", "Cloned frame for index " << currentFrameIndex
+                                                    << " appears invalid or incomplete (w:" << temp_clone->width << " h:" << temp_clone->height
+                                                    << " data[0]:" << (void*)temp_clone->data[0] << " ls[0]:" << temp_clone->linesize[0]
+                                                    << " data[1]:" << (void*)temp_clone->data[1] << " ls[1]:" << temp_clone->linesize[1]
+                                                    << " data[2]:" << (void*)temp_clone->data[2] << " ls[2]:" << temp_clone->linesize[2]
+                                                    << "). Discarding clone.");
                                         av_frame_free(&temp_clone); // Free the problematic clone, do not store it
                                     } else {
                                         // Clone is sane, store it
@@ -405,11 +410,13 @@ bool CachedDecoder::decodeRange(int startFrame, int endFrame) {
 
                                         // Set type
                                         if (frameIndex_[currentFrameIndex].type == FrameInfo::EMPTY || frameIndex_[currentFrameIndex].type == FrameInfo::CACHED) {
-                                            frameIndex_[currentFrameIndex].type = FrameInfo::CACHED;
+                                            setFrameType(frameIndex_, currentFrameIndex, FrameInfo::CACHED);
                                         }
+                                        playerMetrics.decodeCached.recordSince(lastStoredTime);
+                                        lastStoredTime = std::chrono::steady_clock::now();
                                     }
                                 } else {
-                                     std::cerr << "CachedDecoder Error: av_frame_clone returned nullptr for index " << currentFrameIndex << std::endl;
+                                     TX_LOG_ERROR("CachedDecoder", "av_frame_clone returned nullptr for index " << currentFrameIndex);
                                 }
                             } // End if !cached_frame
                          } // else: Индекс "прыгнул" назад? Пропускаем сохранение.
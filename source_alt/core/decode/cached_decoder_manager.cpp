@@ -1,4 +1,6 @@
 #include "cached_decoder_manager.h"
+#include "../trace/perf_trace.h"
+#include "../log/logger.h"
 #include "cached_decoder.h" // Needed for decoder instance and static methods
 #include "decode.h"         // For FrameInfo struct definition
 #include <iostream>
@@ -29,20 +31,30 @@ CachedDecoderManager::CachedDecoderManager(
     // Calculate preload threshold (e.g., 75% of segment size)
     preloadThreshold_ = static_cast<int>(segmentSize_ * 0.65);
 
+    openFile();
+
+    // std::cout << "CachedDecoderManager: Segment Size = " << segmentSize_ << ", Preload Threshold = " << preloadThreshold_ << std::endl;
+    // std::cout << "CachedDecoderManager: Initialized." << std::endl;
+}
+
+// Opens lowResFilename_ and its thumbnail strip
+void CachedDecoderManager::openFile() {
     // Create the CachedDecoder instance
     try {
-        decoder_ = std::make_unique<CachedDecoder>(lowResFilename_, frameIndex_);
-        if (!decoder_ || !decoder_->isInitialized()) {
+        auto decoder = std::make_unique<CachedDecoder>(lowResFilename_, frameIndex_);
+        if (!decoder || !decoder->isInitialized()) {
              throw std::runtime_error("CachedDecoder instance failed to initialize.");
         }
+        decoder_ = std::move(decoder);
     } catch (const std::exception& e) {
-        std::cerr << "CachedDecoderManager Error: Failed to create CachedDecoder: " << e.what() << std::endl;
+        TX_LOG_ERROR("CachedDecoderManager", "Failed to create CachedDecoder: " << e.what());
         // Rethrow or handle appropriately - maybe set an error state for the manager?
         throw; // Rethrow for now
     }
 
-    // std::cout << "CachedDecoderManager: Segment Size = " << segmentSize_ << ", Preload Threshold = " << preloadThreshold_ << std::endl;
-    // std::cout << "CachedDecoderManager: Initialized." << std::endl;
+    // Map the strip from a previous session, if any. Thumbnails are only
+    // decompressed when their segment is loaded.
+    strip_.open(ThumbnailStrip::pathForProxy(lowResFilename_), static_cast<int>(frameIndex_.size()));
 }
 
 // Destructor
@@ -54,10 +66,16 @@ CachedDecoderManager::~CachedDecoderManager() {
 // Start the manager thread
 void CachedDecoderManager::run() {
     if (isRunning_) {
+        if (suspendRequested_) {
+            // Parked by suspend(): the same thread carries on with the new file
+            { std::lock_guard<std::mutex> lock(mtx_); suspendRequested_ = false; }
+            cv_.notify_all();
+        }
         // std::cout << "CachedDecoderManager: Already running." << std::endl;
         return;
     }
     // std::cout << "CachedDecoderManager: Starting manager thread." << std::endl;
+    suspendRequested_ = false;
     stopRequested_ = false;
     isRunning_ = true;
     managerThread_ = std::thread(&CachedDecoderManager::decodingLoop, this);
@@ -69,15 +87,67 @@ void CachedDecoderManager::stop() {
         return;
     }
     // std::cout << "CachedDecoderManager: Stopping manager thread..." << std::endl;
-    stopRequested_ = true;
-    cv_.notify_one(); // Wake up the thread if it's waiting
+    { std::lock_guard<std::mutex> lock(mtx_); stopRequested_ = true; } // A parked loop waits without timeout
+    cv_.notify_all(); // Wake up the thread if it's waiting
     if (managerThread_.joinable()) {
         managerThread_.join();
     }
     isRunning_ = false;
+
+    // Persist what this session decoded so the next open can skip it
+    strip_.stopEncoding();
+    if (strip_.hasPendingChanges()) {
+        strip_.save();
+    }
     // std::cout << "CachedDecoderManager: Manager thread stopped." << std::endl;
 }
 
+// Park the thread between segments and save what this file recorded
+void CachedDecoderManager::suspend() {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        suspendRequested_ = true;
+        cv_.notify_all();
+        while (isRunning_ && !parked_) {
+            parkedCv_.wait_for(lock, std::chrono::milliseconds(50));
+        }
+    }
+    strip_.stopEncoding();
+    if (strip_.hasPendingChanges()) {
+        strip_.save();
+    }
+}
+
+// Rebind a suspended manager; frameIndex_ already holds the new file's index
+void CachedDecoderManager::setFile(const std::string& lowResFilename, int segmentSize) {
+    const std::string previousFilename = lowResFilename_;
+    lowResFilename_ = lowResFilename;
+    try {
+        openFile();
+    } catch (...) {
+        lowResFilename_ = previousFilename;
+        throw;
+    }
+    segmentSize_ = segmentSize > 0 ? segmentSize : 14000;
+    preloadThreshold_ = static_cast<int>(segmentSize_ * 0.65);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        loadedSegments_.clear();
+    }
+    previousSegment_ = -1;
+    previousIsReverse_ = isReverse_.load();
+    lastNotifiedFrame_ = -1;
+    TX_LOG_DEBUG("CachedDecoderManager", "Switched to " << lowResFilename_);
+}
+
+void CachedDecoderManager::parkWhileSuspended() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    parked_ = true;
+    parkedCv_.notify_all();
+    cv_.wait(lock, [&] { return stopRequested_.load() || !suspendRequested_.load(); });
+    parked_ = false;
+}
+
 // Notify the manager about frame changes
 void CachedDecoderManager::notifyFrameChange() {
     // Simply notify the condition variable to potentially wake up the loop
@@ -86,8 +156,14 @@ void CachedDecoderManager::notifyFrameChange() {
 
 // The main loop for managing cached segments
 void CachedDecoderManager::decodingLoop() {
+    PerfTrace::setThreadName("cached_manager");
     // std::cout << "CachedDecoderManager: Decoding loop started." << std::endl;
     while (!stopRequested_) {
+        if (suspendRequested_.load()) {
+            parkWhileSuspended();
+            continue;
+        }
+
         int currentFrame = -1; // Initialize with invalid value
         bool needsUpdate = false;
         bool directionChanged = false;
@@ -95,7 +171,7 @@ void CachedDecoderManager::decodingLoop() {
         { // Scope for lock
             std::unique_lock<std::mutex> lock(mtx_);
             if (!cv_.wait_for(lock, std::chrono::milliseconds(3600), [&] {
-                return stopRequested_.load() || currentFrame_.load() != lastNotifiedFrame_;
+                return stopRequested_.load() || suspendRequested_.load() || currentFrame_.load() != lastNotifiedFrame_;
             })) {
                 if (stopRequested_ || currentFrame_.load() == lastNotifiedFrame_) {
                     continue; 
@@ -103,6 +179,7 @@ void CachedDecoderManager::decodingLoop() {
             }
 
             if (stopRequested_) break; 
+            if (suspendRequested_) continue;
 
             currentFrame = currentFrame_.load(); 
             
@@ -244,7 +321,7 @@ void CachedDecoderManager::decodingLoop() {
 // Function to load a specific segment
 void CachedDecoderManager::loadSegment(int segmentIndex) {
     if (!decoder_ || !decoder_->isInitialized()) { // Check if decoder is valid
-         std::cerr << "CachedDecoderManager Error: Decoder not initialized in loadSegment." << std::endl;
+         TX_LOG_ERROR("CachedDecoderManager", "Decoder not initialized in loadSegment.");
          return;
     }
     if (frameIndex_.empty() || segmentSize_ <= 0) return;
@@ -269,8 +346,19 @@ void CachedDecoderManager::loadSegment(int segmentIndex) {
 
     // std::cout << "CachedDecoderManager: Requesting load for segment " << segmentIndex << " [" << startFrame << "-" << endFrame << "]" << std::endl;
 
-    // --- Call the actual decoding function --- 
-    bool success = decoder_->decodeRange(startFrame, endFrame); // Call instance method
+    // --- Serve from the on-disk strip if a previous session covered this range ---
+    bool success = false;
+    if (strip_.covers(startFrame, endFrame)) {
+        success = loadSegmentFromStrip(startFrame, endFrame);
+    }
+
+    // --- Otherwise call the actual decoding function --- 
+    if (!success) {
+        success = decoder_->decodeRange(startFrame, endFrame); // Call instance method
+        if (success) {
+            recordSegmentInStrip(startFrame, endFrame);
+        }
+    }
 
     // Placeholder removed
     // std::this_thread::sleep_for(std::chrono::milliseconds(10)); 
@@ -288,14 +376,14 @@ void CachedDecoderManager::loadSegment(int segmentIndex) {
             if (i >= 0 && i < frameIndex_.size()) { 
                 std::lock_guard<std::mutex> frameLock(frameIndex_[i].mutex); // Lock individual frame
                 if (frameIndex_[i].cached_frame && frameIndex_[i].type == FrameInfo::EMPTY) {
-                    frameIndex_[i].type = FrameInfo::CACHED;
+                    setFrameType(frameIndex_, i, FrameInfo::CACHED);
                 }
             }
         }
         // --- End Ensure FrameType ---
 
     } else {
-        std::cerr << "CachedDecoderManager Warning: Failed to load segment " << segmentIndex << std::endl;
+        TX_LOG_WARN("CachedDecoderManager", "Failed to load segment " << segmentIndex);
     }
 
     // Optional: Use std::async for true background loading
@@ -308,6 +396,33 @@ void CachedDecoderManager::loadSegment(int segmentIndex) {
 }
 
 
+// Fill cached_frame slots in [startFrame, endFrame] from the thumbnail strip
+bool CachedDecoderManager::loadSegmentFromStrip(int startFrame, int endFrame) {
+    int restored = strip_.loadRange(startFrame, endFrame, [this](int idx, std::shared_ptr<AVFrame> frame) {
+        if (idx < 0 || idx >= static_cast<int>(frameIndex_.size())) return;
+        std::lock_guard<std::mutex> frameLock(frameIndex_[idx].mutex);
+        if (!frameIndex_[idx].cached_frame) {
+            frameIndex_[idx].cached_frame = frame;
+        }
+    });
+    // std::cout << "CachedDecoderManager: Restored " << restored << " frames from strip for [" << startFrame << "-" << endFrame << "]" << std::endl;
+    return restored > 0;
+}
+
+// Hand the frames decodeRange just stored to the strip's encoder so the next session can reuse them
+void CachedDecoderManager::recordSegmentInStrip(int startFrame, int endFrame) {
+    ThumbnailStrip::FrameRefs frames;
+    for (int i = startFrame; i <= endFrame && !stopRequested_; ++i) {
+        std::lock_guard<std::mutex> frameLock(frameIndex_[i].mutex);
+        if (frameIndex_[i].cached_frame) {
+            frames.emplace_back(i, frameIndex_[i].cached_frame); // A ref; encoded on the strip's thread
+        }
+    }
+    if (!stopRequested_) {
+        strip_.recordSegment(startFrame, endFrame, std::move(frames));
+    }
+}
+
 // Function to unload a specific segment
 void CachedDecoderManager::unloadSegment(int segmentIndex) {
     bool shouldRemove = false;
@@ -362,11 +477,11 @@ void CachedDecoderManager::removeCachedFrames(std::vector<FrameInfo>& frameIndex
             // Reset type only if it was CACHED
             if (frameIndex[i].type == FrameInfo::CACHED) {
                  if (frameIndex[i].frame) {
-                     frameIndex[i].type = FrameInfo::FULL_RES;
+                     setFrameType(frameIndex, i, FrameInfo::FULL_RES);
                  } else if (frameIndex[i].low_res_frame){
-                    frameIndex[i].type = FrameInfo::LOW_RES;
+                    setFrameType(frameIndex, i, FrameInfo::LOW_RES);
                  } else {
-                    frameIndex[i].type = FrameInfo::EMPTY;
+                    setFrameType(frameIndex, i, FrameInfo::EMPTY);
                  }
             }
         }
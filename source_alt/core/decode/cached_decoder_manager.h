@@ -9,6 +9,7 @@
 #include <set>
 #include <chrono>
 #include <memory> // For unique_ptr if needed
+#include "thumbnail_strip.h"
 
 // Forward declarations
 struct FrameInfo;
@@ -26,10 +27,16 @@ public:
 
     ~CachedDecoderManager();
 
-    void run();  // Start the manager thread
+    void run();  // Start the manager thread, or resume it after setFile
     void stop(); // Stop the manager thread
     void notifyFrameChange(); // Notify the manager about frame changes
 
+    // File switching without a new manager: suspend() parks the thread and saves
+    // the strip, setFile() opens the next proxy once frameIndex holds its index,
+    // run() resumes. Throws like the constructor if the proxy cannot be opened.
+    void suspend();
+    void setFile(const std::string& lowResFilename, int segmentSize);
+
 private:
     // Configuration & State
     std::string lowResFilename_;
@@ -42,12 +49,18 @@ private:
     // Decoder Instance
     std::unique_ptr<CachedDecoder> decoder_; // Instance of the decoder
 
+    // On-disk copy of the sparse tier (see thumbnail_strip.h)
+    ThumbnailStrip strip_;
+
     // Threading
     std::thread managerThread_;
     std::mutex mtx_;
     std::condition_variable cv_;
     std::atomic<bool> stopRequested_;
     std::atomic<bool> isRunning_;
+    std::atomic<bool> suspendRequested_{false};
+    bool parked_ = false; // Loop is waiting in parkWhileSuspended, guarded by mtx_
+    std::condition_variable parkedCv_;
 
     // Segment Management
     std::set<int> loadedSegments_;
@@ -60,8 +73,12 @@ private:
 
     // Private methods
     void decodingLoop();
+    void openFile(); // Decoder and strip for lowResFilename_
+    void parkWhileSuspended(); // Loop thread only
     void loadSegment(int segmentIndex);
     void unloadSegment(int segmentIndex);
+    bool loadSegmentFromStrip(int startFrame, int endFrame);
+    void recordSegmentInStrip(int startFrame, int endFrame);
     // Helper to remove cached frames similar to LowResDecoder::removeLowResFrames
     static void removeCachedFrames(std::vector<FrameInfo>& frameIndex, int startIndex, int endIndex); 
 }; 
\ No newline at end of file
@@ -194,9 +194,9 @@ void FrameCleaner::cleanFrames(int startFrame, int endFrame) {
             }
             // Не удаляем cached_frame
             if (frameIndex[i].cached_frame) {
-                frameIndex[i].type = FrameInfo::CACHED;
+                setFrameType(frameIndex, i, FrameInfo::CACHED);
             } else {
-                frameIndex[i].type = FrameInfo::EMPTY;
+                setFrameType(frameIndex, i, FrameInfo::EMPTY);
             }
         }
 }
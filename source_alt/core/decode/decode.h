@@ -6,6 +6,7 @@
 #include <future>
 #include <chrono>
 #include <mutex>
+#include "frame_state_summary.h"
 // #include "full_res_decoder.h" // Removed includes to break circular dependency
 // #include "low_res_decoder.h"
 // #include "cached_decoder.h"
@@ -166,6 +167,16 @@ struct FrameBuffer {
     }
 };
 
+// Sets the type of frameIndex[index] and reports the change to
+// frameStateSummary. Every type change on the shared frame index goes
+// through here so the per-bucket counts stay exact.
+inline void setFrameType(std::vector<FrameInfo>& frameIndex, int index, FrameInfo::FrameType type) {
+    FrameInfo& info = frameIndex[index];
+    if (info.type == type) return;
+    frameStateSummary.transition(index, info.type, type);
+    info.type = type;
+}
+
 // Global frame index
 extern std::vector<FrameInfo> frameIndex;
 extern std::vector<FrameInfo> globalFrameIndex;
@@ -0,0 +1,119 @@
+#include "file_preparer.h"
+#include "low_res_decoder.h"
+#include "../log/logger.h"
+
+#include <chrono>
+#include <filesystem>
+
+FilePreparer filePreparer;
+
+FilePreparer::~FilePreparer() {
+    stop();
+}
+
+std::string FilePreparer::normalizePath(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+    return ec ? path : absolute.lexically_normal().string();
+}
+
+bool FilePreparer::prepareNow(const std::string& path, PreparedFile& out, const Progress& progress) {
+    auto report = [&](const char* stage, int percent) {
+        if (progress) progress(stage, percent);
+    };
+    out = PreparedFile{};
+    out.path = path;
+
+    report("Creating frame index...", 0);
+    out.frameIndex = createFrameIndex(path.c_str());
+    if (out.frameIndex.empty()) {
+        TX_LOG_WARN("Session", "No frames indexed in " << path);
+    }
+
+    report("Converting to low-res...", 20);
+    auto convertProgress = [&](int percent) {
+        report("Converting to low-res...", 20 + percent * 70 / 100);
+    };
+    if (!LowResDecoder::convertToLowRes(path, out.lowResPath, convertProgress)) {
+        TX_LOG_ERROR("Session", "Error converting " << path << " to low resolution");
+        return false;
+    }
+
+    report("Probing...", 90);
+    get_video_dimensions(path.c_str(), &out.width, &out.height);
+    out.fps = get_video_fps(path.c_str());
+    out.duration = get_file_duration(path.c_str());
+    report("Prepared", 100);
+    return true;
+}
+
+void FilePreparer::prepare(const std::string& path) {
+    std::string key = normalizePath(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (key == working_ || (ready_ && ready_->path == key)) return;
+        requested_ = key;
+        stopping_ = false;
+        if (!thread_.joinable()) thread_ = std::thread(&FilePreparer::run, this);
+    }
+    cv_.notify_all();
+}
+
+bool FilePreparer::take(const std::string& path, PreparedFile& out) {
+    std::string key = normalizePath(path);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (requested_ == key) requested_.clear(); // The loading sequence is about to do it anyway
+    if (working_ == key) {
+        TX_LOG_INFO("Session", "Waiting for the background preparation of " << key);
+        cv_.wait(lock, [&] { return working_ != key; });
+    }
+    if (!ready_ || ready_->path != key) return false;
+    out = std::move(*ready_);
+    ready_.reset();
+    return true;
+}
+
+void FilePreparer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        requested_.clear();
+        if (!working_.empty()) {
+            TX_LOG_INFO("Session", "Waiting for the background preparation of " << working_ << " to finish");
+        }
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.reset();
+}
+
+void FilePreparer::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (requested_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        working_.swap(requested_);
+        requested_.clear();
+        ready_.reset(); // One prepared file at a time; its frame index is not small
+        std::string path = working_;
+        lock.unlock();
+
+        auto started = std::chrono::steady_clock::now();
+        auto prepared = std::make_unique<PreparedFile>();
+        bool ok = prepareNow(path, *prepared);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        if (ok) {
+            TX_LOG_INFO("Session", "Prepared " << path << " in " << seconds << " s (" << prepared->frameIndex.size() << " frames)");
+        } else {
+            TX_LOG_WARN("Session", "Could not prepare " << path);
+        }
+
+        lock.lock();
+        if (ok) ready_ = std::move(prepared);
+        working_.clear();
+        cv_.notify_all(); // take() may be waiting for this file
+    }
+}
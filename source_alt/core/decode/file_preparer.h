@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "decode.h"
+
+// Everything the loading sequence derives from a file before the decoder
+// managers and audio can start: the frame index, the proxy, and the probe.
+struct PreparedFile {
+    std::string path;                // Absolute, as the loading sequence names it
+    std::vector<FrameInfo> frameIndex;
+    std::string lowResPath;          // Base proxy in the cache directory
+    int width = 0;
+    int height = 0;
+    double fps = 0.0;
+    double duration = 0.0;
+    double resumeTime = -1.0;        // Where the file was left, when it comes back from the session cache
+};
+
+// Prepares the next file of a session while the current one plays.
+//
+// Indexing a file and making its proxy are the slow part of a switch; the
+// managers and the audio engine come up in a fraction of that. prepare()
+// queues a file for a background thread, and the loading sequence calls
+// take() before doing the work itself: a file that is ready is handed over
+// as is, one that is still being prepared is waited for rather than started
+// twice. One result is kept; preparing another file replaces it.
+class FilePreparer {
+public:
+    // Stage description and 0-100 progress over the whole preparation
+    using Progress = std::function<void(const char* stage, int percent)>;
+
+    ~FilePreparer();
+
+    // Does the preparation on the calling thread
+    static bool prepareNow(const std::string& path, PreparedFile& out, const Progress& progress = nullptr);
+    // The key prepare() and take() match on
+    static std::string normalizePath(const std::string& path);
+
+    // Queues `path` for the background thread, replacing a request that has not started yet
+    void prepare(const std::string& path);
+    // Moves the result for `path` into `out`, waiting while it is being prepared.
+    // False if `path` was not prepared or failed; a queued request for it is dropped.
+    bool take(const std::string& path, PreparedFile& out);
+    // Waits for the file in progress, if any, and stops the thread
+    void stop();
+
+private:
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::string requested_;               // Queued, not started
+    std::string working_;                 // Being prepared
+    std::unique_ptr<PreparedFile> ready_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+extern FilePreparer filePreparer;
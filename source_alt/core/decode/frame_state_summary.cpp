@@ -0,0 +1,80 @@
+#include "frame_state_summary.h"
+#include <algorithm>
+
+FrameStateSummary frameStateSummary;
+
+void FrameStateSummary::reset(int totalFrames) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    totalFrames_ = std::max(0, totalFrames);
+    framesPerBucket_ = std::max(1, (totalFrames_ + kMaxBuckets - 1) / kMaxBuckets);
+    bucketCount_ = (totalFrames_ + framesPerBucket_ - 1) / framesPerBucket_;
+    counts_.assign(static_cast<size_t>(bucketCount_) * kTypeCount, 0);
+    for (int b = 0; b < bucketCount_; ++b) {
+        int first = b * framesPerBucket_;
+        counts_[static_cast<size_t>(b) * kTypeCount] = std::min(framesPerBucket_, totalFrames_ - first); // EMPTY
+    }
+    totals_[0].store(static_cast<uint32_t>(totalFrames_), std::memory_order_relaxed);
+    for (int t = 1; t < kTypeCount; ++t) totals_[t].store(0, std::memory_order_relaxed);
+    ++generation_;
+    dirtyFirst_ = -1;
+    dirtyLast_ = -1;
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void FrameStateSummary::transition(int frame, int fromType, int toType) {
+    if (fromType == toType || fromType < 0 || fromType >= kTypeCount || toType < 0 || toType >= kTypeCount) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (frame < 0 || frame >= totalFrames_) return;
+        int bucket = frame / framesPerBucket_;
+        uint32_t* counts = &counts_[static_cast<size_t>(bucket) * kTypeCount];
+        if (counts[fromType] > 0) {
+            --counts[fromType];
+            totals_[fromType].fetch_sub(1, std::memory_order_relaxed);
+        }
+        ++counts[toType];
+        totals_[toType].fetch_add(1, std::memory_order_relaxed);
+        if (dirtyFirst_ < 0) {
+            dirtyFirst_ = dirtyLast_ = bucket;
+        } else {
+            dirtyFirst_ = std::min(dirtyFirst_, bucket);
+            dirtyLast_ = std::max(dirtyLast_, bucket);
+        }
+        version_.fetch_add(1, std::memory_order_release);
+    }
+    if (toType != 0) { // Not EMPTY
+        if (void (*listener)() = publishListener_.load()) listener();
+    }
+}
+
+bool FrameStateSummary::refresh(View& view, int& firstBucket, int& lastBucket) {
+    if (version_.load(std::memory_order_acquire) == readVersion_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    readVersion_ = version_.load(std::memory_order_relaxed);
+
+    if (view.generation != generation_) {
+        // New frame index: take everything
+        view.totalFrames = totalFrames_;
+        view.framesPerBucket = framesPerBucket_;
+        view.bucketCount = bucketCount_;
+        view.counts = counts_;
+        view.generation = generation_;
+        dirtyFirst_ = -1;
+        dirtyLast_ = -1;
+        firstBucket = 0;
+        lastBucket = bucketCount_ - 1;
+        return bucketCount_ > 0;
+    }
+    if (dirtyFirst_ < 0) return false;
+
+    firstBucket = dirtyFirst_;
+    lastBucket = dirtyLast_;
+    std::copy(counts_.begin() + static_cast<size_t>(firstBucket) * kTypeCount,
+              counts_.begin() + static_cast<size_t>(lastBucket + 1) * kTypeCount,
+              view.counts.begin() + static_cast<size_t>(firstBucket) * kTypeCount);
+    dirtyFirst_ = -1;
+    dirtyLast_ = -1;
+    return true;
+}
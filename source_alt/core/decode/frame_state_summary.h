@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Per-bucket counts of frame types (FrameInfo::FrameType) over the frame index.
+//
+// Decoders report every type change as they publish and evict frames (see
+// setFrameType in decode.h), so the index bar can be drawn from the counts
+// without walking or locking the frame index. Buckets cover a fixed number of
+// frames, chosen so a file of any length fits in kMaxBuckets.
+class FrameStateSummary {
+public:
+    static constexpr int kTypeCount = 4;
+    static constexpr int kMaxBuckets = 16384;
+
+    // Reader-side copy of the counts
+    struct View {
+        int totalFrames = 0;
+        int framesPerBucket = 1;
+        int bucketCount = 0;
+        std::vector<uint32_t> counts; // bucketCount * kTypeCount, indexed [bucket * kTypeCount + type]
+        uint64_t generation = 0;
+    };
+
+    // New frame index of totalFrames frames, all EMPTY
+    void reset(int totalFrames);
+    // One frame changed type
+    void transition(int frame, int fromType, int toType);
+    // Called (outside the lock, on the decoder's thread) whenever a frame
+    // becomes displayable, i.e. changes to a type other than EMPTY
+    void setPublishListener(void (*listener)()) { publishListener_.store(listener); }
+
+    // Brings `view` up to date and returns the range of buckets that changed
+    // since the last call, or false if nothing did. Meant for a single reader
+    // (the render thread); the changed range is cleared on every call.
+    bool refresh(View& view, int& firstBucket, int& lastBucket);
+
+    // Frames of each type over the whole index; lock-free, any thread
+    uint32_t total(int type) const {
+        return (type >= 0 && type < kTypeCount) ? totals_[type].load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    std::mutex mutex_;
+    int totalFrames_ = 0;
+    int framesPerBucket_ = 1;
+    int bucketCount_ = 0;
+    std::vector<uint32_t> counts_;
+    uint64_t generation_ = 0;
+    int dirtyFirst_ = -1; // Changed bucket range, -1 if none
+    int dirtyLast_ = -1;
+    std::atomic<uint64_t> version_{0}; // Bumped on every change, checked without the lock
+    uint64_t readVersion_ = 0;
+    std::atomic<void (*)()> publishListener_{nullptr};
+    std::atomic<uint32_t> totals_[kTypeCount] = {};
+};
+
+extern FrameStateSummary frameStateSummary;
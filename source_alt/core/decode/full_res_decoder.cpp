@@ -1,5 +1,8 @@
 #include "full_res_decoder.h"
 #include "decode.h" // Includes FrameInfo definition
+#include "../trace/perf_trace.h"
+#include "../log/logger.h"
+#include "../trace/metrics.h"
 #include <iostream>
 #include <thread>
 #include <atomic>
@@ -50,18 +53,16 @@ FullResDecoder::FullResDecoder(const std::string& sourceFilename)
 {
     // --- ADDED: Instance counter log ---
     int current_instance_num = ++instance_counter_;
-    std::cout << "[FullResDecoder CONSTRUCTOR TID:" << std::this_thread::get_id() << "] Instance # " << current_instance_num << " created for: " << sourceFilename_ << std::endl;
-    std::cerr << "[FullResDecoder CONSTRUCTOR TID:" << std::this_thread::get_id() << "] Instance # " << current_instance_num << " created for: " << sourceFilename_ << std::endl;
+    TX_LOG_DEBUG("FullResDecoder", "Instance # " << current_instance_num << " created for: " << sourceFilename_);
 
-    std::cout << "FullResDecoder: Initializing for " << sourceFilename_ << "..." << std::endl;
+    TX_LOG_INFO("FullResDecoder", "Initializing for " << sourceFilename_ << "...");
     initialized_ = initialize();
 }
 
 FullResDecoder::~FullResDecoder() {
     // --- ADDED: Instance counter log for destructor ---
     // int current_instance_num = instance_counter_.load(); // or just use a member if you store it
-    std::cout << "[FullResDecoder DESTRUCTOR TID:" << std::this_thread::get_id() << "] Destroying decoder for: " << sourceFilename_ << " (Instance count might be misleading if not decremented)" << std::endl;
-    std::cerr << "[FullResDecoder DESTRUCTOR TID:" << std::this_thread::get_id() << "] Destroying decoder for: " << sourceFilename_ << " (Instance count might be misleading if not decremented)" << std::endl;
+    TX_LOG_DEBUG("FullResDecoder", "Destroying decoder for: " << sourceFilename_ << " (Instance count might be misleading if not decremented)");
     cleanup();
     // std::cout << "FullResDecoder: Destroyed." << std::endl; // Original log
 }
@@ -77,22 +78,22 @@ bool FullResDecoder::initialize() {
     // hw_init_success = false; 
 
     // Лог входа в функцию initialize
-    std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] initialize ENTERED for " << sourceFilename_ << std::endl;
+    TX_LOG_DEBUG("FullResDecoder", "initialize ENTERED for " << sourceFilename_);
 
     if (avformat_open_input(&formatCtx_, sourceFilename_.c_str(), nullptr, nullptr) != 0) {
-        std::cerr << "FullResDecoder Error: Could not open input file: " << sourceFilename_ << std::endl;
+        TX_LOG_ERROR("FullResDecoder", "Could not open input file: " << sourceFilename_);
         return false;
     }
 
     if (avformat_find_stream_info(formatCtx_, nullptr) < 0) {
-        std::cerr << "FullResDecoder Error: Could not find stream info for: " << sourceFilename_ << std::endl;
+        TX_LOG_ERROR("FullResDecoder", "Could not find stream info for: " << sourceFilename_);
         cleanup();
         return false;
     }
 
     videoStreamIndex_ = av_find_best_stream(formatCtx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
     if (videoStreamIndex_ < 0) {
-         std::cerr << "FullResDecoder Error: Could not find video stream in: " << sourceFilename_ << std::endl;
+         TX_LOG_ERROR("FullResDecoder", "Could not find video stream in: " << sourceFilename_);
          cleanup();
          return false;
     }
@@ -101,32 +102,32 @@ bool FullResDecoder::initialize() {
 
     codec = avcodec_find_decoder(codecParams_->codec_id);
     if (!codec) {
-        std::cerr << "FullResDecoder Error: Could not find decoder for codec id " << codecParams_->codec_id << std::endl;
+        TX_LOG_ERROR("FullResDecoder", "Could not find decoder for codec id " << codecParams_->codec_id);
         cleanup();
         return false;
     }
-    std::cout << "FullResDecoder: Found decoder: " << codec->name << " for " << sourceFilename_ << std::endl;
+    TX_LOG_INFO("FullResDecoder", "Found decoder: " << codec->name << " for " << sourceFilename_);
 
 #ifdef __APPLE__
     enum AVHWDeviceType hw_type = AV_HWDEVICE_TYPE_VIDEOTOOLBOX;
     AVCodecContext* tempHwCodecCtx = nullptr;
     AVBufferRef* tempHwDeviceCtxRef = nullptr; // Для av_hwdevice_ctx_create
 
-    std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] initialize: Starting HW config loop for " << sourceFilename_ << std::endl;
+    TX_LOG_DEBUG("FullResDecoder", "initialize: Starting HW config loop for " << sourceFilename_);
     for (int i = 0; ; i++) {
         const AVCodecHWConfig *hw_config = avcodec_get_hw_config(codec, i);
         if (!hw_config) {
-            std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] initialize: No more HW configs for " << codec->name << " for " << sourceFilename_ << std::endl;
+            TX_LOG_DEBUG("FullResDecoder", "initialize: No more HW configs for " << codec->name << " for " << sourceFilename_);
             break;
         }
 
         if (hw_config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX && hw_config->device_type == hw_type) {
-            std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] initialize: Found VideoToolbox HW config method for " << sourceFilename_ << std::endl;
+            TX_LOG_DEBUG("FullResDecoder", "initialize: Found VideoToolbox HW config method for " << sourceFilename_);
 
             // 1. Создаем HW девайс контекст
             ret = av_hwdevice_ctx_create(&tempHwDeviceCtxRef, hw_type, nullptr, nullptr, 0);
             if (ret < 0) {
-                std::cerr << "FullResDecoder Warning: Failed to create HW device context: " << av_err2str(ret) << " for " << sourceFilename_ << std::endl;
+                TX_LOG_WARN("FullResDecoder", "Failed to create HW device context: " << av_err2str(ret) << " for " << sourceFilename_);
                 tempHwDeviceCtxRef = nullptr; // Убедимся, что NULL
                 continue; // Следующая HW конфигурация
             }
@@ -134,14 +135,14 @@ bool FullResDecoder::initialize() {
             // 2. Создаем и настраиваем кодек контекст
             tempHwCodecCtx = avcodec_alloc_context3(codec);
             if (!tempHwCodecCtx) {
-                std::cerr << "FullResDecoder Warning: Failed to allocate HW codec context attempt for " << sourceFilename_ << std::endl;
+                TX_LOG_WARN("FullResDecoder", "Failed to allocate HW codec context attempt for " << sourceFilename_);
                 av_buffer_unref(&tempHwDeviceCtxRef); // Очищаем созданный девайс контекст
                 continue;
             }
 
             tempHwCodecCtx->hw_device_ctx = av_buffer_ref(tempHwDeviceCtxRef); // Передаем владение ссылкой
             if (!tempHwCodecCtx->hw_device_ctx) {
-                std::cerr << "FullResDecoder Warning: Failed to ref HW device context for " << sourceFilename_ << std::endl;
+                TX_LOG_WARN("FullResDecoder", "Failed to ref HW device context for " << sourceFilename_);
                 av_buffer_unref(&tempHwDeviceCtxRef); // Наша ссылка
                 avcodec_free_context(&tempHwCodecCtx); // Контекст кодека (он бы свою ссылку очистил, если бы получил)
                 continue;
@@ -152,19 +153,19 @@ bool FullResDecoder::initialize() {
 
             tempHwCodecCtx->get_format = get_hw_format;
             if (avcodec_parameters_to_context(tempHwCodecCtx, codecParams_) < 0) {
-                std::cerr << "FullResDecoder Warning: Failed to copy params to HW context attempt for " << sourceFilename_ << std::endl;
+                TX_LOG_WARN("FullResDecoder", "Failed to copy params to HW context attempt for " << sourceFilename_);
                 avcodec_free_context(&tempHwCodecCtx); // Очистит свою ссылку на tempHwDeviceCtxRef
                 av_buffer_unref(&tempHwDeviceCtxRef);    // Очищаем нашу исходную ссылку
                 continue;
             }
 
             if (avcodec_open2(tempHwCodecCtx, codec, nullptr) < 0) {
-                std::cerr << "FullResDecoder Warning: Failed to open codec with HW acceleration for " << sourceFilename_ << std::endl;
+                TX_LOG_WARN("FullResDecoder", "Failed to open codec with HW acceleration for " << sourceFilename_);
                 avcodec_free_context(&tempHwCodecCtx);
                 av_buffer_unref(&tempHwDeviceCtxRef);
                 continue;
             }
-            std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] initialize: HW codec opened, attempting test decode for " << sourceFilename_ << std::endl;
+            TX_LOG_DEBUG("FullResDecoder", "initialize: HW codec opened, attempting test decode for " << sourceFilename_);
 
             // 3. ТЕСТОВОЕ ДЕКОДИРОВАНИЕ
             bool test_decode_successful = false;
@@ -181,25 +182,25 @@ bool FullResDecoder::initialize() {
                 int packets_read_for_test = 0;
                 while (frames_decoded_count < REQUIRED_TEST_FRAMES && packets_read_for_test < 20) { // Ограничение на кол-во пакетов для теста
                     if (av_read_frame(formatCtx_, test_packet) < 0) {
-                        std::cerr << "FullResDecoder HW Test: Failed to read packet for test decode for " << sourceFilename_ << std::endl;
+                        TX_LOG_WARN("FullResDecoder", "HW Test: Failed to read packet for test decode for " << sourceFilename_);
                         break; 
                     }
                     packets_read_for_test++;
                     if (test_packet->stream_index == videoStreamIndex_) {
                         ret = avcodec_send_packet(tempHwCodecCtx, test_packet);
                         if (ret < 0 && ret != AVERROR(EAGAIN)) {
-                            std::cerr << "FullResDecoder HW Test: Failed to send packet: " << av_err2str(ret) << " for " << sourceFilename_ << std::endl;
+                            TX_LOG_WARN("FullResDecoder", "HW Test: Failed to send packet: " << av_err2str(ret) << " for " << sourceFilename_);
                             av_packet_unref(test_packet);
                             break; 
                         }
                         if (ret == 0) { // Пакет успешно отправлен (или EAGAIN)
                            int receive_ret = avcodec_receive_frame(tempHwCodecCtx, test_frame);
                            if (receive_ret == 0) {
-                               std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] initialize: HW Test Decode successful for 1 frame for " << sourceFilename_ << std::endl;
+                               TX_LOG_DEBUG("FullResDecoder", "initialize: HW Test Decode successful for 1 frame for " << sourceFilename_);
                                frames_decoded_count++;
                                av_frame_unref(test_frame);
                            } else if (receive_ret != AVERROR(EAGAIN) && receive_ret != AVERROR_EOF) {
-                               std::cerr << "FullResDecoder HW Test: Failed to receive frame: " << av_err2str(receive_ret) << " for " << sourceFilename_ << std::endl;
+                               TX_LOG_WARN("FullResDecoder", "HW Test: Failed to receive frame: " << av_err2str(receive_ret) << " for " << sourceFilename_);
                                av_packet_unref(test_packet);
                 break;
             }
@@ -213,7 +214,7 @@ bool FullResDecoder::initialize() {
             av_frame_free(&test_frame);
 
             if (test_decode_successful) {
-                std::cout << "FullResDecoder: Successfully initialized with VideoToolbox HW Acceleration (passed test decode) for " << sourceFilename_ << std::endl;
+                TX_LOG_INFO("FullResDecoder", "Successfully initialized with VideoToolbox HW Acceleration (passed test decode) for " << sourceFilename_);
                 codecCtx_ = tempHwCodecCtx; // Присваиваем успешно протестированный контекст
             hw_accel_enabled_ = true;
             hw_init_success = true;
@@ -232,7 +233,7 @@ bool FullResDecoder::initialize() {
 
                 break; // Выходим из цикла поиска HW конфигураций
             } else {
-                std::cerr << "FullResDecoder: HW Test Decode FAILED. Cleaning up this HW attempt for " << sourceFilename_ << std::endl;
+                TX_LOG_WARN("FullResDecoder", "HW Test Decode FAILED. Cleaning up this HW attempt for " << sourceFilename_);
                 avcodec_free_context(&tempHwCodecCtx); // Очищаем неудачный кодек-контекст
                 av_buffer_unref(&tempHwDeviceCtxRef);    // Очищаем наш изначальный ref на девайс-контекст
                 tempHwDeviceCtxRef = nullptr;
@@ -248,7 +249,7 @@ bool FullResDecoder::initialize() {
 
     // --- Fallback to Software Decoder if HW failed (hw_init_success все еще false) ---
     if (!hw_init_success) {
-        std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] initialize: Initializing Software Decoder for " << sourceFilename_ << std::endl;
+        TX_LOG_DEBUG("FullResDecoder", "initialize: Initializing Software Decoder for " << sourceFilename_);
         // hw_device_ctx_ должен быть nullptr здесь, если логика выше верна
         if (hw_device_ctx_) { // Дополнительная проверка
             av_buffer_unref(&hw_device_ctx_);
@@ -260,22 +261,22 @@ bool FullResDecoder::initialize() {
 
         codecCtx_ = avcodec_alloc_context3(codec);
         if (!codecCtx_) {
-            std::cerr << "FullResDecoder Error: Could not alloc SW codec context for " << sourceFilename_ << std::endl;
+            TX_LOG_ERROR("FullResDecoder", "Could not alloc SW codec context for " << sourceFilename_);
             cleanup(); return false;
         }
         if (avcodec_parameters_to_context(codecCtx_, codecParams_) < 0) {
-            std::cerr << "FullResDecoder Error: Could not copy codec params to SW context for " << sourceFilename_ << std::endl;
+            TX_LOG_ERROR("FullResDecoder", "Could not copy codec params to SW context for " << sourceFilename_);
             cleanup(); return false;
         }
         if (avcodec_open2(codecCtx_, codec, nullptr) < 0) {
-            std::cerr << "FullResDecoder Error: Could not open SW codec for " << sourceFilename_ << std::endl;
+            TX_LOG_ERROR("FullResDecoder", "Could not open SW codec for " << sourceFilename_);
             cleanup(); return false;
         }
-        std::cout << "FullResDecoder: Initialized with Software Decoder for " << sourceFilename_ << std::endl;
+        TX_LOG_INFO("FullResDecoder", "Initialized with Software Decoder for " << sourceFilename_);
     }
 
     if (!codecCtx_) { // Если ни HW, ни SW не инициализировались
-        std::cerr << "FullResDecoder Error: Codec context is null after all initialization attempts for " << sourceFilename_ << std::endl;
+        TX_LOG_ERROR("FullResDecoder", "Codec context is null after all initialization attempts for " << sourceFilename_);
         cleanup(); return false;
     }
 
@@ -294,14 +295,14 @@ bool FullResDecoder::initialize() {
     initialized_ = true;
     hw_irrecoverably_failed_ = false; // Убедимся, что сброшен при успешной инициализации (HW или SW)
 
-    std::cout << "FullResDecoder: Final Initialization successful for " << sourceFilename_ << "." << std::endl;
-    std::cout << "  Mode: " << (hw_accel_enabled_ ? "Hardware (VideoToolbox)" : "Software") << std::endl;
-    std::cout << "  Resolution: " << width_ << "x" << height_ << std::endl;
+    TX_LOG_INFO("FullResDecoder", "Final Initialization successful for " << sourceFilename_ << ".");
+    TX_LOG_INFO("FullResDecoder", "  Mode: " << (hw_accel_enabled_ ? "Hardware (VideoToolbox)" : "Software"));
+    TX_LOG_INFO("FullResDecoder", "  Resolution: " << width_ << "x" << height_);
     const char* fmt_name = av_get_pix_fmt_name(pixFmt_);
-    std::cout << "  Context Pixel Format: " << (fmt_name ? fmt_name : "N/A") << std::endl;
-    std::cout << "  SAR: " << sampleAspectRatio_.num << "/" << sampleAspectRatio_.den << std::endl;
-    std::cout << "  Calculated Display Aspect Ratio: " << displayAspectRatio_ << std::endl;
-    std::cout << "  Time Base: " << videoStream_->time_base.num << "/" << videoStream_->time_base.den << std::endl;
+    TX_LOG_INFO("FullResDecoder", "  Context Pixel Format: " << (fmt_name ? fmt_name : "N/A"));
+    TX_LOG_INFO("FullResDecoder", "  SAR: " << sampleAspectRatio_.num << "/" << sampleAspectRatio_.den);
+    TX_LOG_INFO("FullResDecoder", "  Calculated Display Aspect Ratio: " << displayAspectRatio_);
+    TX_LOG_INFO("FullResDecoder", "  Time Base: " << videoStream_->time_base.num << "/" << videoStream_->time_base.den);
 
     return true;
 }
@@ -342,7 +343,8 @@ bool FullResDecoder::isHardwareAccelerated() const {
 
 
 bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int startFrame, int endFrame) {
-    std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] decodeFrameRange ENTERED. File: " << sourceFilename_ << " Range: [" << startFrame << "-" << endFrame <<"] hw_failed_flag is: " << hw_irrecoverably_failed_.load() << std::endl;
+    PERF_SPAN("decode.full");
+    TX_LOG_DEBUG("FullResDecoder", "decodeFrameRange ENTERED. File: " << sourceFilename_ << " Range: [" << startFrame << "-" << endFrame <<"] hw_failed_flag is: " << hw_irrecoverably_failed_.load());
     stop_requested_ = false;
     is_decoding_ = true; // Mark that we're actively decoding
 
@@ -352,11 +354,11 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - hw_failure_time_).count();
         
         if (elapsed >= 5) {
-            std::cout << "[FullResDecoder] " << elapsed << " seconds passed since HW failure. Attempting to reset and retry." << std::endl;
+            TX_LOG_INFO("FullResDecoder", elapsed << " seconds passed since HW failure. Attempting to reset and retry.");
             hw_irrecoverably_failed_ = false;
             // Continue with decoding attempt
         } else {
-            std::cerr << "[FullResDecoder TID:" << std::this_thread::get_id() << "] decodeFrameRange Error: HW failed " << elapsed << " seconds ago (need 5s before retry). ABORTING for " << sourceFilename_ << std::endl;
+            TX_LOG_ERROR("FullResDecoder", "decodeFrameRange Error: HW failed " << elapsed << " seconds ago (need 5s before retry). ABORTING for " << sourceFilename_);
             is_decoding_ = false; // Clear decoding flag
             return false;
         }
@@ -364,13 +366,13 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
 
     auto function_start_time = std::chrono::high_resolution_clock::now();
     if (!initialized_ || !formatCtx_ || !codecCtx_ || videoStreamIndex_ < 0) {
-        std::cerr << "FullResDecoder::decodeFrameRange Error: Decoder not initialized." << std::endl;
+        TX_LOG_ERROR("FullResDecoder", "decodeFrameRange: Decoder not initialized.");
         is_decoding_ = false; // Clear decoding flag
         return false;
     }
 
     if (frameIndex.empty()) {
-        std::cerr << "FullResDecoder::decodeFrameRange Warning: Frame index is empty." << std::endl;
+        TX_LOG_WARN("FullResDecoder", "decodeFrameRange: Frame index is empty.");
         is_decoding_ = false; // Clear decoding flag
         return true; // Nothing to do
     }
@@ -380,7 +382,7 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
     endFrame = std::min(static_cast<int>(frameIndex.size()) - 1, endFrame);
 
     if (startFrame > endFrame) {
-         std::cerr << "FullResDecoder::decodeFrameRange Error: Invalid frame range requested after clamping (" << startFrame << " - " << endFrame << ")" << std::endl;
+         TX_LOG_ERROR("FullResDecoder", "decodeFrameRange: Invalid frame range requested after clamping (" << startFrame << " - " << endFrame << ")");
          is_decoding_ = false; // Clear decoding flag
          return false;
     }
@@ -408,7 +410,7 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
         std::chrono::duration<double, std::milli> seek_duration = seek_end_time - seek_start_time;
 
         if (seek_ret < 0) {
-            std::cerr << "[Timing] FullResDecoder::decodeFrameRange Warning: Seek failed in " << seek_duration.count() << " ms (Error: " << av_err2str(seek_ret) << "). Will attempt decode sequentially." << std::endl;
+            TX_LOG_WARN("FullResDecoder", "decodeFrameRange: Seek failed in " << seek_duration.count() << " ms (Error: " << av_err2str(seek_ret) << "). Will attempt decode sequentially.");
             startTimeMs = -1; // Reset startTimeMs if seek failed, rely only on counter
         } else {
             avcodec_flush_buffers(codecCtx_);
@@ -425,7 +427,7 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
             // REMOVED: Timestamp repair - let original timestamps work naturally
         }
     } else {
-        std::cerr << "[Timing] FullResDecoder::decodeFrameRange Warning: Invalid time_ms for startFrame " << startFrame << ". Will attempt decode sequentially." << std::endl;
+        TX_LOG_WARN("FullResDecoder", "decodeFrameRange: Invalid time_ms for startFrame " << startFrame << ". Will attempt decode sequentially.");
         startTimeMs = -1; // No valid start time, rely only on counter
     }
 
@@ -433,7 +435,7 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
         AVPacket* packet = av_packet_alloc();
         AVFrame* frame = av_frame_alloc(); // This frame will receive the final data (HW or SW)
     if (!packet || !frame) {
-        std::cerr << "FullResDecoder::decodeFrameRange Error: Failed to allocate packet or frame." << std::endl;
+        TX_LOG_ERROR("FullResDecoder", "decodeFrameRange: Failed to allocate packet or frame.");
         av_packet_free(&packet);
         av_frame_free(&frame);
         is_decoding_ = false; // Clear decoding flag
@@ -444,8 +446,8 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
     int decoded_frame_count = 0; // Counter for timing log
     bool success = true; // Flag to track overall success
 
-    // Comment out timing log
-    // auto loop_start_time = std::chrono::high_resolution_clock::now(); // Timing: Loop start
+    auto loop_start_time = std::chrono::steady_clock::now(); // Timing: Loop start
+    auto last_stored_time = loop_start_time; // Per-frame decode latency is measured between stored frames
     while (!stop_requested_.load() && av_read_frame(formatCtx_, packet) >= 0) {
         if (packet->stream_index == videoStreamIndex_) {
             int ret = avcodec_send_packet(codecCtx_, packet);
@@ -459,14 +461,14 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
                 // }
                 // --- LESS AGGRESSIVE CHECK ---
                 if (ret != AVERROR(EAGAIN)) { // Still ignore EAGAIN
-                    std::cerr << "FullResDecoder::decodeFrameRange Warning: Error sending packet: " << av_err2str(ret) << " (code: " << ret << ") for " << sourceFilename_ << std::endl;
+                    TX_LOG_WARN("FullResDecoder", "decodeFrameRange: Error sending packet: " << av_err2str(ret) << " (code: " << ret << ") for " << sourceFilename_);
                     if (hw_accel_enabled_) {
                         // Only mark as irrecoverably failed for specific critical errors
                         if (ret == AVERROR_INVALIDDATA || ret == AVERROR_EXTERNAL || ret == AVERROR_UNKNOWN || ret == AVERROR_PATCHWELCOME) {
-                            std::cerr << "[FullResDecoder TID:" << std::this_thread::get_id() << "] decodeFrameRange: Marking HW as irrecoverably failed due to critical send_packet error: " << ret << std::endl;
+                            TX_LOG_ERROR("FullResDecoder", "decodeFrameRange: Marking HW as irrecoverably failed due to critical send_packet error: " << ret);
                             hw_irrecoverably_failed_ = true;
                             hw_failure_time_ = std::chrono::steady_clock::now(); // Record failure time
-                            std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] decodeFrameRange hw_failed_flag SET TO TRUE after critical send_packet error." << std::endl;
+                            TX_LOG_DEBUG("FullResDecoder", "decodeFrameRange hw_failed_flag SET TO TRUE after critical send_packet error.");
                         }
                         // For other errors, just log and continue - might be temporary
                     }
@@ -493,14 +495,14 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
                     // success = false; 
                     // goto decode_loop_end;
                     // --- LESS AGGRESSIVE CHECK ---
-                    std::cerr << "FullResDecoder::decodeFrameRange Error: Error receiving frame: " << av_err2str(ret) << " (code: " << ret << ") for " << sourceFilename_ << std::endl;
+                    TX_LOG_ERROR("FullResDecoder", "decodeFrameRange: Error receiving frame: " << av_err2str(ret) << " (code: " << ret << ") for " << sourceFilename_);
                     if (hw_accel_enabled_) {
                         // Only mark as irrecoverably failed for specific critical errors
                         if (ret == AVERROR_INVALIDDATA || ret == AVERROR_EXTERNAL || ret == AVERROR_UNKNOWN || ret == AVERROR_PATCHWELCOME) {
-                            std::cerr << "[FullResDecoder TID:" << std::this_thread::get_id() << "] decodeFrameRange: Marking HW as irrecoverably failed due to critical receive_frame error: " << ret << std::endl;
+                            TX_LOG_ERROR("FullResDecoder", "decodeFrameRange: Marking HW as irrecoverably failed due to critical receive_frame error: " << ret);
                             hw_irrecoverably_failed_ = true;
                             hw_failure_time_ = std::chrono::steady_clock::now(); // Record failure time
-                            std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] decodeFrameRange hw_failed_flag SET TO TRUE after critical receive_frame error." << std::endl;
+                            TX_LOG_DEBUG("FullResDecoder", "decodeFrameRange hw_failed_flag SET TO TRUE after critical receive_frame error.");
                         }
                         // For other errors, might be temporary - try to continue
                     }
@@ -540,7 +542,7 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
                     // Clone the received frame (could be HW surface or SW data)
                     frameIndex[currentOutputFrameIndex].frame = std::shared_ptr<AVFrame>(av_frame_clone(frame), [](AVFrame* f) { av_frame_free(&f); });
                     if (!frameIndex[currentOutputFrameIndex].frame) {
-                        std::cerr << "FullResDecoder::decodeFrameRange Error: Failed to clone frame for index " << currentOutputFrameIndex << std::endl;
+                        TX_LOG_ERROR("FullResDecoder", "decodeFrameRange: Failed to clone frame for index " << currentOutputFrameIndex);
                         success = false;
                         goto decode_loop_end; // Stop processing on critical error
                     } else {
@@ -548,19 +550,16 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
                         frameIndex[currentOutputFrameIndex].pts = framePts;
                         frameIndex[currentOutputFrameIndex].relative_pts = framePts - (videoStream_->start_time != AV_NOPTS_VALUE ? videoStream_->start_time : 0);
                         frameIndex[currentOutputFrameIndex].time_ms = frameTimeMs; // FIXED: Update time_ms consistently
-                        frameIndex[currentOutputFrameIndex].type = FrameInfo::FULL_RES; // Mark as full-res attempt
+                        setFrameType(frameIndex, currentOutputFrameIndex, FrameInfo::FULL_RES); // Mark as full-res attempt
                         frameIndex[currentOutputFrameIndex].time_base = timeBase;
                         frameIndex[currentOutputFrameIndex].format = (AVPixelFormat)frame->format; // <<< STORE THE ACTUAL FORMAT
+                        resident_.insert(currentOutputFrameIndex); // Still under the frame lock
 
-                        // Debug log for HW frame
-                        if (frame->format == AV_PIX_FMT_VIDEOTOOLBOX) {
-                             CVPixelBufferRef cv_pix_buf = (CVPixelBufferRef)frame->data[3];
-                             // std::cout << "[Decoded HW Frame " << currentOutputFrameIndex << "] Format: VT, CVPixelBufferRef: " << (void*)cv_pix_buf << std::endl;
-                        } else {
-                             // const char* sw_fmt_name = av_get_pix_fmt_name((AVPixelFormat)frame->format);
-                             // std::cout << "[Decoded SW Frame " << currentOutputFrameIndex << "] Format: " << (sw_fmt_name ? sw_fmt_name : "Unknown") << std::endl;
-                        }
+                        TX_LOG_TRACE("FullResDecoder", "Decoded frame " << currentOutputFrameIndex << " at " << frameTimeMs
+                                     << " ms, format: " << (frame->format == AV_PIX_FMT_VIDEOTOOLBOX ? "VT" : av_get_pix_fmt_name((AVPixelFormat)frame->format)));
                         decoded_frame_count++; // Increment counter only when frame is stored
+                        playerMetrics.decodeFullRes.recordSince(last_stored_time);
+                        last_stored_time = std::chrono::steady_clock::now();
                     }
 
                     // frameIndex[currentOutputFrameIndex].is_decoding = false;
@@ -586,14 +585,13 @@ bool FullResDecoder::decodeFrameRange(std::vector<FrameInfo>& frameIndex, int st
     } // end while(av_read_frame)
 
 decode_loop_end:
-    // Comment out timing log
-    // auto loop_end_time = std::chrono::high_resolution_clock::now(); // Timing: Loop end
-    // std::chrono::duration<double, std::milli> loop_duration = loop_end_time - loop_start_time;
-    // std::cout << "[Timing] FullResDecoder::decodeFrameRange: Decode loop finished in " << loop_duration.count() << " ms. Decoded frames: " << decoded_frame_count << std::endl;
+    TX_LOG_DEBUG("FullResDecoder", "decodeFrameRange: Decode loop finished in "
+                 << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loop_start_time).count()
+                 << " ms. Decoded frames: " << decoded_frame_count);
 
     if (stop_requested_.load()) { // Optional: Log if stopped due to request
         // Keep this log? It might be useful.
-        std::cout << "[FullResDecoder] Exiting decode loop due to stop request." << std::endl;
+        TX_LOG_DEBUG("FullResDecoder", "Exiting decode loop due to stop request.");
     }
     av_frame_free(&frame);
     av_packet_free(&packet);
@@ -603,7 +601,7 @@ decode_loop_end:
     // std::cout << "[Timing] FullResDecoder::decodeFrameRange: Finished processing range [" << startFrame << " - " << endFrame << "] in " << function_duration.count() << " ms." << std::endl;
 
     if (hw_irrecoverably_failed_.load()) {
-         std::cerr << "[FullResDecoder TID:" << std::this_thread::get_id() << "] decodeFrameRange EXITING due to hw_failed_flag=true for " << sourceFilename_ << std::endl;
+         TX_LOG_WARN("FullResDecoder", "decodeFrameRange EXITING due to hw_failed_flag=true for " << sourceFilename_);
     }
     
     // Clear decoding flag and flush buffers if stop was requested
@@ -618,58 +616,54 @@ decode_loop_end:
 }
 
 
-void FullResDecoder::removeHighResFrames(std::vector<FrameInfo>& frameIndex,
-                                       int start, int end,
-                                       int highResStart, int highResEnd) {
-    // Clamp indices
-    start = std::max(0, start);
-    end = std::min(static_cast<int>(frameIndex.size()) - 1, end);
-    if (start > end) return;
-
-    for (int i = start; i <= end; ++i) {
-        // Lock only the frame being modified
-        std::lock_guard<std::mutex> lock(frameIndex[i].mutex);
+void FullResDecoder::releaseRuns(std::vector<FrameInfo>& frameIndex,
+                                 const std::vector<ResidentSet::Run>& runs) {
+    const int indexSize = static_cast<int>(frameIndex.size());
+    for (const auto& run : runs) {
+        int runEnd = std::min(run.second, indexSize - 1);
+        for (int i = std::max(0, run.first); i <= runEnd; ++i) {
+            // Lock only the frame being modified
+            std::lock_guard<std::mutex> lock(frameIndex[i].mutex);
 
-        // Check if it's outside the current high-res window
-        if (i < highResStart || i > highResEnd) {
             // Check if it currently has a full-res frame (could be HW or SW)
             if (frameIndex[i].frame) {
                 frameIndex[i].frame.reset(); // Release the shared_ptr
 
                 // Update type based on whether low_res exists
                 if (frameIndex[i].low_res_frame) {
-                    frameIndex[i].type = FrameInfo::LOW_RES;
+                    setFrameType(frameIndex, i, FrameInfo::LOW_RES);
                     // Keep the format of the low_res frame (should be SW)
                     frameIndex[i].format = static_cast<AVPixelFormat>(frameIndex[i].low_res_frame->format);
                 } else {
-                    frameIndex[i].type = FrameInfo::EMPTY;
+                    setFrameType(frameIndex, i, FrameInfo::EMPTY);
                     frameIndex[i].format = AV_PIX_FMT_NONE;
                 }
-                 // std::cout << "Removed full-res frame outside window at index " << i << std::endl;
             }
         }
     }
 }
 
-void FullResDecoder::clearHighResFrames(std::vector<FrameInfo>& frameIndex) {
-    for (auto& frameInfo : frameIndex) {
-        // Lock the frame being modified
-        std::lock_guard<std::mutex> lock(frameInfo.mutex);
+void FullResDecoder::removeHighResFrames(std::vector<FrameInfo>& frameIndex,
+                                         int highResStart, int highResEnd) {
+    // Only the resident runs that fell out of the window are touched
+    releaseRuns(frameIndex, resident_.takeOutside(highResStart, highResEnd));
+}
 
-        if (frameInfo.frame) {
-            frameInfo.frame.reset(); // Release the full-res frame
+void FullResDecoder::clearHighResFrames(std::vector<FrameInfo>& frameIndex) {
+    releaseRuns(frameIndex, resident_.takeAll());
+    // std::cout << "Cleared all high-res frames." << std::endl;
+}
 
-            // Update type based on low_res frame presence
-            if (frameInfo.low_res_frame) {
-                frameInfo.type = FrameInfo::LOW_RES;
-                frameInfo.format = static_cast<AVPixelFormat>(frameInfo.low_res_frame->format);
-            } else {
-                frameInfo.type = FrameInfo::EMPTY;
-                frameInfo.format = AV_PIX_FMT_NONE;
-            }
-        }
+void FullResDecoder::adoptResident(std::vector<FrameInfo>& frameIndex, int first, int last) {
+    last = std::min(last, static_cast<int>(frameIndex.size()) - 1);
+    for (int i = std::max(0, first); i <= last; ++i) {
+        std::lock_guard<std::mutex> lock(frameIndex[i].mutex);
+        if (frameIndex[i].frame) resident_.insert(i); // Under the frame lock, as in decodeFrameRange
     }
-    // std::cout << "Cleared all high-res frames." << std::endl;
+}
+
+size_t FullResDecoder::residentFrameCount() const {
+    return resident_.size();
 }
 
 
@@ -710,13 +704,13 @@ void FullResDecoder::requestStop() {
 // --- ADDED: Implementation for checking irrecoverable HW failure ---
 bool FullResDecoder::hasHardwareFailedIrrecoverably() const {
     // Added log to see when this is called
-    std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] hasHardwareFailedIrrecoverably() CALLED. Returning: " << hw_irrecoverably_failed_.load() << " for " << sourceFilename_ << std::endl;
+    TX_LOG_DEBUG("FullResDecoder", "hasHardwareFailedIrrecoverably() CALLED. Returning: " << hw_irrecoverably_failed_.load() << " for " << sourceFilename_);
     return hw_irrecoverably_failed_.load();
 }
 
 // --- ADDED: Implementation for resetting HW failure flag ---
 void FullResDecoder::resetHardwareFailureFlag() {
-    std::cout << "[FullResDecoder TID:" << std::this_thread::get_id() << "] resetHardwareFailureFlag() CALLED. Resetting hw_irrecoverably_failed_ flag for " << sourceFilename_ << std::endl;
+    TX_LOG_DEBUG("FullResDecoder", "resetHardwareFailureFlag() CALLED. Resetting hw_irrecoverably_failed_ flag for " << sourceFilename_);
     hw_irrecoverably_failed_ = false;
     stop_requested_ = false;  // Also reset stop flag to allow retry
 } 
\ No newline at end of file
@@ -15,6 +15,7 @@ extern "C" {
 }
 
 #include "decode.h"
+#include "resident_set.h"
 
 // Forward declarations
 // struct FrameInfo;
@@ -37,11 +38,20 @@ public:
     AVPixelFormat getPixelFormat() const; // Returns context pix fmt
     float getDisplayAspectRatio() const; // <-- ADDED Getter
 
+    // --- Window maintenance ---
+    // Drop full-res frames outside [highResStart, highResEnd]. Only frames this
+    // decoder stored (tracked in resident_) are visited, so cost scales with
+    // the number of frames evicted, not with the size of the frame index.
+    void removeHighResFrames(std::vector<FrameInfo>& frameIndex,
+                             int highResStart, int highResEnd);
+    void clearHighResFrames(std::vector<FrameInfo>& frameIndex);
+    // Track full-res frames in [first, last] that were not decoded by this
+    // decoder (an index restored from the session cache), so the window
+    // maintenance above releases them like its own.
+    void adoptResident(std::vector<FrameInfo>& frameIndex, int first, int last);
+    size_t residentFrameCount() const;
+
     // --- Static Utility Methods ---
-    static void removeHighResFrames(std::vector<FrameInfo>& frameIndex,
-                                  int start, int end,
-                                  int highResStart, int highResEnd);
-    static void clearHighResFrames(std::vector<FrameInfo>& frameIndex);
     static bool shouldProcessFrame(const FrameInfo& frame);
 
     void requestStop();
@@ -57,6 +67,7 @@ private:
     bool initialize();
     void cleanup();
     static enum AVPixelFormat get_hw_format(AVCodecContext *ctx, const enum AVPixelFormat *pix_fmts); // Moved from test
+    static void releaseRuns(std::vector<FrameInfo>& frameIndex, const std::vector<ResidentSet::Run>& runs);
 
     // Member variables
     std::string sourceFilename_;
@@ -87,6 +98,9 @@ private:
     std::atomic<bool> hw_irrecoverably_failed_;
     std::chrono::steady_clock::time_point hw_failure_time_; // Track when HW failed
 
+    // Indices whose FrameInfo::frame was filled by this decoder
+    ResidentSet resident_;
+
     // --- ADDED: Static counter for instances ---
     static std::atomic<int> instance_counter_;
 
@@ -1,4 +1,6 @@
 #include "full_res_decoder_manager.h"
+#include "../trace/perf_trace.h"
+#include "../log/logger.h"
 #include "../common/common.h" // For seekInfo, speed_reset_requested etc.
 #include <iostream>
 #include <chrono>
@@ -36,20 +38,26 @@ FullResDecoderManager::FullResDecoderManager(
     highResConditionsMetPreviously_(false)
 {
     // --- ADDED: Log for manager constructor ---
-    std::cout << "[FRDM CONSTRUCTOR TID:" << std::this_thread::get_id() << "] FullResDecoderManager CREATED. Decoder ptr will be: " << decoder_.get() << " (though not yet assigned)" << std::endl;
-    std::cerr << "[FRDM CONSTRUCTOR TID:" << std::this_thread::get_id() << "] FullResDecoderManager CREATED. Decoder ptr will be: " << decoder_.get() << " (though not yet assigned)" << std::endl;
+    TX_LOG_DEBUG("FullResDecoderManager", "Manager created.");
 
-    const std::chrono::milliseconds highResUpdateInterval(18000); // Define interval constant here too
     decoder_ = std::make_unique<FullResDecoder>(filename_);
     if (!decoder_ || !decoder_->isInitialized()) {
-        std::cerr << "FullResDecoderManager Error: Failed to initialize FullResDecoder." << std::endl;
+        TX_LOG_ERROR("FullResDecoderManager", "Failed to initialize FullResDecoder.");
         throw std::runtime_error("Failed to initialize FullResDecoder in FullResDecoderManager");
     }
     // std::cout << "FullResDecoderManager: Initialized successfully." << std::endl;
 
-    // --- Perform initial decode during construction --- 
+    decodeInitialWindow();
+
+    // Initialize time point to epoch to ensure the first check passes
+    lastHighResUpdateTime_ = std::chrono::steady_clock::time_point(); 
+}
+
+// --- Initial decode, done before the thread runs (construction and setFile) ---
+void FullResDecoderManager::decodeInitialWindow() {
+    const std::chrono::milliseconds highResUpdateInterval(18000);
     if (decoder_ && !frameIndex_.empty()) {
-        // std::cout << "[FRDM Constructor] Performing initial decode..." << std::endl;
+        // std::cout << "[FRDM] Performing initial decode..." << std::endl;
         int initialFrame = 0; // Start centered at frame 0
         int windowSize = highResWindowSize_; // Get window size
         int sizeBehind = static_cast<int>(windowSize * 0.10);
@@ -60,19 +68,16 @@ FullResDecoderManager::FullResDecoderManager(
         if (initialStart <= initialEnd) {
             bool success = decoder_->decodeFrameRange(frameIndex_, initialStart, initialEnd);
             if (!success) {
-                std::cerr << "[FRDM Constructor] Warning: Initial decodeFrameRange failed for [" 
-                          << initialStart << "-" << initialEnd << "]" << std::endl;
+                TX_LOG_WARN("FullResDecoderManager", "Initial decodeFrameRange failed for ["
+                            << initialStart << "-" << initialEnd << "]");
             }
             // Schedule the next update after the initial decode
             nextScheduledHighResTime_ = std::chrono::steady_clock::now() + highResUpdateInterval;
-            // std::cout << "[FRDM Constructor] Initial decode finished. Next decode scheduled for: " << nextScheduledHighResTime_.time_since_epoch().count() << std::endl;
+            // std::cout << "[FRDM] Initial decode finished. Next decode scheduled for: " << nextScheduledHighResTime_.time_since_epoch().count() << std::endl;
         } else {
-            // std::cout << "[FRDM Constructor] Warning: Cannot perform initial decode, invalid range [" << initialStart << "-" << initialEnd << "]" << std::endl;
+            // std::cout << "[FRDM] Warning: Cannot perform initial decode, invalid range [" << initialStart << "-" << initialEnd << "]" << std::endl;
         }
     }
-
-    // Initialize time point to epoch to ensure the first check passes
-    lastHighResUpdateTime_ = std::chrono::steady_clock::time_point(); 
 }
 
 FullResDecoderManager::~FullResDecoderManager() {
@@ -96,14 +101,23 @@ FullResDecoderManager::~FullResDecoderManager() {
 
 void FullResDecoderManager::run() {
     if (isRunning_) {
+        if (suspendRequested_) {
+            // Parked by suspend(): the same thread carries on with the new file
+            { std::lock_guard<std::mutex> lock(mtx_); suspendRequested_ = false; }
+            cv_.notify_all();
+        }
         // std::cout << "FullResDecoderManager: Already running." << std::endl;
         return;
     }
     if (!decoder_ || !decoder_->isInitialized()) {
-        std::cerr << "FullResDecoderManager Error: Decoder not initialized. Cannot run." << std::endl;
+        TX_LOG_ERROR("FullResDecoderManager", "Decoder not initialized. Cannot run.");
         return;
     }
+    if (managerThread_.joinable()) {
+        managerThread_.join(); // The loop stopped itself (permanent HW failure)
+    }
     // std::cout << "FullResDecoderManager: Starting manager thread." << std::endl;
+    suspendRequested_ = false;
     stopRequested_ = false;
     isRunning_ = true;
     managerThread_ = std::thread(&FullResDecoderManager::decodingLoop, this);
@@ -114,12 +128,12 @@ void FullResDecoderManager::stop() {
         return;
     }
     
-    stopRequested_ = true;
+    { std::lock_guard<std::mutex> lock(mtx_); stopRequested_ = true; } // A parked loop waits without timeout
     
     // Cancel any ongoing async decode
     cancelOngoingDecode();
     
-    cv_.notify_one();
+    cv_.notify_all();
     
     if (managerThread_.joinable()) {
         managerThread_.join();
@@ -133,6 +147,62 @@ void FullResDecoderManager::stop() {
     }
 }
 
+void FullResDecoderManager::suspend() {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        suspendRequested_ = true;
+        cv_.notify_all();
+        // The loop sees the request between iterations; one that ended on its own never parks
+        while (isRunning_ && !parked_) {
+            parkedCv_.wait_for(lock, std::chrono::milliseconds(50));
+        }
+    }
+    // Nothing may still decode into frameIndex_ once it is handed over
+    cancelOngoingDecode();
+    {
+        std::lock_guard<std::mutex> lock(decodingFutureMutex_);
+        if (decodingFuture_.valid()) {
+            try {
+                decodingFuture_.get();
+            } catch (...) {
+                // The result no longer matters
+            }
+        }
+    }
+    if (decoder_) {
+        decoder_->clearHighResFrames(frameIndex_);
+    }
+}
+
+void FullResDecoderManager::setFile(const std::string& filename, int highResWindowSize) {
+    auto decoder = std::make_unique<FullResDecoder>(filename);
+    if (!decoder->isInitialized()) {
+        TX_LOG_ERROR("FullResDecoderManager", "Failed to initialize FullResDecoder for " << filename);
+        throw std::runtime_error("Failed to initialize FullResDecoder in FullResDecoderManager");
+    }
+    {
+        std::lock_guard<std::mutex> lock(activityCheckMutex_);
+        decoder_ = std::move(decoder);
+    }
+    filename_ = filename;
+    highResWindowSize_ = highResWindowSize;
+    current_decoder_hw_failed_permanently_ = false;
+    lastProcessedFrame_ = -1;
+    highResConditionsMetPreviously_ = false;
+    lastHighResUpdateTime_ = std::chrono::steady_clock::time_point();
+    nextScheduledHighResTime_ = std::chrono::steady_clock::now();
+    decodeInitialWindow();
+    TX_LOG_DEBUG("FullResDecoderManager", "Switched to " << filename_);
+}
+
+void FullResDecoderManager::parkWhileSuspended() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    parked_ = true;
+    parkedCv_.notify_all();
+    cv_.wait(lock, [&] { return stopRequested_.load() || !suspendRequested_.load(); });
+    parked_ = false;
+}
+
 void FullResDecoderManager::notifyFrameChange() {
     // std::cout << "FullResDecoderManager: Frame change notification received." << std::endl; 
     cv_.notify_one(); 
@@ -157,22 +227,28 @@ int getHighResUpdateIntervalMs(double playbackRateAbs, bool isReverse) {
 }
 
 void FullResDecoderManager::decodingLoop() {
-    std::cout << "[FRDM TID:" << std::this_thread::get_id() << "] decodingLoop ENTERED. Decoder ptr: " << decoder_.get() << std::endl;
-    std::cerr << "[FRDM TID:" << std::this_thread::get_id() << "] decodingLoop ENTERED. Decoder ptr: " << decoder_.get() << std::endl;
+    PerfTrace::setThreadName("full_res_manager");
+    TX_LOG_DEBUG("FullResDecoderManager", "decodingLoop ENTERED. Decoder ptr: " << decoder_.get());
 
     // std::cout << "FullResDecoderManager: Decoding loop started. Initial next scheduled time: " << nextScheduledHighResTime_.time_since_epoch().count() << std::endl;
     const std::chrono::milliseconds highResUpdateInterval(18000); // Keep interval definition here as well
     
     while (!stopRequested_) {
+        if (suspendRequested_.load()) {
+            parkWhileSuspended();
+            continue;
+        }
+
         // Check if manager should be active based on window size first
         if (!isHighResActive_.load()) {
             // If not active, just wait for conditions to change (e.g., window resize activation)
             // Or for stop request.
             std::unique_lock<std::mutex> lock(mtx_);
             cv_.wait_for(lock, std::chrono::milliseconds(500), [&] {
-                return stopRequested_.load() || isHighResActive_.load(); 
+                return stopRequested_.load() || suspendRequested_.load() || isHighResActive_.load(); 
             });
             if (stopRequested_.load()) break;
+            if (suspendRequested_.load()) continue;
             if (isHighResActive_.load()) {
                 // std::cout << "[FRDM] Woke up and now active, re-evaluating..." << std::endl;
             } else {
@@ -190,7 +266,7 @@ void FullResDecoderManager::decodingLoop() {
         bool justReturnedToHighRes = false; // Initialize here
 
         if (current_decoder_hw_failed_permanently_) {
-            std::cerr << "[FRDM TID:" << std::this_thread::get_id() << "] Loop stopping: Manager_hw_failed_flag IS TRUE. Decoder ptr: " << decoder_.get() << std::endl;
+            TX_LOG_WARN("FullResDecoderManager", "Loop stopping: Manager_hw_failed_flag IS TRUE. Decoder ptr: " << decoder_.get());
             stopRequested_ = true; 
             continue; 
         }
@@ -202,7 +278,7 @@ void FullResDecoderManager::decodingLoop() {
             // Timeout allows periodic checks even if paused or no notifications received
             if (!cv_.wait_for(lock, std::chrono::milliseconds(200), [&] {
                  // Wake if stop requested OR if the current frame is different from the last one processed
-                return stopRequested_.load() || currentFrame_.load() != lastProcessedFrame_;
+                return stopRequested_.load() || suspendRequested_.load() || currentFrame_.load() != lastProcessedFrame_;
             })) {
                 // Timeout occurred
                 currentFrame = currentFrame_.load(); // Re-check current frame
@@ -214,6 +290,7 @@ void FullResDecoderManager::decodingLoop() {
 
             // Check stop condition again after waking up
             if (stopRequested_) break;
+            if (suspendRequested_) continue;
 
             // Frame has changed or was notified
             currentFrame = currentFrame_.load(); // Get latest frame
@@ -293,21 +370,21 @@ void FullResDecoderManager::decodingLoop() {
                             try {
                                 bool prevResult = decodingFuture_.get();
                                 if (!prevResult && decoder_ && decoder_->isHardwareAccelerated() && decoder_->hasHardwareFailedIrrecoverably()) {
-                                    std::cerr << "[FRDM] Previous decode failed with HW error" << std::endl;
+                                    TX_LOG_ERROR("FullResDecoderManager", "Previous decode failed with HW error");
                                     current_decoder_hw_failed_permanently_ = true;
                                 }
                             } catch (...) {
-                                std::cerr << "[FRDM] Exception getting previous decode result" << std::endl;
+                                TX_LOG_WARN("FullResDecoderManager", "Exception getting previous decode result");
                             }
                         }
                     }
                 }
                 
                 // Launch async decode
-                std::cout << "[FRDM TID:" << std::this_thread::get_id() << "] Launching ASYNC decodeFrameRange. Decoder ptr: " << decoder_.get() 
-                          << ", isHW: " << (decoder_ ? decoder_->isHardwareAccelerated() : -1) 
-                          << ", hasHWfailed_flag: " << (decoder_ ? decoder_->hasHardwareFailedIrrecoverably() : -1) 
-                          << ", Range: [" << highResStart << "-" << highResEnd << "]" << std::endl;
+                TX_LOG_DEBUG("FullResDecoderManager", "Launching ASYNC decodeFrameRange. Decoder ptr: " << decoder_.get()
+                             << ", isHW: " << (decoder_ ? decoder_->isHardwareAccelerated() : -1)
+                             << ", hasHWfailed_flag: " << (decoder_ ? decoder_->hasHardwareFailedIrrecoverably() : -1)
+                             << ", Range: [" << highResStart << "-" << highResEnd << "]");
                 
                 {
                     std::lock_guard<std::mutex> lock(decodingFutureMutex_);
@@ -326,23 +403,17 @@ void FullResDecoderManager::decodingLoop() {
 
 // --- Cleanup (Restored from 10/04 version) --- 
             // Clean up frames outside the *new* high-res window. 
-            // This uses the static method. Needs careful synchronization if frameIndex is heavily shared.
+            // Eviction goes through the decoder's resident set, see FullResDecoder::removeHighResFrames.
             
             // // std::cout << "FullResDecoderManager: Cleaning frames outside [" << highResStart << "-" << highResEnd << "]" << std::endl;
-            // Clean before the window
-            if (highResStart > 0) {
-                 FullResDecoder::removeHighResFrames(frameIndex_, 0, highResStart - 1, highResStart, highResEnd);
-            }
-            // Clean after the window
-            if (highResEnd < static_cast<int>(frameIndex_.size()) - 1) {
-                 FullResDecoder::removeHighResFrames(frameIndex_, highResEnd + 1, frameIndex_.size() - 1, highResStart, highResEnd);
-            }
+            // Evict only the resident frames that left the window (no full-index sweep)
+            decoder_->removeHighResFrames(frameIndex_, highResStart, highResEnd);
             
              /* --- REMOVED: Aggressive clearing of all high-res frames when not at 1.0x speed ---
             // If high-res decoding is completely disabled (e.g., high speed), clear all high-res frames
             if (!highResConditionsMetNow) { // Use the current condition flag
                 // // std::cout << "FullResDecoderManager: High-res disabled, clearing all." << std::endl;
-                FullResDecoder::clearHighResFrames(frameIndex_);
+                decoder_->clearHighResFrames(frameIndex_);
             }
             */
 
@@ -388,9 +459,9 @@ void FullResDecoderManager::checkWindowSizeAndToggleActivity(int windowWidth, in
 
     if (isHighResActive_ && !shouldBeActive) {
         // Transitioning from active to inactive
-        std::cout << "[FRDM] Deactivating FullRes decoding due to small window size (" 
-                  << windowWidth << "x" << windowHeight << " vs native " 
-                  << nativeWidth << "x" << nativeHeight << ")." << std::endl;
+        TX_LOG_INFO("FullResDecoderManager", "Deactivating FullRes decoding due to small window size ("
+                    << windowWidth << "x" << windowHeight << " vs native "
+                    << nativeWidth << "x" << nativeHeight << ").");
         isHighResActive_ = false;
         
         // Cancel any ongoing async decode
@@ -399,8 +470,8 @@ void FullResDecoderManager::checkWindowSizeAndToggleActivity(int windowWidth, in
         decoder_->clearHighResFrames(frameIndex_); // Clear frames
     } else if (!isHighResActive_ && shouldBeActive) {
         // Transitioning from inactive to active
-        std::cout << "[FRDM] Activating FullRes decoding due to larger window size (" 
-                  << windowWidth << "x" << windowHeight << ")." << std::endl;
+        TX_LOG_INFO("FullResDecoderManager", "Activating FullRes decoding due to larger window size ("
+                    << windowWidth << "x" << windowHeight << ").");
         isHighResActive_ = true;
         // Notify the loop to re-evaluate decoding needs if it was paused due to inactivity
         cv_.notify_one(); 
@@ -430,15 +501,15 @@ void FullResDecoderManager::cancelOngoingDecode() {
         auto status = decodingFuture_.wait_for(std::chrono::milliseconds(100));
         
         if (status == std::future_status::timeout) {
-            std::cerr << "[FRDM] Warning: Decode operation did not finish within timeout after stop request" << std::endl;
+            TX_LOG_WARN("FullResDecoderManager", "Decode operation did not finish within timeout after stop request");
             // Note: we can't force-terminate the thread, but at least we tried
         } else {
             // Get the result to clear the future state
             try {
                 bool result = decodingFuture_.get();
-                std::cout << "[FRDM] Async decode cancelled, result was: " << result << std::endl;
+                TX_LOG_INFO("FullResDecoderManager", "Async decode cancelled, result was: " << result);
             } catch (const std::exception& e) {
-                std::cerr << "[FRDM] Exception while getting decode result: " << e.what() << std::endl;
+                TX_LOG_WARN("FullResDecoderManager", "Exception while getting decode result: " << e.what());
             }
         }
     }
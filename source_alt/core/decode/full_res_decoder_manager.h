@@ -27,10 +27,16 @@ public:
 
     ~FullResDecoderManager();
 
-    void run(); // Start the manager thread
+    void run(); // Start the manager thread, or resume it after setFile
     void stop(); // Stop the manager thread
     void notifyFrameChange(); // Notify about frame changes
 
+    // File switching without a new manager: suspend() parks the thread and drops
+    // this file's frames, setFile() opens the next file once frameIndex holds its
+    // index, run() resumes. Throws like the constructor if the file cannot be opened.
+    void suspend();
+    void setFile(const std::string& filename, int highResWindowSize);
+
     // Add getter for the decoder instance
     FullResDecoder* getDecoder() const;
 
@@ -40,6 +46,8 @@ public:
 
 private:
     void decodingLoop(); // The actual loop logic
+    void decodeInitialWindow(); // Window around frame 0, before the thread runs
+    void parkWhileSuspended(); // Loop thread only
 
     std::string filename_;                     // Store filename copy
     std::vector<FrameInfo>& frameIndex_;       // Reference to shared data
@@ -48,7 +56,7 @@ private:
     std::atomic<bool>& isPlaying_;             // Reference to shared data
     std::atomic<bool>& isReverse_;             // Added: Reference to shared data
     
-    const int highResWindowSize_;             // Store as const reference
+    int highResWindowSize_;                   // Per file, changed only while suspended
 
     // --- ADDED: Flag for permanent HW failure of the current decoder instance ---
     bool current_decoder_hw_failed_permanently_ = false;
@@ -61,6 +69,9 @@ private:
     std::condition_variable cv_;
     std::atomic<bool> isRunning_{false};
     std::atomic<bool> stopRequested_{false};
+    std::atomic<bool> suspendRequested_{false};
+    bool parked_ = false; // Loop is waiting in parkWhileSuspended, guarded by mtx_
+    std::condition_variable parkedCv_;
     int lastProcessedFrame_ = -1; // Track last frame processed
     std::chrono::steady_clock::time_point lastDecodeCheckTime_; // Time of last decode check/initiation
     std::chrono::steady_clock::time_point lastHighResUpdateTime_; // Added to throttle updates
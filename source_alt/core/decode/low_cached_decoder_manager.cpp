@@ -1,4 +1,6 @@
 #include "low_cached_decoder_manager.h"
+#include "../trace/perf_trace.h"
+#include "../log/logger.h"
 #include <iostream>
 #include <chrono>   // For std::chrono::milliseconds
 #include <algorithm> // For std::min, std::max
@@ -40,15 +42,58 @@ LowCachedDecoderManager::LowCachedDecoderManager(
     previousIsReverse_(isReverse_.load()) // Initialize previous direction
 {
     // std::cout << "LowCachedDecoderManager: Initializing..." << std::endl;
-    decoder_ = std::make_unique<LowResDecoder>(lowResFilename);
-    if (!decoder_ || !decoder_->isInitialized()) {
-        std::cerr << "LowCachedDecoderManager Error: Failed to initialize LowResDecoder." << std::endl;
+    openLevels(lowResFilename);
+    // std::cout << "LowCachedDecoderManager: Initialized successfully." << std::endl;
+    preloadInitialSegment();
+}
+
+// --- Opens the base proxy and every pyramid level next to it ---
+void LowCachedDecoderManager::openLevels(const std::string& lowResFilename) {
+    auto decoder = std::make_unique<LowResDecoder>(lowResFilename);
+    if (!decoder || !decoder->isInitialized()) {
+        TX_LOG_ERROR("LowCachedDecoderManager", "Failed to initialize LowResDecoder.");
         // Handle initialization failure, maybe throw an exception or set an error state
         throw std::runtime_error("Failed to initialize LowResDecoder in LowCachedDecoderManager");
     }
-    // std::cout << "LowCachedDecoderManager: Initialized successfully." << std::endl;
-    // lastLowResUpdateTime_ = std::chrono::steady_clock::time_point(); // Already initialized
+    // Open the other pyramid levels that exist next to the base proxy
+    std::vector<std::unique_ptr<LowResDecoder>> extraDecoders;
+    std::vector<std::pair<int, LowResDecoder*>> byWidth;
+    byWidth.emplace_back(decoder->getWidth(), decoder.get());
+    for (const auto& level : ProxyPyramid::availableLevels(lowResFilename)) {
+        if (level.divisor == 0) continue; // Base, already open
+        auto levelDecoder = std::make_unique<LowResDecoder>(level.filename);
+        if (!levelDecoder->isInitialized()) {
+            TX_LOG_WARN("LowCachedDecoderManager", "Skipping proxy level " << level.filename);
+            continue;
+        }
+        byWidth.emplace_back(levelDecoder->getWidth(), levelDecoder.get());
+        extraDecoders.push_back(std::move(levelDecoder));
+    }
+    std::sort(byWidth.begin(), byWidth.end(),
+              [](const std::pair<int, LowResDecoder*>& a, const std::pair<int, LowResDecoder*>& b) { return a.first < b.first; });
+    std::vector<int> levelWidths;
+    std::vector<LowResDecoder*> levels;
+    size_t baseLevel = 0;
+    for (size_t i = 0; i < byWidth.size(); ++i) {
+        levelWidths.push_back(byWidth[i].first);
+        levels.push_back(byWidth[i].second);
+        if (byWidth[i].second == decoder.get()) baseLevel = i;
+    }
+    // Nothing failed: replace the previous file's decoders, if any
+    levels_ = std::move(levels);
+    extraDecoders_ = std::move(extraDecoders);
+    decoder_ = std::move(decoder);
+    activeLevel_ = baseLevel; // Start on the base proxy until the output size is known
+    levelSelector_.configure(levelWidths, baseLevel);
+    if (levels_.size() > 1) {
+        std::ostringstream widths;
+        for (size_t i = 0; i < levelWidths.size(); ++i) widths << (i ? ", " : "") << levelWidths[i] << "px";
+        TX_LOG_INFO("LowCachedDecoderManager", "Proxy pyramid with " << levels_.size() << " levels (" << widths.str() << ")");
+    }
+}
 
+// --- Decodes the segment around the current frame, before the thread runs ---
+void LowCachedDecoderManager::preloadInitialSegment() {
     // Optional: Preload the initial segment(s)
     int initialSegment = currentFrame_.load() / segmentSize_;
     int startFrame = initialSegment * segmentSize_;
@@ -69,10 +114,16 @@ LowCachedDecoderManager::~LowCachedDecoderManager() {
 
 void LowCachedDecoderManager::run() {
     if (isRunning_) {
+        if (suspendRequested_) {
+            // Parked by suspend(): the same thread carries on with the new file
+            { std::lock_guard<std::mutex> lock(mtx_); suspendRequested_ = false; }
+            cv_.notify_all();
+        }
         // std::cout << "LowCachedDecoderManager: Already running." << std::endl;
         return;
     }
     // std::cout << "LowCachedDecoderManager: Starting manager thread." << std::endl;
+    suspendRequested_ = false;
     stopRequested_ = false;
     isRunning_ = true; // Set isRunning before starting the thread
     managerThread_ = std::thread(&LowCachedDecoderManager::decodingLoop, this);
@@ -83,16 +134,18 @@ void LowCachedDecoderManager::stop() {
         return;
     }
     
-    stopRequested_ = true;
+    { std::lock_guard<std::mutex> lock(mtx_); stopRequested_ = true; } // A parked loop waits without timeout
     
     // Aggressively stop any active decoders
     if (decoder_) {
-        decoder_->requestStop();
+        for (LowResDecoder* level : levels_) {
+            level->requestStop();
+        }
         // Give a very short time for the decoder to abort
         std::this_thread::sleep_for(std::chrono::milliseconds(5));
     }
     
-    cv_.notify_one();
+    cv_.notify_all();
     
     if (managerThread_.joinable()) {
         managerThread_.join();
@@ -101,16 +154,155 @@ void LowCachedDecoderManager::stop() {
     isRunning_ = false;
 }
 
+void LowCachedDecoderManager::suspend() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    suspendRequested_ = true;
+    // A segment decode in progress is abandoned, as on stop()
+    for (LowResDecoder* level : levels_) {
+        level->requestStop();
+    }
+    cv_.notify_all();
+    while (isRunning_ && !parked_) {
+        parkedCv_.wait_for(lock, std::chrono::milliseconds(50));
+    }
+}
+
+void LowCachedDecoderManager::setFile(const std::string& lowResFilename, int highResWindowSize) {
+    openLevels(lowResFilename);
+    highResWindowSize_ = highResWindowSize;
+    lastNotifiedFrame_ = -1;
+    lastLowResUpdateTime_ = std::chrono::steady_clock::time_point();
+    previousPlaybackRate_ = std::abs(playbackRate_.load());
+    previousIsReverse_ = isReverse_.load();
+    previousSegment_ = -1;
+    loadedSegments_.clear();
+    segmentStride_.clear();
+    sparseActive_ = false;
+    sparseLo_ = 0;
+    sparseHi_ = -1;
+    preloadInitialSegment();
+    TX_LOG_DEBUG("LowCachedDecoderManager", "Switched to " << lowResFilename);
+}
+
+void LowCachedDecoderManager::parkWhileSuspended() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    parked_ = true;
+    parkedCv_.notify_all();
+    cv_.wait(lock, [&] { return stopRequested_.load() || !suspendRequested_.load(); });
+    parked_ = false;
+}
+
 void LowCachedDecoderManager::notifyFrameChange() {
     // No need for mutex here, just notify
     // std::cout << "LowCachedDecoderManager: Frame change notification received." << std::endl; 
     cv_.notify_one(); 
 }
 
+void LowCachedDecoderManager::setOutputSize(int width, int height) {
+    levelSelector_.setOutputSize(width, height);
+    cv_.notify_one(); // Let the loop re-evaluate the level
+}
+
+void LowCachedDecoderManager::setDisplayRefreshRate(double hz) {
+    if (hz > 0) displayHz_ = hz;
+}
+
+int LowCachedDecoderManager::getActiveLevelWidth() const {
+    size_t level = activeLevel_.load();
+    return level < levels_.size() ? levels_[level]->getWidth() : 0;
+}
+
+// Low-res frames may come from any pyramid level, each level tracks its own residents
+void LowCachedDecoderManager::removeLowResRange(int startFrame, int endFrame) {
+    for (LowResDecoder* level : levels_) {
+        level->removeLowResFrames(frameIndex_, startFrame, endFrame);
+    }
+}
+
+// Only intra-only proxies can skip frames for free; a long-GOP proxy has to
+// decode every frame anyway, so storing all of them costs nothing extra
+int LowCachedDecoderManager::strideFor(double playbackRateAbs, const LowResDecoder* levelDecoder) const {
+    if (!levelDecoder || !levelDecoder->isIntraOnly()) return 1;
+    return ProxyPyramid::shuttleStride(playbackRateAbs, original_fps.load(), displayHz_.load());
+}
+
+bool LowCachedDecoderManager::segmentTooSparse(int segmentIndex, int wantedStride) const {
+    auto it = segmentStride_.find(segmentIndex);
+    return it != segmentStride_.end() && it->second > wantedStride;
+}
+
+// --- High-speed shuttle: decode only the frames the display will show ---
+// Targets are one stride apart over the next kSparseLookaheadSeconds of
+// display time. Targets with a resident low-res frame within half a stride
+// are skipped, and each remaining one is served by the keyframe-aligned seek
+// path, so a pass costs at most lookahead * (kSparseMaxWalk + 1) decodes no
+// matter how long the file is.
+void LowCachedDecoderManager::runSparseShuttle(int currentFrame, double playbackRateAbs) {
+    const int frameCount = static_cast<int>(frameIndex_.size());
+    if (frameCount == 0 || levels_.empty()) return;
+
+    size_t level = levelSelector_.choose(playbackRateAbs, original_fps.load());
+    activeLevel_ = level;
+    LowResDecoder* levelDecoder = levels_[level];
+
+    double hz = displayHz_.load();
+    int stride = ProxyPyramid::shuttleStride(playbackRateAbs, original_fps.load(), hz);
+    int halfStride = stride / 2;
+    int lookahead = std::max(1, static_cast<int>(hz * kSparseLookaheadSeconds));
+    int direction = isReverse_.load() ? -1 : 1;
+
+    // Keep the lookahead plus a short tail behind the playhead, drop the rest
+    int span = lookahead * stride;
+    int lo = std::max(0, direction > 0 ? currentFrame - span / 4 : currentFrame - span);
+    int hi = std::min(frameCount - 1, direction > 0 ? currentFrame + span : currentFrame + span / 4);
+    if (lo > 0) removeLowResRange(0, lo - 1);
+    if (hi < frameCount - 1) removeLowResRange(hi + 1, frameCount - 1);
+    sparseActive_ = true;
+    previousSegment_ = -1; // Force a segment pass once the speed drops again
+    sparseLo_ = lo;
+    sparseHi_ = hi;
+
+    std::vector<int> targets;
+    for (int k = 0; k < lookahead; ++k) {
+        int target = currentFrame + direction * k * stride;
+        if (target < 0 || target >= frameCount) break;
+        bool covered = false;
+        for (LowResDecoder* l : levels_) {
+            if (l->hasResidentIn(target - halfStride, target + halfStride)) { covered = true; break; }
+        }
+        if (!covered) targets.push_back(target);
+    }
+    if (targets.empty()) return;
+
+    auto decodeStart = std::chrono::steady_clock::now();
+    levelDecoder->decodeSparseFrames(frameIndex_, targets, halfStride, kSparseMaxWalk);
+    double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+    // Source frames covered per second, comparable with segment loads
+    levelSelector_.recordDecode(level, static_cast<int>(targets.size()) * stride, decodeSeconds);
+}
+
+void LowCachedDecoderManager::dropSparseOutsideSegments() {
+    if (!sparseActive_) return;
+    sparseActive_ = false;
+    if (sparseLo_ > sparseHi_ || segmentSize_ <= 0) return;
+    for (int seg = sparseLo_ / segmentSize_; seg <= sparseHi_ / segmentSize_; ++seg) {
+        if (loadedSegments_.count(seg)) continue; // Overwritten by the segment pass
+        int startFrame = std::max(sparseLo_, seg * segmentSize_);
+        int endFrame = std::min(sparseHi_, seg * segmentSize_ + segmentSize_ - 1);
+        removeLowResRange(startFrame, endFrame);
+    }
+}
+
 void LowCachedDecoderManager::decodingLoop() {
+    PerfTrace::setThreadName("low_cached_manager");
     // std::cout << "LowCachedDecoderManager: Decoding loop started." << std::endl;
     
     while (!stopRequested_) {
+        if (suspendRequested_.load()) {
+            parkWhileSuspended();
+            continue;
+        }
+
         int currentFrame = currentFrame_.load();
         double currentPlaybackRateAbs = std::abs(playbackRate_.load());
         double rateDifference = std::abs(currentPlaybackRateAbs - previousPlaybackRate_);
@@ -124,7 +316,7 @@ void LowCachedDecoderManager::decodingLoop() {
             // Wait only if playing or if the frame hasn't changed significantly since last check
             // Add a timeout to periodically check even if not notified
             if (!cv_.wait_for(lock, std::chrono::milliseconds(100), [&] {
-                return stopRequested_.load() || currentFrame_.load() != lastNotifiedFrame_;
+                return stopRequested_.load() || suspendRequested_.load() || currentFrame_.load() != lastNotifiedFrame_;
             })) {
                 // Timeout occurred, re-check conditions
                 currentFrame = currentFrame_.load(); // Get latest frame
@@ -136,6 +328,7 @@ void LowCachedDecoderManager::decodingLoop() {
 
             // Check stop condition again after waking up
             if (stopRequested_) break;
+            if (suspendRequested_) continue;
 
             // Frame has changed or was notified
             currentFrame = currentFrame_.load(); // Get latest frame after wait
@@ -147,7 +340,7 @@ void LowCachedDecoderManager::decodingLoop() {
             }
         } // Lock released here
 
-        // --- Speed Check: Disable and Clear if Speed >= threshold ---
+        // --- Speed Check: Switch to sparse shuttle if Speed >= threshold ---
         if (currentPlaybackRateAbs >= speed_threshold.load()) {
             std::set<int> segmentsToClear; // Temporary set to hold segments for clearing
             bool hadSegmentsToClear = false;
@@ -161,6 +354,7 @@ void LowCachedDecoderManager::decodingLoop() {
                               // << loadedSegments_.size() << " loaded low-res segments." << std::endl;
                     segmentsToClear = loadedSegments_;
                     loadedSegments_.clear();          // Clear the original set immediately
+                    segmentStride_.clear();
                     previousSegment_ = -1;            // Reset segment tracking
                 }
             } // Mutex released
@@ -173,7 +367,7 @@ void LowCachedDecoderManager::decodingLoop() {
                     int endFrame = std::min(startFrame + segmentSize_ - 1, 
                                             static_cast<int>(frameIndex_.size()) - 1); 
                     if (startFrame <= endFrame) { // Ensure valid range before calling remove
-                       LowResDecoder::removeLowResFrames(frameIndex_, startFrame, endFrame);
+                       removeLowResRange(startFrame, endFrame);
                        // std::cout << "LowCachedDecoderManager: Cleared low-res segment " << segIdx << std::endl; // Optional log
                     }
                 }
@@ -181,6 +375,9 @@ void LowCachedDecoderManager::decodingLoop() {
                  // std::cout << "LowCachedDecoderManager: Finished clearing low-res segments." << std::endl;
             }
 
+            // Segments are gone; serve only the frames that will be displayed
+            runSparseShuttle(currentFrame, currentPlaybackRateAbs);
+
             // Skip the rest of the segment logic for this iteration
             continue; 
 
@@ -192,8 +389,18 @@ void LowCachedDecoderManager::decodingLoop() {
                 bool segmentChanged = (currentSegment != previousSegment_);
                 bool directionChanged = (isReverse_.load() != previousIsReverse_);
 
-                // --- Force immediate update if segment changed OR direction changed --- 
-                if (segmentChanged || directionChanged) {
+                // --- Pick the pyramid level for the current speed / output size / budget ---
+                size_t wantedLevel = levelSelector_.choose(currentPlaybackRateAbs, original_fps.load());
+                bool levelChanged = (wantedLevel != activeLevel_.load());
+                if (levelChanged) {
+                    TX_LOG_INFO("LowCachedDecoderManager", "Proxy level " << levels_[activeLevel_.load()]->getWidth()
+                                << "px -> " << levels_[wantedLevel]->getWidth() << "px at " << currentPlaybackRateAbs << "x");
+                    activeLevel_ = wantedLevel;
+                }
+                int wantedStride = strideFor(currentPlaybackRateAbs, levels_[activeLevel_.load()]);
+
+                // --- Force immediate update if segment, direction or level changed --- 
+                if (segmentChanged || directionChanged || levelChanged) {
                      // if (segmentChanged) {
                          // std::cout << "LowCachedDecoderManager: Segment changed to " << currentSegment << ". Forcing update." << std::endl;
                      // } else { // directionChanged
@@ -215,18 +422,24 @@ void LowCachedDecoderManager::decodingLoop() {
                       std::set<int> segmentsToUnload = loadedSegments_;
                       for (int targetSeg : targetSegments) {
                           if (targetSeg >= 0 && targetSeg < numSegmentsTotal) {
-                              if (loadedSegments_.find(targetSeg) == loadedSegments_.end()) { segmentsToLoad.insert(targetSeg); }
+                              if (levelChanged || loadedSegments_.find(targetSeg) == loadedSegments_.end() ||
+                                  segmentTooSparse(targetSeg, wantedStride)) { segmentsToLoad.insert(targetSeg); }
                               segmentsToUnload.erase(targetSeg);
                           }
                       }
+                      // On a level change (or when a segment was decoded at a coarser stride)
+                      // target segments are re-decoded in place: the new pass overwrites
+                      // low_res_frame so the display never sees a gap.
+                      for (int segIdx : segmentsToLoad) loadedSegments_.erase(segIdx);
 
                       // Unload immediately
                       for (int segIdx : segmentsToUnload) {
                           int startFrame = segIdx * segmentSize_;
                           int endFrame = startFrame + segmentSize_ - 1;
                           // std::cout << "LowCachedDecoderManager: Unloading segment (forced) " << segIdx << " [" << startFrame << "-" << endFrame << "]" << std::endl;
-                          LowResDecoder::removeLowResFrames(frameIndex_, startFrame, endFrame);
+                          removeLowResRange(startFrame, endFrame);
                           loadedSegments_.erase(segIdx);
+                          segmentStride_.erase(segIdx);
                       }
 
                       // Load immediately, prioritizing current segment
@@ -276,11 +489,14 @@ void LowCachedDecoderManager::decodingLoop() {
                         if (targetSeg >= 0 && targetSeg < numSegmentsTotal) { // Check bounds
                             if (loadedSegments_.find(targetSeg) == loadedSegments_.end()) {
                                 segmentsToLoad.insert(targetSeg); // Not loaded, needs loading
+                            } else if (segmentTooSparse(targetSeg, wantedStride)) {
+                                segmentsToLoad.insert(targetSeg); // Slowed down since it was loaded
                             }
                         }
                     }
 
                     if (!segmentsToLoad.empty() && (timeSinceLastUpdate >= lowResUpdateInterval || forceUpdateDueToRateChange)) {
+                         for (int segIdx : segmentsToLoad) loadedSegments_.erase(segIdx);
                          // Prioritize loading current segment if needed within interval/rate check
                          if (segmentsToLoad.count(currentSegment)) {
                              // std::cout << "  Prioritizing load of current segment (interval/rate): " << currentSegment << std::endl;
@@ -296,6 +512,10 @@ void LowCachedDecoderManager::decodingLoop() {
                     // Update segment tracker even if no load happened, as frame moved within segment
                     previousSegment_ = currentSegment; 
                 }
+
+                // Back from sparse shuttle: the forced update above loaded the target
+                // segments, now release the sparse frames nothing else owns
+                dropSparseOutsideSegments();
             } // end if(decoder_ && !frameIndex_.empty() ...)
         } // end else (speed < threshold)
 
@@ -318,7 +538,7 @@ void LowCachedDecoderManager::decodingLoop() {
 // --- Helper function to load a segment --- 
 void LowCachedDecoderManager::loadSegment(int segmentIndex) {
     if (!decoder_ || !decoder_->isInitialized()) { 
-         std::cerr << "LowCachedDecoderManager Error: Decoder not initialized in loadSegment." << std::endl;
+         TX_LOG_ERROR("LowCachedDecoderManager", "Decoder not initialized in loadSegment.");
          return;
     }
     if (frameIndex_.empty() || segmentSize_ <= 0) return;
@@ -346,14 +566,25 @@ void LowCachedDecoderManager::loadSegment(int segmentIndex) {
     int highResStart = std::max(0, currentFrame - highResHalfSize);
     int highResEnd = std::min(static_cast<int>(frameIndex_.size()) - 1, currentFrame + highResHalfSize);
 
-    bool success = decoder_->decodeLowResRange(frameIndex_, startFrame, endFrame, highResStart, highResEnd, false);
+    size_t level = activeLevel_.load();
+    LowResDecoder* levelDecoder = level < levels_.size() ? levels_[level] : decoder_.get();
+
+    int stride = strideFor(std::abs(playbackRate_.load()), levelDecoder);
+
+    auto decodeStart = std::chrono::steady_clock::now();
+    bool success = levelDecoder->decodeLowResRange(frameIndex_, startFrame, endFrame, highResStart, highResEnd, false, stride);
+    double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+    if (success) {
+        levelSelector_.recordDecode(level, endFrame - startFrame + 1, decodeSeconds);
+    }
 
     if (success) {
         std::lock_guard<std::mutex> lock(mtx_);
         loadedSegments_.insert(segmentIndex); // Add to set *after* successful load
+        segmentStride_[segmentIndex] = stride;
         // std::cout << "LowCachedDecoderManager: Successfully loaded segment " << segmentIndex << ". Total loaded: " << loadedSegments_.size() << std::endl;
     } else {
-        std::cerr << "LowCachedDecoderManager Warning: Failed to load segment " << segmentIndex << std::endl;
+        TX_LOG_WARN("LowCachedDecoderManager", "Failed to load segment " << segmentIndex);
         // Optional: remove from loading set if used
     }
 }
@@ -365,6 +596,7 @@ void LowCachedDecoderManager::unloadSegment(int segmentIndex) {
         std::lock_guard<std::mutex> lock(mtx_);
         if (loadedSegments_.count(segmentIndex)) {
             loadedSegments_.erase(segmentIndex);
+            segmentStride_.erase(segmentIndex);
             shouldRemove = true;
         }
     }
@@ -374,7 +606,7 @@ void LowCachedDecoderManager::unloadSegment(int segmentIndex) {
         int endFrame = std::min(startFrame + segmentSize_ - 1, static_cast<int>(frameIndex_.size()) - 1);
         if (startFrame <= endFrame) {
             // std::cout << "LowCachedDecoderManager: Unloading segment " << segmentIndex << " [" << startFrame << "-" << endFrame << "]" << std::endl;
-            LowResDecoder::removeLowResFrames(frameIndex_, startFrame, endFrame);
+            removeLowResRange(startFrame, endFrame);
         }
     }
 }
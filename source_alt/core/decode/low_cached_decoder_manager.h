@@ -10,8 +10,10 @@
 #include <memory> // For std::unique_ptr
 #include <chrono> // Added for time point
 #include <set>    // Added for segment tracking
+#include <map>
 
 #include "low_res_decoder.h" // Include the decoder it manages
+#include "proxy_pyramid.h"
 #include "decode.h" // Includes FrameInfo definition
 
 class LowCachedDecoderManager {
@@ -35,7 +37,7 @@ public:
     LowCachedDecoderManager(const LowCachedDecoderManager&) = delete;
     LowCachedDecoderManager& operator=(const LowCachedDecoderManager&) = delete;
 
-    // Start the manager's background thread
+    // Start the manager's background thread, or resume it after setFile
     void run();
 
     // Stop the manager's background thread
@@ -44,13 +46,36 @@ public:
     // Notify the manager about a potential seek or change in current frame
     void notifyFrameChange(); 
 
+    // File switching without a new manager: suspend() parks the thread, setFile()
+    // opens the next proxy and its levels once frameIndex holds the new index,
+    // run() resumes. Throws like the constructor if the proxy cannot be opened.
+    void suspend();
+    void setFile(const std::string& lowResFilename, int highResWindowSize);
+
+    // Output size in pixels, used to pick the proxy pyramid level
+    void setOutputSize(int width, int height);
+    int getActiveLevelWidth() const;
+
+    // Refresh rate of the display the window is on; bounds the shuttle stride
+    void setDisplayRefreshRate(double hz);
+
 private:
     // The main loop running on the background thread
     void decodingLoop();
+    void openLevels(const std::string& lowResFilename); // Replaces decoder_, levels_ only on success
+    void preloadInitialSegment();
+    void parkWhileSuspended(); // Loop thread only
 
-    // The decoder instance responsible for low-res decoding
+    // The decoder instance responsible for low-res decoding (base 640px proxy)
     std::unique_ptr<LowResDecoder> decoder_;
 
+    // Proxy pyramid: one decoder per available level, sorted by width.
+    // levels_ holds non-owning pointers and includes decoder_.
+    std::vector<std::unique_ptr<LowResDecoder>> extraDecoders_;
+    std::vector<LowResDecoder*> levels_;
+    std::atomic<size_t> activeLevel_{0};
+    ProxyLevelSelector levelSelector_;
+
     // Shared data references
     std::vector<FrameInfo>& frameIndex_;
     std::atomic<int>& currentFrame_;
@@ -69,18 +94,35 @@ private:
     std::condition_variable cv_;
     std::atomic<bool> isRunning_{false};
     std::atomic<bool> stopRequested_{false};
+    std::atomic<bool> suspendRequested_{false};
+    bool parked_ = false; // Loop is waiting in parkWhileSuspended, guarded by mtx_
+    std::condition_variable parkedCv_;
     
     // Internal state for the decoding loop
     int lastNotifiedFrame_ = -1; // To track changes in currentFrame_
     std::chrono::steady_clock::time_point lastLowResUpdateTime_; // Added
     double previousPlaybackRate_ = 0.0; // Added
     std::set<int> loadedSegments_; // Added - tracks loaded segment indices
+    std::map<int, int> segmentStride_; // Stride each loaded segment was decoded with (1 = every frame)
+    std::atomic<double> displayHz_{60.0};
+
+    // Sparse shuttle above speed_threshold: window of frames it may have filled
+    static constexpr double kSparseLookaheadSeconds = 0.5; // Displayed frames requested ahead
+    static constexpr int kSparseMaxWalk = 12;              // Max frames decoded past a keyframe per target
+    bool sparseActive_ = false;
+    int sparseLo_ = 0;
+    int sparseHi_ = -1;
     int previousSegment_ = -1; // Added - tracks last processed segment index
     bool previousIsReverse_ = false; // Added - tracks last direction state
 
     // Private methods
     void loadSegment(int segmentIndex);   // Declaration added
     void unloadSegment(int segmentIndex); // Declaration added
+    void removeLowResRange(int startFrame, int endFrame); // Through every level's resident set
+    int strideFor(double playbackRateAbs, const LowResDecoder* levelDecoder) const; // 1 unless the proxy is intra-only
+    bool segmentTooSparse(int segmentIndex, int wantedStride) const; // Loaded with a larger stride than wanted now
+    void runSparseShuttle(int currentFrame, double playbackRateAbs);
+    void dropSparseOutsideSegments(); // After leaving sparse mode, keep only what loaded segments cover
 };
 
 #endif // LOW_CACHED_DECODER_MANAGER_H 
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "low_res_decoder.h"
 #include "decode.h"
+#include "proxy_pyramid.h"
+#include "../trace/perf_trace.h"
+#include "../log/logger.h"
+#include "../trace/metrics.h"
 #include <iostream>
 #include <filesystem>
 #include <thread>
@@ -10,11 +14,16 @@
 #include <cmath> // For std::abs in timestamp comparison
 #include <atomic> // Include atomic header
 #include <cstdio> // For popen, pclose, fgets
+#include <cstring> // For strcspn
 #include <string>
 #include <algorithm> // For std::min
 #include <vector> // For storing ffprobe output lines
 #include <cstdlib> // For atof
 #include <functional> // For std::function
+#include <deque>
+#include <set>
+#include <mutex>
+#include <condition_variable>
 #include <mach-o/dyld.h>
 #include <limits.h>
 
@@ -51,12 +60,12 @@ LowResDecoder::LowResDecoder(const std::string& lowResFilename)
       pixFmt_(AV_PIX_FMT_NONE), 
       stop_requested_(false) 
 {
-    std::cout << "LowResDecoder created for: " << lowResFilename_ << std::endl;
+    TX_LOG_INFO("LowResDecoder", "created for: " << lowResFilename_);
     initialized_ = initialize(); // Call initialize on construction
 }
 
 LowResDecoder::~LowResDecoder() {
-    std::cout << "LowResDecoder destroyed for: " << lowResFilename_ << std::endl;
+    TX_LOG_INFO("LowResDecoder", "destroyed for: " << lowResFilename_);
     cleanup(); // Call cleanup on destruction
 }
 
@@ -67,14 +76,14 @@ bool LowResDecoder::initialize() {
 
     // Open input file
     if (avformat_open_input(&formatCtx_, lowResFilename_.c_str(), nullptr, nullptr) != 0) {
-        std::cerr << "LowResDecoder Error: Failed to open file " << lowResFilename_ << std::endl;
+        TX_LOG_ERROR("LowResDecoder", "Failed to open file " << lowResFilename_);
         cleanup();
         return false;
     }
 
     // Find stream info
     if (avformat_find_stream_info(formatCtx_, nullptr) < 0) {
-        std::cerr << "LowResDecoder Error: Failed to find stream information for " << lowResFilename_ << std::endl;
+        TX_LOG_ERROR("LowResDecoder", "Failed to find stream information for " << lowResFilename_);
         cleanup();
         return false;
     }
@@ -83,7 +92,7 @@ bool LowResDecoder::initialize() {
     const AVCodec* codec = nullptr; 
     videoStreamIndex_ = av_find_best_stream(formatCtx_, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
     if (videoStreamIndex_ < 0 || !codec) {
-        std::cerr << "LowResDecoder Error: Video stream not found or codec could not be found in " << lowResFilename_ << std::endl;
+        TX_LOG_ERROR("LowResDecoder", "Video stream not found or codec could not be found in " << lowResFilename_);
         cleanup();
         return false;
     }
@@ -93,14 +102,14 @@ bool LowResDecoder::initialize() {
     // Allocate codec context
     codecCtx_ = avcodec_alloc_context3(codec);
     if (!codecCtx_) {
-        std::cerr << "LowResDecoder Error: Failed to allocate codec context" << std::endl;
+        TX_LOG_ERROR("LowResDecoder", "Failed to allocate codec context");
         cleanup();
         return false;
     }
 
     // Copy codec parameters to context
     if (avcodec_parameters_to_context(codecCtx_, codecParams_) < 0) {
-        std::cerr << "LowResDecoder Error: Failed to copy codec parameters to context" << std::endl;
+        TX_LOG_ERROR("LowResDecoder", "Failed to copy codec parameters to context");
         cleanup();
         return false;
     }
@@ -111,7 +120,7 @@ bool LowResDecoder::initialize() {
 
     // Open codec
     if (avcodec_open2(codecCtx_, codec, nullptr) < 0) {
-        std::cerr << "LowResDecoder Error: Failed to open codec" << std::endl;
+        TX_LOG_ERROR("LowResDecoder", "Failed to open codec");
         cleanup();
         return false;
     }
@@ -120,6 +129,19 @@ bool LowResDecoder::initialize() {
     width_ = codecCtx_->width;
     height_ = codecCtx_->height;
     pixFmt_ = codecCtx_->pix_fmt;
+    profile_ = ProxyPyramid::detectProfile(formatCtx_, videoStreamIndex_);
+
+    // Keyframe times for the sparse shuttle path
+    keyframeMs_.clear();
+    int64_t streamStart = (videoStream_->start_time != AV_NOPTS_VALUE) ? videoStream_->start_time : 0;
+    int indexEntries = avformat_index_get_entries_count(videoStream_);
+    for (int i = 0; i < indexEntries; ++i) {
+        const AVIndexEntry* entry = avformat_index_get_entry(videoStream_, i);
+        if (entry && (entry->flags & AVINDEX_KEYFRAME)) {
+            keyframeMs_.push_back(av_rescale_q(entry->timestamp - streamStart, videoStream_->time_base, {1, 1000}));
+        }
+    }
+    std::sort(keyframeMs_.begin(), keyframeMs_.end());
 
     // SwsContext for potential future format conversions (e.g., to RGB)
     // Initialize only if needed, or consider initializing it on demand later.
@@ -128,15 +150,16 @@ bool LowResDecoder::initialize() {
                              width_, height_, AV_PIX_FMT_RGB24, // Example target format
                              SWS_BILINEAR, nullptr, nullptr, nullptr);
     if (!swsCtx_) {
-        std::cerr << "LowResDecoder Warning: Failed to create SwsContext" << std::endl;
+        TX_LOG_WARN("LowResDecoder", "Failed to create SwsContext");
         // This might not be fatal if conversion isn't strictly required initially
     }
     */
 
-    std::cout << "LowResDecoder initialized successfully for " << lowResFilename_ << std::endl;
-    std::cout << "  Resolution: " << width_ << "x" << height_ << std::endl;
-    std::cout << "  Pixel Format: " << (pixFmt_ != AV_PIX_FMT_NONE ? av_get_pix_fmt_name(pixFmt_) : "N/A") << std::endl;
-    std::cout << "  Time Base: " << videoStream_->time_base.num << "/" << videoStream_->time_base.den << std::endl;
+    TX_LOG_INFO("LowResDecoder", "initialized successfully for " << lowResFilename_);
+    TX_LOG_INFO("LowResDecoder", "  Resolution: " << width_ << "x" << height_);
+    TX_LOG_INFO("LowResDecoder", "  Pixel Format: " << (pixFmt_ != AV_PIX_FMT_NONE ? av_get_pix_fmt_name(pixFmt_) : "N/A"));
+    TX_LOG_INFO("LowResDecoder", "  Time Base: " << videoStream_->time_base.num << "/" << videoStream_->time_base.den);
+    TX_LOG_INFO("LowResDecoder", "  Proxy Profile: " << ProxyPyramid::profileName(profile_) << " (" << keyframeMs_.size() << " keyframes)");
     
     initialized_ = true;
     return true;
@@ -164,7 +187,7 @@ void LowResDecoder::cleanup() {
     height_ = 0;
     pixFmt_ = AV_PIX_FMT_NONE;
     stop_requested_ = false; // Reset stop flag on cleanup? (Consider lifecycle)
-    std::cout << "LowResDecoder cleaned up." << std::endl;
+    TX_LOG_INFO("LowResDecoder", "cleaned up.");
 }
 
 // --- Public method to request stop --- 
@@ -172,11 +195,14 @@ void LowResDecoder::requestStop() {
     // Set the stop flag first
     stop_requested_ = true;
     
-    // Note: For LowResDecoder, we don't close any contexts here because:
-    // 1. The decoder uses thread-local contexts in decodeLowResRange
-    // 2. Member contexts (formatCtx_, codecCtx_) are only used for initialization info
-    // 3. Closing them here would break subsequent decode attempts
-    // The contexts will be properly cleaned up in the destructor
+    // Only the flag is set, no context is closed here:
+    // 1. decodeLowResRange opens its own contexts for each call
+    // 2. decodeSparseFrames decodes through the member contexts (formatCtx_, codecCtx_),
+    //    so closing them could pull them out from under a sparse decode in progress
+    // 3. The decoder stays usable: every decode clears the flag when it starts
+    // The member contexts are freed by cleanup() in the destructor. A sparse decode
+    // must have returned before the decoder is destroyed; the managers join their
+    // thread (stop) or park it (suspend) before they release a decoder.
 }
 
 // --- Static Methods --- 
@@ -273,37 +299,16 @@ double getVideoDuration(const std::string& filename) {
     }
 }
 
-bool LowResDecoder::convertToLowRes(const std::string& filename, std::string& outputFilename, const std::function<void(int)>& progressCallback) {
-    std::string cacheDir = getCachePath();
-    fs::create_directories(cacheDir);
-
-    std::string fileId = generateFileId(filename);
-    if (fileId.empty()) {
-        std::cerr << "Error generating file ID" << std::endl;
-        return false;
-    }
+namespace {
 
-    std::string cachePath = cacheDir + "/" + fileId + "_lowres.mp4";
+struct ProxyOutput {
+    int width;
+    int bitrateKbps;
+    std::string path;
+};
 
-    if (fs::exists(cachePath)) {
-        std::cout << "Found cached low-resolution file: " << cachePath << std::endl;
-        outputFilename = cachePath;
-        if (progressCallback) {
-            progressCallback(100);
-        }
-        return true;
-    }
-
-    // --- Get Video Duration ---
-    double totalDuration = getVideoDuration(filename);
-    if (totalDuration <= 0) {
-        std::cerr << "Could not determine video duration. Progress reporting will be inaccurate." << std::endl;
-    } else {
-         std::cout << "Total video duration: " << totalDuration << " seconds." << std::endl;
-    }
-    // --- End Get Video Duration ---
-
-    // Find ffmpeg executable
+// System ffmpeg, else the one bundled in the app's Resources; empty if neither
+std::string findFfmpeg() {
     std::string ffmpegPath;
     
     // First try system ffmpeg
@@ -334,16 +339,56 @@ bool LowResDecoder::convertToLowRes(const std::string& filename, std::string& ou
                 // Check if bundled ffmpeg exists and is executable
                 if (!fs::exists(ffmpegPath) || access(ffmpegPath.c_str(), X_OK) != 0) {
                     std::cerr << "Neither system nor bundled ffmpeg found!" << std::endl;
-                    return false;
+                    return "";
                 }
             }
         }
     }
 
+    return ffmpegPath;
+}
+
+// Encodes every output from a single decode of the source: the video is split
+// once and each branch scaled. Outputs are written under a temporary name and
+// renamed into place when ffmpeg succeeds, so an interrupted run never leaves
+// a truncated proxy that a later open would take for a finished one.
+bool encodeProxies(const std::string& filename, const std::vector<ProxyOutput>& outputs, ProxyProfile profile,
+                   const std::function<void(int)>& progressCallback) {
+    // --- Get Video Duration ---
+    double totalDuration = getVideoDuration(filename);
+    if (totalDuration <= 0) {
+        std::cerr << "Could not determine video duration. Progress reporting will be inaccurate." << std::endl;
+    } else {
+         std::cout << "Total video duration: " << totalDuration << " seconds." << std::endl;
+    }
+    // --- End Get Video Duration ---
+
+    std::string ffmpegPath = findFfmpeg();
+    if (ffmpegPath.empty()) {
+        return false;
+    }
     std::cout << "Using ffmpeg from: " << ffmpegPath << std::endl;
 
     // Create FFmpeg command for low-res conversion without audio (-an)
-    std::string command = "\"" + ffmpegPath + "\" -nostdin -y -i \"" + filename + "\" -vf \"scale=640:-2\" -c:v libx264 -profile:v baseline -preset medium -b:v 500k -an \"" + cachePath + "\" 2>&1";
+    std::vector<std::string> partialPaths;
+    std::string filterGraph = "[0:v]split=" + std::to_string(outputs.size());
+    std::string scaleChains;
+    std::string outputArgs;
+    for (size_t branch = 0; branch < outputs.size(); ++branch) {
+        const ProxyOutput& output = outputs[branch];
+        fs::path partial(output.path);
+        partial.replace_extension(".partial" + fs::path(output.path).extension().string());
+        std::string in = "[s" + std::to_string(branch) + "]";
+        std::string out = "[v" + std::to_string(branch) + "]";
+        filterGraph += in;
+        scaleChains += ";" + in + "scale=" + std::to_string(output.width) + ":-2" + out;
+        outputArgs += " -map \"" + out + "\" " + ProxyPyramid::encoderArgs(profile, output.bitrateKbps) +
+                      " -an \"" + partial.string() + "\"";
+        partialPaths.push_back(partial.string());
+    }
+
+    std::string command = "\"" + ffmpegPath + "\" -nostdin -y -i \"" + filename + "\" -filter_complex \"" +
+                          filterGraph + scaleChains + "\"" + outputArgs + " 2>&1";
 
     FILE* pipe = popen(command.c_str(), "r");
     if (!pipe) {
@@ -363,6 +408,7 @@ bool LowResDecoder::convertToLowRes(const std::string& filename, std::string& ou
              } else {
                  std::cerr << "Error reading FFmpeg output pipe." << std::endl;
                  pclose(pipe);
+                 for (const auto& path : partialPaths) fs::remove(path);
                  return false;
              }
          }
@@ -411,10 +457,98 @@ bool LowResDecoder::convertToLowRes(const std::string& filename, std::string& ou
     if (status != 0) {
         std::cerr << "FFmpeg command failed with status " << status << std::endl;
         std::cerr << "FFmpeg output:\n" << result << std::endl;
-        fs::remove(cachePath); 
+        for (const auto& path : partialPaths) {
+            fs::remove(path);
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        std::error_code ec;
+        fs::rename(partialPaths[i], outputs[i].path, ec);
+        if (ec) {
+            std::cerr << "Cannot move " << partialPaths[i] << " into place: " << ec.message() << std::endl;
+            fs::remove(partialPaths[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pyramid levels being built by buildMissingLevels, by base proxy path. Never
+// destroyed: a background build may still be running at exit.
+struct LevelBuilds {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::set<std::string> running;
+};
+
+LevelBuilds& levelBuilds() {
+    static LevelBuilds* instance = new LevelBuilds();
+    return *instance;
+}
+
+std::vector<ProxyLevel> missingLevels(const std::string& filename, const std::string& cachePath) {
+    int sourceWidth = 0, sourceHeight = 0;
+    get_video_dimensions(filename.c_str(), &sourceWidth, &sourceHeight);
+    std::vector<ProxyLevel> missing;
+    for (const auto& level : ProxyPyramid::plannedLevels(cachePath, sourceWidth)) {
+        if (!fs::exists(level.filename)) {
+            missing.push_back(level);
+        }
+    }
+    return missing;
+}
+
+} // namespace
+
+bool LowResDecoder::convertToLowRes(const std::string& filename, std::string& outputFilename, const std::function<void(int)>& progressCallback) {
+    return convertToLowRes(filename, outputFilename, progressCallback, ProxyPyramid::configuredProfile(), true);
+}
+
+bool LowResDecoder::convertToLowRes(const std::string& filename, std::string& outputFilename, const std::function<void(int)>& progressCallback,
+                                    ProxyProfile profile, bool withPyramid) {
+    std::string cacheDir = getCachePath();
+    fs::create_directories(cacheDir);
+
+    std::string fileId = generateFileId(filename);
+    if (fileId.empty()) {
+        std::cerr << "Error generating file ID" << std::endl;
         return false;
     }
 
+    std::string cachePath = cacheDir + "/" + fileId + ProxyPyramid::baseSuffix(profile);
+
+    if (fs::exists(cachePath)) {
+        std::cout << "Found cached low-resolution file: " << cachePath << std::endl;
+        outputFilename = cachePath;
+        if (progressCallback) {
+            progressCallback(100);
+        }
+        // A base proxy from before the pyramid, or whose levels were evicted: the
+        // file opens now and the levels follow; availableLevels() copes meanwhile
+        if (withPyramid && !missingLevels(filename, cachePath).empty()) {
+            std::thread([filename, profile] { buildMissingLevels(filename, profile); }).detach();
+        }
+        return true;
+    }
+
+    // The base proxy and every pyramid level come out of a single decode of the source
+    std::vector<ProxyOutput> outputs{{640, 500, cachePath}};
+    if (withPyramid) {
+        for (const auto& level : missingLevels(filename, cachePath)) {
+            outputs.push_back({level.width, ProxyPyramid::levelBitrateKbps(level.width), level.filename});
+            std::cout << "Generating proxy level 1/" << level.divisor << " (" << level.width << "px): " << level.filename << std::endl;
+        }
+    }
+    if (!encodeProxies(filename, outputs, profile, progressCallback)) {
+        // The levels are optional; the file opens with the base proxy alone
+        if (outputs.size() == 1) return false;
+        std::cerr << "Proxy levels failed; creating the base proxy alone" << std::endl;
+        outputs.resize(1);
+        if (!encodeProxies(filename, outputs, profile, progressCallback)) return false;
+    }
+
     outputFilename = cachePath;
 
     if (progressCallback) {
@@ -425,10 +559,42 @@ bool LowResDecoder::convertToLowRes(const std::string& filename, std::string& ou
     return true;
 }
 
-// --- Static Methods ---
+bool LowResDecoder::buildMissingLevels(const std::string& filename, ProxyProfile profile) {
+    std::string fileId = generateFileId(filename);
+    if (fileId.empty()) return false;
+    std::string cachePath = getCachePath() + "/" + fileId + ProxyPyramid::baseSuffix(profile);
+
+    LevelBuilds& builds = levelBuilds();
+    {
+        // One build per proxy; a second caller waits for it and then finds the levels there
+        std::unique_lock<std::mutex> lock(builds.mutex);
+        builds.done.wait(lock, [&] { return builds.running.count(cachePath) == 0; });
+        builds.running.insert(cachePath);
+    }
 
-// Static method to remove low-res frames outside the active buffer range
-// Changed to remove frames *inside* the specified range [startIndex, endIndex]
+    std::vector<ProxyOutput> outputs;
+    for (const auto& level : missingLevels(filename, cachePath)) {
+        outputs.push_back({level.width, ProxyPyramid::levelBitrateKbps(level.width), level.filename});
+        TX_LOG_INFO("LowResDecoder", "Generating proxy level 1/" << level.divisor << " (" << level.width
+                    << "px): " << level.filename);
+    }
+    bool ok = outputs.empty() || encodeProxies(filename, outputs, profile, nullptr);
+    if (!ok) {
+        TX_LOG_WARN("LowResDecoder", "Proxy levels for " << filename << " failed; playing from the base proxy");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(builds.mutex);
+        builds.running.erase(cachePath);
+    }
+    builds.done.notify_all();
+    return ok;
+}
+
+// --- Window maintenance ---
+
+// Removes low-res frames *inside* the specified range [startIndex, endIndex].
+// Only resident runs are visited, so unloading a mostly-empty segment is cheap.
 void LowResDecoder::removeLowResFrames(std::vector<FrameInfo>& frameIndex, int startIndex, int endIndex) {
     // Clamp indices to valid range
     startIndex = std::max(0, startIndex);
@@ -440,46 +606,57 @@ void LowResDecoder::removeLowResFrames(std::vector<FrameInfo>& frameIndex, int s
 
     // std::cout << "LowResDecoder::removeLowResFrames: Cleaning *inside* range [" << startIndex << "-" << endIndex << "]" << std::endl;
 
-    for (int i = startIndex; i <= endIndex; ++i) {
-        // Lock only the frame being modified
-        std::lock_guard<std::mutex> lock(frameIndex[i].mutex);
+    for (const auto& run : resident_.takeInside(startIndex, endIndex)) {
+        for (int i = run.first; i <= run.second; ++i) {
+            // Lock only the frame being modified
+            std::lock_guard<std::mutex> lock(frameIndex[i].mutex);
 
-        // Check if it currently has a low-res frame
-        if (frameIndex[i].low_res_frame) {
-            // --- Explicitly unreference frame data buffers BEFORE reset --- 
-            av_frame_unref(frameIndex[i].low_res_frame.get());
-            // --- End Explicit Unref ---
-            
-            frameIndex[i].low_res_frame.reset(); // Release the shared_ptr
-
-            // Reset type only if it was LOW_RES
-            if (frameIndex[i].type == FrameInfo::LOW_RES) {
-                // If a full-res frame exists, keep that type, otherwise set to EMPTY
-                if (frameIndex[i].frame) {
-                    frameIndex[i].type = FrameInfo::FULL_RES;
-                } else {
-                    frameIndex[i].type = FrameInfo::EMPTY;
+            // Check if it currently has a low-res frame
+            if (frameIndex[i].low_res_frame) {
+                // --- Explicitly unreference frame data buffers BEFORE reset --- 
+                av_frame_unref(frameIndex[i].low_res_frame.get());
+                // --- End Explicit Unref ---
+                
+                frameIndex[i].low_res_frame.reset(); // Release the shared_ptr
+
+                // Reset type only if it was LOW_RES
+                if (frameIndex[i].type == FrameInfo::LOW_RES) {
+                    // If a full-res frame exists, keep that type, otherwise set to EMPTY
+                    if (frameIndex[i].frame) {
+                        setFrameType(frameIndex, i, FrameInfo::FULL_RES);
+                    } else {
+                        setFrameType(frameIndex, i, FrameInfo::EMPTY);
+                    }
                 }
+                // std::cout << "Removed low-res frame at index " << i << std::endl;
             }
-            // std::cout << "Removed low-res frame at index " << i << std::endl;
         }
     }
 }
 
+bool LowResDecoder::hasResidentIn(int start, int end) const {
+    return resident_.intersects(start, end);
+}
+
+size_t LowResDecoder::residentFrameCount() const {
+    return resident_.size();
+}
+
 // --- Instance Methods ---
 
-bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int startFrame, int endFrame, int highResStart, int highResEnd, bool skipHighResWindow) {
+bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int startFrame, int endFrame, int highResStart, int highResEnd, bool skipHighResWindow, int stride) {
+    PERF_SPAN("decode.low");
     // Reverting to the user-provided multi-threaded logic from the older build
     stop_requested_ = false; // Reset stop flag at start
     is_decoding_ = true; // Mark that we're actively decoding
     
     if (!initialized_) {
-        std::cerr << "LowResDecoder::decodeLowResRange Error: Decoder object not initialized (cannot get filename)." << std::endl;
+        TX_LOG_ERROR("LowResDecoder", "decodeLowResRange: Decoder object not initialized (cannot get filename).");
         is_decoding_ = false;
         return false;
     }
     if (frameIndex.empty()) {
-        std::cerr << "LowResDecoder::decodeLowResRange Warning: Frame index is empty." << std::endl;
+        TX_LOG_WARN("LowResDecoder", "decodeLowResRange: Frame index is empty.");
         is_decoding_ = false;
         return true; // Nothing to do
     }
@@ -488,7 +665,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
     endFrame = std::min(static_cast<int>(frameIndex.size()) - 1, endFrame);
 
     if (startFrame > endFrame) {
-         std::cerr << "LowResDecoder::decodeLowResRange Error: Invalid frame range requested after clamping (" << startFrame << " - " << endFrame << ")" << std::endl;
+         TX_LOG_ERROR("LowResDecoder", "decodeLowResRange: Invalid frame range requested after clamping (" << startFrame << " - " << endFrame << ")");
         is_decoding_ = false;
         return false; 
     }
@@ -500,6 +677,11 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
     std::vector<std::thread> threads;
     std::atomic<bool> success{true};
 
+    stride = std::max(1, stride);
+    // Intra-only proxies: every packet is a complete frame, so packets between
+    // stride points can be dropped before the decoder ever sees them
+    const bool skipPackets = (stride > 1 && isIntraOnly());
+
     auto decodeSegment = [&](int threadId, int threadStartFrame, int threadEndFrame) {
         AVFormatContext* formatContext = nullptr;
         AVCodecContext* codecContext = nullptr;
@@ -512,13 +694,13 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
 
         // Open input file context for this thread
         if (avformat_open_input(&formatContext, filename.c_str(), nullptr, nullptr) != 0) {
-            std::cerr << "[Thread " << threadId << "] Error opening input: " << filename << std::endl;
+            TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error opening input: " << filename);
             success = false;
             return;
         }
 
         if (avformat_find_stream_info(formatContext, nullptr) < 0) {
-            std::cerr << "[Thread " << threadId << "] Error finding stream info." << std::endl;
+            TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error finding stream info.");
             avformat_close_input(&formatContext);
             success = false;
             return;
@@ -529,7 +711,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
         const AVCodec* tempCodecPtr = nullptr; // Temporary pointer for av_find_best_stream
         videoStream = av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, &tempCodecPtr, 0);
         if (videoStream < 0) {
-            std::cerr << "[Thread " << threadId << "] Error finding video stream." << std::endl;
+            TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error finding video stream.");
             avformat_close_input(&formatContext);
             success = false;
             return;
@@ -537,13 +719,18 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
         AVCodecParameters* codecParams = formatContext->streams[videoStream]->codecpar;
 
         // --- Explicit Decoder Selection based on Thread ID ---
+        if (codecParams->codec_id != AV_CODEC_ID_H264) {
+            // MJPEG proxy profile: plain software decoder
+            codec = avcodec_find_decoder(codecParams->codec_id);
+            use_videotoolbox = false;
+        } else {
 #ifdef __APPLE__
         if (threadId < numThreads / 2) { // First half of threads attempt VideoToolbox
             codec = avcodec_find_decoder_by_name("h264_videotoolbox");
             if (codec) {
                 use_videotoolbox = true;
             } else {
-                std::cerr << "[Thread " << threadId << "] Failed to find h264_videotoolbox decoder. Falling back to software." << std::endl;
+                TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Failed to find h264_videotoolbox decoder. Falling back to software.");
                 codec = avcodec_find_decoder_by_name("h264");
                 use_videotoolbox = false;
             }
@@ -556,9 +743,10 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
         codec = avcodec_find_decoder_by_name("h264");
         use_videotoolbox = false;
 #endif
+        }
 
         if (!codec) {
-            std::cerr << "[Thread " << threadId << "] Failed to find required decoder (h264_videotoolbox or h264)." << std::endl;
+            TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Failed to find required decoder (h264_videotoolbox or h264).");
             avformat_close_input(&formatContext);
             success = false;
             return;
@@ -567,14 +755,14 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
 
         codecContext = avcodec_alloc_context3(codec);
         if (!codecContext) {
-            std::cerr << "[Thread " << threadId << "] Error allocating codec context for decoder: " << codec->name << std::endl;
+            TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error allocating codec context for decoder: " << codec->name);
             avformat_close_input(&formatContext);
             success = false;
             return;
         }
 
         if (avcodec_parameters_to_context(codecContext, codecParams) < 0) {
-            std::cerr << "[Thread " << threadId << "] Error copying codec parameters." << std::endl;
+            TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error copying codec parameters.");
             avcodec_free_context(&codecContext);
             avformat_close_input(&formatContext);
             success = false;
@@ -587,7 +775,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
             // --- VideoToolbox Hardware Acceleration Setup ---
             int err = av_hwdevice_ctx_create(&hw_device_ctx_ref, AV_HWDEVICE_TYPE_VIDEOTOOLBOX, nullptr, nullptr, 0);
             if (err < 0) {
-                std::cerr << "[Thread " << threadId << "] Failed to create VideoToolbox device context: " << av_err2str(err) << ". Aborting HW attempt for this thread." << std::endl;
+                TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Failed to create VideoToolbox device context: " << av_err2str(err) << ". Aborting HW attempt for this thread.");
                 // Do not fall back, just fail this thread's HW attempt as per hybrid explicit approach
                 avcodec_free_context(&codecContext);
                 avformat_close_input(&formatContext);
@@ -597,7 +785,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
             
             codecContext->hw_device_ctx = av_buffer_ref(hw_device_ctx_ref); // codec context takes ownership of a new ref
             if (!codecContext->hw_device_ctx) {
-                  std::cerr << "[Thread " << threadId << "] Failed to ref hw_device_ctx for VideoToolbox. Aborting HW attempt." << std::endl;
+                  TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Failed to ref hw_device_ctx for VideoToolbox. Aborting HW attempt.");
                   av_buffer_unref(&hw_device_ctx_ref); // Release the originally created ref
                   avcodec_free_context(&codecContext);
                   avformat_close_input(&formatContext);
@@ -611,14 +799,17 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
             // --- Software Decoder Threading Setup ---
             codecContext->thread_count = std::max(1, (int)std::thread::hardware_concurrency() / numThreads); // Distribute cores among SW threads
             codecContext->thread_type = FF_THREAD_FRAME; // Use frame-level threading for software
+            if (skipPackets) {
+                // Frame threading delays output; keep packets and frames in lockstep
+                codecContext->thread_count = 1;
+            }
             // --- End Software Setup ---
         }
 
         // Open the selected codec (HW or SW)
         if (avcodec_open2(codecContext, codec, nullptr) < 0) {
-            std::cerr << "[Thread " << threadId << "] Error opening codec: " << codec->name;
-            if (use_videotoolbox) std::cerr << " (VideoToolbox attempted)";
-            std::cerr << std::endl;
+            TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error opening codec: " << codec->name
+                         << (use_videotoolbox ? " (VideoToolbox attempted)" : ""));
             if (codecContext->hw_device_ctx) av_buffer_unref(&codecContext->hw_device_ctx);
             if (hw_device_ctx_ref) av_buffer_unref(&hw_device_ctx_ref); // Clean up original ref if it exists
             avcodec_free_context(&codecContext);
@@ -654,7 +845,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
             int seek_flags = AVSEEK_FLAG_BACKWARD; // Seek to nearest keyframe before target
             int seek_ret = av_seek_frame(formatContext, videoStream, seek_target_ts, seek_flags);
             if (seek_ret < 0) {
-                 std::cerr << "[Thread " << threadId << "] Warning: Seek to ts " << seek_target_ts << " (ms " << seekTargetTimeMs << ") failed: " << av_err2str(seek_ret) << std::endl;
+                 TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Warning: Seek to ts " << seek_target_ts << " (ms " << seekTargetTimeMs << ") failed: " << av_err2str(seek_ret));
                  // Decide if this is fatal for the thread? Maybe not, attempt decode from start?
                  // For now, flush buffers and continue decoding from wherever FFmpeg landed us.
                  avcodec_flush_buffers(codecContext);
@@ -665,7 +856,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
                  // REMOVED: Timestamp repair - let original timestamps work naturally
             }
         } else {
-            std::cerr << "[Thread " << threadId << "] Warning: No valid timestamp found in range [" << threadStartFrame << ", " << threadEndFrame << "] for seeking. Starting decode from beginning of stream for this thread." << std::endl;
+            TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Warning: No valid timestamp found in range [" << threadStartFrame << ", " << threadEndFrame << "] for seeking. Starting decode from beginning of stream for this thread.");
             // If no valid time, just flush and start reading from the beginning (effectively)
             avcodec_flush_buffers(codecContext);
         }
@@ -674,7 +865,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
         AVPacket* packet = av_packet_alloc();
         AVFrame* frame = av_frame_alloc();
         if (!packet || !frame) { 
-            std::cerr << "[Thread " << threadId << "] Error allocating packet/frame." << std::endl;
+            TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error allocating packet/frame.");
             if (codecContext->hw_device_ctx) av_buffer_unref(&codecContext->hw_device_ctx);
             avcodec_free_context(&codecContext); 
             avformat_close_input(&formatContext); 
@@ -683,16 +874,33 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
         }
 
         int currentFrame = threadStartFrame; // Frame index counter for this thread
+        int packetFrame = threadStartFrame;  // Next frame index by packet (skipPackets only)
+        std::deque<int> sentFrames;          // Indices of packets sent, in decode order (skipPackets only)
+        auto lastStoredTime = std::chrono::steady_clock::now(); // Per-frame decode latency: between stored frames
 
         // --- Decoding Loop (Remains largely the same) ---
         while (success && !stop_requested_.load() && av_read_frame(formatContext, packet) >= 0) {
             if (packet->stream_index == videoStream) {
+                if (skipPackets) {
+                    int64_t packetPts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+                    int64_t packetMs = (packetPts != AV_NOPTS_VALUE)
+                        ? av_rescale_q(packetPts - fileStartTime, timeBase, {1, 1000}) : -1;
+                    bool inRange = (packetMs >= seekTargetTimeMs - 100 || seekTargetTimeMs < 0);
+                    bool wanted = inRange && packetFrame <= threadEndFrame && ((packetFrame - threadStartFrame) % stride == 0);
+                    if (inRange) packetFrame++;
+                    if (!wanted) {
+                        av_packet_unref(packet);
+                        if (packetFrame > threadEndFrame && sentFrames.empty()) goto thread_decode_loop_end;
+                        continue;
+                    }
+                    sentFrames.push_back(packetFrame - 1);
+                }
                 int ret = avcodec_send_packet(codecContext, packet);
                 if (ret < 0) {
                     if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) { 
                          char errbuf[AV_ERROR_MAX_STRING_SIZE] = {0};
                          av_strerror(ret, errbuf, sizeof(errbuf));
-                         std::cerr << "[Thread " << threadId << "] Warning: Error sending packet: " << errbuf << std::endl; 
+                         TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Error sending packet: " << errbuf);
                     }
                     av_packet_unref(packet);
                     if (ret == AVERROR_EOF) break; // Exit outer loop on send EOF
@@ -705,12 +913,12 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
                         break; // Need more packets
                     } else if (ret == AVERROR_EOF) {
                         // End of stream signalled by decoder
-                        std::cout << "[Thread " << threadId << "] Decoder signalled EOF." << std::endl;
+                        TX_LOG_DEBUG("LowResDecoder", "[Thread " << threadId << "] Decoder signalled EOF.");
                         goto thread_decode_loop_end; // Exit outer loop for this thread
                     } else if (ret < 0) {
                         char errbuf[AV_ERROR_MAX_STRING_SIZE] = {0};
                         av_strerror(ret, errbuf, sizeof(errbuf));
-                        std::cerr << "[Thread " << threadId << "] Error receiving frame: " << errbuf << std::endl;
+                        TX_LOG_ERROR("LowResDecoder", "[Thread " << threadId << "] Error receiving frame: " << errbuf);
                         // Consider this potentially fatal for the thread?
                         // Let's break the inner loop for now and let the outer loop decide.
                         break; 
@@ -748,13 +956,28 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
                     // --- Frame Storage Logic (Refined to reduce lock scope) ---
                     bool stored_this_frame_attempt = false;
 
+                    // With packet skipping the slot comes from the packet that produced
+                    // this frame; otherwise frames fill consecutive slots
+                    bool onStride = true;
+                    if (skipPackets) {
+                        if (sentFrames.empty()) {
+                            av_frame_unref(frame);
+                            continue;
+                        }
+                        currentFrame = sentFrames.front();
+                        sentFrames.pop_front();
+                    } else {
+                        onStride = ((currentFrame - threadStartFrame) % stride == 0);
+                    }
+
                     // Check if we should generally process a frame for the currentFrame index
                     if (currentFrame >= threadStartFrame && currentFrame <= threadEndFrame && currentFrame < frameIndex.size() &&
-                        (frameTimeMs >= seekTargetTimeMs - 100 || seekTargetTimeMs < 0))
+                        (skipPackets || frameTimeMs >= seekTargetTimeMs - 100 || seekTargetTimeMs < 0))
                     {
                         stored_this_frame_attempt = true; // We will attempt to process this slot
 
-                        AVFrame* cloned_av_frame = av_frame_clone(frame); // Clone OUTSIDE the lock
+                        // Off-stride frames were only decoded as references; their slot is left as is
+                        AVFrame* cloned_av_frame = onStride ? av_frame_clone(frame) : nullptr; // Clone OUTSIDE the lock
 
                         if (cloned_av_frame) {
                             // Clone successful, now lock for assignments
@@ -768,19 +991,20 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
                                 frameIndex[currentFrame].time_ms = frameTimeMs;
                             }
                             frameIndex[currentFrame].time_base = timeBase;
-                            frameIndex[currentFrame].type = FrameInfo::LOW_RES;
-
-                            // Optional: Log cloned frame format if needed (useful for HW debugging)
-                            // if (use_videotoolbox) {
-                            //     std::cout << "[Thread " << threadId << "] VT Cloned format: " << av_get_pix_fmt_name(static_cast<AVPixelFormat>(cloned_av_frame->format)) << std::endl;
-                            // }
-                        } else {
+                            setFrameType(frameIndex, currentFrame, FrameInfo::LOW_RES);
+                            resident_.insert(currentFrame); // Still under the frame lock
+
+                            TX_LOG_TRACE("LowResDecoder", "[Thread " << threadId << "] Decoded frame " << currentFrame
+                                         << " at " << frameTimeMs << " ms, format: " << av_get_pix_fmt_name(static_cast<AVPixelFormat>(frame->format)));
+                            playerMetrics.decodeLowRes.recordSince(lastStoredTime);
+                            lastStoredTime = std::chrono::steady_clock::now();
+                        } else if (onStride) {
                             // Clone failed
-                            std::cerr << "[Thread " << threadId << "] LowResDecoder: Failed to clone AVFrame for index " << currentFrame << ". Resetting slot." << std::endl;
+                            TX_LOG_WARN("LowResDecoder", "[Thread " << threadId << "] Failed to clone AVFrame for index " << currentFrame << ". Resetting slot.");
                             std::lock_guard<std::mutex> lock(frameIndex[currentFrame].mutex); // Lock to reset
                             frameIndex[currentFrame].low_res_frame.reset();
                             if (frameIndex[currentFrame].type != FrameInfo::FULL_RES) {
-                                frameIndex[currentFrame].type = FrameInfo::EMPTY;
+                                setFrameType(frameIndex, currentFrame, FrameInfo::EMPTY);
                             }
                         }
                     }
@@ -799,7 +1023,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
                     av_frame_unref(frame); // Unref frame inside receive loop
 
                     // Check if this thread's work is done
-                    if (currentFrame > threadEndFrame) {
+                    if (skipPackets ? (packetFrame > threadEndFrame && sentFrames.empty()) : (currentFrame > threadEndFrame)) {
                         // std::cout << "[Thread " << threadId << "] Reached end of assigned segment." << std::endl; // DEBUG
                         goto thread_decode_loop_end;
                     }
@@ -810,7 +1034,7 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
 
     thread_decode_loop_end:
         if (stop_requested_.load()) { 
-            std::cout << "[Thread " << threadId << "] Exiting due to stop request." << std::endl;
+            TX_LOG_DEBUG("LowResDecoder", "[Thread " << threadId << "] Exiting due to stop request.");
         }
         av_frame_free(&frame);
         av_packet_free(&packet);
@@ -830,11 +1054,11 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
     int startOffset = startFrame;
 
     if (totalFramesInRange <= 0) {
-        std::cerr << "LowResDecoder::decodeLowResRange Warning: No frames in the calculated range [" << startFrame << ", " << endFrame << "]. Nothing to decode." << std::endl;
+        TX_LOG_WARN("LowResDecoder", "decodeLowResRange: No frames in the calculated range [" << startFrame << ", " << endFrame << "]. Nothing to decode.");
         return true; // Success, but nothing done.
     }
 
-    std::cout << "LowResDecoder: Launching " << numThreads << " threads for range [" << startFrame << "-" << endFrame << "] (Total: " << totalFramesInRange << " frames)" << std::endl;
+    TX_LOG_DEBUG("LowResDecoder", "Launching " << numThreads << " threads for range [" << startFrame << "-" << endFrame << "] (Total: " << totalFramesInRange << " frames)");
 
     for (int i = 0; i < numThreads; ++i) {
         int threadStart = startOffset;
@@ -857,12 +1081,118 @@ bool LowResDecoder::decodeLowResRange(std::vector<FrameInfo>& frameIndex, int st
             thread.join();
         }
     }
-    std::cout << "LowResDecoder: All threads joined. Final success status: " << (success.load() ? "true" : "false") << std::endl;
+    TX_LOG_DEBUG("LowResDecoder", "All threads joined. Final success status: " << (success.load() ? "true" : "false"));
 
     is_decoding_ = false; // Clear decoding flag
     return success.load(); // Return the final success status
 }
 
+// --- Sparse shuttle decode ---
+
+int LowResDecoder::decodeSparseFrames(std::vector<FrameInfo>& frameIndex, const std::vector<int>& targets, int tolerance, int maxWalk) {
+    if (!initialized_ || frameIndex.empty() || targets.empty()) return 0;
+    PERF_SPAN("decode.sparse");
+    stop_requested_ = false;
+    is_decoding_ = true;
+
+    const int frameCount = static_cast<int>(frameIndex.size());
+    const AVRational timeBase = videoStream_->time_base;
+    const int64_t streamStart = (videoStream_->start_time != AV_NOPTS_VALUE) ? videoStream_->start_time : 0;
+    const double fps = original_fps.load() > 0 ? original_fps.load() : 25.0;
+    const double frameMsDuration = 1000.0 / fps;
+    auto timeOf = [&](int idx) { return frameIndex[idx].time_ms >= 0 ? frameIndex[idx].time_ms : idx * frameMsDuration; };
+
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    if (!packet || !frame) {
+        TX_LOG_ERROR("LowResDecoder", "decodeSparseFrames: Failed to allocate packet/frame.");
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+        is_decoding_ = false;
+        return 0;
+    }
+
+    int stored = 0;
+    for (int target : targets) {
+        if (stop_requested_.load()) break;
+        if (target < 0 || target >= frameCount) continue;
+        auto targetStartTime = std::chrono::steady_clock::now();
+
+        double targetMs = timeOf(target);
+        double seekMs = targetMs;
+
+        // --- Pick the frame to seek to: nearby keyframe, short walk, or nearest keyframe ---
+        if (!keyframeMs_.empty()) {
+            auto next = std::lower_bound(keyframeMs_.begin(), keyframeMs_.end(), static_cast<int64_t>(targetMs));
+            double after = (next != keyframeMs_.end()) ? static_cast<double>(*next) : -1.0;
+            double before = (next != keyframeMs_.begin()) ? static_cast<double>(*std::prev(next)) : -1.0;
+            double nearest = before;
+            if (after >= 0 && (before < 0 || after - targetMs < targetMs - before)) nearest = after;
+
+            if (nearest >= 0 && std::abs(nearest - targetMs) <= tolerance * frameMsDuration) {
+                seekMs = nearest;
+            } else if (before < 0 || (targetMs - before) > maxWalk * frameMsDuration) {
+                if (nearest >= 0) seekMs = nearest; // Walking would blow the budget
+            }
+        }
+
+        int64_t seekTs = av_rescale_q(static_cast<int64_t>(seekMs), {1, 1000}, timeBase) + streamStart;
+        if (av_seek_frame(formatCtx_, videoStreamIndex_, seekTs, AVSEEK_FLAG_BACKWARD) < 0) {
+            continue;
+        }
+        avcodec_flush_buffers(codecCtx_);
+
+        // --- Decode up to the chosen frame (at most maxWalk + 1 frames) ---
+        AVFrame* result = nullptr;
+        int64_t resultPts = AV_NOPTS_VALUE;
+        int decoded = 0;
+        while (!result && decoded <= maxWalk && !stop_requested_.load() && av_read_frame(formatCtx_, packet) >= 0) {
+            if (packet->stream_index == videoStreamIndex_ && avcodec_send_packet(codecCtx_, packet) >= 0) {
+                while (!result && avcodec_receive_frame(codecCtx_, frame) == 0) {
+                    ++decoded;
+                    int64_t framePts = frame->best_effort_timestamp;
+                    if (framePts == AV_NOPTS_VALUE) framePts = frame->pts;
+                    double frameMs = (framePts != AV_NOPTS_VALUE)
+                        ? static_cast<double>(av_rescale_q(framePts - streamStart, timeBase, {1, 1000})) : seekMs;
+                    if (frameMs >= seekMs - frameMsDuration / 2 || decoded > maxWalk) {
+                        result = av_frame_clone(frame);
+                        resultPts = framePts;
+                        // Store at the slot the decoded frame actually belongs to
+                        seekMs = frameMs;
+                    }
+                    av_frame_unref(frame);
+                }
+            }
+            av_packet_unref(packet);
+        }
+        if (!result) continue;
+
+        int slot = target + static_cast<int>(std::lround((seekMs - targetMs) / frameMsDuration));
+        slot = std::max(0, std::min(frameCount - 1, slot));
+
+        std::lock_guard<std::mutex> lock(frameIndex[slot].mutex);
+        if (frameIndex[slot].low_res_frame) {
+            av_frame_free(&result); // Filled by a segment pass meanwhile
+            continue;
+        }
+        frameIndex[slot].low_res_frame = std::shared_ptr<AVFrame>(result, [](AVFrame* f) { av_frame_free(&f); });
+        frameIndex[slot].pts = resultPts;
+        frameIndex[slot].relative_pts = resultPts - streamStart;
+        frameIndex[slot].time_base = timeBase;
+        if (frameIndex[slot].type != FrameInfo::FULL_RES) {
+            setFrameType(frameIndex, slot, FrameInfo::LOW_RES);
+        }
+        resident_.insert(slot); // Still under the frame lock
+        ++stored;
+        playerMetrics.decodeLowRes.recordSince(targetStartTime); // Seek plus walk for one sparse frame
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    is_decoding_ = false;
+    return stored;
+}
+
 // --- Getters ---
 
 bool LowResDecoder::isInitialized() const {
@@ -881,6 +1211,14 @@ AVPixelFormat LowResDecoder::getPixelFormat() const {
     return pixFmt_;
 }
 
+ProxyProfile LowResDecoder::getProxyProfile() const {
+    return profile_;
+}
+
+bool LowResDecoder::isIntraOnly() const {
+    return profile_ != ProxyProfile::LongGop;
+}
+
 // --- Non-Static Methods (if any) --- 
 // Example:
 // bool LowResDecoder::decodeFrame(int frameNumber, AVFrame* outputFrame) {
@@ -16,6 +16,8 @@ extern "C" {
 }
 
 #include "decode.h" // Includes FrameInfo definition
+#include "resident_set.h"
+#include "proxy_pyramid.h"
 
 // Forward declaration
 struct FrameInfo;
@@ -33,26 +35,54 @@ public:
     // Convert original video to low-res version
     static bool convertToLowRes(const std::string& filename, std::string& outputFilename, 
                               const std::function<void(int)>& progressCallback = nullptr);
+    // Same with an explicit proxy profile; withPyramid = false writes only the base proxy
+    static bool convertToLowRes(const std::string& filename, std::string& outputFilename,
+                              const std::function<void(int)>& progressCallback,
+                              ProxyProfile profile, bool withPyramid);
+    // Generates the pyramid levels of an existing base proxy that are not on
+    // disk yet; blocks. convertToLowRes runs it in the background when it
+    // finds the base proxy without them. False if a level could not be made.
+    static bool buildMissingLevels(const std::string& filename, ProxyProfile profile);
     
     // String utilities for file handling
     static std::string getCachePath();
     static std::string generateFileId(const std::string& filename);
     
-    // Function to remove low-res frames outside a given window
-    static void removeLowResFrames(std::vector<FrameInfo>& frameIndex, int start, int end);
-
     // --- Instance Methods ---
-    // Decode low-res frames in a specific range
+    // Remove low-res frames inside [start, end]. Walks only the indices this
+    // decoder has stored (resident_), not every slot in the range.
+    void removeLowResFrames(std::vector<FrameInfo>& frameIndex, int start, int end);
+    size_t residentFrameCount() const;
+    bool hasResidentIn(int start, int end) const;
+
+    // Decode low-res frames in a specific range. With stride > 1 only every
+    // stride-th frame is stored; on intra-only proxies the frames in between
+    // are not decoded at all.
     bool decodeLowResRange(std::vector<FrameInfo>& frameIndex, 
                            int startFrame, int endFrame, 
                            int highResStart, int highResEnd, 
-                           bool skipHighResWindow = false);
+                           bool skipHighResWindow = false,
+                           int stride = 1);
+
+    // Keyframe-aligned sparse decode for high-speed shuttle. Each target costs
+    // one seek plus at most maxWalk + 1 decoded frames: a keyframe within
+    // tolerance frames of the target is used as is, otherwise the target is
+    // decoded from the preceding keyframe if that is at most maxWalk frames
+    // back, otherwise the nearest keyframe stands in. Runs on the instance's
+    // own demuxer/decoder (single caller), so it must not overlap teardown:
+    // requestStop() only makes it return early, the caller waits for that
+    // before destroying the decoder. Returns the number of frames stored.
+    int decodeSparseFrames(std::vector<FrameInfo>& frameIndex, const std::vector<int>& targets,
+                           int tolerance, int maxWalk);
 
     bool isInitialized() const;
     int getWidth() const;
     int getHeight() const;
     AVPixelFormat getPixelFormat() const;
+    ProxyProfile getProxyProfile() const;
+    bool isIntraOnly() const;
 
+    // Asks a running decode to return early; safe from any thread
     void requestStop();
 
 private:
@@ -72,10 +102,15 @@ private:
     int width_ = 0;
     int height_ = 0;
     AVPixelFormat pixFmt_ = AV_PIX_FMT_NONE;
+    ProxyProfile profile_ = ProxyProfile::LongGop;
+    std::vector<int64_t> keyframeMs_; // Keyframe times from the stream index, ascending
     std::atomic<bool> stop_requested_{false};
     std::atomic<bool> is_decoding_{false}; // Track if actively decoding
     AVBufferRef *global_hw_device_ctx_ = nullptr;
     bool hw_accel_available_ = false;
+
+    // Indices whose FrameInfo::low_res_frame was filled by this decoder
+    ResidentSet resident_;
 };
 
 #endif // LOW_RES_DECODER_H 
\ No newline at end of file
@@ -0,0 +1,445 @@
+#include "proxy_pyramid.h"
+#include "low_res_decoder.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <cstdlib>
+#include <cmath>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace fs = std::filesystem;
+
+namespace {
+const int kBaseProxyWidth = 640;   // Width of the classic _lowres.mp4 proxy
+const int kMinLevelWidth = 128;
+}
+
+ProxyProfile ProxyPyramid::configuredProfile() {
+    const char* env = getenv("TAPEXPLAYER_PROXY_PROFILE");
+    if (!env) return ProxyProfile::LongGop;
+    std::string value(env);
+    if (value == "intra") return ProxyProfile::IntraH264;
+    if (value == "mjpeg") return ProxyProfile::Mjpeg;
+    if (value != "gop") {
+        std::cerr << "ProxyPyramid: Unknown TAPEXPLAYER_PROXY_PROFILE '" << value << "', using gop" << std::endl;
+    }
+    return ProxyProfile::LongGop;
+}
+
+const char* ProxyPyramid::profileName(ProxyProfile profile) {
+    switch (profile) {
+        case ProxyProfile::IntraH264: return "intra";
+        case ProxyProfile::Mjpeg: return "mjpeg";
+        default: return "gop";
+    }
+}
+
+std::string ProxyPyramid::baseSuffix(ProxyProfile profile) {
+    if (profile == ProxyProfile::LongGop) return "_lowres.mp4";
+    return std::string("_lowres_") + profileName(profile) + ".mp4";
+}
+
+std::string ProxyPyramid::encoderArgs(ProxyProfile profile, int bitrateKbps) {
+    switch (profile) {
+        case ProxyProfile::IntraH264:
+            // Every frame is an IDR; needs roughly 4x the bitrate for the same quality
+            return "-c:v libx264 -profile:v baseline -preset veryfast -x264-params keyint=1:scenecut=0 -b:v " +
+                   std::to_string(bitrateKbps * 4) + "k";
+        case ProxyProfile::Mjpeg:
+            return "-c:v mjpeg -pix_fmt yuvj420p -q:v 5";
+        default:
+            return "-c:v libx264 -profile:v baseline -preset medium -b:v " + std::to_string(bitrateKbps) + "k";
+    }
+}
+
+ProxyProfile ProxyPyramid::detectProfile(AVFormatContext* formatCtx, int streamIndex) {
+    if (!formatCtx || streamIndex < 0 || streamIndex >= static_cast<int>(formatCtx->nb_streams)) {
+        return ProxyProfile::LongGop;
+    }
+    AVStream* stream = formatCtx->streams[streamIndex];
+    if (stream->codecpar->codec_id == AV_CODEC_ID_MJPEG) return ProxyProfile::Mjpeg;
+
+    // The mp4 sample table marks sync samples; a long-GOP file fails within its first GOP
+    int entries = avformat_index_get_entries_count(stream);
+    if (entries <= 1) return ProxyProfile::LongGop;
+    int sample = std::min(entries, 300);
+    for (int i = 0; i < sample; ++i) {
+        const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+        if (!entry || !(entry->flags & AVINDEX_KEYFRAME)) return ProxyProfile::LongGop;
+    }
+    return ProxyProfile::IntraH264;
+}
+
+int ProxyPyramid::shuttleStride(double playbackRateAbs, double sourceFps, double displayHz) {
+    if (sourceFps <= 0) sourceFps = 25.0;
+    if (displayHz <= 0) displayHz = 60.0;
+    return std::max(1, static_cast<int>(playbackRateAbs * sourceFps / displayHz));
+}
+
+std::vector<int> ProxyPyramid::configuredDivisors() {
+    std::vector<int> divisors;
+    const char* env = getenv("TAPEXPLAYER_PROXY_LEVELS");
+    if (!env) {
+        return {8, 4, 2};
+    }
+    std::stringstream ss(env);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        try {
+            int d = std::stoi(item);
+            if (d >= 2 && d <= 32 && std::find(divisors.begin(), divisors.end(), d) == divisors.end()) {
+                divisors.push_back(d);
+            }
+        } catch (...) {
+            std::cerr << "ProxyPyramid: Ignoring invalid level '" << item << "' in TAPEXPLAYER_PROXY_LEVELS" << std::endl;
+        }
+    }
+    return divisors;
+}
+
+std::string ProxyPyramid::levelFilename(const std::string& baseLowResFilename, int divisor) {
+    const std::string ext = ".mp4";
+    std::string stem = baseLowResFilename;
+    if (stem.size() > ext.size() && stem.compare(stem.size() - ext.size(), ext.size(), ext) == 0) {
+        stem.erase(stem.size() - ext.size());
+    }
+    return stem + "_d" + std::to_string(divisor) + ext;
+}
+
+std::vector<ProxyLevel> ProxyPyramid::plannedLevels(const std::string& baseLowResFilename, int sourceWidth) {
+    std::vector<ProxyLevel> levels;
+    if (sourceWidth <= 0) return levels;
+
+    for (int divisor : configuredDivisors()) {
+        int width = (sourceWidth / divisor) & ~1;
+        if (width < kMinLevelWidth) continue;
+        // Within 15% of the base proxy - not worth a separate file
+        if (std::abs(width - kBaseProxyWidth) < kBaseProxyWidth * 0.15) continue;
+        ProxyLevel level;
+        level.divisor = divisor;
+        level.width = width;
+        level.filename = levelFilename(baseLowResFilename, divisor);
+        levels.push_back(level);
+    }
+    return levels;
+}
+
+std::vector<ProxyLevel> ProxyPyramid::availableLevels(const std::string& baseLowResFilename) {
+    std::vector<ProxyLevel> levels;
+    ProxyLevel base;
+    base.divisor = 0;
+    base.filename = baseLowResFilename;
+    levels.push_back(base);
+
+    for (int divisor : configuredDivisors()) {
+        std::string path = levelFilename(baseLowResFilename, divisor);
+        if (fs::exists(path)) {
+            ProxyLevel level;
+            level.divisor = divisor;
+            level.filename = path;
+            levels.push_back(level);
+        }
+    }
+    return levels; // Widths are filled in by whoever opens the files
+}
+
+int ProxyPyramid::levelBitrateKbps(int width) {
+    double scale = static_cast<double>(width) / kBaseProxyWidth;
+    int kbps = static_cast<int>(500.0 * scale * scale);
+    return std::max(150, std::min(6000, kbps));
+}
+
+// --- Benchmark ---
+
+namespace {
+
+struct LevelBenchResult {
+    int frames = 0;
+    double seconds = 0.0;
+    double seekAvgMs = 0.0;
+    int width = 0;
+    int height = 0;
+};
+
+// Sequential decode of up to maxFrames, then a few random seeks (seek + decode
+// first frame). Single context, SW decoder with FFmpeg's own threading.
+bool benchmarkLevel(const std::string& filename, int maxFrames, LevelBenchResult& out) {
+    AVFormatContext* fmt = nullptr;
+    if (avformat_open_input(&fmt, filename.c_str(), nullptr, nullptr) != 0) return false;
+    if (avformat_find_stream_info(fmt, nullptr) < 0) { avformat_close_input(&fmt); return false; }
+
+    const AVCodec* codec = nullptr;
+    int streamIdx = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (streamIdx < 0 || !codec) { avformat_close_input(&fmt); return false; }
+
+    AVCodecContext* ctx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(ctx, fmt->streams[streamIdx]->codecpar);
+    ctx->thread_count = 0; // Auto
+    if (avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        avformat_close_input(&fmt);
+        return false;
+    }
+    out.width = ctx->width;
+    out.height = ctx->height;
+
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+
+    auto decodeUntil = [&](int wanted) {
+        int got = 0;
+        while (got < wanted && av_read_frame(fmt, pkt) >= 0) {
+            if (pkt->stream_index == streamIdx && avcodec_send_packet(ctx, pkt) >= 0) {
+                while (got < wanted && avcodec_receive_frame(ctx, frame) == 0) {
+                    ++got;
+                    av_frame_unref(frame);
+                }
+            }
+            av_packet_unref(pkt);
+        }
+        return got;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    out.frames = decodeUntil(maxFrames);
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Random access: seek to evenly spaced points and decode one frame
+    const int seekCount = 8;
+    double totalSeekMs = 0.0;
+    int seeksDone = 0;
+    int64_t duration = fmt->duration > 0 ? fmt->duration : 0;
+    for (int i = 1; i <= seekCount && duration > 0; ++i) {
+        int64_t target = duration * i / (seekCount + 1);
+        auto s0 = std::chrono::steady_clock::now();
+        if (av_seek_frame(fmt, -1, target, AVSEEK_FLAG_BACKWARD) < 0) continue;
+        avcodec_flush_buffers(ctx);
+        decodeUntil(1);
+        totalSeekMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s0).count();
+        ++seeksDone;
+    }
+    out.seekAvgMs = seeksDone > 0 ? totalSeekMs / seeksDone : 0.0;
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+    avformat_close_input(&fmt);
+    return out.frames > 0;
+}
+
+// Decode cost of one second of shuttle at the given rate, starting at the top
+// of the file. Long-GOP proxies must decode every frame; intra proxies only
+// send the packets that land on the display stride.
+bool benchmarkShuttle(const std::string& filename, double rate, double& msPerShuttleSecond, int& decodedFrames) {
+    AVFormatContext* fmt = nullptr;
+    if (avformat_open_input(&fmt, filename.c_str(), nullptr, nullptr) != 0) return false;
+    if (avformat_find_stream_info(fmt, nullptr) < 0) { avformat_close_input(&fmt); return false; }
+
+    const AVCodec* codec = nullptr;
+    int streamIdx = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (streamIdx < 0 || !codec) { avformat_close_input(&fmt); return false; }
+
+    AVCodecContext* ctx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(ctx, fmt->streams[streamIdx]->codecpar);
+    ctx->thread_count = 1; // Same as one decodeLowResRange worker
+    if (avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        avformat_close_input(&fmt);
+        return false;
+    }
+
+    AVRational fr = fmt->streams[streamIdx]->avg_frame_rate;
+    double fps = (fr.num > 0 && fr.den > 0) ? av_q2d(fr) : 25.0;
+    bool intra = ProxyPyramid::detectProfile(fmt, streamIdx) != ProxyProfile::LongGop;
+    int stride = ProxyPyramid::shuttleStride(rate, fps);
+    const double shuttleSeconds = 2.0;
+    int coveredFrames = static_cast<int>(rate * fps * shuttleSeconds);
+
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    int packetIdx = 0;
+    decodedFrames = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    while (packetIdx < coveredFrames && av_read_frame(fmt, pkt) >= 0) {
+        if (pkt->stream_index == streamIdx) {
+            bool wanted = !intra || (packetIdx % stride == 0);
+            ++packetIdx;
+            if (wanted && avcodec_send_packet(ctx, pkt) >= 0) {
+                while (avcodec_receive_frame(ctx, frame) == 0) {
+                    ++decodedFrames;
+                    av_frame_unref(frame);
+                }
+            }
+        }
+        av_packet_unref(pkt);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Short files cover less than the full shuttle window
+    double coveredSeconds = packetIdx / (rate * fps);
+    msPerShuttleSecond = coveredSeconds > 0 ? elapsed * 1000.0 / coveredSeconds : 0.0;
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+    avformat_close_input(&fmt);
+    return packetIdx > 0;
+}
+
+} // namespace
+
+int ProxyPyramid::runDecodeBenchmark(const std::string& sourceFilename) {
+    std::string baseProxy;
+    std::cout << "[ProxyBench] Preparing proxies for " << sourceFilename << std::endl;
+    if (!LowResDecoder::convertToLowRes(sourceFilename, baseProxy)) {
+        std::cerr << "[ProxyBench] Failed to create proxies" << std::endl;
+        return 1;
+    }
+    // With a cached base proxy the levels are built in the background; the benchmark needs them now
+    LowResDecoder::buildMissingLevels(sourceFilename, configuredProfile());
+
+    const int maxFrames = 1500;
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(8) << "level" << std::right
+              << std::setw(11) << "size" << std::setw(10) << "file MB"
+              << std::setw(10) << "frames" << std::setw(12) << "decode fps"
+              << std::setw(12) << "seek ms" << std::endl;
+
+    for (const auto& level : availableLevels(baseProxy)) {
+        LevelBenchResult r;
+        if (!benchmarkLevel(level.filename, maxFrames, r)) {
+            std::cerr << "[ProxyBench] Failed to decode " << level.filename << std::endl;
+            continue;
+        }
+        std::string name = level.divisor == 0 ? "base" : "1/" + std::to_string(level.divisor);
+        std::string dims = std::to_string(r.width) + "x" + std::to_string(r.height);
+        double fileMb = static_cast<double>(fs::file_size(level.filename)) / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(8) << name << std::right
+                  << std::setw(11) << dims
+                  << std::setw(10) << std::fixed << std::setprecision(1) << fileMb
+                  << std::setw(10) << r.frames
+                  << std::setw(12) << std::setprecision(0) << (r.seconds > 0 ? r.frames / r.seconds : 0.0)
+                  << std::setw(12) << std::setprecision(1) << r.seekAvgMs << std::endl;
+    }
+    return 0;
+}
+
+int ProxyPyramid::runProfileBenchmark(const std::string& sourceFilename) {
+    const ProxyProfile profiles[] = {ProxyProfile::LongGop, ProxyProfile::IntraH264, ProxyProfile::Mjpeg};
+    const double rates[] = {3.0, 10.0, 24.0};
+
+    std::vector<std::pair<ProxyProfile, std::string>> proxies;
+    for (ProxyProfile profile : profiles) {
+        std::string proxy;
+        std::cout << "[ProxyBench] Preparing " << profileName(profile) << " proxy for " << sourceFilename << std::endl;
+        if (!LowResDecoder::convertToLowRes(sourceFilename, proxy, nullptr, profile, false)) {
+            std::cerr << "[ProxyBench] Failed to create " << profileName(profile) << " proxy" << std::endl;
+            continue;
+        }
+        proxies.emplace_back(profile, proxy);
+    }
+    if (proxies.empty()) return 1;
+
+    // Decode ms per second of shuttle on one core; below 1000 keeps up
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(8) << "profile" << std::right << std::setw(10) << "file MB";
+    for (double rate : rates) {
+        std::cout << std::setw(12) << (std::to_string(static_cast<int>(rate)) + "x ms/s");
+    }
+    std::cout << std::endl;
+
+    for (const auto& entry : proxies) {
+        double fileMb = static_cast<double>(fs::file_size(entry.second)) / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(8) << profileName(entry.first) << std::right
+                  << std::setw(10) << std::fixed << std::setprecision(1) << fileMb;
+        for (double rate : rates) {
+            double msPerSecond = 0.0;
+            int decoded = 0;
+            if (benchmarkShuttle(entry.second, rate, msPerSecond, decoded)) {
+                std::cout << std::setw(12) << std::setprecision(0) << msPerSecond;
+            } else {
+                std::cout << std::setw(12) << "-";
+            }
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+// --- ProxyLevelSelector ---
+
+void ProxyLevelSelector::configure(const std::vector<int>& levelWidths, size_t initialLevel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    widths_ = levelWidths;
+    decodeFps_.assign(levelWidths.size(), 0.0);
+    current_ = std::min(initialLevel, levelWidths.empty() ? size_t(0) : levelWidths.size() - 1);
+    upgradePending_ = false;
+}
+
+void ProxyLevelSelector::setOutputSize(int width, int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    outputWidth_ = width;
+    (void)height; // Levels keep the source aspect, width is enough
+}
+
+void ProxyLevelSelector::recordDecode(size_t level, int frames, double seconds) {
+    if (level >= decodeFps_.size() || frames <= 0 || seconds <= 0.0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    double fps = frames / seconds;
+    double& avg = decodeFps_[level];
+    avg = (avg <= 0.0) ? fps : avg * 0.7 + fps * 0.3;
+}
+
+double ProxyLevelSelector::measuredFps(size_t level) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return level < decodeFps_.size() ? decodeFps_[level] : 0.0;
+}
+
+size_t ProxyLevelSelector::choose(double playbackRateAbs, double sourceFps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (widths_.size() <= 1) return 0;
+    if (outputWidth_ <= 0) return current_; // No output size yet
+
+    // Detail that survives at speed: full output width at 1x, much less when shuttling
+    double detailFactor;
+    if (playbackRateAbs <= 1.1) detailFactor = 1.0;
+    else if (playbackRateAbs <= 4.0) detailFactor = 0.75;
+    else if (playbackRateAbs <= 10.0) detailFactor = 0.5;
+    else detailFactor = 0.35;
+    int targetWidth = std::max(1, static_cast<int>(outputWidth_ * detailFactor));
+
+    size_t pick = widths_.size() - 1;
+    for (size_t i = 0; i < widths_.size(); ++i) {
+        if (widths_[i] >= targetWidth) { pick = i; break; }
+    }
+
+    // Decode budget: segment loads must keep up with rate * fps, with 20% headroom
+    double requiredFps = std::max(1.0, playbackRateAbs) * (sourceFps > 0 ? sourceFps : 25.0) * 1.2;
+    while (pick > 0 && decodeFps_[pick] > 0.0 && decodeFps_[pick] < requiredFps) {
+        --pick;
+    }
+
+    // Downgrades apply immediately; upgrades must hold for a second to avoid
+    // bouncing between levels while the rate ramps
+    auto now = std::chrono::steady_clock::now();
+    if (pick > current_) {
+        if (!upgradePending_) {
+            upgradePending_ = true;
+            upgradeSince_ = now;
+            return current_;
+        }
+        if (now - upgradeSince_ < std::chrono::seconds(1)) {
+            return current_;
+        }
+    }
+    upgradePending_ = false;
+    current_ = pick;
+    return current_;
+}
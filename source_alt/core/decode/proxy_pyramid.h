@@ -0,0 +1,97 @@
+#ifndef PROXY_PYRAMID_H
+#define PROXY_PYRAMID_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+
+struct AVFormatContext;
+
+// Encoding profile of the proxy files. LongGop is the classic x264 baseline
+// proxy. The intra profiles make every frame a keyframe, so shuttle can seek
+// straight to a frame and skip everything between the frames it shows.
+enum class ProxyProfile {
+    LongGop,
+    IntraH264,  // x264 baseline, keyint=1
+    Mjpeg
+};
+
+// One proxy file in the pyramid. divisor == 0 is the classic 640px
+// "_lowres.mp4" proxy; the other levels are source_width / divisor.
+struct ProxyLevel {
+    int divisor = 0;
+    int width = 0;
+    std::string filename;
+};
+
+class ProxyPyramid {
+public:
+    // Profile for newly generated proxies, from TAPEXPLAYER_PROXY_PROFILE
+    // ("gop", "intra" or "mjpeg"). Defaults to LongGop.
+    static ProxyProfile configuredProfile();
+    static const char* profileName(ProxyProfile profile);
+
+    // "_lowres.mp4" for LongGop, "_lowres_intra.mp4" / "_lowres_mjpeg.mp4" otherwise,
+    // so proxies of different profiles can sit side by side in the cache
+    static std::string baseSuffix(ProxyProfile profile);
+
+    // ffmpeg output options (codec, rate control) for one proxy output
+    static std::string encoderArgs(ProxyProfile profile, int bitrateKbps);
+
+    // Profile of an opened proxy: MJPEG by codec, IntraH264 if the index says
+    // every sample is a keyframe, LongGop otherwise
+    static ProxyProfile detectProfile(AVFormatContext* formatCtx, int streamIndex);
+
+    // Divisors to generate, from TAPEXPLAYER_PROXY_LEVELS (e.g. "8,4,2").
+    // Defaults to 1/8, 1/4 and 1/2; an empty value disables the extra levels.
+    static std::vector<int> configuredDivisors();
+
+    // "<id>_lowres.mp4" -> "<id>_lowres_d<divisor>.mp4"
+    static std::string levelFilename(const std::string& baseLowResFilename, int divisor);
+
+    // Extra levels worth generating for a source of the given width. Levels
+    // that would be tiny or duplicate the 640px base proxy are skipped.
+    static std::vector<ProxyLevel> plannedLevels(const std::string& baseLowResFilename, int sourceWidth);
+
+    // Base proxy plus every configured level that exists on disk
+    static std::vector<ProxyLevel> availableLevels(const std::string& baseLowResFilename);
+
+    // Source frames between the frames shuttle actually shows: at most one
+    // frame per display refresh is ever on screen
+    static int shuttleStride(double playbackRateAbs, double sourceFps, double displayHz = 60.0);
+
+    // x264 bitrate for a level, scaled by area from the 500k@640px base
+    static int levelBitrateKbps(int width);
+
+    // --bench-proxies: decode each available level of sourceFilename and
+    // print decode fps per level. Generates missing proxies first.
+    static int runDecodeBenchmark(const std::string& sourceFilename);
+
+    // --bench-profiles: build a base proxy in every profile and print file size
+    // against the decode cost of one second of shuttle at 3x, 10x and 24x
+    static int runProfileBenchmark(const std::string& sourceFilename);
+};
+
+// Picks a pyramid level from playback speed, output size and the decode
+// throughput measured per level. Widths must be sorted ascending.
+class ProxyLevelSelector {
+public:
+    void configure(const std::vector<int>& levelWidths, size_t initialLevel);
+
+    void setOutputSize(int width, int height);
+    void recordDecode(size_t level, int frames, double seconds);
+    size_t choose(double playbackRateAbs, double sourceFps);
+    double measuredFps(size_t level) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<int> widths_;
+    std::vector<double> decodeFps_;   // EWMA per level, 0 = not measured yet
+    int outputWidth_ = 0;
+    size_t current_ = 0;
+    bool upgradePending_ = false;
+    std::chrono::steady_clock::time_point upgradeSince_;
+};
+
+#endif // PROXY_PYRAMID_H
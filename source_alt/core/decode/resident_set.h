@@ -0,0 +1,126 @@
+#ifndef RESIDENT_SET_H
+#define RESIDENT_SET_H
+
+#include <map>
+#include <vector>
+#include <mutex>
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+// Tracks which frame indices currently hold a decoded frame for one tier
+// (full-res, low-res, ...). Stored as disjoint inclusive runs [start, end],
+// because decoders always fill contiguous ranges. Window maintenance then
+// only touches the runs that actually leave the window instead of sweeping
+// the whole frame index.
+//
+// Locking: the set has its own mutex and never takes FrameInfo::mutex.
+// Decoders call insert() while holding the frame's mutex; evictors take
+// runs out of the set first and only then lock individual frames. That
+// ordering guarantees "frame present => index resident"; the reverse may be
+// briefly stale, which only costs a no-op visit on the next eviction.
+class ResidentSet {
+public:
+    using Run = std::pair<int, int>; // inclusive [first, second]
+
+    void insert(int index) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto next = runs_.upper_bound(index); // first run starting after index
+        if (next != runs_.begin()) {
+            auto prev = std::prev(next);
+            if (prev->second >= index) return; // already resident
+            if (prev->second == index - 1) {
+                prev->second = index;
+                if (next != runs_.end() && next->first == index + 1) {
+                    prev->second = next->second;
+                    runs_.erase(next);
+                }
+                ++count_;
+                return;
+            }
+        }
+        if (next != runs_.end() && next->first == index + 1) {
+            int end = next->second;
+            runs_.erase(next);
+            runs_.emplace(index, end);
+        } else {
+            runs_.emplace(index, index);
+        }
+        ++count_;
+    }
+
+    // Removes and returns every resident run clipped to [start, end].
+    std::vector<Run> takeInside(int start, int end) {
+        std::vector<Run> taken;
+        if (start > end) return taken;
+        std::lock_guard<std::mutex> lock(mutex_);
+        takeInsideLocked(start, end, taken);
+        return taken;
+    }
+
+    // Removes and returns every resident run that lies outside [start, end].
+    std::vector<Run> takeOutside(int start, int end) {
+        std::vector<Run> taken;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (start > 0) takeInsideLocked(0, start - 1, taken);
+        if (end < std::numeric_limits<int>::max()) takeInsideLocked(end + 1, std::numeric_limits<int>::max(), taken);
+        return taken;
+    }
+
+    std::vector<Run> takeAll() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Run> taken(runs_.begin(), runs_.end());
+        runs_.clear();
+        count_ = 0;
+        return taken;
+    }
+
+    // True if any index in [start, end] is resident
+    bool intersects(int start, int end) const {
+        if (start > end) return false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = runs_.upper_bound(end); // first run starting after end
+        if (it == runs_.begin()) return false;
+        return std::prev(it)->second >= start;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        runs_.clear();
+        count_ = 0;
+    }
+
+private:
+    void takeInsideLocked(int start, int end, std::vector<Run>& taken) {
+        auto it = runs_.upper_bound(start);
+        if (it != runs_.begin() && std::prev(it)->second >= start) --it;
+
+        while (it != runs_.end() && it->first <= end) {
+            int runStart = it->first;
+            int runEnd = it->second;
+            it = runs_.erase(it);
+
+            int cutStart = std::max(runStart, start);
+            int cutEnd = std::min(runEnd, end);
+            taken.emplace_back(cutStart, cutEnd);
+            count_ -= static_cast<size_t>(cutEnd - cutStart) + 1;
+
+            if (runStart < start) runs_.emplace(runStart, start - 1);
+            if (runEnd > end) {
+                runs_.emplace(end + 1, runEnd);
+                break;
+            }
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::map<int, int> runs_; // run start -> run end (inclusive)
+    size_t count_ = 0;
+};
+
+#endif // RESIDENT_SET_H
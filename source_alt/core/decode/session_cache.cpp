@@ -0,0 +1,143 @@
+#include "session_cache.h"
+#include "../log/logger.h"
+
+#include <algorithm>
+
+SessionCache sessionCache;
+
+namespace {
+
+size_t frameBytes(const AVFrame* frame) {
+    if (!frame) return 0;
+    if (frame->hw_frames_ctx) {
+        // A hardware surface; its memory is not in buf[]
+        return static_cast<size_t>(frame->width) * frame->height * 3 / 2;
+    }
+    size_t bytes = 0;
+    for (const AVBufferRef* buf : frame->buf) {
+        if (buf) bytes += buf->size;
+    }
+    return bytes;
+}
+
+bool statFile(const std::string& path, std::uintmax_t& size, std::filesystem::file_time_type& modified) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    modified = std::filesystem::last_write_time(path, ec);
+    return !ec;
+}
+
+} // namespace
+
+SessionCache::FullResWindow SessionCache::captureFullRes(std::vector<FrameInfo>& frameIndex, int frame) {
+    FullResWindow window;
+    int count = static_cast<int>(frameIndex.size());
+    if (count == 0) return window;
+    frame = std::clamp(frame, 0, count - 1);
+    window.first = std::max(0, frame - kFullResFrames);
+    int last = std::min(count - 1, frame + kFullResFrames);
+    for (int i = window.first; i <= last; ++i) {
+        std::lock_guard<std::mutex> lock(frameIndex[i].mutex);
+        window.frames.push_back(frameIndex[i].frame);
+    }
+    return window;
+}
+
+void SessionCache::setBudgetMb(size_t mb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = mb << 20;
+    evictOverBudget();
+}
+
+void SessionCache::store(PreparedFile&& file, FullResWindow&& window, double lastTime) {
+    Entry entry;
+    if (file.frameIndex.empty() || !statFile(file.path, entry.fileSize, entry.modified)) return;
+
+    // Cached frames stay; low-res frames go; full-res only in the window
+    std::vector<FrameInfo>& index = file.frameIndex;
+    size_t bytes = index.size() * sizeof(FrameInfo);
+    for (size_t i = 0; i < index.size(); ++i) {
+        FrameInfo& info = index[i];
+        std::lock_guard<std::mutex> lock(info.mutex);
+        info.low_res_frame.reset();
+        info.frame.reset();
+        size_t offset = i - static_cast<size_t>(window.first);
+        if (i >= static_cast<size_t>(window.first) && offset < window.frames.size()) {
+            info.frame = std::move(window.frames[offset]);
+        }
+        // Types are set directly: the frame-state summary describes the file now loading
+        if (info.frame) {
+            info.type = FrameInfo::FULL_RES;
+            info.format = static_cast<AVPixelFormat>(info.frame->format);
+        } else {
+            info.type = info.cached_frame ? FrameInfo::CACHED : FrameInfo::EMPTY;
+            info.format = AV_PIX_FMT_NONE;
+        }
+        info.is_decoding = false;
+        info.is_ready = false;
+        bytes += frameBytes(info.frame.get()) + frameBytes(info.cached_frame.get());
+    }
+    entry.file = std::move(file);
+    entry.file.resumeTime = lastTime;
+    entry.bytes = bytes;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->file.path == entry.file.path) {
+            bytes_ -= it->bytes;
+            entries_.erase(it);
+            break;
+        }
+    }
+    TX_LOG_INFO("Session", "Keeping " << entry.file.path << " (" << (bytes >> 20) << " MB)");
+    bytes_ += bytes;
+    entries_.push_front(std::move(entry));
+    evictOverBudget();
+}
+
+bool SessionCache::take(const std::string& path, PreparedFile& out) {
+    std::string key = FilePreparer::normalizePath(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) { return e.file.path == key; });
+    if (it == entries_.end()) return false;
+
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type modified;
+    bool unchanged = statFile(key, size, modified) && size == it->fileSize && modified == it->modified;
+    if (unchanged) out = std::move(it->file);
+    else TX_LOG_INFO("Session", key << " changed on disk; its kept state is dropped");
+    bytes_ -= it->bytes;
+    entries_.erase(it);
+    return unchanged;
+}
+
+bool SessionCache::contains(const std::string& path) {
+    std::string key = FilePreparer::normalizePath(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::any_of(entries_.begin(), entries_.end(), [&](const Entry& e) { return e.file.path == key; });
+}
+
+void SessionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    bytes_ = 0;
+}
+
+size_t SessionCache::files() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t SessionCache::bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+void SessionCache::evictOverBudget() {
+    while (bytes_ > budget_ && !entries_.empty()) {
+        TX_LOG_INFO("Session", "Evicting " << entries_.back().file.path << " (" << (entries_.back().bytes >> 20) << " MB)");
+        bytes_ -= entries_.back().bytes;
+        entries_.pop_back();
+    }
+}
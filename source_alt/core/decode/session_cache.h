@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "file_preparer.h"
+
+// Files of the session the player has switched away from, kept so that
+// returning to one skips the index, the proxy hash and the probe and starts
+// with warm frames.
+//
+// A kept file holds its frame index with the sparse-cache frames still in
+// it, plus a few full-res frames around the position it was left at; low-res
+// frames are dropped, the proxy decoder refills them in moments. Files are
+// evicted least recently used first to stay within a memory budget that
+// covers the indexes and every frame they hold. A file that changed on disk
+// since it was kept is not handed back.
+class SessionCache {
+public:
+    static constexpr size_t kDefaultBudgetMb = 1024;
+    static constexpr int kFullResFrames = 12; // Kept on each side of the last position
+
+    // Full-res frames around the playhead. The full-res manager releases its
+    // frames when it stops, so they are captured before that.
+    struct FullResWindow {
+        int first = 0;
+        std::vector<std::shared_ptr<AVFrame>> frames;
+    };
+    static FullResWindow captureFullRes(std::vector<FrameInfo>& frameIndex, int frame);
+
+    void setBudgetMb(size_t mb);
+
+    // Keeps a file that is being closed; its decoder managers must be stopped
+    void store(PreparedFile&& file, FullResWindow&& window, double lastTime);
+    // Moves a kept file into `out`, with `out.resumeTime` set to where it was left
+    bool take(const std::string& path, PreparedFile& out);
+    bool contains(const std::string& path);
+    void clear();
+
+    size_t files();
+    size_t bytes();
+
+private:
+    struct Entry {
+        PreparedFile file;
+        std::uintmax_t fileSize = 0;
+        std::filesystem::file_time_type modified;
+        size_t bytes = 0;
+    };
+
+    void evictOverBudget(); // Caller holds mutex_
+
+    std::mutex mutex_;
+    std::list<Entry> entries_; // Most recently used first
+    size_t bytes_ = 0;
+    size_t budget_ = kDefaultBudgetMb << 20;
+};
+
+extern SessionCache sessionCache;
@@ -0,0 +1,489 @@
+#include "thumbnail_strip.h"
+#include "../log/logger.h"
+#include "../trace/perf_trace.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+namespace {
+
+const char kStripMagic[8] = {'T', 'X', 'P', 'S', 'T', 'R', 'I', 'P'};
+
+// Thumbnails are for the next session; encoding must not compete with the decoders
+void lowerThreadPriority() {
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+}
+
+} // namespace
+
+ThumbnailStrip::ThumbnailStrip() {}
+
+ThumbnailStrip::~ThumbnailStrip() {
+    stopEncoding();
+    close();
+    if (encCtx_) avcodec_free_context(&encCtx_);
+    if (decCtx_) avcodec_free_context(&decCtx_);
+    if (swsCtx_) sws_freeContext(swsCtx_);
+    if (scaledFrame_) av_frame_free(&scaledFrame_);
+    if (packet_) av_packet_free(&packet_);
+    if (encPacket_) av_packet_free(&encPacket_);
+}
+
+std::string ThumbnailStrip::pathForProxy(const std::string& lowResFilename) {
+    const std::string suffix = "_lowres.mp4";
+    if (lowResFilename.size() > suffix.size() &&
+        lowResFilename.compare(lowResFilename.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return lowResFilename.substr(0, lowResFilename.size() - suffix.size()) + "_sparse.txs";
+    }
+    return lowResFilename + ".txs";
+}
+
+bool ThumbnailStrip::open(const std::string& path, int frameCount) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmapLocked();
+    path_ = path;
+    frameCount_ = frameCount;
+    covered_.clear();
+    pending_.clear();
+    rangesChanged_ = false;
+    return mapLocked();
+}
+
+bool ThumbnailStrip::mapLocked() {
+    int fd = ::open(path_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false; // No strip yet - normal for a file seen for the first time
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(StripHeader))) {
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // Mapping stays valid after close
+    if (addr == MAP_FAILED) {
+        TX_LOG_ERROR("ThumbnailStrip", "mmap failed for " << path_);
+        return false;
+    }
+
+    mapped_ = static_cast<const uint8_t*>(addr);
+    mappedSize_ = static_cast<size_t>(st.st_size);
+    header_ = reinterpret_cast<const StripHeader*>(mapped_);
+
+    size_t tablesSize = sizeof(StripHeader) +
+                        static_cast<size_t>(header_->rangeCount) * sizeof(StripRange) +
+                        static_cast<size_t>(header_->entryCount) * sizeof(StripEntry);
+
+    bool valid = std::memcmp(header_->magic, kStripMagic, sizeof(kStripMagic)) == 0 &&
+                 header_->version == kVersion &&
+                 header_->frameCount == frameCount_ &&
+                 header_->width > 0 && header_->height > 0 &&
+                 tablesSize <= mappedSize_;
+
+    if (valid) {
+        // covers() and loadRange() rely on both tables being sorted
+        const StripRange* ranges = reinterpret_cast<const StripRange*>(mapped_ + sizeof(StripHeader));
+        for (uint32_t i = 0; valid && i < header_->rangeCount; ++i) {
+            valid = ranges[i].start >= 0 && ranges[i].start <= ranges[i].end && ranges[i].end < frameCount_ &&
+                    (i == 0 || ranges[i].start > ranges[i - 1].end);
+        }
+        const StripEntry* entries = mappedEntries();
+        for (uint32_t i = 0; valid && i < header_->entryCount; ++i) {
+            const StripEntry& e = entries[i];
+            valid = e.frameIndex >= 0 && e.frameIndex < frameCount_ &&
+                    (i == 0 || e.frameIndex > entries[i - 1].frameIndex) &&
+                    e.offset >= tablesSize && e.offset <= mappedSize_ && e.size <= mappedSize_ - e.offset;
+        }
+    }
+
+    if (!valid) {
+        TX_LOG_WARN("ThumbnailStrip", "Ignoring stale or corrupt strip " << path_);
+        unmapLocked();
+        return false;
+    }
+
+    width_ = header_->width;
+    height_ = header_->height;
+    const StripRange* ranges = reinterpret_cast<const StripRange*>(mapped_ + sizeof(StripHeader));
+    covered_.assign(ranges, ranges + header_->rangeCount);
+
+    TX_LOG_INFO("ThumbnailStrip", "Mapped " << path_ << " (" << header_->entryCount << " thumbnails, "
+                << header_->rangeCount << " ranges, " << mappedSize_ / 1024 << " KB)");
+    return true;
+}
+
+void ThumbnailStrip::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmapLocked();
+}
+
+void ThumbnailStrip::unmapLocked() {
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(mapped_), mappedSize_);
+    }
+    mapped_ = nullptr;
+    mappedSize_ = 0;
+    header_ = nullptr;
+}
+
+bool ThumbnailStrip::isMapped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mapped_ != nullptr;
+}
+
+const ThumbnailStrip::StripEntry* ThumbnailStrip::mappedEntries() const {
+    return reinterpret_cast<const StripEntry*>(mapped_ + sizeof(StripHeader) +
+                                               static_cast<size_t>(header_->rangeCount) * sizeof(StripRange));
+}
+
+bool ThumbnailStrip::covers(int start, int end) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& r : covered_) {
+        if (r.start <= start && r.end >= end) return true;
+        if (r.start > start) break;
+    }
+    return false;
+}
+
+size_t ThumbnailStrip::entryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = pending_.size();
+    if (header_) count += header_->entryCount;
+    return count;
+}
+
+int ThumbnailStrip::loadRange(int start, int end,
+                              const std::function<void(int, std::shared_ptr<AVFrame>)>& sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int delivered = 0;
+
+    if (header_) {
+        const StripEntry* entries = mappedEntries();
+        const StripEntry* last = entries + header_->entryCount;
+        const StripEntry* it = std::lower_bound(entries, last, start,
+            [](const StripEntry& e, int idx) { return e.frameIndex < idx; });
+        for (; it != last && it->frameIndex <= end; ++it) {
+            if (pending_.count(it->frameIndex)) continue; // Newer copy pending
+            auto frame = decodeJpeg(mapped_ + it->offset, it->size);
+            if (frame) {
+                sink(it->frameIndex, frame);
+                ++delivered;
+            }
+        }
+    }
+
+    for (auto it = pending_.lower_bound(start); it != pending_.end() && it->first <= end; ++it) {
+        auto frame = decodeJpeg(it->second.data(), it->second.size());
+        if (frame) {
+            sink(it->first, frame);
+            ++delivered;
+        }
+    }
+    return delivered;
+}
+
+bool ThumbnailStrip::ensureEncoder(const AVFrame* src) {
+    if (!encCtx_) {
+        int width, height;
+        {
+            // Keep the geometry of an existing strip so old and new thumbnails match
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (width_ <= 0 || height_ <= 0) {
+                width_ = std::min(kThumbWidth, src->width) & ~1;
+                height_ = static_cast<int>(static_cast<int64_t>(src->height) * width_ / src->width) & ~1;
+                if (width_ <= 0 || height_ <= 0) return false;
+            }
+            width = width_;
+            height = height_;
+        }
+
+        const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+        if (!codec) {
+            TX_LOG_ERROR("ThumbnailStrip", "MJPEG encoder not available");
+            return false;
+        }
+        encCtx_ = avcodec_alloc_context3(codec);
+        if (!encCtx_) return false;
+        encCtx_->width = width;
+        encCtx_->height = height;
+        encCtx_->pix_fmt = AV_PIX_FMT_YUVJ420P;
+        encCtx_->time_base = {1, 25};
+        encCtx_->flags |= AV_CODEC_FLAG_QSCALE;
+        encCtx_->global_quality = FF_QP2LAMBDA * kJpegQScale;
+        if (avcodec_open2(encCtx_, codec, nullptr) < 0) {
+            TX_LOG_ERROR("ThumbnailStrip", "Failed to open MJPEG encoder");
+            avcodec_free_context(&encCtx_);
+            return false;
+        }
+
+        scaledFrame_ = av_frame_alloc();
+        if (!scaledFrame_) return false;
+        scaledFrame_->format = AV_PIX_FMT_YUVJ420P;
+        scaledFrame_->width = width;
+        scaledFrame_->height = height;
+        if (av_frame_get_buffer(scaledFrame_, 0) < 0) {
+            av_frame_free(&scaledFrame_);
+            return false;
+        }
+    }
+
+    if (!swsCtx_ || swsSrcWidth_ != src->width || swsSrcHeight_ != src->height || swsSrcFormat_ != src->format) {
+        if (swsCtx_) sws_freeContext(swsCtx_);
+        swsCtx_ = sws_getContext(src->width, src->height, static_cast<AVPixelFormat>(src->format),
+                                 encCtx_->width, encCtx_->height, AV_PIX_FMT_YUVJ420P,
+                                 SWS_BILINEAR, nullptr, nullptr, nullptr);
+        swsSrcWidth_ = src->width;
+        swsSrcHeight_ = src->height;
+        swsSrcFormat_ = src->format;
+    }
+    return swsCtx_ != nullptr;
+}
+
+void ThumbnailStrip::recordSegment(int start, int end, FrameRefs frames) {
+    if (start > end || frames.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(encodeMutex_);
+        if (encodeStopping_) return;
+        if (encodeQueue_.size() >= kMaxQueuedSegments) {
+            TX_LOG_DEBUG("ThumbnailStrip", "Encoder behind, not recording [" << encodeQueue_.front().start
+                         << "-" << encodeQueue_.front().end << "]");
+            encodeQueue_.pop_front();
+        }
+        encodeQueue_.push_back({start, end, std::move(frames)});
+        if (!encodeThread_.joinable()) {
+            encodeThread_ = std::thread(&ThumbnailStrip::encodeLoop, this);
+        }
+    }
+    encodeCv_.notify_one();
+}
+
+void ThumbnailStrip::stopEncoding() {
+    {
+        std::lock_guard<std::mutex> lock(encodeMutex_);
+        encodeStopping_ = true;
+        encodeQueue_.clear();
+    }
+    encodeAbort_ = true;
+    encodeCv_.notify_all();
+    if (encodeThread_.joinable()) encodeThread_.join();
+
+    std::lock_guard<std::mutex> lock(encodeMutex_);
+    encodeStopping_ = false;
+    encodeAbort_ = false;
+}
+
+void ThumbnailStrip::encodeLoop() {
+    PerfTrace::setThreadName("strip_encoder");
+    lowerThreadPriority();
+    for (;;) {
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(encodeMutex_);
+            encodeCv_.wait(lock, [this] { return encodeStopping_ || !encodeQueue_.empty(); });
+            if (encodeStopping_) return;
+            job = std::move(encodeQueue_.front());
+            encodeQueue_.pop_front();
+        }
+
+        size_t recorded = 0;
+        for (auto& entry : job.frames) {
+            if (encodeAbort_) break;
+            if (addFrame(entry.first, entry.second.get())) ++recorded;
+            entry.second.reset(); // The segment may have been unloaded; let the frame go
+        }
+        // Only claim coverage if every frame of the segment is in the strip; a
+        // segment with holes stays uncovered and is decoded again next session
+        if (recorded == job.frames.size()) {
+            markCovered(job.start, job.end);
+        } else if (recorded > 0) {
+            TX_LOG_DEBUG("ThumbnailStrip", "Encoded " << recorded << " of " << job.frames.size()
+                         << " frames of [" << job.start << "-" << job.end << "]; not marked covered");
+        }
+    }
+}
+
+bool ThumbnailStrip::addFrame(int frameIndex, const AVFrame* frame) {
+    if (!frame || !frame->data[0] || frame->width <= 0 || frame->height <= 0) return false;
+    if (frame->format == AV_PIX_FMT_VIDEOTOOLBOX) return false; // Sparse tier is always SW
+
+    // The encoder state is the encoder thread's; mutex_ is only taken to store the result
+    if (!ensureEncoder(frame)) return false;
+    if (!encPacket_ && !(encPacket_ = av_packet_alloc())) return false;
+    if (av_frame_make_writable(scaledFrame_) < 0) return false;
+
+    sws_scale(swsCtx_, frame->data, frame->linesize, 0, frame->height,
+              scaledFrame_->data, scaledFrame_->linesize);
+    scaledFrame_->pts = frameIndex;
+    scaledFrame_->quality = encCtx_->global_quality;
+
+    if (avcodec_send_frame(encCtx_, scaledFrame_) < 0) return false;
+    std::vector<uint8_t> jpeg;
+    while (avcodec_receive_packet(encCtx_, encPacket_) == 0) {
+        jpeg.assign(encPacket_->data, encPacket_->data + encPacket_->size);
+        av_packet_unref(encPacket_);
+    }
+    if (jpeg.empty()) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_[frameIndex] = std::move(jpeg);
+    return true;
+}
+
+void ThumbnailStrip::mergeRange(std::vector<StripRange>& ranges, int start, int end) {
+    ranges.push_back({start, end});
+    std::sort(ranges.begin(), ranges.end(),
+              [](const StripRange& a, const StripRange& b) { return a.start < b.start; });
+    std::vector<StripRange> merged;
+    for (const auto& r : ranges) {
+        if (!merged.empty() && r.start <= merged.back().end + 1) {
+            merged.back().end = std::max(merged.back().end, r.end);
+        } else {
+            merged.push_back(r);
+        }
+    }
+    ranges.swap(merged);
+}
+
+void ThumbnailStrip::markCovered(int start, int end) {
+    if (start > end) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    mergeRange(covered_, start, end);
+    rangesChanged_ = true;
+}
+
+bool ThumbnailStrip::hasPendingChanges() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rangesChanged_ || !pending_.empty();
+}
+
+bool ThumbnailStrip::ensureDecoder() {
+    if (decCtx_) return true;
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+    if (!codec) {
+        TX_LOG_ERROR("ThumbnailStrip", "MJPEG decoder not available");
+        return false;
+    }
+    decCtx_ = avcodec_alloc_context3(codec);
+    if (!decCtx_) return false;
+    if (avcodec_open2(decCtx_, codec, nullptr) < 0) {
+        TX_LOG_ERROR("ThumbnailStrip", "Failed to open MJPEG decoder");
+        avcodec_free_context(&decCtx_);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<AVFrame> ThumbnailStrip::decodeJpeg(const uint8_t* data, size_t size) {
+    if (!ensureDecoder()) return nullptr;
+    if (!packet_ && !(packet_ = av_packet_alloc())) return nullptr;
+
+    // The decoder needs AV_INPUT_BUFFER_PADDING_SIZE after the payload, which the
+    // mapped file cannot guarantee - copy into a padded packet.
+    if (av_new_packet(packet_, static_cast<int>(size)) < 0) return nullptr;
+    std::memcpy(packet_->data, data, size);
+
+    int ret = avcodec_send_packet(decCtx_, packet_);
+    av_packet_unref(packet_);
+    if (ret < 0) return nullptr;
+
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) return nullptr;
+    if (avcodec_receive_frame(decCtx_, frame) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    return std::shared_ptr<AVFrame>(frame, [](AVFrame* f) { av_frame_free(&f); });
+}
+
+bool ThumbnailStrip::save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty() || (!rangesChanged_ && pending_.empty())) return true;
+    if (width_ <= 0 || height_ <= 0) return false;
+
+    // Merge mapped entries with this session's thumbnails (pending wins)
+    struct Source { const uint8_t* data; uint32_t size; };
+    std::map<int, Source> merged;
+    if (header_) {
+        const StripEntry* entries = mappedEntries();
+        for (uint32_t i = 0; i < header_->entryCount; ++i) {
+            merged[entries[i].frameIndex] = {mapped_ + entries[i].offset, entries[i].size};
+        }
+    }
+    for (const auto& p : pending_) {
+        merged[p.first] = {p.second.data(), static_cast<uint32_t>(p.second.size())};
+    }
+
+    StripHeader header;
+    std::memcpy(header.magic, kStripMagic, sizeof(kStripMagic));
+    header.version = kVersion;
+    header.frameCount = frameCount_;
+    header.width = width_;
+    header.height = height_;
+    header.rangeCount = static_cast<uint32_t>(covered_.size());
+    header.entryCount = static_cast<uint32_t>(merged.size());
+
+    std::vector<StripEntry> table;
+    table.reserve(merged.size());
+    uint64_t offset = sizeof(StripHeader) + covered_.size() * sizeof(StripRange) + merged.size() * sizeof(StripEntry);
+    for (const auto& m : merged) {
+        table.push_back({m.first, m.second.size, offset});
+        offset += m.second.size;
+    }
+
+    std::string tmpPath = path_ + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            TX_LOG_ERROR("ThumbnailStrip", "Cannot write " << tmpPath);
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(covered_.data()), covered_.size() * sizeof(StripRange));
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(StripEntry));
+        for (const auto& m : merged) {
+            out.write(reinterpret_cast<const char*>(m.second.data), m.second.size);
+        }
+        if (!out) {
+            TX_LOG_ERROR("ThumbnailStrip", "Write failed for " << tmpPath);
+            out.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    // Sources may point into the old mapping - only unmap after the write
+    unmapLocked();
+    if (std::rename(tmpPath.c_str(), path_.c_str()) != 0) {
+        TX_LOG_ERROR("ThumbnailStrip", "Failed to move " << tmpPath << " into place");
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    TX_LOG_INFO("ThumbnailStrip", "Saved " << merged.size() << " thumbnails to " << path_
+                << " (" << offset / 1024 << " KB)");
+    pending_.clear();
+    rangesChanged_ = false;
+    mapLocked(); // Serve later loads from the new file
+    return true;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+// Persistent copy of the sparse (CACHED) tier.
+//
+// The strip lives next to the low-res proxy in the cache directory and holds
+// small JPEG thumbnails of every frame CachedDecoder stored, plus a table of
+// frame ranges that were fully covered. On reopen the file is mmap'd and only
+// the table is parsed; thumbnails are decompressed lazily when a segment is
+// loaded, so shuttle over previously seen material does not wait for the
+// proxy to be decoded again.
+//
+// New thumbnails are encoded on a low-priority background thread from
+// references to the frames the decoder stored, so recording a segment does
+// not hold up loading the next one.
+//
+// File layout (native endianness, all fields naturally aligned):
+//   StripHeader
+//   StripRange[rangeCount]      covered frame ranges, sorted, non-overlapping
+//   StripEntry[entryCount]      sorted by frameIndex
+//   JPEG payloads
+class ThumbnailStrip {
+public:
+    ThumbnailStrip();
+    ~ThumbnailStrip();
+
+    ThumbnailStrip(const ThumbnailStrip&) = delete;
+    ThumbnailStrip& operator=(const ThumbnailStrip&) = delete;
+
+    // "<id>_lowres.mp4" -> "<id>_sparse.txs" in the same directory
+    static std::string pathForProxy(const std::string& lowResFilename);
+
+    // Map an existing strip. Returns false (and stays usable for writing) if the
+    // file is missing, corrupt, or was built for a different frame count.
+    bool open(const std::string& path, int frameCount);
+    void close();
+    bool isMapped() const;
+
+    // True if every frame in [start, end] was covered by a previous decode pass
+    bool covers(int start, int end) const;
+    size_t entryCount() const;
+
+    // Decompress every thumbnail stored in [start, end] and pass it to sink.
+    // Returns the number of frames delivered.
+    int loadRange(int start, int end,
+                  const std::function<void(int, std::shared_ptr<AVFrame>)>& sink);
+
+    // --- Recording for the next session ---
+    using FrameRefs = std::vector<std::pair<int, std::shared_ptr<AVFrame>>>;
+    // Queue the frames decoded for [start, end] for encoding; the range is
+    // marked covered once all of them are encoded. Returns immediately.
+    void recordSegment(int start, int end, FrameRefs frames);
+    // Drop queued segments and join the encoder thread; call before save()
+    void stopEncoding();
+    void markCovered(int start, int end);
+    bool hasPendingChanges() const;
+
+    // Merge mapped and pending data into a new file (written to a temp file and
+    // renamed into place), then remap it.
+    bool save();
+
+private:
+    struct StripHeader {
+        char magic[8];
+        uint32_t version;
+        int32_t frameCount;
+        int32_t width;
+        int32_t height;
+        uint32_t rangeCount;
+        uint32_t entryCount;
+    };
+    struct StripRange {
+        int32_t start;
+        int32_t end;
+    };
+    struct StripEntry {
+        int32_t frameIndex;
+        uint32_t size;
+        uint64_t offset;
+    };
+
+    struct EncodeJob {
+        int start;
+        int end;
+        FrameRefs frames;
+    };
+
+    static constexpr uint32_t kVersion = 1;
+    static constexpr int kThumbWidth = 320;   // Half of the 640px proxy
+    static constexpr int kJpegQScale = 6;     // 2 (best) .. 31 (worst)
+    static constexpr size_t kMaxQueuedSegments = 4; // Older segments are dropped, not waited for
+
+    void encodeLoop();
+    bool addFrame(int frameIndex, const AVFrame* frame); // Encoder thread only
+    bool ensureEncoder(const AVFrame* src);
+    bool ensureDecoder();
+    std::shared_ptr<AVFrame> decodeJpeg(const uint8_t* data, size_t size);
+    const StripEntry* mappedEntries() const;
+    static void mergeRange(std::vector<StripRange>& ranges, int start, int end);
+    bool mapLocked();
+    void unmapLocked();
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    int frameCount_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+
+    // mmap'd file
+    const uint8_t* mapped_ = nullptr;
+    size_t mappedSize_ = 0;
+    const StripHeader* header_ = nullptr;
+
+    std::vector<StripRange> covered_;                    // mapped + pending, merged
+    std::map<int, std::vector<uint8_t>> pending_;       // frameIndex -> JPEG
+    bool rangesChanged_ = false;
+
+    // Background encoding
+    std::mutex encodeMutex_;
+    std::condition_variable encodeCv_;
+    std::deque<EncodeJob> encodeQueue_;
+    std::thread encodeThread_;
+    bool encodeStopping_ = false;
+    std::atomic<bool> encodeAbort_{false};
+
+    // Encoder / scaler for new thumbnails; used by the encoder thread only
+    AVCodecContext* encCtx_ = nullptr;
+    SwsContext* swsCtx_ = nullptr;
+    AVFrame* scaledFrame_ = nullptr;
+    int swsSrcWidth_ = 0;
+    int swsSrcHeight_ = 0;
+    int swsSrcFormat_ = -1;
+    AVPacket* encPacket_ = nullptr;
+
+    // Decoder for reading thumbnails back
+    AVCodecContext* decCtx_ = nullptr;
+    AVPacket* packet_ = nullptr;
+};
@@ -51,10 +51,20 @@ void displayFrame(
     float targetDisplayAspectRatio
 );
 
+// Starts the software download of a hardware frame ahead of displayFrame,
+// so it overlaps the rest of the loop iteration
+void stageFrameForDisplay(const std::shared_ptr<AVFrame>& frame);
+
 void renderLoadingScreen(SDL_Renderer* renderer, TTF_Font* font, const LoadingStatus& status);
 
 void cleanupDisplayResources();
 
+class FrameSink;
+// Headless output: every present is read back into `sink` first (nullptr to stop)
+void setDisplayFrameSink(FrameSink* sink);
+// SDL_RenderPresent, preceded by the frame sink read-back when one is set
+void presentRenderer(SDL_Renderer* renderer);
+
 void renderZoomedFrame(SDL_Renderer* renderer, SDL_Texture* texture, int frameWidth, int frameHeight, float zoomFactor, float centerX, float centerY);
 
 void renderZoomThumbnail(SDL_Renderer* renderer, SDL_Texture* texture, int frameWidth, int frameHeight, float zoomFactor, float centerX, float centerY);
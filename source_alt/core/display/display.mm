@@ -31,7 +31,14 @@ extern "C" {
 #include "../decode/decode.h"
 #include "common.h" // Include common.h for playback_rate access
 #include "display.h"
+#include "tape_effect.h"
+#include "frame_uploader.h"
+#include "osd_text.h"
+#include "index_bar.h"
+#include "frame_sink.h"
 #include "metal_renderer.h"
+#include "../trace/perf_trace.h"
+#include "../trace/metrics.h"
 #include "../audio/mainau.h" // Add this at the top with other includes
 #include "../decode/decode.h" // Include for FrameInfo::FrameType
 
@@ -79,6 +86,22 @@ static const std::chrono::milliseconds HSYNC_MIN_INTERVAL(1000); // Min 1 second
 static float tearLineNormalized = 0.5f; // Vertical position of the "tear" (0.0 to 1.0)
 // --- End HSync State ---
 
+// Shuttle effect kernel and the single PRNG behind all effect randomness (HSync, jitter, stripes, snow).
+// Seeded once, so a given TAPEXPLAYER_EFFECT_SEED reproduces the same effect sequence.
+static TapeEffect tapeEffect(TapeEffect::seedFromEnvironment());
+
+// Staging frames, conversion contexts and the download worker of the SW upload path
+static FrameUploader frameUploader;
+
+// Glyph atlas and string layouts for the OSD bar and the loading screen
+static OsdText osdText;
+
+// Frame-type bar texture
+static IndexBar indexBar;
+
+// Headless output, read back before each present
+static FrameSink* displayFrameSink = nullptr;
+
 // Forward declarations for zoom functions
 void renderZoomedFrame(SDL_Renderer* renderer, SDL_Texture* texture, int frameWidth, int frameHeight, float zoomFactor, float centerX, float centerY);
 void renderZoomThumbnail(SDL_Renderer* renderer, SDL_Texture* texture, int frameWidth, int frameHeight, float zoomFactor, float centerX, float centerY);
@@ -177,60 +200,10 @@ void get_video_dimensions(const char* filename, int* width, int* height) {
 }
 
 void updateVisualization(SDL_Renderer* renderer, const std::vector<FrameInfo>& frameIndex, int currentFrame, int bufferStart, int bufferEnd, int highResStart, int highResEnd, bool enableHighResDecode) {
-    int totalFrames = frameIndex.size();
-    if (totalFrames == 0) return; // Nothing to draw
-
-    int windowWidth, windowHeight;
-    SDL_GetRendererOutputSize(renderer, &windowWidth, &windowHeight);
-    
-    int indexHeight = 5; // Reduce the height of the index bar to 5 pixels
-    double frameWidth = static_cast<double>(windowWidth) / totalFrames;
-
-    // Clear only the top part of the screen for the index
-    SDL_SetRenderDrawColor(renderer, 10, 10, 10, 255); // Slightly lighter background for index
-    SDL_Rect indexRect = {0, 0, windowWidth, indexHeight};
-    SDL_RenderFillRect(renderer, &indexRect);
-
-    // --- Optimized Rendering: Iterate through visible pixels --- 
-    for (int pixelX = 0; pixelX < windowWidth; ++pixelX) {
-        // Determine the representative frame index for this pixel column
-        int frameIdx = static_cast<int>(pixelX / frameWidth);
-        frameIdx = std::max(0, std::min(frameIdx, totalFrames - 1)); // Clamp index
-
-        // Get the type of the representative frame
-        FrameInfo::FrameType type = frameIndex[frameIdx].type;
-        bool isInBuffer = (frameIdx >= bufferStart && frameIdx <= bufferEnd);
-        
-        Uint8 r, g, b;
-        
-        // Determine color based on type and buffer status
-        if (isInBuffer) {
-            switch (type) {
-                case FrameInfo::LOW_RES: r = 0; g = 128; b = 255; break; // Light blue
-                case FrameInfo::FULL_RES: r = 255; g = 255; b = 0; break; // Yellow
-                case FrameInfo::CACHED: r = 0; g = 255; b = 128; break; // Light green
-                case FrameInfo::EMPTY: default: r = 64; g = 64; b = 64; break; // Dark gray
-            }
-        } else { // Outside buffer
-            if (type == FrameInfo::CACHED) {
-                r = 0; g = 128; b = 64; // Darker green
-    } else {
-                r = 32; g = 32; b = 32; // Very dark gray
-            }
-        }
-
-        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-        SDL_RenderDrawLine(renderer, pixelX, 0, pixelX, indexHeight - 1);
-    }
+    if (frameIndex.empty()) return; // Nothing to draw
 
-    // --- Render current frame (playhead) --- 
-    int playheadX = static_cast<int>(currentFrame * frameWidth);
-    playheadX = std::max(0, std::min(playheadX, windowWidth - 1));
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
-    SDL_RenderDrawLine(renderer, playheadX, 0, playheadX, indexHeight - 1);
-    if (frameWidth < 1.0 && playheadX < windowWidth - 1) { 
-         SDL_RenderDrawLine(renderer, playheadX + 1, 0, playheadX + 1, indexHeight - 1);
-    }
+    // Colours come from frameStateSummary; the frame index itself is not walked
+    indexBar.render(renderer, currentFrame, bufferStart, bufferEnd);
 }
 
 void renderOSD(SDL_Renderer* renderer, TTF_Font* font, bool isPlaying, double playbackRate, bool isReverse, double currentTime, int frameNumber, bool showOSD, bool waiting_for_timecode, const std::string& input_timecode, double original_fps, bool jog_forward, bool jog_backward, FrameInfo::FrameType frameTypeToDisplay) {
@@ -258,43 +231,26 @@ void renderOSD(SDL_Renderer* renderer, TTF_Font* font, bool isPlaying, double pl
         leftText = "PLAY";
     }
 
-    SDL_Surface* leftSurface = TTF_RenderText_Blended(font, leftText.c_str(), textColor);
-    if (leftSurface) {
-        SDL_Texture* leftTexture = SDL_CreateTextureFromSurface(renderer, leftSurface);
-        if (leftTexture) {
-            SDL_Rect leftRect = {10, windowHeight - 30 + (30 - leftSurface->h) / 2, leftSurface->w, leftSurface->h};
-            SDL_RenderCopy(renderer, leftTexture, NULL, &leftRect);
-            SDL_DestroyTexture(leftTexture);
-        }
-        SDL_FreeSurface(leftSurface);
+    int textWidth = 0, textHeight = 0;
+    if (osdText.measure(renderer, font, leftText, textWidth, textHeight)) {
+        osdText.draw(renderer, font, leftText, 10, windowHeight - 30 + (30 - textHeight) / 2, textColor);
     }
 
     // Timecode
     if (waiting_for_timecode) {
-        // First render the full template in gray to get the total width
+        // Measure the full template to get the total width
         std::string template_timecode = "00:00:00:00";
-        SDL_Surface* templateSurface = TTF_RenderText_Blended(font, template_timecode.c_str(), grayColor);
-        if (!templateSurface) return;
-        
-        int totalWidth = templateSurface->w;
-        int totalHeight = templateSurface->h;
-        SDL_FreeSurface(templateSurface);
+        int totalWidth = 0, totalHeight = 0;
+        if (!osdText.measure(renderer, font, template_timecode, totalWidth, totalHeight)) return;
         
         // Calculate center position
         int startX = (windowWidth - totalWidth) / 2;
         int startY = windowHeight - 30 + (30 - totalHeight) / 2;
         
-        // Get the width of a single digit for positioning
-        SDL_Surface* digitSurface = TTF_RenderText_Blended(font, "0", grayColor);
-        if (!digitSurface) return;
-        int digitWidth = digitSurface->w;
-        SDL_FreeSurface(digitSurface);
-        
-        // Get the width of a colon for positioning
-        SDL_Surface* colonSurface = TTF_RenderText_Blended(font, ":", textColor);
-        if (!colonSurface) return;
-        int colonWidth = colonSurface->w;
-        SDL_FreeSurface(colonSurface);
+        // Get the width of a single digit and of a colon for positioning
+        int digitWidth = 0, colonWidth = 0, glyphHeight = 0;
+        if (!osdText.measure(renderer, font, "0", digitWidth, glyphHeight)) return;
+        if (!osdText.measure(renderer, font, ":", colonWidth, glyphHeight)) return;
         
         // Render each character
         std::string displayTimecode = "00:00:00:00";
@@ -317,41 +273,14 @@ void renderOSD(SDL_Renderer* renderer, TTF_Font* font, bool isPlaying, double pl
             }
             
             // Render character
-            char charStr[2] = {currentChar, '\0'};
-            SDL_Surface* charSurface = TTF_RenderText_Blended(font, charStr, *currentColor);
-            if (charSurface) {
-                SDL_Texture* charTexture = SDL_CreateTextureFromSurface(renderer, charSurface);
-                if (charTexture) {
-                    SDL_Rect charRect = {
-                        currentX,
-                        startY,
-                        charSurface->w,
-                        charSurface->h
-                    };
-                    SDL_RenderCopy(renderer, charTexture, NULL, &charRect);
-                    SDL_DestroyTexture(charTexture);
-                }
-                currentX += isColon ? colonWidth : digitWidth;
-                SDL_FreeSurface(charSurface);
-            }
+            osdText.draw(renderer, font, std::string(1, currentChar), currentX, startY, *currentColor);
+            currentX += isColon ? colonWidth : digitWidth;
         }
     } else {
         // Normal timecode display (not in input mode)
         std::string timecode = generateTXTimecode(currentTime);
-        SDL_Surface* timecodeSurface = TTF_RenderText_Blended(font, timecode.c_str(), textColor);
-        if (timecodeSurface) {
-            SDL_Texture* timecodeTexture = SDL_CreateTextureFromSurface(renderer, timecodeSurface);
-            if (timecodeTexture) {
-                SDL_Rect timecodeRect = {
-                    (windowWidth - timecodeSurface->w) / 2,
-                    windowHeight - 30 + (30 - timecodeSurface->h) / 2,
-                    timecodeSurface->w,
-                    timecodeSurface->h
-                };
-                SDL_RenderCopy(renderer, timecodeTexture, NULL, &timecodeRect);
-                SDL_DestroyTexture(timecodeTexture);
-            }
-            SDL_FreeSurface(timecodeSurface);
+        if (osdText.measure(renderer, font, timecode, textWidth, textHeight)) {
+            osdText.draw(renderer, font, timecode, (windowWidth - textWidth) / 2, windowHeight - 30 + (30 - textHeight) / 2, textColor);
         }
     }
 
@@ -369,16 +298,44 @@ void renderOSD(SDL_Renderer* renderer, TTF_Font* font, bool isPlaying, double pl
         rightText += "x";
     }
     
-    SDL_Surface* rightSurface = TTF_RenderText_Blended(font, rightText.c_str(), textColor);
-    if (rightSurface) {
-        SDL_Texture* rightTexture = SDL_CreateTextureFromSurface(renderer, rightSurface);
-        if (rightTexture) {
-            SDL_Rect rightRect = {windowWidth - rightSurface->w - 10, windowHeight - 30 + (30 - rightSurface->h) / 2, rightSurface->w, rightSurface->h};
-            SDL_RenderCopy(renderer, rightTexture, NULL, &rightRect);
-            SDL_DestroyTexture(rightTexture);
-        }
-        SDL_FreeSurface(rightSurface);
+    if (osdText.measure(renderer, font, rightText, textWidth, textHeight)) {
+        osdText.draw(renderer, font, rightText, windowWidth - textWidth - 10, windowHeight - 30 + (30 - textHeight) / 2, textColor);
     }
+
+    // All OSD text in one draw call
+    osdText.flush(renderer);
+}
+
+// Latency metrics page (Alt+M), top-left. The text is rebuilt a few times a
+// second so the numbers stay readable and the layout cache is not churned.
+static void renderMetricsOverlay(SDL_Renderer* renderer, TTF_Font* font) {
+    static std::vector<std::string> lines;
+    static Uint32 lastRefreshTicks = 0;
+    Uint32 now = SDL_GetTicks();
+    if (lines.empty() || now - lastRefreshTicks >= 250) {
+        lines = playerMetrics.overlayLines();
+        lastRefreshTicks = now;
+    }
+
+    int lineWidth = 0, lineHeight = 0, boxWidth = 0;
+    for (const std::string& line : lines) {
+        if (!osdText.measure(renderer, font, line, lineWidth, lineHeight)) return;
+        boxWidth = std::max(boxWidth, lineWidth);
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 170);
+    SDL_Rect background = {10, 10, boxWidth + 20, static_cast<int>(lines.size()) * lineHeight + 20};
+    SDL_RenderFillRect(renderer, &background);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    SDL_Color textColor = {255, 255, 255, 255};
+    int y = 20;
+    for (const std::string& line : lines) {
+        osdText.draw(renderer, font, line, 20, y, textColor);
+        y += lineHeight;
+    }
+    osdText.flush(renderer);
 }
 
 
@@ -408,6 +365,7 @@ void displayFrame(
     // Add the new parameter to the definition
     float targetDisplayAspectRatio
 ) {
+    PERF_SPAN("display.frame");
     auto request_time = std::chrono::high_resolution_clock::now();
     auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(request_time.time_since_epoch()).count();
     // std::cout << "[TimingDebug:" << ms_since_epoch << "] RENDER frame request: " << newCurrentFrame << " (Segment: " << (segmentSize > 0 ? newCurrentFrame / segmentSize : -1) << ")" << std::endl; // Optional log
@@ -417,14 +375,6 @@ void displayFrame(
     int windowWidth, windowHeight;
     SDL_GetRendererOutputSize(renderer, &windowWidth, &windowHeight);
     static bool firstFrameRendered = false; // Track if at least one frame (Metal or SW) has been shown
-    // Use unique_ptr with custom deleter for automatic cleanup of SwsContext
-    struct SwsContextDeleter {
-        void operator()(SwsContext* ctx) const {
-            if (ctx) { sws_freeContext(ctx); }
-        }
-    };
-    static std::unique_ptr<SwsContext, SwsContextDeleter> swsContextPtr = nullptr;
-    static AVPixelFormat lastSrcPixFormat = AV_PIX_FMT_NONE;
     static SDL_PixelFormatEnum lastSdlPixFormat = SDL_PIXELFORMAT_UNKNOWN;
     bool newFrameProcessed = (frameToDisplay != nullptr); // Flag: True if a new frame ptr was provided
 
@@ -475,23 +425,17 @@ void displayFrame(
     if (hsyncConditionMet && !hsyncLossActive) {
         auto now = std::chrono::steady_clock::now();
         if (now - hsyncLastTriggerTime > HSYNC_MIN_INTERVAL) {
-            // Use a thread-local random engine for better randomness if called from multiple threads,
-            // but displayFrame is likely called from a single render thread.
-            static std::mt19937 gen(std::random_device{}());
-            // Increase probability for debugging
-            std::uniform_int_distribution<> distrib(1, 30); // Chance: 1 in 30 calls (was 250)
-
-            if (distrib(gen) == 1) {
+            // Chance: 1 in 30 calls (was 250)
+            if (tapeEffect.rng().below(30) == 0) {
                 hsyncLossActive = true;
                 hsyncEffectCurrentFrame = 0;
                 // Duration 0.4 to 0.8 seconds based on typical FPS (e.g., 25-60)
-                float effectDurationSec = 0.4f + (static_cast<float>(gen() % 201) / 1000.0f); // Changed to 0.4 to 0.6 sec
+                float effectDurationSec = 0.4f + (static_cast<float>(tapeEffect.rng().below(201)) / 1000.0f); // Changed to 0.4 to 0.6 sec
                 hsyncEffectDurationFrames = static_cast<int>( (originalFps > 0 ? originalFps : 30.0) * effectDurationSec );
                 if (hsyncEffectDurationFrames < 5) hsyncEffectDurationFrames = 5; // Minimum duration
 
                 // Max skew amount will be calculated based on destRect.w later, if effect triggers
                 // For now, set a placeholder or calculate if destRect.w is known (it's not yet)
-                // hsyncMaxSkewAmount = (destRect.w * 0.03f) + (static_cast<float>(gen() % (int)(destRect.w * 0.05f)));
                 hsyncLastTriggerTime = now;
             }
         }
@@ -556,53 +500,46 @@ void displayFrame(
 
         // --- Если не рендерили через Metal, используем старый SW путь ---
         if (!renderedWithMetal) {
-             // --- Add Hardware Frame Transfer Logic ---
-             AVFrame* original_frame = frame; // Keep original pointer
-             AVFrame* sw_frame = nullptr;     // Pointer for potential software frame
-             bool frame_transferred = false;
-
+             double absPlaybackRate = std::abs(currentPlaybackRate);
+             const double effectThreshold = 1.2; // Slightly above 1x to trigger effects
+             const bool tapeEffectActive = betacam_effect_enabled && absPlaybackRate >= effectThreshold && currentTime > 0.1 && (totalDuration - currentTime) > 0.1;
+
+             // Re-displaying the same frame without the animated effect: the texture already holds it
+             if (lastTexture && !tapeEffectActive && frameUploader.alreadyUploaded(frameToDisplay)) {
+                 firstFrameRendered = true;
+             } else {
+             // --- Software source: VideoToolbox frames come from the pooled staging frames ---
+             bool stagingOwned = false;
              if (currentSrcFormat == AV_PIX_FMT_VIDEOTOOLBOX) {
-                 // std::cout << "[Display SW] Detected VideoToolbox frame " << newCurrentFrame << ". Attempting transfer..." << std::endl;
-                 sw_frame = av_frame_alloc();
-                 if (!sw_frame) {
-                     std::cerr << "Error allocating SW frame for transfer." << std::endl;
-                 } else {
-                     // Choose a software format (NV12 is often efficient)
-                     sw_frame->format = AV_PIX_FMT_NV12;
-                     sw_frame->width = frame->width;
-                     sw_frame->height = frame->height;
-
-                     if (av_frame_get_buffer(sw_frame, 0) < 0) {
-                         std::cerr << "Error allocating buffer for SW frame." << std::endl;
-                         av_frame_free(&sw_frame); // Free the frame if buffer allocation failed
-                         sw_frame = nullptr;
-                     } else {
-                         if (av_hwframe_transfer_data(sw_frame, frame, 0) < 0) {
-                             std::cerr << "Error transferring hardware frame data." << std::endl;
-                             av_frame_free(&sw_frame); // Free frame and buffers
-                             sw_frame = nullptr;
-                         } else {
-                             // std::cout << "[Display SW] Successfully transferred VideoToolbox frame to SW format " << sw_frame->format << std::endl;
-                             frame = sw_frame; // Use the transferred software frame from now on
-                             currentSrcFormat = static_cast<AVPixelFormat>(sw_frame->format); // Update format
-                             frame_transferred = true;
-                         }
-                     }
+                 AVFrame* staged = frameUploader.acquire(frameToDisplay, stagingOwned);
+                 if (staged) {
+                     frame = staged;
+                     currentSrcFormat = static_cast<AVPixelFormat>(frame->format);
                  }
                  // If transfer failed, 'frame' remains the original VT frame,
                  // and the switch below might hit default/error.
              }
-             // --- End Hardware Frame Transfer Logic ---
-
 
              SDL_PixelFormatEnum currentSdlFormat = SDL_PIXELFORMAT_UNKNOWN;
              bool recreateTexture = false;
 
+             // NV12 (from HW transfer) goes straight into an NV12 texture when the renderer has them
+             static int rendererHasNV12 = -1;
+             if (rendererHasNV12 < 0) {
+                 rendererHasNV12 = 0;
+                 SDL_RendererInfo rendererInfo;
+                 if (SDL_GetRendererInfo(renderer, &rendererInfo) == 0) {
+                     for (Uint32 i = 0; i < rendererInfo.num_texture_formats; ++i) {
+                         if (rendererInfo.texture_formats[i] == SDL_PIXELFORMAT_NV12) rendererHasNV12 = 1;
+                     }
+                 }
+             }
+
              // Determine SDL format for SW path
              switch (currentSrcFormat) {
                  case AV_PIX_FMT_YUV420P: case AV_PIX_FMT_YUVJ420P: currentSdlFormat = SDL_PIXELFORMAT_IYUV; break;
-                 // --- Force NV12 (from HW transfer) to be converted to IYUV for SW path ---
-                 case AV_PIX_FMT_NV12: currentSdlFormat = SDL_PIXELFORMAT_IYUV; break; 
+                 // --- NV12 is converted to IYUV only if the renderer lacks NV12 textures ---
+                 case AV_PIX_FMT_NV12: currentSdlFormat = rendererHasNV12 ? SDL_PIXELFORMAT_NV12 : SDL_PIXELFORMAT_IYUV; break;
                  case AV_PIX_FMT_YUV422P: case AV_PIX_FMT_YUVJ422P: currentSdlFormat = SDL_PIXELFORMAT_UYVY; break; // Note: YUV422P might be better converted to UYVY for SDL
                  case AV_PIX_FMT_RGB24: currentSdlFormat = SDL_PIXELFORMAT_RGB24; break;
                  case AV_PIX_FMT_BGR24: currentSdlFormat = SDL_PIXELFORMAT_BGR24; break;
@@ -616,6 +553,7 @@ void displayFrame(
              // Check if texture needs recreation
              if (!lastTexture || textureWidth != frame->width || textureHeight != frame->height || lastSdlPixFormat != currentSdlFormat) {
                  if (lastTexture) { SDL_DestroyTexture(lastTexture); lastTexture = nullptr; }
+                 frameUploader.invalidate();
                  lastTexture = SDL_CreateTexture(renderer, currentSdlFormat, SDL_TEXTUREACCESS_STREAMING, frame->width, frame->height);
                  if (lastTexture) {
                      textureWidth = frame->width;
@@ -630,605 +568,120 @@ void displayFrame(
                  }
              }
 
-             // Check SwsContext
+             // Conversion context, cached per size/format pair
              AVPixelFormat targetAvFormat = av_pix_fmt_from_sdl_format(currentSdlFormat); // Determine target AV format for sws_scale
              bool conversionNeeded = (targetAvFormat != currentSrcFormat && targetAvFormat != AV_PIX_FMT_NONE);
-
-             // --- Explicitly force conversion if source was NV12 (from VT) and target is IYUV ---
-             if (currentSrcFormat == AV_PIX_FMT_NV12 && targetAvFormat == AV_PIX_FMT_YUV420P) {
-                 conversionNeeded = true;
+             SwsContext* swsContext = nullptr;
+             if (conversionNeeded) {
+                 swsContext = frameUploader.swsContext(frame->width, frame->height, currentSrcFormat, targetAvFormat);
              }
 
-             if (conversionNeeded && (!swsContextPtr || lastSrcPixFormat != currentSrcFormat || recreateTexture)) {
-                 // unique_ptr.reset() will automatically free the old context if it exists
-                 if (targetAvFormat != AV_PIX_FMT_NONE) {
-                     SwsContext* newCtx = sws_getContext(frame->width, frame->height, currentSrcFormat, frame->width, frame->height, targetAvFormat, SWS_BILINEAR, nullptr, nullptr, nullptr);
-                     if (!newCtx) { std::cerr << "Error creating SwsContext for " << currentSrcFormat << " -> " << SDL_GetPixelFormatName(currentSdlFormat) << std::endl; }
-                     swsContextPtr.reset(newCtx);
-                     // else { std::cout << "[Display] Created SwsContext: " << currentSrcFormat << " -> " << SDL_GetPixelFormatName(currentSdlFormat) << std::endl; } // Optional log
-                     } else {
-                    std::cerr << "Error: Cannot determine target AVFormat for SDL format " << SDL_GetPixelFormatName(currentSdlFormat) << std::endl;
-                    swsContextPtr.reset(); // Ensure ptr is null if context creation fails
-                     }
+             // Effects run on whatever writable copy of the frame is about to be uploaded
+             auto applyEffects = [&](uint8_t* const planes[3], const int pitches[3]) {
+                 TapeFrame tapeFrame;
+                 tapeFrame.layout = (lastSdlPixFormat == SDL_PIXELFORMAT_IYUV) ? TapeLayout::I420 :
+                                    (lastSdlPixFormat == SDL_PIXELFORMAT_NV12) ? TapeLayout::NV12 :
+                                    (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) ? TapeLayout::UYVY : TapeLayout::LumaOnly;
+                 for (int p = 0; p < 3; ++p) { tapeFrame.data[p] = planes[p]; tapeFrame.pitch[p] = pitches[p]; }
+                 tapeFrame.width = textureWidth;
+                 tapeFrame.height = textureHeight;
+
+                 // --- Apply Betacam Effects ---
+                 if (tapeEffectActive) {
+                     tapeEffect.apply(tapeFrame, absPlaybackRate, currentTime);
                  }
-             lastSrcPixFormat = currentSrcFormat; // Update last source format processed
+                 // --- Apply Edge Fade ---
+                 tapeEffect.applyEdgeFade(tapeFrame);
+             };
 
              // Update SW texture data
              if (lastTexture) {
+                  PERF_SPAN("upload.texture");
+                  ScopedLatency uploadLatency(playerMetrics.upload);
+                  bool uploaded = false;
+                  bool updateFromStaging = stagingOwned && !conversionNeeded;
+#if !SDL_VERSION_ATLEAST(2, 0, 16)
+                  if (currentSdlFormat == SDL_PIXELFORMAT_NV12) updateFromStaging = false; // No SDL_UpdateNVTexture
+#endif
+                  if (updateFromStaging) {
+                      // Staging frame is ours: draw the effects into it and upload with one call
+                      applyEffects(frame->data, frame->linesize);
+                      int result = -1;
+                      if (currentSdlFormat == SDL_PIXELFORMAT_NV12) {
+#if SDL_VERSION_ATLEAST(2, 0, 16)
+                          result = SDL_UpdateNVTexture(lastTexture, nullptr, frame->data[0], frame->linesize[0], frame->data[1], frame->linesize[1]);
+#endif
+                      } else if (currentSdlFormat == SDL_PIXELFORMAT_IYUV) {
+                          result = SDL_UpdateYUVTexture(lastTexture, nullptr, frame->data[0], frame->linesize[0], frame->data[1], frame->linesize[1], frame->data[2], frame->linesize[2]);
+                      } else {
+                          result = SDL_UpdateTexture(lastTexture, nullptr, frame->data[0], frame->linesize[0]);
+                      }
+                      uploaded = (result == 0);
+                      if (!uploaded) {
+                          std::cerr << "Error updating texture from staging frame: " << SDL_GetError() << std::endl;
+                      }
+                  } else {
                           uint8_t* pixels = nullptr;
                           int pitch = 0;
                           if (SDL_LockTexture(lastTexture, nullptr, (void**)&pixels, &pitch) == 0) {
                                uint8_t* dst_data[4] = { pixels, nullptr, nullptr, nullptr };
                                int dst_linesize[4] = { pitch, 0, 0, 0 };
-                        // Setup destData/linesize based on the *target* AV format for sws_scale
+                               // Setup destData/linesize based on the *target* AV format
                                if (targetAvFormat == AV_PIX_FMT_NV12) { dst_data[1] = pixels + pitch * frame->height; dst_linesize[1] = pitch; }
-                       else if (targetAvFormat == AV_PIX_FMT_UYVY422) { /* single plane pitch ok */ }
+                               else if (targetAvFormat == AV_PIX_FMT_UYVY422) { /* single plane pitch ok */ }
                                else if (targetAvFormat == AV_PIX_FMT_YUV420P) { dst_data[1] = pixels + pitch * frame->height; dst_data[2] = pixels + pitch * frame->height * 5 / 4; dst_linesize[1] = pitch / 2; dst_linesize[2] = pitch / 2; }
-                       else if (targetAvFormat == AV_PIX_FMT_RGB24 || targetAvFormat == AV_PIX_FMT_BGR24) { /* single plane pitch ok */ }
-                       // Add more cases if other target formats are supported
+                               else if (targetAvFormat == AV_PIX_FMT_RGB24 || targetAvFormat == AV_PIX_FMT_BGR24) { /* single plane pitch ok */ }
 
-                       if (conversionNeeded) {
-                           if (swsContextPtr) {
-                               sws_scale(swsContextPtr.get(), (const uint8_t* const*)frame->data, frame->linesize, 0, frame->height, dst_data, dst_linesize);
-                      } else { std::cerr << "Error: SwsContext is null for needed SW conversion!" << std::endl; }
-                  } else {
-                           // Direct copy if formats match
-                           // Safer row-by-row copy, respecting linesizes
-                           if (currentSdlFormat == SDL_PIXELFORMAT_IYUV && currentSrcFormat == AV_PIX_FMT_YUV420P) {
-                               // Copy Y plane row by row
-                               for (int y = 0; y < frame->height; ++y) {
-                                   if (dst_data[0] && frame->data[0]) { // Safety check pointers
-                                       memcpy(dst_data[0] + y * dst_linesize[0], // Dest: Start of row y in texture Y plane
-                                              frame->data[0] + y * frame->linesize[0], // Src: Start of row y in frame Y plane
-                                              frame->width); // Copy width bytes (actual data width)
-                                   }
-                               }
-                               // Copy U plane row by row (height/2 rows, width/2 bytes per row)
-                               for (int y = 0; y < frame->height / 2; ++y) {
-                                   if (dst_data[1] && frame->data[1]) { // Safety check pointers
-                                       memcpy(dst_data[1] + y * dst_linesize[1], // Dest: Start of row y in texture U plane
-                                              frame->data[1] + y * frame->linesize[1], // Src: Start of row y in frame U plane
-                                              frame->width / 2); // Copy width/2 bytes
-                                   }
-                               }
-                               // Copy V plane row by row (height/2 rows, width/2 bytes per row)
-                               for (int y = 0; y < frame->height / 2; ++y) {
-                                   if (dst_data[2] && frame->data[2]) { // Safety check pointers
-                                        memcpy(dst_data[2] + y * dst_linesize[2], // Dest: Start of row y in texture V plane
-                                               frame->data[2] + y * frame->linesize[2], // Src: Start of row y in frame V plane
-                                               frame->width / 2); // Copy width/2 bytes
-                                   }
-                               }
-                           } else if (currentSdlFormat == SDL_PIXELFORMAT_UYVY && currentSrcFormat == AV_PIX_FMT_UYVY422) {
-                               // Example for packed format (can still use row-by-row for safety)
-                               for (int y = 0; y < frame->height; ++y) {
-                                    if (dst_data[0] && frame->data[0]) { // Safety check pointers
-                                        memcpy(dst_data[0] + y * dst_linesize[0],
-                                               frame->data[0] + y * frame->linesize[0],
-                                               frame->width * 2); // UYVY is 2 bytes per pixel
-                                    }
-                               }
-                           } // Add other direct copy cases if needed (e.g., RGB24)
-                       }
-
-                       // --- Apply Betacam Effects ---
-                       // These effects are applied to the new frame data being put into lastTexture.
-                       double absPlaybackRate = std::abs(currentPlaybackRate);
-                       const double effectThreshold = 1.2; // Slightly above 1x to trigger effects
-                       if (betacam_effect_enabled && absPlaybackRate >= effectThreshold && currentTime > 0.1 && (totalDuration - currentTime) > 0.1) {
-                           // Apply B&W effect for high speeds (>= 10.0x)
-                           if (absPlaybackRate >= 10.0) {
-                               if (lastSdlPixFormat == SDL_PIXELFORMAT_IYUV) {
-                                   memset(dst_data[1], 128, dst_linesize[1] * textureHeight / 2); // U
-                                   memset(dst_data[2], 128, dst_linesize[2] * textureHeight / 2); // V
-                               } else if (lastSdlPixFormat == SDL_PIXELFORMAT_NV12) {
-                                   for (int y = 0; y < textureHeight / 2; ++y) {
-                                       uint8_t* uvPlane = dst_data[1] + y * dst_linesize[1];
-                                       for (int x = 0; x < textureWidth / 2; ++x) { uvPlane[x*2]=128; uvPlane[x*2+1]=128; }
-                                   }
-                               }
-                           }
-
-                           // Calculate stripe parameters
-                           const double resolutionScale = static_cast<double>(textureHeight) / 1080.0;
-                           const int maxStripeHeight = static_cast<int>(720 * resolutionScale);
-                           const int baseStripeHeight = static_cast<int>(85 * resolutionScale);
-                           const int baseStripeSpacing = static_cast<int>(450 * resolutionScale);
-                           const int minStripeSpacing = static_cast<int>(62 * resolutionScale);
-                           int currentMinStripeHeight = (absPlaybackRate >= 16.0) ? 1 : static_cast<int>(14 * resolutionScale); // Set min height to 1 for >= 16x
-                           const int midStripeHeight = static_cast<int>(50 * resolutionScale);
-                           int stripeHeight, stripeSpacing;
-                           // ... (rest of stripe parameter calculation based on absPlaybackRate, identical to old code) ...
-                            if ((absPlaybackRate >= 0.2 && absPlaybackRate < 0.9) || (absPlaybackRate >= 1.1 && absPlaybackRate < 2.0)) {
-                                double t = (absPlaybackRate < 0.9) ? (absPlaybackRate - 0.2) / 0.7 : (absPlaybackRate - 1.2) / 0.8;
-                                t = t * t * (3 - 2 * t); stripeHeight = static_cast<int>(maxStripeHeight * (1 - t) + midStripeHeight * t); stripeSpacing = baseStripeSpacing;
-                            } else if (absPlaybackRate >= 2.0 && absPlaybackRate < 3.7) {
-                                // Smooth transition zone for 2.0x to 3.7x (Betacam fix)
-                                double t = (absPlaybackRate - 2.0) / 1.7; // 0 to 1 over 2.0-3.7 range
-                                stripeHeight = static_cast<int>(baseStripeHeight * (1.0 - t * 0.3)); // Gradual height reduction
-                                stripeSpacing = static_cast<int>(baseStripeSpacing * (1.0 - t * 0.2)); // Gradual spacing reduction
-                            } else if (absPlaybackRate >= 3.7 && absPlaybackRate < 14.0) {
-                                double t = (absPlaybackRate - 3.7) / 10.3; t = std::pow(t, 0.7); // Adjusted range
-                                stripeHeight = static_cast<int>(baseStripeHeight * 0.7 * (1.0 - t) + currentMinStripeHeight * t);
-                                stripeSpacing = static_cast<int>(baseStripeSpacing * 0.8 * (1.0 - t) + minStripeSpacing * t);
-                            } else { // Covers >= 14.0x
-                                 stripeHeight = currentMinStripeHeight; 
-                                 stripeSpacing = minStripeSpacing; 
-                                 // --- Set very low min height for 20x+ specifically ---
-                                 if (absPlaybackRate >= 20.0) {
-                                     currentMinStripeHeight = static_cast<int>(12.0 * resolutionScale); // Set to 1px scaled
-                                     stripeHeight = currentMinStripeHeight; // Ensure stripeHeight uses this new minimum
-                                 }
-                                 // --- End Set low min height ---
-                            }
-
-
-                           // Calculate cycle progress for animation
-                           double cycleProgress;
-                           const double baseDuration = 1.5;
-                           const int fps = static_cast<int>(originalFps > 0 ? originalFps : 30); // Use actual FPS if available
-                           const double minCycleDuration = 0.05; // 50ms minimum cycle time
-                           
-                           if (absPlaybackRate >= 12.0) { // New logic for high speeds (12x+)
-                                double cycleDuration = (baseDuration / absPlaybackRate) * 3.0; // Simple inverse relation + factor
-                                cycleDuration = std::max(minCycleDuration, cycleDuration); // Apply minimum duration
-                                cycleProgress = std::fmod(currentTime, cycleDuration) / cycleDuration;
-                           } else if (absPlaybackRate >= 3.7) { // Covers 3.7x up to 12.0x (Aligned with stripe ranges)
-                                double normalizedSpeed = (absPlaybackRate - 3.7) / 8.3; // Normalize in 3.7-12 range
-                                double speedMultiplier = 0.08 + (std::pow(normalizedSpeed, 3) * 0.15);
-                                if (absPlaybackRate < 8.0) speedMultiplier *= 0.7; // Keep the old adjustment for < 8x
-                                double mediumSpeedDuration = baseDuration / (absPlaybackRate * speedMultiplier);
-                                mediumSpeedDuration = std::max(minCycleDuration, mediumSpeedDuration); // Apply minimum duration
-                                cycleProgress = std::fmod(currentTime, mediumSpeedDuration) / mediumSpeedDuration;
-                           } else { // Covers >= effectThreshold (1.1x) up to 3.7x (Extended range for smooth transition)
-                                double speedFactor = std::min(absPlaybackRate / 2.0, 2.0) * 0.5; 
-                                double adjustedDuration = baseDuration / speedFactor; 
-                                if (adjustedDuration <= 0) adjustedDuration = 1.0; // Fallback
-                                cycleProgress = std::fmod(currentTime, adjustedDuration) / adjustedDuration; 
-                           }
-
-
-                           // --- Generate Stripe Positions with Randomized Spacing ---
-                           std::vector<std::pair<int, int>> stripePositions; // Store {startY, height}
-                           std::vector<int> stripeSpacings; // Store spacing *after* each stripe
-
-                           // Use the calculated stripeSpacing for the current speed as the *base* for randomization
-                           int baseSpacingForSpeed; // Declared here, calculated below
-                           // --- Adjust base spacing based on specific speed ranges --- 
-                           double currentSpacingVariationFactor = 0.001; // Keep default variation low initially
-                           
-                           // Define target spacings for interpolation points
-                           const double spacingAt12x = 100.0 * resolutionScale;
-                           const double spacingAt24x = 18.0 * resolutionScale; // New target spacing
-
-                           if (absPlaybackRate >= 2.0 && absPlaybackRate < 3.5) {
-                                // Add 86 pixels for ~3x range to make stripes sparse (applied to base stripeSpacing)
-                                baseSpacingForSpeed = stripeSpacing + static_cast<int>((10.0 + 76.0) * resolutionScale); 
-                           } else if (absPlaybackRate >= 8.0 && absPlaybackRate < 12.0) { // Fixed range for 10x spacing
-                                // Force smaller spacing for ~10x range
-                                baseSpacingForSpeed = static_cast<int>(spacingAt12x); 
-                           } else if (absPlaybackRate >= 12.0) { // Interpolate from 12x up to 24x, then hold
-                               double t = std::min(1.0, (absPlaybackRate - 12.0) / (24.0 - 12.0)); // Normalize 0 to 1 between 12x and 24x
-                               baseSpacingForSpeed = static_cast<int>(spacingAt12x * (1.0 - t) + spacingAt24x * t);
-                           } else { // Covers < 8x (excluding 2.0-3.5 range handled above)
-                                // Use the originally calculated stripeSpacing which interpolates height/spacing
-                               baseSpacingForSpeed = stripeSpacing; 
-                           }
-                           // --- End Adjust base spacing --- 
-
-                           std::mt19937 rng(std::random_device{}()); // Random number generator
-                           // Use the potentially modified spacing variation factor
-                           double spacingVariationFactor = currentSpacingVariationFactor; 
-                           int minAllowedSpacing = std::max(1, minStripeSpacing / 4); // Reduce min allowed spacing for high speeds
-
-                           // Calculate the initial vertical offset based on cycleProgress and *average* spacing/height
-                           // Ensures the pattern starts scrolling from off-screen smoothly
-                           int averagePatternUnitHeight = baseStripeHeight + baseSpacingForSpeed;
-                           // Ensure averagePatternUnitHeight is positive to avoid division by zero or negative fmod issues
-                           if (averagePatternUnitHeight <= 0) averagePatternUnitHeight = 1; 
-                           double initialOffset = std::fmod(cycleProgress * averagePatternUnitHeight, averagePatternUnitHeight);
-                           int currentY = static_cast<int>(initialOffset) - averagePatternUnitHeight; 
-
-
-                           // Now start the loop to calculate and store stripes, starting from the potentially negative currentY
-                           while (currentY < textureHeight) {
-                               // Calculate height for this potential stripe (variable random variation)
-                               int finalStripeHeight; // Use a new variable for the final calculated height                               
-                               if (absPlaybackRate >= 16.0) {
-                                   // For >= 16x, vary height slightly randomly from 1 to 3 pixels
-                                   finalStripeHeight = 1 + (rand() % 3); // Generates 1, 2, 3
-                               } else {
-                                   // Minimal height variation for other speeds (+/- 1 pixel before scaling)
-                                   double heightVariation = ((rand() % 3 - 1) * resolutionScale); 
-                                   // Use the potentially reduced currentMinStripeHeight for clamping
-                                   finalStripeHeight = std::max(static_cast<int>(stripeHeight + heightVariation), currentMinStripeHeight);
-                               }
-                               // Ensure height is at least 1 pixel if scale is very small
-                               finalStripeHeight = std::max(1, finalStripeHeight); 
-
-                               // Calculate randomized spacing for the *next* gap (using current variation factor)
-                               int currentStripeSpacing;
-                               if (absPlaybackRate >= 16.0) {
-                                   // For >= 16x, apply subtle +/- 2 pixel random offset to base spacing
-                                   int randomOffset = (rand() % 5) - 2; // Generates -2, -1, 0, 1, 2
-                                   currentStripeSpacing = std::max(1, static_cast<int>(baseSpacingForSpeed + randomOffset)); // Ensure spacing is at least 1
+                               if (conversionNeeded) {
+                                   if (swsContext) {
+                                       sws_scale(swsContext, (const uint8_t* const*)frame->data, frame->linesize, 0, frame->height, dst_data, dst_linesize);
+                                   } else { std::cerr << "Error: SwsContext is null for needed SW conversion!" << std::endl; }
                                } else {
-                                   // Apply smaller variation for lower speeds
-                                   int randomSpacingOffset = static_cast<int>(baseSpacingForSpeed * spacingVariationFactor * 2.0 * ((double)rand() / RAND_MAX - 0.5)); // +/- variation
-                                   currentStripeSpacing = std::max(minAllowedSpacing, baseSpacingForSpeed + randomSpacingOffset);
-                               }
-
-                               // Determine the actual start and end Y for drawing, clamping to texture bounds
-                               // This will handle cases where currentY is negative
-                               int startY = std::max(0, currentY);
-                               int endY = std::min(textureHeight, currentY + finalStripeHeight);
-
-                               // Store position only if the stripe is at least partially visible
-                               if (endY > startY && startY < textureHeight) {
-                                   stripePositions.push_back({startY, endY - startY}); // Store {start, actual_height}
+                                   // Direct copy, one memcpy per plane when the pitches line up
+                                   const int w = frame->width;
+                                   const int h = frame->height;
+                                   switch (currentSdlFormat) {
+                                       case SDL_PIXELFORMAT_IYUV:
+                                           FrameUploader::copyPlane(dst_data[0], dst_linesize[0], frame->data[0], frame->linesize[0], w, h);
+                                           FrameUploader::copyPlane(dst_data[1], dst_linesize[1], frame->data[1], frame->linesize[1], w / 2, h / 2);
+                                           FrameUploader::copyPlane(dst_data[2], dst_linesize[2], frame->data[2], frame->linesize[2], w / 2, h / 2);
+                                           break;
+                                       case SDL_PIXELFORMAT_NV12:
+                                           FrameUploader::copyPlane(dst_data[0], dst_linesize[0], frame->data[0], frame->linesize[0], w, h);
+                                           FrameUploader::copyPlane(dst_data[1], dst_linesize[1], frame->data[1], frame->linesize[1], (w / 2) * 2, h / 2);
+                                           break;
+                                       case SDL_PIXELFORMAT_UYVY:
+                                           FrameUploader::copyPlane(dst_data[0], dst_linesize[0], frame->data[0], frame->linesize[0], w * 2, h);
+                                           break;
+                                       case SDL_PIXELFORMAT_RGB24: case SDL_PIXELFORMAT_BGR24:
+                                           FrameUploader::copyPlane(dst_data[0], dst_linesize[0], frame->data[0], frame->linesize[0], w * 3, h);
+                                           break;
+                                       default:
+                                           break;
+                                   }
                                }
 
-                               stripeSpacings.push_back(currentStripeSpacing); // Store spacing for consistency if needed later
-
-                               // Advance Y position using the *final* calculated height
-                               currentY += finalStripeHeight + currentStripeSpacing;
-                               
-                               // Safety break to prevent infinite loops in case of calculation issues
-                               if (stripePositions.size() > textureHeight) { // Unlikely, but safe
-                                    std::cerr << "Warning: Excessive stripe calculation, breaking loop." << std::endl;
-                                    break;
-                               }
-                           }
-                           // --- End Stripe Position Generation ---
-
-
-                           // Apply B&W zones under stripes (2x-10x) - USE STORED POSITIONS
-                           if (absPlaybackRate >= 2.0 && absPlaybackRate < 10.0) {
-                               for (const auto& pos : stripePositions) {
-                                   int startY = pos.first;
-                                   int currentStripeHeight = pos.second; // Use stored actual height
-                                   if (currentStripeHeight <= 0) continue;
-
-                                   int bwZoneHeight = static_cast<int>(currentStripeHeight * 1.75);
-                                   int heightDifference = bwZoneHeight - currentStripeHeight;
-                                   int y_bw = startY - heightDifference / 2;
-
-                                    if (y_bw < textureHeight && y_bw + bwZoneHeight > 0) {
-                                       int bwStartY = std::max(0, y_bw);
-                                       int bwEndY = std::min(textureHeight, y_bw + bwZoneHeight);
-                                        for (int yPos = bwStartY; yPos < bwEndY; ++yPos) {
-                                            uint8_t* rowStart = dst_data[0] + yPos * pitch;
-                                            if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                                for (int x = 0; x < textureWidth; ++x) { // Iterate per pixel
-                                                    // Darken Y component
-                                                    rowStart[x * 2 + 1] = static_cast<uint8_t>(rowStart[x * 2 + 1] * 0.85f);
-                                                    // Set U and V to 128 for B&W
-                                                    if (x % 2 == 0) rowStart[x * 2] = 128; // U for even pixels
-                                                    else rowStart[x * 2] = 128;           // V for odd pixels (actually U for next pair, V for current if x*2-1)
-                                                                                         // Correct way for UYVY: U is at (pixel/2)*4, V is at (pixel/2)*4+2
-                                                }
-                                                // Simpler: Iterate by pairs for UYVY
-                                                for (int i = 0; i < textureWidth / 2; ++i) { // Iterate per UYVY group
-                                                    uint8_t* uyvy_group = rowStart + i * 4;
-                                                    uyvy_group[0] = 128; // U
-                                                    uyvy_group[1] = static_cast<uint8_t>(uyvy_group[1] * 0.85f); // Y0
-                                                    uyvy_group[2] = 128; // V
-                                                    uyvy_group[3] = static_cast<uint8_t>(uyvy_group[3] * 0.85f); // Y1
-                                                }
-                                            } else { // Existing logic for IYUV and NV12
-                                                for (int x = 0; x < textureWidth; ++x) { rowStart[x] = static_cast<uint8_t>(rowStart[x] * 0.85); } // Darken Y (for planar Y)
-                                                if (lastSdlPixFormat == SDL_PIXELFORMAT_IYUV) {
-                                                    int uvY = yPos / 2; if (uvY < textureHeight / 2) { memset(dst_data[1] + uvY * dst_linesize[1], 128, textureWidth / 2); memset(dst_data[2] + uvY * dst_linesize[2], 128, textureWidth / 2); }
-                                                } else if (lastSdlPixFormat == SDL_PIXELFORMAT_NV12) {
-                                                    int uvY = yPos / 2; if (uvY < textureHeight / 2) { uint8_t* uvPlane = dst_data[1] + uvY * dst_linesize[1]; for (int x = 0; x < textureWidth / 2; ++x) { uvPlane[x*2]=128; uvPlane[x*2+1]=128; } }
-                                                }
-                                            }
-                                        }
-                                    }
-                               }
-                           }
-
-                           // Draw grey stripes - USE STORED POSITIONS
-                           for (const auto& pos : stripePositions) {
-                               int startY = pos.first;
-                               int currentStripeHeight = pos.second;
-                               int endY = startY + currentStripeHeight;
-
-                               if (startY < textureHeight && endY > 0 && currentStripeHeight > 0) {
-                                   startY = std::max(0, startY);
-                                   endY = std::min(textureHeight, endY);
-
-                                   for (int yPos = startY; yPos < endY; ++yPos) {
-                                       uint8_t* rowStart = dst_data[0] + yPos * pitch;
-                                       if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                           for (int i = 0; i < textureWidth / 2; ++i) { // Iterate per UYVY group
-                                               uint8_t* uyvy_group = rowStart + i * 4;
-                                               uyvy_group[0] = 128; // U
-                                               uyvy_group[1] = 128; // Y0
-                                               uyvy_group[2] = 128; // V
-                                               uyvy_group[3] = 128; // Y1
-                                           }
-                                       } else {
-                                           memset(rowStart, 128, textureWidth); // Y plane for planar formats
-                                           if (lastSdlPixFormat == SDL_PIXELFORMAT_IYUV) {
-                                               int uvY = yPos / 2; if (uvY < textureHeight / 2) { memset(dst_data[1] + uvY * dst_linesize[1], 128, textureWidth / 2); memset(dst_data[2] + uvY * dst_linesize[2], 128, textureWidth / 2); }
-                                           } else if (lastSdlPixFormat == SDL_PIXELFORMAT_NV12) {
-                                               int uvY = yPos / 2; if (uvY < textureHeight / 2) { uint8_t* uvPlane = dst_data[1] + uvY * dst_linesize[1]; for (int x = 0; x < textureWidth / 2; ++x) { uvPlane[x*2]=128; uvPlane[x*2+1]=128; } }
-                                           }
-                                       }
-                                   }
-                                   // --- Restore stripe drawing logic --- 
-                                   for (int yPos = startY; yPos < endY; ++yPos) {
-                                       memset(dst_data[0] + yPos * pitch, 128, textureWidth); // Y
-                                       if (lastSdlPixFormat == SDL_PIXELFORMAT_IYUV) {
-                                           int uvY = yPos / 2; if (uvY < textureHeight / 2) { memset(dst_data[1] + uvY * dst_linesize[1], 128, textureWidth / 2); memset(dst_data[2] + uvY * dst_linesize[2], 128, textureWidth / 2); }
-                                       } else if (lastSdlPixFormat == SDL_PIXELFORMAT_NV12) {
-                                           int uvY = yPos / 2; if (uvY < textureHeight / 2) { uint8_t* uvPlane = dst_data[1] + uvY * dst_linesize[1]; for (int x = 0; x < textureWidth / 2; ++x) { uvPlane[x*2]=128; uvPlane[x*2+1]=128; } }
-                                       }
-                                   }
-                                   // --- End of restored stripe drawing logic --- 
-
-                                   // Add black outline below the stripe - USES endY from current stripe
-                                   if (absPlaybackRate >= 8.0) {
-                                       const double outlineStartSpeed = 8.0;
-                                       const double outlineFullSpeed = 14.0;
-                                       double t = std::max(0.0, std::min(1.0, (absPlaybackRate - outlineStartSpeed) / (outlineFullSpeed - outlineStartSpeed)));
-                                       uint8_t targetYValue = 16 + static_cast<uint8_t>((128 - 16) * (1.0 - t));
-                                       int currentOutlineHeight = 1;
-                                       for (int h = 0; h < currentOutlineHeight; ++h) {
-                                           int outlineY = endY + h;
-                                           if (outlineY < textureHeight) {
-                                               uint8_t* rowStart = dst_data[0] + outlineY * pitch;
-                                               if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                                   for (int i = 0; i < textureWidth / 2; ++i) { // Iterate per UYVY group
-                                                       uint8_t* uyvy_group = rowStart + i * 4;
-                                                       // For outline, usually only Y is set, U/V remain (or set to neutral grey)
-                                                       uyvy_group[0] = 128; // U (neutral grey)
-                                                       uyvy_group[1] = targetYValue; // Y0
-                                                       uyvy_group[2] = 128; // V (neutral grey)
-                                                       uyvy_group[3] = targetYValue; // Y1
-                                                   }
-                                               } else {
-                                                   memset(rowStart, targetYValue, textureWidth); // Y plane for planar
-                                                   // UV handling for outline (existing code for IYUV/NV12)
-                                                   if (lastSdlPixFormat == SDL_PIXELFORMAT_IYUV) {
-                                                        int uvY = outlineY / 2; if (uvY < textureHeight / 2) { memset(dst_data[1] + uvY * dst_linesize[1], 128, textureWidth / 2); memset(dst_data[2] + uvY * dst_linesize[2], 128, textureWidth / 2); }
-                                                   } else if (lastSdlPixFormat == SDL_PIXELFORMAT_NV12) {
-                                                        int uvY = outlineY / 2; if (uvY < textureHeight / 2) { uint8_t* uvPlane = dst_data[1] + uvY * dst_linesize[1]; for (int x = 0; x < textureWidth / 2; ++x) { uvPlane[x*2]=128; uvPlane[x*2+1]=128; } }
-                                                   }
-                                               }
-                                           }
-                                       }
-                                   }
+                               applyEffects(dst_data, dst_linesize);
 
-                                   // Add snow effect (>= 4x) - USES startY from current stripe
-                                   if (absPlaybackRate >= 4.0 && startY < textureHeight) {
-                                       int snowY = startY;
-                                       int snowCount = std::max(8, textureWidth / 80);
-                                       if (absPlaybackRate > 10.0) snowCount = static_cast<int>(snowCount * 1.5);
-
-                                       for (int j = 0; j < snowCount; ++j) {
-                                           int snowX = rand() % textureWidth; // snowX is pixel index
-                                           double speedFactor_snow = std::sqrt(absPlaybackRate);
-                                           int tailBase = 10 + static_cast<int>(rand() % 20);
-                                           int tailLength = tailBase + static_cast<int>(speedFactor_snow * 5.0);
-
-                                           if (snowY >= 0 && snowY < textureHeight && snowX >= 0 && snowX < textureWidth) {
-                                               uint8_t* rowStart = dst_data[0] + snowY * pitch;
-                                               if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                                   // Snow is white, set Y to bright, U/V to neutral
-                                                   // snowX is the pixel index from 0 to textureWidth-1
-                                                   int baseByteOffset = snowX * 2;
-                                                   if (baseByteOffset + 1 < pitch) { // Check boundary for Y
-                                                      rowStart[baseByteOffset + 1] = 235; // Y
-                                                      if (snowX % 2 == 0) { // This Y is Y0, U is at baseByteOffset
-                                                          if (baseByteOffset < pitch) rowStart[baseByteOffset] = 128; // U
-                                                          if (baseByteOffset + 2 < pitch) rowStart[baseByteOffset+2] = 128; // V
-                                                      } else { // This Y is Y1, V is at baseByteOffset
-                                                          // U is at baseByteOffset - 1, V is at baseByteOffset
-                                                          if (baseByteOffset -1 >= 0) rowStart[baseByteOffset-1] = 128; // U
-                                                          if (baseByteOffset < pitch) rowStart[baseByteOffset] = 128; // V
-                                                      }
-                                                      // Correct UYVY snow (white):
-                                                      // For pixel snowX: U at (snowX/2)*4, Y0 at (snowX/2)*4+1, V at (snowX/2)*4+2, Y1 at (snowX/2)*4+3
-                                                      int group_idx = snowX / 2;
-                                                      int in_group_idx = snowX % 2; // 0 for Y0, 1 for Y1
-                                                      uint8_t* uyvy_pixel_group = rowStart + group_idx * 4;
-                                                      if (group_idx * 4 + (1 + in_group_idx*2) < pitch) { // Check Y component
-                                                          uyvy_pixel_group[0] = 128; // U
-                                                          uyvy_pixel_group[1 + in_group_idx*2] = 235; // Y (Y0 or Y1)
-                                                          uyvy_pixel_group[2] = 128; // V
-                                                      }
-                                                   }
-                                               } else {
-                                                   rowStart[snowX] = 235; // Y plane for planar
-                                               }
-                                           }
-
-                                           for (int k = 1; k < tailLength; k++) {
-                                               int xPos = (snowX + k);
-                                               if (xPos >= textureWidth) continue;
-
-                                               double fadeFactor = exp(-0.15 * k);
-                                               int brightness = 128 + static_cast<int>(107 * fadeFactor);
-
-                                               if (snowY >= 0 && snowY < textureHeight && xPos >= 0 && xPos < textureWidth) {
-                                                   uint8_t* rowStart = dst_data[0] + snowY * pitch;
-                                                    if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                                       int group_idx = xPos / 2;
-                                                       int in_group_idx = xPos % 2;
-                                                       uint8_t* uyvy_pixel_group = rowStart + group_idx * 4;
-                                                       if (group_idx * 4 + (1 + in_group_idx*2) < pitch) { // Check Y component
-                                                            uyvy_pixel_group[0] = 128; // U
-                                                            uyvy_pixel_group[1 + in_group_idx*2] = brightness; // Y (Y0 or Y1)
-                                                            uyvy_pixel_group[2] = 128; // V
-                                                       }
-                                                    } else {
-                                                       rowStart[xPos] = brightness; // Y plane for planar
-                                                    }
-                                               }
-                                           }
-                                       }
-                                   }
-                               }
-                           }
-
-                           // Scanline duplication effect (>= 16x) - NEEDS UPDATED STRIPE MASK
-                            if (absPlaybackRate >= 16.0) {
-                                // Reduce maximum intensity (existing code)
-                                double effectIntensity = std::min(0.85, (absPlaybackRate - 16.0) / 8.0);
-                                std::vector<bool> stripeMask(textureHeight, false);
-
-                                // --- Re-calculate stripeMask based on STORED POSITIONS ---
-                                // Mark B&W zones first (if active)
-                                    if (absPlaybackRate >= 2.0 && absPlaybackRate < 10.0) {
-                                    for (const auto& pos : stripePositions) {
-                                        int startY = pos.first;
-                                        int currentStripeHeight = pos.second;
-                                        if (currentStripeHeight <= 0) continue;
-                                        int bwZoneHeight = static_cast<int>(currentStripeHeight * 1.75);
-                                        int heightDifference = bwZoneHeight - currentStripeHeight;
-                                        int y_bw = startY - heightDifference / 2;
-                                        if (y_bw < textureHeight && y_bw + bwZoneHeight > 0) {
-                                            int bwStartY = std::max(0, y_bw);
-                                            int bwEndY = std::min(textureHeight, y_bw + bwZoneHeight);
-                                            for (int yy = bwStartY; yy < bwEndY; ++yy) stripeMask[yy] = true;
-                                        }
-                                    }
-                                }
-                                
-                                // Mark actual grey stripes
-                                for (const auto& pos : stripePositions) {
-                                    int startY = pos.first;
-                                    int currentStripeHeight = pos.second;
-                                    int endY = startY + currentStripeHeight;
-                                    if (startY < textureHeight && endY > 0 && currentStripeHeight > 0) {
-                                        startY = std::max(0, startY);
-                                        endY = std::min(textureHeight, endY);
-                                        for (int yy = startY; yy < endY; ++yy) stripeMask[yy] = true;
-
-                                        // Also mark the black outline in the mask if it exists
-                                        if (absPlaybackRate >= 8.0) {
-                                            int currentOutlineHeight = 1;
-                                            for (int h = 0; h < currentOutlineHeight; ++h) {
-                                                int outlineY = endY + h;
-                                                if (outlineY < textureHeight) {
-                                                    stripeMask[outlineY] = true;
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                                // --- End Stripe Mask Calculation ---
-
-
-                                // Find clear areas and apply duplication (existing logic using the new mask)
-                                bool inClearArea = false; int clearStart = 0;
-                                for (int y = 0; y < textureHeight; ++y) {
-                                    if (!stripeMask[y] && !inClearArea) { clearStart = y; inClearArea = true; }
-                                    else if ((stripeMask[y] || y == textureHeight - 1) && inClearArea) {
-                                        int clearEnd = stripeMask[y] ? y : y + 1;
-                                        if (clearEnd - clearStart > 1) {
-                                            int areaStart = clearStart;
-                                            int areaEnd = clearEnd;
-                                            int sourceLineY = areaStart;
-
-                                            if (sourceLineY >= 0 && sourceLineY < textureHeight && pitch > 0) {
-                                                uint8_t* srcLine = dst_data[0] + sourceLineY * pitch;
-                                                for (int destY = areaStart + 1; destY < areaEnd; destY++) {
-                                                    uint8_t* dstLine = dst_data[0] + destY * pitch;
-                                                    if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                                        memcpy(dstLine, srcLine, textureWidth * 2); // UYVY is 2 bytes per pixel
-                                                    } else {
-                                                        memcpy(dstLine, srcLine, textureWidth); // Y plane for planar
-                                                    }
-
-                                                    if ((sourceLineY/2 != destY/2) && (destY/2 < textureHeight/2)) {
-                                                        if (lastSdlPixFormat == SDL_PIXELFORMAT_IYUV) {
-                                                            if (dst_linesize[1] > 0) memcpy(dst_data[1] + destY/2 * dst_linesize[1], dst_data[1] + sourceLineY/2 * dst_linesize[1], textureWidth/2);
-                                                            if (dst_linesize[2] > 0) memcpy(dst_data[2] + destY/2 * dst_linesize[2], dst_data[2] + sourceLineY/2 * dst_linesize[2], textureWidth/2);
-                                                        } else if (lastSdlPixFormat == SDL_PIXELFORMAT_NV12) {
-                                                            if (dst_linesize[1] > 0) memcpy(dst_data[1] + destY/2 * dst_linesize[1], dst_data[1] + sourceLineY/2 * dst_linesize[1], textureWidth);
-                                                        }
-                                                        // No specific U/V copy for UYVY here as memcpy of dstLine should cover it.
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        inClearArea = false;
-                                    }
-                                }
-                            }
-                       } // End if absPlaybackRate >= effectThreshold
-
-                       // --- Apply Edge Fade ---
-                       const int leftEdgeFadeWidth = 3;
-                       const int rightEdgeFadeWidth = 2;
-                       if ((leftEdgeFadeWidth > 0 || rightEdgeFadeWidth > 0) && textureWidth > (leftEdgeFadeWidth + rightEdgeFadeWidth) && pitch > 0) {
-                            for (int y = 0; y < textureHeight; ++y) {
-                                uint8_t* rowStart = dst_data[0] + y * pitch;
-                                // Left edge fade
-                                if (leftEdgeFadeWidth > 0) {
-                                    for (int x = 0; x < leftEdgeFadeWidth; ++x) { // x is pixel index
-                                        float fade = static_cast<float>(x) / (leftEdgeFadeWidth > 1 ? (leftEdgeFadeWidth - 1) : 1);
-                                        if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                            int group_idx = x / 2;
-                                            int in_group_idx = x % 2;
-                                            uint8_t* uyvy_pixel_group = rowStart + group_idx * 4;
-                                            // Fade only Y component, leave U/V or set to neutral for strong fade
-                                            if (group_idx * 4 + (1 + in_group_idx*2) < pitch) {
-                                                uint8_t currentY = uyvy_pixel_group[1 + in_group_idx*2];
-                                                uyvy_pixel_group[1 + in_group_idx*2] = static_cast<uint8_t>(currentY * fade + 16.0f * (1.0f - fade));
-                                                // Optionally fade U/V to grey:
-                                                // uyvy_pixel_group[0] = static_cast<uint8_t>(uyvy_pixel_group[0] * fade + 128.0f * (1.0f - fade));
-                                                // uyvy_pixel_group[2] = static_cast<uint8_t>(uyvy_pixel_group[2] * fade + 128.0f * (1.0f - fade));
-                                            }
-                                        } else {
-                                            rowStart[x] = static_cast<uint8_t>(rowStart[x] * fade + 16.0f * (1.0f - fade));
-                                        }
-                                    }
-                                }
-                                // Right edge fade
-                                if (rightEdgeFadeWidth > 0) {
-                                    for (int x = 0; x < rightEdgeFadeWidth; ++x) {
-                                        int realX = textureWidth - 1 - x; // pixel index
-                                        float fade = static_cast<float>(x) / (rightEdgeFadeWidth > 1 ? (rightEdgeFadeWidth - 1) : 1);
-                                        if (lastSdlPixFormat == SDL_PIXELFORMAT_UYVY) {
-                                            int group_idx = realX / 2;
-                                            int in_group_idx = realX % 2;
-                                            uint8_t* uyvy_pixel_group = rowStart + group_idx * 4;
-                                            if (group_idx * 4 + (1 + in_group_idx*2) < pitch) {
-                                                uint8_t currentY = uyvy_pixel_group[1 + in_group_idx*2];
-                                                uyvy_pixel_group[1 + in_group_idx*2] = static_cast<uint8_t>(currentY * fade + 16.0f * (1.0f - fade));
-                                            }
-                                        } else {
-                                            rowStart[realX] = static_cast<uint8_t>(rowStart[realX] * fade + 16.0f * (1.0f - fade));
-                                        }
-                                    }
-                                }
-                            }
-                       }
-                       // --- End Edge Fade ---
-
-                       SDL_UnlockTexture(lastTexture);
-                  } else {
-                      std::cerr << "Error locking texture for SW update/effects: " << SDL_GetError() << std::endl;
-                      // Skip rendering this texture if lock failed
-                      if (lastTexture) { SDL_DestroyTexture(lastTexture); lastTexture = nullptr; }
+                               SDL_UnlockTexture(lastTexture);
+                               uploaded = true;
+                          } else {
+                              std::cerr << "Error locking texture for SW update/effects: " << SDL_GetError() << std::endl;
+                              // Skip rendering this texture if lock failed
+                              SDL_DestroyTexture(lastTexture); lastTexture = nullptr;
+                              frameUploader.invalidate();
+                          }
                   }
 
                   // Mark frame as rendered *only if* texture update was successful
-                  if (lastTexture) {
+                  if (uploaded && lastTexture) {
+                      frameUploader.markUploaded(frameToDisplay, tapeEffectActive);
                       firstFrameRendered = true;
+                  } else {
+                      frameUploader.invalidate();
                   }
-
-             // --- Free transferred frame if created ---
-             if (frame_transferred && sw_frame) {
-                 av_frame_free(&sw_frame); // Frees both frame and its buffers
-             }
-             // --- End Free transferred frame ---
-
              } // end if(lastTexture exists after creation/check)
+             } // end else (needs upload)
         } // End if (!renderedWithMetal)
 
     } else { // No frameToDisplay provided
@@ -1258,11 +711,10 @@ void displayFrame(
         
         // --- Calculate hsyncMaxSkewAmount now that destRect.w is known, if effect just started ---
         if (hsyncLossActive && hsyncEffectCurrentFrame == 1) { // First frame of an active effect
-             static std::mt19937 gen_skew(std::random_device{}()); // Separate generator for amount
              // Max skew is a percentage of the *destination rect width*
-             float baseMaxSkew = destRect.w * (0.02f + (static_cast<float>(gen_skew() % 31) / 1000.0f)); // 2% to 5% of width
+             float baseMaxSkew = destRect.w * (0.02f + (static_cast<float>(tapeEffect.rng().below(31)) / 1000.0f)); // 2% to 5% of width
              hsyncMaxSkewAmount = baseMaxSkew;
-             if (gen_skew() % 2 == 0) hsyncMaxSkewAmount *= -1; // Random direction
+             if (tapeEffect.rng().below(2) == 0) hsyncMaxSkewAmount *= -1; // Random direction
         }
 
 
@@ -1270,8 +722,6 @@ void displayFrame(
         // Jitter calculated earlier within the SW path is used here
         { // Jitter scope
              double absPlaybackRate = std::abs(currentPlaybackRate); // Use current rate again
-             static std::random_device rd_jitter_render; // Separate RNG for render stage jitter
-             static std::mt19937 rng_jitter_render(rd_jitter_render());
 
              double jitterAmplitude = 0;
              // --- Jitter calculations for various speeds (0.2x to 1.0x excluded) ---
@@ -1296,7 +746,7 @@ void displayFrame(
                          // Normal random jitter for other speeds >= 1.0x (and specifically >= 4.0x based on amplitude calc)
                          else { // This covers >=1.0x, excluding 1.3-2.0, but amplitude is only > 0 for >= 1.9, 4.0-16.0, >=20.0
                               // Redundant check since we are inside if(jitterAmplitude > 0), but safe.
-                              std::normal_distribution<> normalJitterDist(0.0, 1.0); destRect.y += static_cast<int>(normalJitterDist(rng_jitter_render) * jitterAmplitude);
+                              destRect.y += static_cast<int>(tapeEffect.rng().normal() * jitterAmplitude);
                          }
                      }
                  }
@@ -1332,51 +782,58 @@ void displayFrame(
                     renderSoftwareTexture(renderer, lastTexture, textureWidth, textureHeight, destRect, &srcBelow, &dstBelow, 0);
                 }
 
-                // Part 2: Above the tear (this part is skewed, rendered line by line)
+                // Part 2: Above the tear (skewed; max skew at the very top, 0 at the tear line)
+                // The skew is a linear ramp, so consecutive lines with the same integer offset are
+                // drawn as one band: at most |hsyncMaxSkewAmount| + 1 copies instead of one per line.
                 int topPartScreenHeight = actualTearLineScreenY - destRect.y;
                 if (topPartScreenHeight > 0) {
-                    for (int y_screen = destRect.y; y_screen < actualTearLineScreenY; ++y_screen) {
-                        SDL_Rect srcLine, dstLine;
-                        
-                        // Normalize y_screen within the skewed region (0 at top of tear, 1 at top of screen)
-                        // Inverse: 0 at top of screen, 1 at tear line
-                        float normalizedYInSkewArea = static_cast<float>(actualTearLineScreenY - 1 - y_screen) / std::max(1, topPartScreenHeight -1) ;
-                        
-                        // Skew for this specific line (max skew at the very top, 0 at tear line)
-                        // hsyncMaxSkewAmount is already animated (0->peak->0)
-                        float currentLineSkew = hsyncMaxSkewAmount * normalizedYInSkewArea;
-
-                        dstLine.x = destRect.x + static_cast<int>(currentLineSkew);
-                        dstLine.y = y_screen;
-                        dstLine.w = destRect.w; // We'll clip this via srcLine.w adjustment if needed
-                        dstLine.h = 1;
-
-                        srcLine.x = 0; // Default source X
-                        // Calculate corresponding Y in source texture
-                        srcLine.y = static_cast<int>((static_cast<float>(y_screen - destRect.y) / destRect.h) * textureHeight);
-                        srcLine.w = textureWidth; // Default source width
-                        srcLine.h = 1;
-                        
-                        // Adjust srcLine.x and srcLine.w based on how much dstLine.x is shifted
-                        // and how much of dstLine.w would be outside destRect.x / destRect.x + destRect.w
-                        // This is a simplified clipping, more advanced would be needed for perfect results
-                        if (dstLine.x < destRect.x) {
-                            int offset = destRect.x - dstLine.x;
-                            srcLine.x += static_cast<int>((float)offset / dstLine.w * srcLine.w) ; 
-                            srcLine.w -= static_cast<int>((float)offset / dstLine.w * srcLine.w) ; 
-                            dstLine.w -= offset;
-                            dstLine.x = destRect.x;
+                    auto lineSkew = [&](int y_screen) {
+                        float normalizedYInSkewArea = static_cast<float>(actualTearLineScreenY - 1 - y_screen) / std::max(1, topPartScreenHeight - 1);
+                        return static_cast<int>(hsyncMaxSkewAmount * normalizedYInSkewArea);
+                    };
+                    auto drawBand = [&](int bandStartY, int bandEndY, int skew) {
+                        SDL_Rect srcBand, dstBand;
+                        dstBand.x = destRect.x + skew;
+                        dstBand.y = bandStartY;
+                        dstBand.w = destRect.w;
+                        dstBand.h = bandEndY - bandStartY;
+
+                        srcBand.x = 0;
+                        srcBand.y = static_cast<int>((static_cast<float>(bandStartY - destRect.y) / destRect.h) * textureHeight);
+                        int srcEndY = static_cast<int>((static_cast<float>(bandEndY - destRect.y) / destRect.h) * textureHeight);
+                        srcBand.w = textureWidth;
+                        srcBand.h = std::max(1, std::min(textureHeight, srcEndY) - srcBand.y);
+
+                        // Clip the shifted band to destRect, trimming the source proportionally
+                        if (dstBand.x < destRect.x) {
+                            int offset = destRect.x - dstBand.x;
+                            int srcTrim = static_cast<int>((float)offset / dstBand.w * srcBand.w);
+                            srcBand.x += srcTrim;
+                            srcBand.w -= srcTrim;
+                            dstBand.w -= offset;
+                            dstBand.x = destRect.x;
                         }
-                        if (dstLine.x + dstLine.w > destRect.x + destRect.w) {
-                            int overflow = (dstLine.x + dstLine.w) - (destRect.x + destRect.w);
-                            srcLine.w -= static_cast<int>((float)overflow / dstLine.w * srcLine.w) ; 
-                            dstLine.w -= overflow;
+                        if (dstBand.x + dstBand.w > destRect.x + destRect.w) {
+                            int overflow = (dstBand.x + dstBand.w) - (destRect.x + destRect.w);
+                            srcBand.w -= static_cast<int>((float)overflow / dstBand.w * srcBand.w);
+                            dstBand.w -= overflow;
                         }
 
-                        if (srcLine.y >= 0 && srcLine.y < textureHeight && srcLine.w > 0 && dstLine.w > 0) {
-                             SDL_RenderCopy(renderer, lastTexture, &srcLine, &dstLine);
+                        if (srcBand.y >= 0 && srcBand.y < textureHeight && srcBand.w > 0 && dstBand.w > 0) {
+                            SDL_RenderCopy(renderer, lastTexture, &srcBand, &dstBand);
                         }
+                    };
+
+                    int bandStartY = destRect.y;
+                    int bandSkew = lineSkew(bandStartY);
+                    for (int y_screen = destRect.y + 1; y_screen < actualTearLineScreenY; ++y_screen) {
+                        int skew = lineSkew(y_screen);
+                        if (skew == bandSkew) continue;
+                        drawBand(bandStartY, y_screen, bandSkew);
+                        bandStartY = y_screen;
+                        bandSkew = skew;
                     }
+                    drawBand(bandStartY, actualTearLineScreenY, bandSkew);
                 }
             } else {
                  renderSoftwareTexture(renderer, lastTexture, textureWidth, textureHeight, destRect, nullptr, &destRect, 0); // Pass 0 for horizontalShift when no effect
@@ -1425,13 +882,16 @@ void displayFrame(
         renderOSD(renderer, font, isPlaying.load(), currentPlaybackRate, isReverse, currentTime, newCurrentFrame, showOSD, waitingForTimecode, inputTimecode, originalFps, jog_forward.load(), jog_backward.load(), frameTypeToDisplay);
     }
 
+    if (show_metrics_overlay.load() && font) {
+        renderMetricsOverlay(renderer, font);
+    }
+
     // Update the screen
-    SDL_RenderPresent(renderer);
+    presentRenderer(renderer);
 }
 
 // Function to clean up resources when program exits
 void cleanupDisplayResources() {
-    // Corrected SwsContext cleanup
 #ifdef __APPLE__
     metalRenderer.cleanup();
 #endif
@@ -1445,9 +905,24 @@ void cleanupDisplayResources() {
         screenTexture = nullptr;
         screenTextureInitialized = false;
     }
-    // Access the static SwsContext declared within displayFrame's scope (or make it global/member if needed)
-    // No explicit cleanup needed here anymore for SwsContext,
-    // static unique_ptr in displayFrame will handle it at program exit.
+    frameUploader.reset();
+    osdText.reset();
+    indexBar.reset();
+}
+
+void setDisplayFrameSink(FrameSink* sink) {
+    displayFrameSink = sink;
+}
+
+void presentRenderer(SDL_Renderer* renderer) {
+    if (displayFrameSink) {
+        displayFrameSink->submit(renderer);
+    }
+    SDL_RenderPresent(renderer);
+}
+
+void stageFrameForDisplay(const std::shared_ptr<AVFrame>& frame) {
+    frameUploader.stage(frame);
 }
 
 // Function to render the loading screen
@@ -1474,15 +949,9 @@ void renderLoadingScreen(SDL_Renderer* renderer, TTF_Font* font, const LoadingSt
     
     // Left Text (Fixed during loading)
     std::string leftText = "THREADING"; // More accurate VCR term for loading
-    SDL_Surface* leftSurface = TTF_RenderText_Blended(font, leftText.c_str(), textColor);
-    if (leftSurface) {
-        SDL_Texture* leftTexture = SDL_CreateTextureFromSurface(renderer, leftSurface);
-        if (leftTexture) {
-            SDL_Rect leftRect = {10, windowHeight - 30 + (30 - leftSurface->h) / 2, leftSurface->w, leftSurface->h};
-            SDL_RenderCopy(renderer, leftTexture, NULL, &leftRect);
-            SDL_DestroyTexture(leftTexture);
-        }
-        SDL_FreeSurface(leftSurface);
+    int textWidth = 0, textHeight = 0;
+    if (osdText.measure(renderer, font, leftText, textWidth, textHeight)) {
+        osdText.draw(renderer, font, leftText, 10, windowHeight - 30 + (30 - textHeight) / 2, textColor);
     }
 
     // Center Text (Stage) -> Blinking Timecode Placeholder
@@ -1493,15 +962,8 @@ void renderLoadingScreen(SDL_Renderer* renderer, TTF_Font* font, const LoadingSt
         lastBlinkTime = currentTicks;
     }
     std::string timecodeText = showDashes ? "--:--:--:--" : "  :  :  :  ";
-    SDL_Surface* timecodeSurface = TTF_RenderText_Blended(font, timecodeText.c_str(), textColor);
-    if (timecodeSurface) {
-        SDL_Texture* timecodeTexture = SDL_CreateTextureFromSurface(renderer, timecodeSurface);
-        if (timecodeTexture) {
-            SDL_Rect timecodeRect = {(windowWidth - timecodeSurface->w) / 2, windowHeight - 30 + (30 - timecodeSurface->h) / 2, timecodeSurface->w, timecodeSurface->h};
-            SDL_RenderCopy(renderer, timecodeTexture, NULL, &timecodeRect);
-            SDL_DestroyTexture(timecodeTexture);
-        }
-        SDL_FreeSurface(timecodeSurface);
+    if (osdText.measure(renderer, font, timecodeText, textWidth, textHeight)) {
+        osdText.draw(renderer, font, timecodeText, (windowWidth - textWidth) / 2, windowHeight - 30 + (30 - textHeight) / 2, textColor);
     }
 
     // Right Text (Progress Percentage) -> Show as 3-digit number
@@ -1509,19 +971,13 @@ void renderLoadingScreen(SDL_Renderer* renderer, TTF_Font* font, const LoadingSt
     char progressBuffer[4]; // 3 digits + null terminator
     snprintf(progressBuffer, sizeof(progressBuffer), "%03d", progressPercent);
     std::string rightText = progressBuffer;
-    SDL_Surface* rightSurface = TTF_RenderText_Blended(font, rightText.c_str(), textColor);
-    if (rightSurface) {
-        SDL_Texture* rightTexture = SDL_CreateTextureFromSurface(renderer, rightSurface);
-        if (rightTexture) {
-            SDL_Rect rightRect = {windowWidth - rightSurface->w - 10, windowHeight - 30 + (30 - rightSurface->h) / 2, rightSurface->w, rightSurface->h};
-            SDL_RenderCopy(renderer, rightTexture, NULL, &rightRect);
-            SDL_DestroyTexture(rightTexture);
-        }
-        SDL_FreeSurface(rightSurface);
+    if (osdText.measure(renderer, font, rightText, textWidth, textHeight)) {
+        osdText.draw(renderer, font, rightText, windowWidth - textWidth - 10, windowHeight - 30 + (30 - textHeight) / 2, textColor);
     }
+    osdText.flush(renderer);
     
     // Present the renderer
-    SDL_RenderPresent(renderer);
+    presentRenderer(renderer);
 }
 
 // Implementation of zoom functions (Jitter removed)
@@ -0,0 +1,160 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+std::atomic<bool> FramePacer::waitingForFrame_{false};
+std::atomic<bool> FramePacer::sleeping_{false};
+std::atomic<bool> FramePacer::wakePending_{false};
+std::atomic<Uint32> FramePacer::wakeEventType_{0};
+
+namespace {
+
+double toMs(FramePacer::Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+FramePacer::Clock::duration fromSeconds(double seconds) {
+    return std::chrono::duration_cast<FramePacer::Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+} // namespace
+
+FramePacer::FramePacer()
+    : targetInterval_(fromSeconds(1.0 / 60.0))
+    , refreshPeriod_(fromSeconds(1.0 / 60.0))
+    , frameStart_(Clock::now())
+    , lastPresent_(frameStart_)
+    , wakeTime_(frameStart_) {
+    recent_.reserve(kRecentIntervals);
+}
+
+void FramePacer::setTargetFps(double fps) {
+    Clock::duration interval = fromSeconds(fps > 0.0 ? 1.0 / fps : 1.0 / 60.0);
+    if (interval != targetInterval_) {
+        targetInterval_ = interval;
+        resetStats(); // Intervals against the old target would skew the numbers
+    }
+}
+
+void FramePacer::setDisplay(double refreshHz, bool vsync) {
+    refreshPeriod_ = fromSeconds(refreshHz > 0.0 ? 1.0 / refreshHz : 1.0 / 60.0);
+    vsync_ = vsync;
+    if (wakeEventType_.load() == 0) {
+        Uint32 type = SDL_RegisterEvents(1);
+        if (type != static_cast<Uint32>(-1)) wakeEventType_.store(type);
+    }
+    std::cout << "[Pacer] Display " << refreshHz << " Hz, vsync " << (vsync ? "on" : "off") << std::endl;
+}
+
+void FramePacer::markFrameStart() {
+    frameStart_ = Clock::now();
+}
+
+void FramePacer::markPresented() {
+    Clock::time_point now = Clock::now();
+    if (havePresent_) {
+        double interval = toMs(now - lastPresent_);
+        ++count_;
+        double delta = interval - mean_;
+        mean_ += delta / count_;
+        m2_ += delta * (interval - mean_);
+        min_ = count_ == 1 ? interval : std::min(min_, interval);
+        max_ = count_ == 1 ? interval : std::max(max_, interval);
+        if (interval > toMs(targetInterval_) * 1.5) ++late_;
+        if (recent_.size() < kRecentIntervals) {
+            recent_.push_back(static_cast<float>(interval));
+        } else {
+            recent_[recentPos_] = static_cast<float>(interval);
+            recentPos_ = (recentPos_ + 1) % kRecentIntervals;
+        }
+    }
+    workMsAverage_ = workMsAverage_ * 0.9 + toMs(now - wakeTime_) * 0.1;
+    lastPresent_ = now;
+    havePresent_ = true;
+}
+
+FramePacer::Clock::time_point FramePacer::nextDeadline(Clock::time_point now) const {
+    if (!vsync_ || !havePresent_) {
+        return frameStart_ + targetInterval_;
+    }
+    // Presents already block on vblank: nothing to add at or above the refresh rate
+    if (targetInterval_ * 2 <= refreshPeriod_ * 3) {
+        return now;
+    }
+    // Wake ahead of the vblank that ends the target interval by the usual render time
+    auto vblanks = std::max<Clock::rep>(1, (targetInterval_ + refreshPeriod_ / 2) / refreshPeriod_);
+    Clock::duration lead = fromSeconds(std::min(toMs(refreshPeriod_) / 2.0, workMsAverage_ + 1.0) / 1000.0);
+    return lastPresent_ + refreshPeriod_ * vblanks - lead;
+}
+
+void FramePacer::waitForNextFrame() {
+    Clock::time_point deadline = nextDeadline(Clock::now());
+    wakePending_.store(false);
+    sleeping_.store(true);
+
+    for (;;) {
+        Clock::time_point now = Clock::now();
+        if (now >= deadline) break;
+        Clock::duration remaining = deadline - now;
+        if (remaining > std::chrono::milliseconds(2)) {
+            // Whole milliseconds in the event wait, the rest below
+            int timeoutMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count()) - 1;
+            if (SDL_WaitEventTimeout(nullptr, timeoutMs)) break; // Input or a frame-ready wake
+        } else {
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+
+    sleeping_.store(false);
+    wakeTime_ = Clock::now();
+}
+
+void FramePacer::notifyFrameReady() {
+    if (!waitingForFrame_.load(std::memory_order_relaxed) || !sleeping_.load()) return;
+    Uint32 type = wakeEventType_.load();
+    if (type == 0 || wakePending_.exchange(true)) return;
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = type;
+    SDL_PushEvent(&event);
+}
+
+FramePacer::Stats FramePacer::stats() const {
+    Stats s;
+    s.frames = count_;
+    s.targetMs = toMs(targetInterval_);
+    s.meanMs = mean_;
+    s.stddevMs = count_ > 1 ? std::sqrt(m2_ / (count_ - 1)) : 0.0;
+    s.minMs = min_;
+    s.maxMs = max_;
+    s.late = late_;
+    if (!recent_.empty()) {
+        std::vector<float> sorted(recent_);
+        size_t index = std::min(sorted.size() - 1, static_cast<size_t>(sorted.size() * 0.99));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        s.p99Ms = sorted[index];
+    }
+    return s;
+}
+
+void FramePacer::resetStats() {
+    count_ = 0;
+    mean_ = m2_ = min_ = max_ = 0.0;
+    late_ = 0;
+    recent_.clear();
+    recentPos_ = 0;
+    havePresent_ = false;
+}
+
+void FramePacer::logStats(const char* label) const {
+    Stats s = stats();
+    if (s.frames == 0) return;
+    std::cout << std::fixed << std::setprecision(2)
+              << "[Pacer] " << label << ": " << s.frames << " frames, target " << s.targetMs
+              << " ms, interval mean " << s.meanMs << " / sd " << s.stddevMs
+              << " / min " << s.minMs << " / max " << s.maxMs << " / p99 " << s.p99Ms
+              << " ms, late " << s.late << std::defaultfloat << std::endl;
+}
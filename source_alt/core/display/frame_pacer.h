@@ -0,0 +1,86 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Paces the display loop against a monotonic clock instead of spinning on
+// SDL_GetTicks.
+//
+// waitForNextFrame() blocks in SDL_WaitEventTimeout until the next display
+// deadline, so the thread is asleep between frames but still returns as soon
+// as input arrives. With a vsync'd renderer the present itself paces rates at
+// or above the refresh rate; slower rates wake just ahead of the vblank that
+// matches the target interval. While the loop is waiting for a frame that has
+// not been decoded yet, notifyFrameReady() from a decoder thread ends the wait
+// early. Present-to-present intervals are kept for jitter statistics.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t frames = 0;   // Presents measured
+        double targetMs = 0.0;
+        double meanMs = 0.0;   // Present-to-present interval
+        double stddevMs = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+        double p99Ms = 0.0;    // Over the last kRecentIntervals presents
+        uint64_t late = 0;     // Intervals over 1.5x the target
+    };
+
+    FramePacer();
+
+    void setTargetFps(double fps);
+    // Refresh rate of the window's display and whether presents block on vblank
+    void setDisplay(double refreshHz, bool vsync);
+
+    void markFrameStart();
+    // Call right after SDL_RenderPresent
+    void markPresented();
+    // Sleeps until the next deadline; returns early on SDL events and,
+    // while waiting for a frame, on notifyFrameReady()
+    void waitForNextFrame();
+
+    // The frame the loop wants is not decoded yet
+    void setWaitingForFrame(bool waiting) { waitingForFrame_.store(waiting, std::memory_order_relaxed); }
+    // Thread-safe; called when a decoder publishes a displayable frame
+    static void notifyFrameReady();
+
+    Stats stats() const;
+    void resetStats();
+    void logStats(const char* label) const;
+
+private:
+    static constexpr size_t kRecentIntervals = 512;
+
+    Clock::time_point nextDeadline(Clock::time_point now) const;
+
+    Clock::duration targetInterval_;
+    Clock::duration refreshPeriod_;
+    bool vsync_ = false;
+
+    Clock::time_point frameStart_;
+    Clock::time_point lastPresent_;
+    Clock::time_point wakeTime_;
+    bool havePresent_ = false;
+    double workMsAverage_ = 0.0; // Wake-to-present time, used as the vsync lead
+
+    // Interval statistics (Welford)
+    uint64_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+    uint64_t late_ = 0;
+    std::vector<float> recent_;
+    size_t recentPos_ = 0;
+
+    // Shared with notifyFrameReady() on decoder threads; one display loop per process
+    static std::atomic<bool> waitingForFrame_;
+    static std::atomic<bool> sleeping_;
+    static std::atomic<bool> wakePending_;
+    static std::atomic<Uint32> wakeEventType_;
+};
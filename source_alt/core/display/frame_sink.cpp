@@ -0,0 +1,152 @@
+#include "frame_sink.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+FrameSink::~FrameSink() {
+    close();
+}
+
+bool FrameSink::open(const std::string& spec, int width, int height) {
+    close();
+    width_ = width;
+    height_ = height;
+
+    if (spec.empty() || spec == "null") {
+        kind_ = Kind::Null;
+        std::cout << "[FrameSink] Discarding frames" << std::endl;
+        return true;
+    }
+    if (spec.compare(0, 5, "file:") == 0 && spec.size() > 5) {
+        kind_ = Kind::File;
+        target_ = spec.substr(5);
+        file_ = fopen(target_.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "[FrameSink] Cannot open " << target_ << ": " << strerror(errno) << std::endl;
+            kind_ = Kind::Null;
+            return false;
+        }
+        pixels_.resize(static_cast<size_t>(width) * height * 4);
+        std::cout << "[FrameSink] Writing raw BGRA " << width << "x" << height << " frames to " << target_ << std::endl;
+        return true;
+    }
+    if (spec.compare(0, 4, "shm:") == 0 && spec.size() > 4) {
+        kind_ = Kind::SharedMemory;
+        target_ = spec.substr(4);
+        if (target_[0] != '/') target_ = "/" + target_;
+        if (!openSharedMemory(width, height)) {
+            kind_ = Kind::Null;
+            return false;
+        }
+        std::cout << "[FrameSink] Publishing BGRA " << width << "x" << height << " frames in shared memory " << target_ << std::endl;
+        return true;
+    }
+
+    std::cerr << "[FrameSink] Unknown output '" << spec << "' (expected null, file:<path> or shm:<name>)" << std::endl;
+    return false;
+}
+
+bool FrameSink::openSharedMemory(int width, int height) {
+    const size_t dataOffset = (sizeof(ShmHeader) + 63) & ~static_cast<size_t>(63);
+    shmSize_ = dataOffset + static_cast<size_t>(width) * height * 4;
+
+    shmFd_ = shm_open(target_.c_str(), O_CREAT | O_RDWR, 0644);
+    if (shmFd_ < 0) {
+        std::cerr << "[FrameSink] shm_open " << target_ << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(shmFd_, static_cast<off_t>(shmSize_)) != 0) {
+        std::cerr << "[FrameSink] ftruncate failed: " << strerror(errno) << std::endl;
+        ::close(shmFd_);
+        shmFd_ = -1;
+        return false;
+    }
+    shmBase_ = mmap(nullptr, shmSize_, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd_, 0);
+    if (shmBase_ == MAP_FAILED) {
+        std::cerr << "[FrameSink] mmap failed: " << strerror(errno) << std::endl;
+        shmBase_ = nullptr;
+        ::close(shmFd_);
+        shmFd_ = -1;
+        return false;
+    }
+
+    ShmHeader* header = new (shmBase_) ShmHeader();
+    header->magic = kShmMagic;
+    header->version = 1;
+    header->width = static_cast<uint32_t>(width);
+    header->height = static_cast<uint32_t>(height);
+    header->stride = static_cast<uint32_t>(width) * 4;
+    header->dataOffset = static_cast<uint32_t>(dataOffset);
+    header->sequence.store(0, std::memory_order_release);
+    header->frameNumber = 0;
+    header->timestampNs = 0;
+    return true;
+}
+
+void FrameSink::close() {
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    if (shmBase_) {
+        munmap(shmBase_, shmSize_);
+        shmBase_ = nullptr;
+    }
+    if (shmFd_ >= 0) {
+        ::close(shmFd_);
+        shmFd_ = -1;
+        shm_unlink(target_.c_str());
+    }
+    if (frames_ > 0) {
+        std::cout << "[FrameSink] " << frames_ << " frames written" << std::endl;
+    }
+    kind_ = Kind::Null;
+    frames_ = 0;
+}
+
+void FrameSink::submit(SDL_Renderer* renderer) {
+    if (kind_ == Kind::Null || !renderer) return;
+
+    // The output size is fixed at open(); a different render size is clipped to it
+    int outputWidth = 0, outputHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &outputWidth, &outputHeight);
+    SDL_Rect rect = {0, 0, std::min(width_, outputWidth), std::min(height_, outputHeight)};
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    if (kind_ == Kind::File) {
+        if (SDL_RenderReadPixels(renderer, &rect, SDL_PIXELFORMAT_ARGB8888, pixels_.data(), width_ * 4) != 0) {
+            std::cerr << "[FrameSink] SDL_RenderReadPixels failed: " << SDL_GetError() << std::endl;
+            return;
+        }
+        if (fwrite(pixels_.data(), 1, pixels_.size(), file_) != pixels_.size()) {
+            std::cerr << "[FrameSink] Short write to " << target_ << ", closing the sink" << std::endl;
+            close();
+            return;
+        }
+        ++frames_;
+        return;
+    }
+
+    // Shared memory: read straight into the mapping under the sequence lock
+    ShmHeader* header = static_cast<ShmHeader*>(shmBase_);
+    uint8_t* data = static_cast<uint8_t*>(shmBase_) + header->dataOffset;
+    uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    int result = SDL_RenderReadPixels(renderer, &rect, SDL_PIXELFORMAT_ARGB8888, data, static_cast<int>(header->stride));
+    header->frameNumber = frames_ + 1;
+    header->timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    header->sequence.store(sequence + 2, std::memory_order_release);
+    if (result != 0) {
+        std::cerr << "[FrameSink] SDL_RenderReadPixels failed: " << SDL_GetError() << std::endl;
+        return;
+    }
+    ++frames_;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Destination for composited frames in headless mode.
+//
+// Every present is read back (BGRA, 4 bytes per pixel, rows packed) and
+// handed to one of:
+//   null         nothing is read back; measures the pipeline alone
+//   file:<path>  raw frames appended to a file, e.g. for
+//                ffmpeg -f rawvideo -pix_fmt bgra -s WxH -i <path>
+//   shm:<name>   latest frame in a POSIX shared memory object (see ShmHeader)
+class FrameSink {
+public:
+    enum class Kind { Null, File, SharedMemory };
+
+    // Layout at the start of the shared memory object, pixels follow at
+    // dataOffset. `sequence` is odd while a frame is being written; a reader
+    // copies the pixels and accepts them if the sequence was even and unchanged.
+    struct ShmHeader {
+        uint32_t magic;       // kShmMagic
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;      // Bytes per row
+        uint32_t dataOffset;  // From the start of the object
+        std::atomic<uint64_t> sequence;
+        uint64_t frameNumber;
+        uint64_t timestampNs; // steady_clock at read-back
+    };
+    static constexpr uint32_t kShmMagic = 0x54585046; // "TXPF"
+
+    FrameSink() = default;
+    ~FrameSink();
+
+    FrameSink(const FrameSink&) = delete;
+    FrameSink& operator=(const FrameSink&) = delete;
+
+    // Parses the spec ("null", "file:<path>", "shm:<name>") and opens the sink
+    bool open(const std::string& spec, int width, int height);
+    void close();
+
+    // Reads the current render target back; call before SDL_RenderPresent
+    void submit(SDL_Renderer* renderer);
+
+    Kind kind() const { return kind_; }
+    uint64_t framesWritten() const { return frames_; }
+
+private:
+    bool openSharedMemory(int width, int height);
+
+    Kind kind_ = Kind::Null;
+    std::string target_;
+    int width_ = 0;
+    int height_ = 0;
+    uint64_t frames_ = 0;
+
+    FILE* file_ = nullptr;
+    std::vector<uint8_t> pixels_; // Read-back buffer for the file sink
+
+    int shmFd_ = -1;
+    void* shmBase_ = nullptr;
+    size_t shmSize_ = 0;
+};
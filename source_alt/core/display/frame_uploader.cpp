@@ -0,0 +1,195 @@
+#include "frame_uploader.h"
+#include "../trace/perf_trace.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+}
+
+FrameUploader::~FrameUploader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobCv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+    reset();
+}
+
+void FrameUploader::workerLoop() {
+    PerfTrace::setThreadName("frame_uploader");
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        jobCv_.wait(lock, [this] { return stopping_ || jobQueued_; });
+        if (stopping_) return;
+        jobQueued_ = false;
+        Slot& slot = slots_[pendingSlot_];
+
+        // The slot is ours until pendingSlot_ is cleared; acquire()/stage() wait for that
+        lock.unlock();
+        bool ok = download(slot);
+        lock.lock();
+
+        slot.ready = ok;
+        if (!ok) slot.source.reset();
+        pendingSlot_ = -1;
+        doneCv_.notify_all();
+    }
+}
+
+void FrameUploader::waitIdle(std::unique_lock<std::mutex>& lock) {
+    doneCv_.wait(lock, [this] { return pendingSlot_ < 0; });
+}
+
+bool FrameUploader::download(Slot& slot) {
+    PERF_SPAN("upload.hw_download");
+    const AVFrame* src = slot.source.get();
+    if (!slot.frame) {
+        slot.frame = av_frame_alloc();
+        if (!slot.frame) {
+            std::cerr << "Error allocating SW frame for transfer." << std::endl;
+            return false;
+        }
+    }
+    // Keep the buffer while the size matches; only the first frame of a size allocates
+    if (!slot.frame->buf[0] || slot.frame->width != src->width || slot.frame->height != src->height) {
+        av_frame_unref(slot.frame);
+        slot.frame->format = AV_PIX_FMT_NV12;
+        slot.frame->width = src->width;
+        slot.frame->height = src->height;
+        if (av_frame_get_buffer(slot.frame, 0) < 0) {
+            std::cerr << "Error allocating buffer for SW frame." << std::endl;
+            av_frame_unref(slot.frame);
+            return false;
+        }
+    }
+    if (av_hwframe_transfer_data(slot.frame, src, 0) < 0) {
+        std::cerr << "Error transferring hardware frame data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void FrameUploader::stage(const std::shared_ptr<AVFrame>& frame) {
+    if (!frame || frame->format != AV_PIX_FMT_VIDEOTOOLBOX) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitIdle(lock);
+    for (const Slot& slot : slots_) {
+        if (slot.ready && slot.source == frame) return; // Already downloaded
+    }
+    if (!worker_.joinable()) {
+        worker_ = std::thread(&FrameUploader::workerLoop, this);
+    }
+
+    int index = nextSlot_;
+    nextSlot_ = (nextSlot_ + 1) % kSlotCount;
+    slots_[index].source = frame;
+    slots_[index].ready = false;
+    pendingSlot_ = index;
+    jobQueued_ = true;
+    jobCv_.notify_one();
+}
+
+AVFrame* FrameUploader::acquire(const std::shared_ptr<AVFrame>& frame, bool& owned) {
+    owned = false;
+    if (!frame) return nullptr;
+    if (frame->format != AV_PIX_FMT_VIDEOTOOLBOX) return frame.get();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitIdle(lock);
+    for (Slot& slot : slots_) {
+        if (slot.ready && slot.source == frame) {
+            owned = true;
+            return slot.frame;
+        }
+    }
+
+    // Not staged (or the staged download failed): download now
+    Slot& slot = slots_[nextSlot_];
+    nextSlot_ = (nextSlot_ + 1) % kSlotCount;
+    slot.source = frame;
+    slot.ready = download(slot);
+    if (!slot.ready) {
+        slot.source.reset();
+        return nullptr;
+    }
+    owned = true;
+    return slot.frame;
+}
+
+SwsContext* FrameUploader::swsContext(int width, int height, AVPixelFormat src, AVPixelFormat dst) {
+    ++swsUseCounter_;
+    for (SwsEntry& entry : swsCache_) {
+        if (entry.width == width && entry.height == height && entry.src == src && entry.dst == dst) {
+            entry.lastUse = swsUseCounter_;
+            return entry.context;
+        }
+    }
+
+    SwsContext* context = sws_getContext(width, height, src, width, height, dst, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!context) {
+        std::cerr << "Error creating SwsContext for " << src << " -> " << dst << std::endl;
+        return nullptr;
+    }
+    if (swsCache_.size() >= kSwsCacheSize) {
+        auto lru = std::min_element(swsCache_.begin(), swsCache_.end(), [](const SwsEntry& a, const SwsEntry& b) {
+            return a.lastUse < b.lastUse;
+        });
+        sws_freeContext(lru->context);
+        swsCache_.erase(lru);
+    }
+    swsCache_.push_back({width, height, src, dst, context, swsUseCounter_});
+    return context;
+}
+
+bool FrameUploader::alreadyUploaded(const std::shared_ptr<AVFrame>& frame) const {
+    return frame && lastUploaded_ == frame && !lastUploadAnimated_;
+}
+
+void FrameUploader::markUploaded(const std::shared_ptr<AVFrame>& frame, bool animated) {
+    // Holding the reference also keeps the address from being reused by a new frame
+    lastUploaded_ = frame;
+    lastUploadAnimated_ = animated;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitIdle(lock);
+    for (Slot& slot : slots_) {
+        if (slot.source == frame) {
+            slot.source.reset();
+            slot.ready = false;
+        }
+    }
+}
+
+void FrameUploader::invalidate() {
+    lastUploaded_.reset();
+}
+
+void FrameUploader::reset() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitIdle(lock);
+    for (Slot& slot : slots_) {
+        av_frame_free(&slot.frame);
+        slot.source.reset();
+        slot.ready = false;
+    }
+    for (SwsEntry& entry : swsCache_) {
+        sws_freeContext(entry.context);
+    }
+    swsCache_.clear();
+    lastUploaded_.reset();
+}
+
+void FrameUploader::copyPlane(uint8_t* dst, int dstPitch, const uint8_t* src, int srcPitch, int rowBytes, int rows) {
+    if (!dst || !src || rows <= 0 || rowBytes <= 0) return;
+    if (dstPitch == srcPitch) {
+        memcpy(dst, src, static_cast<size_t>(srcPitch) * (rows - 1) + rowBytes);
+        return;
+    }
+    for (int y = 0; y < rows; ++y) {
+        memcpy(dst + static_cast<size_t>(y) * dstPitch, src + static_cast<size_t>(y) * srcPitch, rowBytes);
+    }
+}
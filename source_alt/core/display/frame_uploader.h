@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+// Reusable state of the software texture upload path in displayFrame.
+//
+// Hardware (VideoToolbox) frames are downloaded into a small pool of staging
+// frames that are allocated once per size, instead of a fresh AVFrame per
+// displayed frame. The download is started by stage() right after frame
+// selection and runs on a persistent worker thread, so it overlaps the rest of
+// the loop iteration up to the texture update. SwsContexts are cached per
+// size/format key.
+class FrameUploader {
+public:
+    FrameUploader() = default;
+    ~FrameUploader();
+
+    FrameUploader(const FrameUploader&) = delete;
+    FrameUploader& operator=(const FrameUploader&) = delete;
+
+    // Starts downloading a hardware frame on the worker; software frames are ignored
+    void stage(const std::shared_ptr<AVFrame>& frame);
+
+    // Software view of `frame`: the staged download (waiting for it if needed),
+    // a synchronous download if it was not staged, or the frame itself for
+    // software frames. `owned` is set for staging frames, which the caller may
+    // modify in place. Returns nullptr if a download failed. The result stays
+    // valid until the next stage() or acquire().
+    AVFrame* acquire(const std::shared_ptr<AVFrame>& frame, bool& owned);
+
+    // Conversion context for this size and format pair, owned by the uploader
+    SwsContext* swsContext(int width, int height, AVPixelFormat src, AVPixelFormat dst);
+
+    // The texture already holds `frame` and nothing animated was drawn into it,
+    // so it does not need to be uploaded again
+    bool alreadyUploaded(const std::shared_ptr<AVFrame>& frame) const;
+    // Records the upload. A staging copy of `frame` was modified by the effects
+    // and is dropped so a later acquire() downloads it again.
+    void markUploaded(const std::shared_ptr<AVFrame>& frame, bool animated);
+    // The texture contents are gone (recreated or destroyed)
+    void invalidate();
+
+    // Frees staging frames and conversion contexts
+    void reset();
+
+    // Copies `rows` rows of rowBytes; one memcpy when the pitches match
+    static void copyPlane(uint8_t* dst, int dstPitch, const uint8_t* src, int srcPitch, int rowBytes, int rows);
+
+private:
+    struct Slot {
+        AVFrame* frame = nullptr;          // Staging buffer, reallocated only on size change
+        std::shared_ptr<AVFrame> source;   // Hardware frame it holds (or is downloading)
+        bool ready = false;                // Download finished successfully
+    };
+
+    struct SwsEntry {
+        int width;
+        int height;
+        AVPixelFormat src;
+        AVPixelFormat dst;
+        SwsContext* context;
+        uint64_t lastUse;
+    };
+
+    static constexpr int kSlotCount = 2;
+    static constexpr size_t kSwsCacheSize = 4;
+
+    bool download(Slot& slot);
+    void waitIdle(std::unique_lock<std::mutex>& lock);
+    void workerLoop();
+
+    std::mutex mutex_;
+    std::condition_variable jobCv_;
+    std::condition_variable doneCv_;
+    std::thread worker_;
+    bool stopping_ = false;
+    int pendingSlot_ = -1; // Slot queued or being downloaded
+    bool jobQueued_ = false;
+
+    Slot slots_[kSlotCount];
+    int nextSlot_ = 0;
+
+    std::vector<SwsEntry> swsCache_;
+    uint64_t swsUseCounter_ = 0;
+
+    std::shared_ptr<AVFrame> lastUploaded_;
+    bool lastUploadAnimated_ = false;
+};
@@ -0,0 +1,154 @@
+#include "index_bar.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// FrameInfo::FrameType order: EMPTY, LOW_RES, CACHED, FULL_RES
+constexpr int kEmpty = 0;
+constexpr int kLowRes = 1;
+constexpr int kCached = 2;
+constexpr int kFullRes = 3;
+
+// A column shows the best tier any of its frames holds, not the most common
+// one: the sparse tier keeps one frame in every few by design, so EMPTY would
+// always outnumber it. Inside the buffer the dense tiers come first; outside
+// it only the sparse tier has its own colour.
+constexpr int kInBufferPriority[] = {kFullRes, kLowRes, kCached};
+constexpr int kOutBufferPriority[] = {kCached};
+
+constexpr uint32_t kInBufferColors[FrameStateSummary::kTypeCount] = {
+    0xFF404040, // Dark gray
+    0xFF0080FF, // Light blue
+    0xFF00FF80, // Light green
+    0xFFFFFF00, // Yellow
+};
+constexpr uint32_t kOutBufferColors[FrameStateSummary::kTypeCount] = {
+    0xFF202020, // Very dark gray
+    0xFF202020,
+    0xFF008040, // Darker green
+    0xFF202020,
+};
+
+} // namespace
+
+IndexBar::~IndexBar() {
+    reset();
+}
+
+void IndexBar::reset() {
+    if (texture_) {
+        SDL_DestroyTexture(texture_);
+        texture_ = nullptr;
+    }
+    textureRenderer_ = nullptr;
+    width_ = 0;
+    view_ = FrameStateSummary::View();
+}
+
+bool IndexBar::ensureTexture(SDL_Renderer* renderer, int width) {
+    if (texture_ && textureRenderer_ == renderer && width_ == width) return true;
+    if (texture_) SDL_DestroyTexture(texture_);
+    texture_ = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, 2);
+    if (!texture_) {
+        std::cerr << "[IndexBar] Error creating texture: " << SDL_GetError() << std::endl;
+        textureRenderer_ = nullptr;
+        width_ = 0;
+        return false;
+    }
+    SDL_SetTextureScaleMode(texture_, SDL_ScaleModeNearest);
+    textureRenderer_ = renderer;
+    width_ = width;
+    pixels_.assign(static_cast<size_t>(width) * 2, kOutBufferColors[0]);
+    fullUpdate_ = true;
+    return true;
+}
+
+int IndexBar::columnOfFrame(int frame) const {
+    return static_cast<int>(static_cast<int64_t>(frame) * width_ / view_.totalFrames);
+}
+
+void IndexBar::updateColumns(int firstColumn, int lastColumn) {
+    const int total = view_.totalFrames;
+    const int perBucket = view_.framesPerBucket;
+    for (int x = firstColumn; x <= lastColumn; ++x) {
+        // Frames of this column (at least one when the window is wider than the file)
+        int first = static_cast<int>(static_cast<int64_t>(x) * total / width_);
+        int last = static_cast<int>(static_cast<int64_t>(x + 1) * total / width_) - 1;
+        last = std::min(total - 1, std::max(first, last));
+
+        uint32_t sums[FrameStateSummary::kTypeCount] = {0, 0, 0, 0};
+        for (int b = first / perBucket; b <= last / perBucket; ++b) {
+            const uint32_t* counts = &view_.counts[static_cast<size_t>(b) * FrameStateSummary::kTypeCount];
+            for (int t = 0; t < FrameStateSummary::kTypeCount; ++t) sums[t] += counts[t];
+        }
+        int inType = kEmpty;
+        for (int t : kInBufferPriority) {
+            if (sums[t] > 0) {
+                inType = t;
+                break;
+            }
+        }
+        int outType = kEmpty;
+        for (int t : kOutBufferPriority) {
+            if (sums[t] > 0) {
+                outType = t;
+                break;
+            }
+        }
+        pixels_[x] = kInBufferColors[inType];
+        pixels_[width_ + x] = kOutBufferColors[outType];
+    }
+
+    SDL_Rect rect = {firstColumn, 0, lastColumn - firstColumn + 1, 2};
+    SDL_UpdateTexture(texture_, &rect, pixels_.data() + firstColumn, width_ * static_cast<int>(sizeof(uint32_t)));
+}
+
+void IndexBar::render(SDL_Renderer* renderer, int currentFrame, int bufferStart, int bufferEnd) {
+    int windowWidth, windowHeight;
+    SDL_GetRendererOutputSize(renderer, &windowWidth, &windowHeight);
+    if (windowWidth <= 0) return;
+
+    const uint64_t previousGeneration = view_.generation;
+    if (!ensureTexture(renderer, windowWidth)) return;
+
+    int firstBucket = 0, lastBucket = -1;
+    bool changed = frameStateSummary.refresh(view_, firstBucket, lastBucket);
+    if (view_.totalFrames <= 0) return; // Nothing to draw
+
+    if (fullUpdate_ || previousGeneration != view_.generation) {
+        updateColumns(0, width_ - 1);
+        fullUpdate_ = false;
+    } else if (changed) {
+        int firstFrame = firstBucket * view_.framesPerBucket;
+        int lastFrame = std::min(view_.totalFrames - 1, (lastBucket + 1) * view_.framesPerBucket - 1);
+        // Through the last column of lastFrame: one frame spans several when the bar is wider than the file
+        int firstColumn = columnOfFrame(firstFrame);
+        int lastColumn = std::max(firstColumn, std::min(width_ - 1, columnOfFrame(lastFrame + 1) - 1));
+        updateColumns(firstColumn, lastColumn);
+    }
+
+    // Outside-buffer colours across the bar, in-buffer colours over the buffer
+    SDL_Rect src = {0, 1, width_, 1};
+    SDL_Rect dst = {0, 0, width_, kHeight};
+    SDL_RenderCopy(renderer, texture_, &src, &dst);
+    bufferStart = std::max(0, bufferStart);
+    bufferEnd = std::min(view_.totalFrames - 1, bufferEnd);
+    if (bufferStart <= bufferEnd) {
+        int x0 = columnOfFrame(bufferStart);
+        int x1 = std::min(width_ - 1, columnOfFrame(bufferEnd));
+        src = {x0, 0, x1 - x0 + 1, 1};
+        dst = {x0, 0, x1 - x0 + 1, kHeight};
+        SDL_RenderCopy(renderer, texture_, &src, &dst);
+    }
+
+    // --- Render current frame (playhead) ---
+    double frameWidth = static_cast<double>(width_) / view_.totalFrames;
+    int playheadX = static_cast<int>(currentFrame * frameWidth);
+    playheadX = std::max(0, std::min(playheadX, width_ - 1));
+    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Red
+    SDL_RenderDrawLine(renderer, playheadX, 0, playheadX, kHeight - 1);
+    if (frameWidth < 1.0 && playheadX < width_ - 1) {
+        SDL_RenderDrawLine(renderer, playheadX + 1, 0, playheadX + 1, kHeight - 1);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+#include "../decode/frame_state_summary.h"
+
+// Frame-type bar at the top of the window, drawn from frameStateSummary.
+//
+// The bar is a streaming texture one texel per window column and two rows:
+// row 0 holds the colours for columns inside the decode buffer, row 1 the
+// colours outside it. Only the columns whose buckets changed are rewritten;
+// each frame draws row 1 across the bar and row 0 over the buffer range, so
+// moving the buffer does not touch the texture at all.
+class IndexBar {
+public:
+    IndexBar() = default;
+    ~IndexBar();
+
+    IndexBar(const IndexBar&) = delete;
+    IndexBar& operator=(const IndexBar&) = delete;
+
+    void render(SDL_Renderer* renderer, int currentFrame, int bufferStart, int bufferEnd);
+    void reset();
+
+private:
+    static constexpr int kHeight = 5;
+
+    bool ensureTexture(SDL_Renderer* renderer, int width);
+    void updateColumns(int firstColumn, int lastColumn);
+    int columnOfFrame(int frame) const;
+
+    SDL_Texture* texture_ = nullptr;
+    SDL_Renderer* textureRenderer_ = nullptr;
+    int width_ = 0;
+    bool fullUpdate_ = false; // New texture: every column has to be written
+    FrameStateSummary::View view_;
+    std::vector<uint32_t> pixels_; // Two rows of width_ ARGB8888 texels, staged for the update
+};
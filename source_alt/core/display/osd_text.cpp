@@ -0,0 +1,305 @@
+#include "osd_text.h"
+#include "../log/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+OsdText::~OsdText() {
+    reset();
+}
+
+void OsdText::reset() {
+    for (Atlas* atlas : atlases_) {
+        if (atlas->texture) SDL_DestroyTexture(atlas->texture);
+        delete atlas;
+    }
+    atlases_.clear();
+    layouts_.clear();
+    batchTexture_ = nullptr;
+    batchVertices_.clear();
+    batchIndices_.clear();
+}
+
+OsdText::Atlas* OsdText::atlasFor(SDL_Renderer* renderer, TTF_Font* font) {
+    if (!renderer || !font) return nullptr;
+    for (Atlas* atlas : atlases_) {
+        if (atlas->renderer == renderer && atlas->font == font) {
+            return atlas->texture ? atlas : nullptr;
+        }
+    }
+    // Kept even if the build failed, so a broken font is not re-rendered every frame
+    Atlas* atlas = new Atlas();
+    atlas->renderer = renderer;
+    atlas->font = font;
+    atlases_.push_back(atlas);
+    return buildAtlas(*atlas) ? atlas : nullptr;
+}
+
+bool OsdText::buildAtlas(Atlas& atlas) {
+    const SDL_Color white = {255, 255, 255, 255};
+    atlas.lineHeight = TTF_FontHeight(atlas.font);
+
+    // Render every glyph once and shelf-pack them into rows of kAtlasWidth
+    SDL_Surface* glyphSurfaces[kGlyphCount] = {};
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+    for (int i = 0; i < kGlyphCount; ++i) {
+        Uint16 ch = static_cast<Uint16>(kFirstGlyph + i);
+        Glyph& glyph = atlas.glyphs[i];
+        int minx, maxx, miny, maxy, advance;
+        if (!TTF_GlyphIsProvided(atlas.font, ch) || TTF_GlyphMetrics(atlas.font, ch, &minx, &maxx, &miny, &maxy, &advance) != 0) {
+            continue;
+        }
+        glyph.advance = advance;
+        if (ch == ' ') continue; // Advance only
+
+        SDL_Surface* surface = TTF_RenderGlyph_Blended(atlas.font, ch, white);
+        if (!surface) continue;
+        if (x + surface->w + 1 > kAtlasWidth) {
+            x = 0;
+            y += rowHeight + 1;
+            rowHeight = 0;
+        }
+        glyph.src = {x, y, surface->w, surface->h};
+        glyphSurfaces[i] = surface;
+        x += surface->w + 1;
+        rowHeight = std::max(rowHeight, surface->h);
+    }
+    atlas.width = kAtlasWidth;
+    atlas.height = y + rowHeight;
+
+    bool ok = false;
+    SDL_Surface* sheet = atlas.height > 0
+        ? SDL_CreateRGBSurfaceWithFormat(0, atlas.width, atlas.height, 32, SDL_PIXELFORMAT_ARGB8888)
+        : nullptr;
+    if (sheet) {
+        SDL_FillRect(sheet, nullptr, SDL_MapRGBA(sheet->format, 255, 255, 255, 0));
+        for (int i = 0; i < kGlyphCount; ++i) {
+            if (!glyphSurfaces[i]) continue;
+            // Copy alpha as-is instead of blending onto the transparent sheet
+            SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+            SDL_Rect dst = atlas.glyphs[i].src;
+            SDL_BlitSurface(glyphSurfaces[i], nullptr, sheet, &dst);
+        }
+        atlas.texture = SDL_CreateTextureFromSurface(atlas.renderer, sheet);
+        if (atlas.texture) {
+            SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+            ok = true;
+        } else {
+            TX_LOG_ERROR("OSD", "Error creating glyph atlas texture: " << SDL_GetError());
+        }
+        SDL_FreeSurface(sheet);
+    } else {
+        TX_LOG_ERROR("OSD", "Error creating glyph atlas surface: " << SDL_GetError());
+    }
+    for (SDL_Surface* surface : glyphSurfaces) {
+        if (surface) SDL_FreeSurface(surface);
+    }
+    if (ok) {
+        TX_LOG_DEBUG("OSD", "Glyph atlas built: " << atlas.width << "x" << atlas.height
+                     << ", line height " << atlas.lineHeight);
+    }
+    return ok;
+}
+
+const OsdText::Layout* OsdText::layoutFor(SDL_Renderer* renderer, TTF_Font* font, const std::string& text) {
+    Atlas* atlas = atlasFor(renderer, font);
+    if (!atlas) return nullptr;
+
+    ++useCounter_;
+    for (Layout& layout : layouts_) {
+        if (layout.atlas == atlas && layout.text == text) {
+            layout.lastUse = useCounter_;
+            return &layout;
+        }
+    }
+
+    // Miss: take a new slot, or reuse the least recently used one and its storage
+    Layout* layout;
+    if (layouts_.size() < kLayoutCacheSize) {
+        layouts_.emplace_back();
+        layout = &layouts_.back();
+    } else {
+        layout = &*std::min_element(layouts_.begin(), layouts_.end(), [](const Layout& a, const Layout& b) {
+            return a.lastUse < b.lastUse;
+        });
+    }
+    layout->atlas = atlas;
+    layout->text = text;
+    layout->vertices.clear();
+    layout->lastUse = useCounter_;
+
+    const float invW = 1.0f / atlas->width;
+    const float invH = 1.0f / atlas->height;
+    const SDL_Color white = {255, 255, 255, 255};
+    int pen = 0;
+    Uint16 previous = 0;
+    for (unsigned char c : text) {
+        if (c < kFirstGlyph || c > kLastGlyph) continue;
+        const Glyph& glyph = atlas->glyphs[c - kFirstGlyph];
+        if (previous) pen += TTF_GetFontKerningSizeGlyphs(atlas->font, previous, c);
+        previous = c;
+
+        if (glyph.src.w > 0) {
+            const float x0 = static_cast<float>(pen);
+            const float x1 = x0 + glyph.src.w;
+            const float y1 = static_cast<float>(glyph.src.h);
+            const float u0 = glyph.src.x * invW;
+            const float u1 = (glyph.src.x + glyph.src.w) * invW;
+            const float v0 = glyph.src.y * invH;
+            const float v1 = (glyph.src.y + glyph.src.h) * invH;
+            layout->vertices.push_back({{x0, 0.0f}, white, {u0, v0}});
+            layout->vertices.push_back({{x1, 0.0f}, white, {u1, v0}});
+            layout->vertices.push_back({{x1, y1}, white, {u1, v1}});
+            layout->vertices.push_back({{x0, y1}, white, {u0, v1}});
+        }
+        pen += glyph.advance;
+    }
+    layout->width = pen;
+    layout->height = atlas->lineHeight;
+    return layout;
+}
+
+bool OsdText::measure(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, int& width, int& height) {
+    const Layout* layout = layoutFor(renderer, font, text);
+    if (!layout) return false;
+    width = layout->width;
+    height = layout->height;
+    return true;
+}
+
+void OsdText::draw(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, int x, int y, SDL_Color color) {
+    const Layout* layout = layoutFor(renderer, font, text);
+    if (!layout || layout->vertices.empty()) return;
+
+    // One draw call per atlas: switching atlases flushes what is queued
+    if (batchTexture_ && batchTexture_ != layout->atlas->texture) {
+        flush(renderer);
+    }
+    batchTexture_ = layout->atlas->texture;
+
+    const float fx = static_cast<float>(x);
+    const float fy = static_cast<float>(y);
+    for (size_t q = 0; q < layout->vertices.size(); q += 4) {
+        const int base = static_cast<int>(batchVertices_.size());
+        for (size_t v = q; v < q + 4; ++v) {
+            SDL_Vertex vertex = layout->vertices[v];
+            vertex.position.x += fx;
+            vertex.position.y += fy;
+            vertex.color = color;
+            batchVertices_.push_back(vertex);
+        }
+        const int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+        batchIndices_.insert(batchIndices_.end(), quad, quad + 6);
+    }
+}
+
+void OsdText::flush(SDL_Renderer* renderer) {
+    if (batchTexture_ && !batchIndices_.empty()) {
+        if (SDL_RenderGeometry(renderer, batchTexture_, batchVertices_.data(), static_cast<int>(batchVertices_.size()),
+                               batchIndices_.data(), static_cast<int>(batchIndices_.size())) != 0) {
+            TX_LOG_WARN("OSD", "SDL_RenderGeometry failed: " << SDL_GetError());
+        }
+    }
+    batchTexture_ = nullptr;
+    batchVertices_.clear();
+    batchIndices_.clear();
+}
+
+// --- Benchmark ---
+
+namespace {
+
+// The three OSD strings drawn the way renderOSD did before the atlas
+void drawLegacyString(SDL_Renderer* renderer, TTF_Font* font, const char* text, int x, int y) {
+    SDL_Color textColor = {255, 255, 255, 255};
+    SDL_Surface* surface = TTF_RenderText_Blended(font, text, textColor);
+    if (!surface) return;
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture) {
+        SDL_Rect rect = {x, y, surface->w, surface->h};
+        SDL_RenderCopy(renderer, texture, NULL, &rect);
+        SDL_DestroyTexture(texture);
+    }
+    SDL_FreeSurface(surface);
+}
+
+void benchTimecode(int frame, char* buffer, size_t size) {
+    snprintf(buffer, size, "00:%02d:%02d:%02d", (frame / 1500) % 60, (frame / 25) % 60, frame % 25);
+}
+
+} // namespace
+
+int OsdText::runBenchmark(const unsigned char* fontData, size_t fontSize) {
+    const int frames = 600;
+    const int width = 1280;
+    const int height = 720;
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0 || TTF_Init() != 0) {
+        std::cerr << "[OSDBench] SDL init failed: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    SDL_Window* window = SDL_CreateWindow("OSD benchmark", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                          width, height, SDL_WINDOW_HIDDEN);
+    SDL_Renderer* renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED) : nullptr;
+    if (window && !renderer) renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    SDL_RWops* rw = SDL_RWFromConstMem(fontData, static_cast<int>(fontSize));
+    TTF_Font* font = rw ? TTF_OpenFontRW(rw, 1, 16) : nullptr;
+    if (!renderer || !font) {
+        std::cerr << "[OSDBench] Setup failed: " << SDL_GetError() << std::endl;
+        if (font) TTF_CloseFont(font);
+        if (renderer) SDL_DestroyRenderer(renderer);
+        if (window) SDL_DestroyWindow(window);
+        TTF_Quit();
+        SDL_Quit();
+        return 1;
+    }
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(renderer, &info);
+
+    const int textY = height - 30 + 7;
+    char timecode[32];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        SDL_RenderClear(renderer);
+        benchTimecode(f, timecode, sizeof(timecode));
+        drawLegacyString(renderer, font, "SHUTTLE", 10, textY);
+        drawLegacyString(renderer, font, timecode, width / 2 - 50, textY);
+        drawLegacyString(renderer, font, "FWD 4.00x", width - 90, textY);
+        SDL_RenderFlush(renderer);
+    }
+    double legacyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    const SDL_Color white = {255, 255, 255, 255};
+    double atlasMs;
+    {
+        OsdText text;
+        start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; ++f) {
+            SDL_RenderClear(renderer);
+            benchTimecode(f, timecode, sizeof(timecode));
+            text.draw(renderer, font, "SHUTTLE", 10, textY, white);
+            text.draw(renderer, font, timecode, width / 2 - 50, textY, white);
+            text.draw(renderer, font, "FWD 4.00x", width - 90, textY, white);
+            text.flush(renderer);
+            SDL_RenderFlush(renderer);
+        }
+        atlasMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    }
+
+    std::cout << "[OSDBench] renderer " << info.name << ", " << frames << " frames, 3 strings per frame" << std::endl;
+    std::cout << std::fixed << std::setprecision(3)
+              << "[OSDBench] per-frame TTF textures: " << legacyMs << " ms/frame" << std::endl
+              << "[OSDBench] glyph atlas:            " << atlasMs << " ms/frame (atlas build included)" << std::endl;
+
+    TTF_CloseFont(font);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    TTF_Quit();
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Text renderer for the OSD bar.
+//
+// Printable ASCII glyphs of a font are rendered once into a single atlas
+// texture (one atlas per font, i.e. per point size). Strings are laid out into
+// quads against the atlas and kept in a small cache keyed by content, so the
+// static labels cost nothing after the first frame and a changing timecode only
+// re-runs the layout. draw() queues quads; flush() draws everything queued with
+// one SDL_RenderGeometry call. No surfaces or textures are created per frame.
+class OsdText {
+public:
+    OsdText() = default;
+    ~OsdText();
+
+    OsdText(const OsdText&) = delete;
+    OsdText& operator=(const OsdText&) = delete;
+
+    // Queues `text` with its top-left corner at (x, y)
+    void draw(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, int x, int y, SDL_Color color);
+    // Size of `text` as draw() lays it out; false if the atlas is unavailable
+    bool measure(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, int& width, int& height);
+    // Draws the queued quads
+    void flush(SDL_Renderer* renderer);
+
+    // Frees atlases and cached layouts (renderer or font going away)
+    void reset();
+
+    // OSD ms/frame with per-frame TTF surfaces/textures vs. the atlas
+    static int runBenchmark(const unsigned char* fontData, size_t fontSize);
+
+private:
+    static constexpr int kFirstGlyph = 32;
+    static constexpr int kLastGlyph = 126;
+    static constexpr int kGlyphCount = kLastGlyph - kFirstGlyph + 1;
+    static constexpr int kAtlasWidth = 512;
+    static constexpr size_t kLayoutCacheSize = 32;
+
+    struct Glyph {
+        SDL_Rect src{0, 0, 0, 0}; // Rect in the atlas, w == 0 if the font has no such glyph
+        int advance = 0;
+    };
+
+    struct Atlas {
+        SDL_Renderer* renderer = nullptr;
+        TTF_Font* font = nullptr;
+        SDL_Texture* texture = nullptr;
+        int width = 0;
+        int height = 0;
+        int lineHeight = 0;
+        Glyph glyphs[kGlyphCount];
+    };
+
+    // Quads of one string relative to its origin, colour applied when queued
+    struct Layout {
+        const Atlas* atlas = nullptr;
+        std::string text;
+        std::vector<SDL_Vertex> vertices; // 4 per glyph
+        int width = 0;
+        int height = 0;
+        uint64_t lastUse = 0;
+    };
+
+    Atlas* atlasFor(SDL_Renderer* renderer, TTF_Font* font);
+    bool buildAtlas(Atlas& atlas);
+    const Layout* layoutFor(SDL_Renderer* renderer, TTF_Font* font, const std::string& text);
+
+    std::vector<Atlas*> atlases_;
+    std::vector<Layout> layouts_;
+    uint64_t useCounter_ = 0;
+
+    // Pending batch
+    SDL_Texture* batchTexture_ = nullptr;
+    std::vector<SDL_Vertex> batchVertices_;
+    std::vector<int> batchIndices_;
+};
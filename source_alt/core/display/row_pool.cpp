@@ -0,0 +1,87 @@
+#include "row_pool.h"
+#include <algorithm>
+
+RowWorkerPool::RowWorkerPool(int workers)
+    : workerTarget_(std::max(0, workers)) {
+}
+
+RowWorkerPool::~RowWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+int RowWorkerPool::defaultWorkerCount() {
+    // A few helpers are enough: decoders already keep most cores busy
+    int hw = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(0, std::min(3, hw / 2 - 1));
+}
+
+void RowWorkerPool::startWorkers() {
+    threads_.reserve(workerTarget_);
+    for (int i = 0; i < workerTarget_; ++i) {
+        threads_.emplace_back(&RowWorkerPool::workerLoop, this);
+    }
+}
+
+void RowWorkerPool::runTiles() {
+    for (;;) {
+        int tile = nextTile_.fetch_add(1);
+        int begin = tile * tileRows_;
+        if (begin >= rows_) break;
+        (*job_)(begin, std::min(rows_, begin + tileRows_));
+    }
+}
+
+void RowWorkerPool::parallelFor(int rows, int tileRows, const std::function<void(int, int)>& fn) {
+    if (rows <= 0) return;
+    tileRows = std::max(1, tileRows);
+    if (workerTarget_ == 0 || rows <= tileRows) {
+        fn(0, rows);
+        return;
+    }
+    if (threads_.empty()) {
+        startWorkers();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        rows_ = rows;
+        tileRows_ = tileRows;
+        nextTile_ = 0;
+        busyWorkers_ = static_cast<int>(threads_.size());
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    runTiles();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busyWorkers_ == 0; });
+    job_ = nullptr;
+}
+
+void RowWorkerPool::workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+        }
+
+        runTiles();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--busyWorkers_ == 0) done_.notify_one();
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+// Small persistent pool for row-parallel image kernels on the render thread.
+// Workers are started on first use and sleep between jobs; the calling thread
+// takes tiles as well, so a pool of N workers runs N + 1 tiles at a time.
+class RowWorkerPool {
+public:
+    explicit RowWorkerPool(int workers = defaultWorkerCount());
+    ~RowWorkerPool();
+
+    RowWorkerPool(const RowWorkerPool&) = delete;
+    RowWorkerPool& operator=(const RowWorkerPool&) = delete;
+
+    // Runs fn(begin, end) over [0, rows) in tiles of tileRows and returns once
+    // every tile is done. Tiles never overlap; keep tileRows even when a 4:2:0
+    // chroma row must stay with its luma pair.
+    void parallelFor(int rows, int tileRows, const std::function<void(int, int)>& fn);
+
+    int workerCount() const { return workerTarget_; }
+    static int defaultWorkerCount();
+
+private:
+    void startWorkers();
+    void workerLoop();
+    void runTiles();
+
+    int workerTarget_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    // Current job, valid while busyWorkers_ > 0 or the caller is inside parallelFor
+    const std::function<void(int, int)>* job_ = nullptr;
+    int rows_ = 0;
+    int tileRows_ = 1;
+    std::atomic<int> nextTile_{0};
+    int busyWorkers_ = 0;
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+};
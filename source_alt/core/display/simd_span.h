@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Minimal portable SIMD layer for the display effects.
+//
+// Built on the GCC/Clang vector extensions, which lower to NEON on arm64 and
+// SSE2 on x86_64 without any intrinsics headers. Other compilers fall back to
+// the scalar loops, which produce the same bytes. Only covers what the tape
+// effect needs: scaling spans of 8-bit samples and pattern fills.
+namespace simd {
+
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+#define TAPEX_SIMD_VECTOR 1
+typedef uint8_t u8x16 __attribute__((vector_size(16)));
+typedef uint32_t u32x16 __attribute__((vector_size(64)));
+#endif
+
+// p[i] = (p[i] * mulQ16) >> 16 for n bytes. With mulQ16 = 55706 this is
+// bit-exact with truncating p[i] * 0.85 in float or double.
+inline void scaleQ16(uint8_t* p, int n, uint32_t mulQ16) {
+    int i = 0;
+#ifdef TAPEX_SIMD_VECTOR
+    for (; i + 16 <= n; i += 16) {
+        u8x16 v;
+        memcpy(&v, p + i, 16);
+        u32x16 w = __builtin_convertvector(v, u32x16);
+        w = (w * mulQ16) >> 16;
+        v = __builtin_convertvector(w, u8x16);
+        memcpy(p + i, &v, 16);
+    }
+#endif
+    for (; i < n; ++i) {
+        p[i] = static_cast<uint8_t>((p[i] * mulQ16) >> 16);
+    }
+}
+
+// Packed 4:2:2 (UYVY) row of n bytes: scale the odd (luma) bytes like
+// scaleQ16 and set the even (chroma) bytes to chromaValue.
+inline void scaleOddSetEvenQ16(uint8_t* p, int n, uint32_t mulQ16, uint8_t chromaValue) {
+    int i = 0;
+#ifdef TAPEX_SIMD_VECTOR
+    const u8x16 oddMask = {0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF};
+    const u8x16 chroma = (u8x16){} + chromaValue;
+    for (; i + 16 <= n; i += 16) {
+        u8x16 v;
+        memcpy(&v, p + i, 16);
+        u32x16 w = __builtin_convertvector(v, u32x16);
+        w = (w * mulQ16) >> 16;
+        u8x16 scaled = __builtin_convertvector(w, u8x16);
+        v = (scaled & oddMask) | (chroma & ~oddMask);
+        memcpy(p + i, &v, 16);
+    }
+#endif
+    for (; i + 1 < n; i += 2) {
+        p[i] = chromaValue;
+        p[i + 1] = static_cast<uint8_t>((p[i + 1] * mulQ16) >> 16);
+    }
+}
+
+// Repeats a 4-byte pattern (e.g. one UYVY pixel pair) count times
+inline void fill32(uint8_t* p, int count, const uint8_t pattern[4]) {
+    uint32_t word;
+    memcpy(&word, pattern, 4);
+    int i = 0;
+#ifdef TAPEX_SIMD_VECTOR
+    typedef uint32_t u32x4 __attribute__((vector_size(16)));
+    const u32x4 words = (u32x4){} + word;
+    for (; i + 4 <= count; i += 4) {
+        memcpy(p + i * 4, &words, 16);
+    }
+#endif
+    for (; i < count; ++i) {
+        memcpy(p + i * 4, &word, 4);
+    }
+}
+
+} // namespace simd
@@ -0,0 +1,553 @@
+#include "tape_effect.h"
+#include "simd_span.h"
+#include "../trace/perf_trace.h"
+#include "../trace/metrics.h"
+#include "../log/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+
+namespace {
+
+// 0.85 in Q16; (v * 55706) >> 16 matches static_cast<uint8_t>(v * 0.85) for every 8-bit v
+constexpr uint32_t kDarkenQ16 = 55706;
+// Rows per tile; even so a 4:2:0 chroma row is handled with its luma pair
+constexpr int kTileRows = 32;
+constexpr size_t kTableCacheSize = 8;
+// Random layouts kept per table; one is picked per frame
+constexpr int kVariantsPerTable = 4;
+constexpr int kSnowRingSize = 1024;
+
+bool isPlanar(TapeLayout layout) {
+    return layout == TapeLayout::I420 || layout == TapeLayout::NV12;
+}
+
+} // namespace
+
+double TapeRng::normal() {
+    double u1 = (next() + 1.0) * (1.0 / 4294967297.0); // (0, 1]
+    double u2 = unit();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+TapeEffect::TapeEffect(uint64_t seed) : rng_(seed) {
+}
+
+uint64_t TapeEffect::seedFromEnvironment() {
+    const char* env = std::getenv("TAPEXPLAYER_EFFECT_SEED");
+    if (env && *env) {
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(env, &end, 0);
+        if (end && *end == '\0') {
+            TX_LOG_INFO("TapeEffect", "Using effect seed " << value);
+            return static_cast<uint64_t>(value);
+        }
+        TX_LOG_WARN("TapeEffect", "Ignoring invalid TAPEXPLAYER_EFFECT_SEED: " << env);
+    }
+    return kDefaultSeed;
+}
+
+void TapeEffect::ensureSnowTail(int length) {
+    for (int k = static_cast<int>(snowTail_.size()); k < length; ++k) {
+        double fadeFactor = std::exp(-0.15 * k);
+        snowTail_.push_back(static_cast<uint8_t>(128 + static_cast<int>(107 * fadeFactor)));
+    }
+}
+
+TapeEffect::SpeedTable& TapeEffect::tableFor(int bucket, int width, int height) {
+    ++useCounter_;
+    for (auto& table : tables_) {
+        if (table->bucket == bucket && table->width == width && table->height == height) {
+            table->lastUse = useCounter_;
+            return *table;
+        }
+    }
+
+    if (tables_.size() < kTableCacheSize) {
+        tables_.push_back(std::make_unique<SpeedTable>());
+    } else {
+        auto lru = std::min_element(tables_.begin(), tables_.end(), [](const auto& a, const auto& b) {
+            return a->lastUse < b->lastUse;
+        });
+        std::iter_swap(lru, tables_.end() - 1);
+        *tables_.back() = SpeedTable();
+    }
+    SpeedTable& slot = *tables_.back();
+    slot.bucket = bucket;
+    slot.width = width;
+    slot.height = height;
+    slot.lastUse = useCounter_;
+    buildTable(slot);
+    return slot;
+}
+
+void TapeEffect::buildTable(SpeedTable& table) {
+    const double absPlaybackRate = static_cast<double>(table.bucket) / kBucketsPerX;
+    const int textureHeight = table.height;
+
+    // Calculate stripe parameters
+    const double resolutionScale = static_cast<double>(textureHeight) / 1080.0;
+    const int maxStripeHeight = static_cast<int>(720 * resolutionScale);
+    const int baseStripeHeight = static_cast<int>(85 * resolutionScale);
+    const int baseStripeSpacing = static_cast<int>(450 * resolutionScale);
+    const int minStripeSpacing = static_cast<int>(62 * resolutionScale);
+    int currentMinStripeHeight = (absPlaybackRate >= 16.0) ? 1 : static_cast<int>(14 * resolutionScale); // Set min height to 1 for >= 16x
+    const int midStripeHeight = static_cast<int>(50 * resolutionScale);
+    int stripeHeight, stripeSpacing;
+    if ((absPlaybackRate >= 0.2 && absPlaybackRate < 0.9) || (absPlaybackRate >= 1.1 && absPlaybackRate < 2.0)) {
+        double t = (absPlaybackRate < 0.9) ? (absPlaybackRate - 0.2) / 0.7 : (absPlaybackRate - 1.2) / 0.8;
+        t = t * t * (3 - 2 * t); stripeHeight = static_cast<int>(maxStripeHeight * (1 - t) + midStripeHeight * t); stripeSpacing = baseStripeSpacing;
+    } else if (absPlaybackRate >= 2.0 && absPlaybackRate < 3.7) {
+        // Smooth transition zone for 2.0x to 3.7x (Betacam fix)
+        double t = (absPlaybackRate - 2.0) / 1.7; // 0 to 1 over 2.0-3.7 range
+        stripeHeight = static_cast<int>(baseStripeHeight * (1.0 - t * 0.3)); // Gradual height reduction
+        stripeSpacing = static_cast<int>(baseStripeSpacing * (1.0 - t * 0.2)); // Gradual spacing reduction
+    } else if (absPlaybackRate >= 3.7 && absPlaybackRate < 14.0) {
+        double t = (absPlaybackRate - 3.7) / 10.3; t = std::pow(t, 0.7); // Adjusted range
+        stripeHeight = static_cast<int>(baseStripeHeight * 0.7 * (1.0 - t) + currentMinStripeHeight * t);
+        stripeSpacing = static_cast<int>(baseStripeSpacing * 0.8 * (1.0 - t) + minStripeSpacing * t);
+    } else { // Covers >= 14.0x
+        stripeHeight = currentMinStripeHeight;
+        stripeSpacing = minStripeSpacing;
+        // Very low min height for 20x+ specifically
+        if (absPlaybackRate >= 20.0) {
+            currentMinStripeHeight = static_cast<int>(12.0 * resolutionScale);
+            stripeHeight = currentMinStripeHeight;
+        }
+    }
+
+    // Scroll period; the per-frame phase is fmod(currentTime, cycleDuration)
+    const double baseDuration = 1.5;
+    const double minCycleDuration = 0.05; // 50ms minimum cycle time
+    if (absPlaybackRate >= 12.0) {
+        table.cycleDuration = std::max(minCycleDuration, (baseDuration / absPlaybackRate) * 3.0);
+    } else if (absPlaybackRate >= 3.7) { // 3.7x up to 12.0x (aligned with stripe ranges)
+        double normalizedSpeed = (absPlaybackRate - 3.7) / 8.3;
+        double speedMultiplier = 0.08 + (std::pow(normalizedSpeed, 3) * 0.15);
+        if (absPlaybackRate < 8.0) speedMultiplier *= 0.7;
+        table.cycleDuration = std::max(minCycleDuration, baseDuration / (absPlaybackRate * speedMultiplier));
+    } else { // Effect threshold up to 3.7x
+        double speedFactor = std::min(absPlaybackRate / 2.0, 2.0) * 0.5;
+        double adjustedDuration = baseDuration / speedFactor;
+        table.cycleDuration = adjustedDuration > 0 ? adjustedDuration : 1.0;
+    }
+
+    // --- Base spacing for the current speed range ---
+    int baseSpacingForSpeed;
+    const double spacingAt12x = 100.0 * resolutionScale;
+    const double spacingAt24x = 18.0 * resolutionScale;
+
+    if (absPlaybackRate >= 2.0 && absPlaybackRate < 3.5) {
+        // Sparse stripes around 3x
+        baseSpacingForSpeed = stripeSpacing + static_cast<int>((10.0 + 76.0) * resolutionScale);
+    } else if (absPlaybackRate >= 8.0 && absPlaybackRate < 12.0) {
+        baseSpacingForSpeed = static_cast<int>(spacingAt12x);
+    } else if (absPlaybackRate >= 12.0) { // Interpolate from 12x up to 24x, then hold
+        double t = std::min(1.0, (absPlaybackRate - 12.0) / (24.0 - 12.0));
+        baseSpacingForSpeed = static_cast<int>(spacingAt12x * (1.0 - t) + spacingAt24x * t);
+    } else {
+        baseSpacingForSpeed = stripeSpacing;
+    }
+
+    const double spacingVariationFactor = 0.001;
+    const int minAllowedSpacing = std::max(1, minStripeSpacing / 4);
+
+    // The pattern scrolls by one unit per cycle, so the strip is one unit taller than the frame
+    table.unit = std::max(1, baseStripeHeight + baseSpacingForSpeed);
+    const int stripRows = textureHeight + table.unit;
+
+    const bool darkenZones = absPlaybackRate >= 2.0 && absPlaybackRate < 10.0;
+    const bool outline = absPlaybackRate >= 8.0;
+    uint8_t outlineY = 0;
+    if (outline) {
+        const double outlineStartSpeed = 8.0;
+        const double outlineFullSpeed = 14.0;
+        double t = std::max(0.0, std::min(1.0, (absPlaybackRate - outlineStartSpeed) / (outlineFullSpeed - outlineStartSpeed)));
+        outlineY = 16 + static_cast<uint8_t>((128 - 16) * (1.0 - t));
+    }
+
+    table.variants.resize(kVariantsPerTable);
+    for (Variant& variant : table.variants) {
+        variant.fill.assign(stripRows, -1);
+        variant.darken.assign(stripRows, 0);
+        variant.runStart.clear();
+        variant.stripeStart.clear();
+        variant.stripeEnd.clear();
+
+        int currentY = 0;
+        while (currentY < stripRows) {
+            int finalStripeHeight;
+            if (absPlaybackRate >= 16.0) {
+                finalStripeHeight = 1 + rng_.below(3); // 1..3 px
+            } else {
+                double heightVariation = ((rng_.below(3) - 1) * resolutionScale);
+                finalStripeHeight = std::max(static_cast<int>(stripeHeight + heightVariation), currentMinStripeHeight);
+            }
+            finalStripeHeight = std::max(1, finalStripeHeight);
+
+            int currentStripeSpacing;
+            if (absPlaybackRate >= 16.0) {
+                int randomOffset = rng_.below(5) - 2; // -2..2
+                currentStripeSpacing = std::max(1, baseSpacingForSpeed + randomOffset);
+            } else {
+                int randomSpacingOffset = static_cast<int>(baseSpacingForSpeed * spacingVariationFactor * 2.0 * (rng_.unit() - 0.5));
+                currentStripeSpacing = std::max(minAllowedSpacing, baseSpacingForSpeed + randomSpacingOffset);
+            }
+
+            variant.stripeStart.push_back(currentY);
+            variant.stripeEnd.push_back(std::min(stripRows, currentY + finalStripeHeight));
+            currentY += finalStripeHeight + currentStripeSpacing;
+
+            if (static_cast<int>(variant.stripeStart.size()) > stripRows) { // Unlikely, but safe
+                TX_LOG_WARN("TapeEffect", "Excessive stripe calculation, breaking loop");
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < variant.stripeStart.size(); ++i) {
+            const int startY = variant.stripeStart[i];
+            const int endY = variant.stripeEnd[i];
+            const int height = endY - startY;
+
+            // B&W zone under the stripe (2x-10x); overlapping zones darken twice
+            if (darkenZones) {
+                int bwZoneHeight = static_cast<int>(height * 1.75);
+                int y_bw = startY - (bwZoneHeight - height) / 2;
+                for (int y = std::max(0, y_bw); y < std::min(stripRows, y_bw + bwZoneHeight); ++y) {
+                    ++variant.darken[y];
+                }
+            }
+            for (int y = startY; y < endY; ++y) variant.fill[y] = 128;
+            if (outline && endY < stripRows) variant.fill[endY] = outlineY;
+        }
+
+        // Scanline duplication (>= 16x): each clear run repeats its first row
+        if (absPlaybackRate >= 16.0) {
+            variant.runStart.assign(stripRows, -1);
+            int runStart = -1;
+            for (int y = 0; y < stripRows; ++y) {
+                if (variant.fill[y] >= 0) { runStart = -1; continue; }
+                if (runStart < 0) runStart = y;
+                variant.runStart[y] = runStart;
+            }
+        }
+    }
+
+    table.chromaBlank = absPlaybackRate >= 10.0;
+    table.snowCount = 0;
+    table.snowRing.clear();
+    if (absPlaybackRate >= 4.0) {
+        table.snowCount = std::max(8, table.width / 80);
+        if (absPlaybackRate > 10.0) table.snowCount = static_cast<int>(table.snowCount * 1.5);
+        const int snowTailBoost = static_cast<int>(std::sqrt(absPlaybackRate) * 5.0);
+        table.snowRing.resize(kSnowRingSize);
+        for (Flake& flake : table.snowRing) {
+            flake.x = rng_.below(table.width);
+            flake.tail = 10 + rng_.below(20) + snowTailBoost;
+            ensureSnowTail(flake.tail);
+        }
+    }
+}
+
+void TapeEffect::runEffectRows(const TapeFrame& frame, const FramePick& pick, int begin, int end) const {
+    const int width = frame.width;
+    const int height = frame.height;
+    const bool packed422 = frame.layout == TapeLayout::UYVY;
+    const Variant& variant = *pick.variant;
+    const int shift = pick.shift;
+
+    for (int y = begin; y < end; ++y) {
+        uint8_t* row = frame.data[0] + y * frame.pitch[0];
+        const int v = y + shift;
+
+        if (variant.fill[v] >= 0) {
+            uint8_t value = static_cast<uint8_t>(variant.fill[v]);
+            if (packed422) {
+                const uint8_t pair[4] = {128, value, 128, value};
+                simd::fill32(row, width / 2, pair);
+            } else {
+                memset(row, value, width);
+            }
+        } else {
+            for (int pass = 0; pass < variant.darken[v]; ++pass) {
+                if (packed422) {
+                    // The packed path always darkened each zone twice
+                    simd::scaleOddSetEvenQ16(row, width * 2, kDarkenQ16, 128);
+                    simd::scaleOddSetEvenQ16(row, width * 2, kDarkenQ16, 128);
+                } else {
+                    simd::scaleQ16(row, width, kDarkenQ16);
+                }
+            }
+        }
+
+        if (y % 2 == 0 && y / 2 < height / 2 && isPlanar(frame.layout)) {
+            auto touched = [&](int vy) { return variant.fill[vy] >= 0 || variant.darken[vy] > 0; };
+            if (pick.table->chromaBlank || touched(v) || touched(v + 1)) {
+                int c = y / 2;
+                if (frame.layout == TapeLayout::I420) {
+                    memset(frame.data[1] + c * frame.pitch[1], 128, width / 2);
+                    memset(frame.data[2] + c * frame.pitch[2], 128, width / 2);
+                } else {
+                    memset(frame.data[1] + c * frame.pitch[1], 128, (width / 2) * 2);
+                }
+            }
+        }
+    }
+
+    // Snow on the first visible row of each stripe (>= 4x)
+    const SpeedTable& table = *pick.table;
+    if (table.snowCount == 0) return;
+    const int ringSize = static_cast<int>(table.snowRing.size());
+    for (size_t s = std::lower_bound(snowRowY_.begin(), snowRowY_.end(), begin) - snowRowY_.begin();
+         s < snowRowY_.size() && snowRowY_[s] < end; ++s) {
+        uint8_t* row = frame.data[0] + snowRowY_[s] * frame.pitch[0];
+        int ringIndex = (pick.snowBase + snowStripe_[s] * table.snowCount) % ringSize;
+        for (int j = 0; j < table.snowCount; ++j, ringIndex = (ringIndex + 1) % ringSize) {
+            const Flake& f = table.snowRing[ringIndex];
+            int tailEnd = std::min(width, f.x + f.tail);
+            if (packed422) {
+                uint8_t* group = row + (f.x / 2) * 4;
+                group[0] = 128;
+                group[2] = 128;
+                if (f.x % 2 == 0) {
+                    group[1] = 235;
+                } else {
+                    group[1] = 128; // Head on Y1 also greys its pair's Y0
+                    group[3] = 235;
+                }
+                for (int x = f.x + 1; x < tailEnd; ++x) {
+                    uint8_t* g = row + (x / 2) * 4;
+                    g[0] = 128;
+                    g[1 + (x % 2) * 2] = snowTail_[x - f.x];
+                    g[2] = 128;
+                }
+            } else {
+                row[f.x] = 235;
+                for (int x = f.x + 1; x < tailEnd; ++x) {
+                    row[x] = snowTail_[x - f.x];
+                }
+            }
+        }
+    }
+}
+
+void TapeEffect::runCopyRows(const TapeFrame& frame, const FramePick& pick, int begin, int end) const {
+    const int width = frame.width;
+    const int height = frame.height;
+    const int rowBytes = frame.layout == TapeLayout::UYVY ? width * 2 : width;
+    const Variant& variant = *pick.variant;
+    const int shift = pick.shift;
+
+    // A run cut by the top edge repeats row 0. Sources start a run and are never
+    // destinations, so tiles only read them.
+    auto sourceOf = [&](int y) {
+        int start = variant.runStart[y + shift];
+        return start < 0 ? -1 : std::max(0, start - shift);
+    };
+
+    for (int y = begin; y < end; ++y) {
+        int src = sourceOf(y);
+        if (src >= 0 && src != y) {
+            memcpy(frame.data[0] + y * frame.pitch[0], frame.data[0] + src * frame.pitch[0], rowBytes);
+        }
+
+        if (y % 2 != 0 || y / 2 >= height / 2 || !isPlanar(frame.layout)) continue;
+        // Chroma row c follows whichever of its two luma rows is a copy from another chroma row
+        int c = y / 2;
+        int srcC = -1;
+        for (int d = y; d <= y + 1 && d < height; ++d) {
+            int s = sourceOf(d);
+            if (s >= 0 && s != d && s / 2 != c) srcC = s / 2;
+        }
+        if (srcC < 0) continue;
+        if (frame.layout == TapeLayout::I420) {
+            memcpy(frame.data[1] + c * frame.pitch[1], frame.data[1] + srcC * frame.pitch[1], width / 2);
+            memcpy(frame.data[2] + c * frame.pitch[2], frame.data[2] + srcC * frame.pitch[2], width / 2);
+        } else {
+            memcpy(frame.data[1] + c * frame.pitch[1], frame.data[1] + srcC * frame.pitch[1], width);
+        }
+    }
+}
+
+void TapeEffect::apply(const TapeFrame& frame, double absRate, double currentTime) {
+    if (!frame.data[0] || frame.pitch[0] <= 0 || frame.width <= 0 || frame.height <= 0) return;
+    if (frame.layout == TapeLayout::I420 && (!frame.data[1] || !frame.data[2])) return;
+    if (frame.layout == TapeLayout::NV12 && !frame.data[1]) return;
+    PERF_SPAN("effect.tape");
+    ScopedLatency effectLatency(playerMetrics.effect);
+
+    const int bucket = std::max(1, static_cast<int>(std::lround(absRate * kBucketsPerX)));
+    const SpeedTable& table = tableFor(bucket, frame.width, frame.height);
+
+    // Per-frame part: scroll phase, layout variant and snow offset
+    FramePick pick;
+    pick.table = &table;
+    pick.variant = &table.variants[rng_.below(static_cast<int>(table.variants.size()))];
+    double cycleProgress = std::fmod(currentTime, table.cycleDuration) / table.cycleDuration;
+    pick.shift = table.unit - static_cast<int>(std::fmod(cycleProgress * table.unit, table.unit));
+    pick.snowBase = table.snowRing.empty() ? 0 : rng_.below(static_cast<int>(table.snowRing.size()));
+
+    snowRowY_.clear();
+    snowStripe_.clear();
+    if (table.snowCount > 0) {
+        const Variant& variant = *pick.variant;
+        for (size_t i = 0; i < variant.stripeStart.size(); ++i) {
+            int startY = variant.stripeStart[i] - pick.shift;
+            int endY = variant.stripeEnd[i] - pick.shift;
+            if (endY <= 0 || startY >= frame.height) continue;
+            snowRowY_.push_back(std::max(0, startY));
+            snowStripe_.push_back(static_cast<int>(i));
+        }
+    }
+
+    pool_.parallelFor(frame.height, kTileRows, [&](int begin, int end) {
+        runEffectRows(frame, pick, begin, end);
+    });
+    if (!pick.variant->runStart.empty()) {
+        pool_.parallelFor(frame.height, kTileRows, [&](int begin, int end) {
+            runCopyRows(frame, pick, begin, end);
+        });
+    }
+}
+
+void TapeEffect::applyEdgeFade(const TapeFrame& frame) {
+    const int leftEdgeFadeWidth = 3;
+    const int rightEdgeFadeWidth = 2;
+    const int textureWidth = frame.width;
+    const int pitch = frame.pitch[0];
+    if (!frame.data[0] || textureWidth <= (leftEdgeFadeWidth + rightEdgeFadeWidth) || pitch <= 0) return;
+
+    const bool packed422 = frame.layout == TapeLayout::UYVY;
+    // Byte offset of the luma sample for pixel x
+    auto lumaOffset = [packed422](int x) { return packed422 ? (x / 2) * 4 + 1 + (x % 2) * 2 : x; };
+
+    for (int y = 0; y < frame.height; ++y) {
+        uint8_t* rowStart = frame.data[0] + y * pitch;
+        for (int x = 0; x < leftEdgeFadeWidth; ++x) {
+            float fade = static_cast<float>(x) / (leftEdgeFadeWidth > 1 ? (leftEdgeFadeWidth - 1) : 1);
+            uint8_t& sample = rowStart[lumaOffset(x)];
+            sample = static_cast<uint8_t>(sample * fade + 16.0f * (1.0f - fade));
+        }
+        for (int x = 0; x < rightEdgeFadeWidth; ++x) {
+            float fade = static_cast<float>(x) / (rightEdgeFadeWidth > 1 ? (rightEdgeFadeWidth - 1) : 1);
+            uint8_t& sample = rowStart[lumaOffset(textureWidth - 1 - x)];
+            sample = static_cast<uint8_t>(sample * fade + 16.0f * (1.0f - fade));
+        }
+    }
+}
+
+// Benchmark frame: planes in one buffer, filled with a fixed ramp
+static TapeFrame makeBenchFrame(std::vector<uint8_t>& pixels, TapeLayout layout, int width, int height) {
+    const int lumaPitch = layout == TapeLayout::UYVY ? width * 2 : width;
+    pixels.assign(static_cast<size_t>(lumaPitch) * height * 2, 0);
+    for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = static_cast<uint8_t>(i * 7);
+    TapeFrame frame;
+    frame.layout = layout;
+    frame.width = width;
+    frame.height = height;
+    frame.data[0] = pixels.data();
+    frame.pitch[0] = lumaPitch;
+    if (layout == TapeLayout::I420) {
+        frame.data[1] = pixels.data() + static_cast<size_t>(lumaPitch) * height;
+        frame.data[2] = frame.data[1] + static_cast<size_t>(lumaPitch / 2) * (height / 2);
+        frame.pitch[1] = frame.pitch[2] = lumaPitch / 2;
+    }
+    return frame;
+}
+
+// Seeded reference run: a few frames per speed from kDefaultSeed, hashed (FNV-1a)
+// after every frame. A mismatch means the effect's output changed; update the
+// golden value only when that change is intended.
+bool TapeEffect::checkGolden() {
+    struct Golden { TapeLayout layout; uint64_t hash; };
+    const Golden goldens[] = {{TapeLayout::I420, 0xcc6fb77ee25ca542ULL}, {TapeLayout::UYVY, 0x69da8c4230f200f2ULL}};
+    const double rates[] = {1.5, 3.0, 6.0, 10.0, 16.0, 24.0};
+    const int framesPerRate = 4;
+
+    bool ok = true;
+    for (const Golden& golden : goldens) {
+        std::vector<uint8_t> pixels;
+        TapeFrame frame = makeBenchFrame(pixels, golden.layout, 720, 576);
+        TapeEffect effect;
+        uint64_t hash = 1469598103934665603ULL;
+        double currentTime = 10.0;
+        for (double rate : rates) {
+            for (int f = 0; f < framesPerRate; ++f) {
+                currentTime += 1.0 / 25.0;
+                effect.apply(frame, rate, currentTime);
+                effect.applyEdgeFade(frame);
+                for (uint8_t byte : pixels) hash = (hash ^ byte) * 1099511628211ULL;
+            }
+        }
+        const char* name = golden.layout == TapeLayout::I420 ? "I420" : "UYVY";
+        if (hash != golden.hash) {
+            TX_LOG_ERROR("TapeEffect", "Golden check failed for " << name << ": output hash 0x" << std::hex << hash
+                         << ", expected 0x" << golden.hash << std::dec);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int TapeEffect::runBenchmark() {
+    if (!checkGolden()) {
+        std::cout << "[EffectBench] Seeded output does not match the golden hash" << std::endl;
+        return 1;
+    }
+    std::cout << "[EffectBench] Seeded output matches the golden hash" << std::endl;
+
+    struct Size { int width; int height; const char* name; };
+    const Size sizes[] = {{720, 576, "576p"}, {1280, 720, "720p"}, {1920, 1080, "1080p"}, {3840, 2160, "2160p"}};
+    const double rates[] = {1.5, 3.0, 6.0, 10.0, 16.0, 24.0};
+    const TapeLayout layouts[] = {TapeLayout::I420, TapeLayout::UYVY};
+    const int frames = 120;
+
+    std::cout << "[EffectBench] " << RowWorkerPool::defaultWorkerCount() << " worker thread(s) + caller, "
+              << frames << " frames per cell, ms/frame (first frame incl. table build in brackets)" << std::endl;
+    for (TapeLayout layout : layouts) {
+        std::cout << std::endl << (layout == TapeLayout::I420 ? "I420" : "UYVY") << std::endl;
+        std::cout << std::left << std::setw(8) << "size" << std::right;
+        for (double rate : rates) {
+            std::ostringstream label;
+            label << rate << "x";
+            std::cout << std::setw(16) << label.str();
+        }
+        std::cout << std::endl;
+
+        for (const Size& size : sizes) {
+            std::vector<uint8_t> pixels;
+            TapeFrame frame = makeBenchFrame(pixels, layout, size.width, size.height);
+
+            std::cout << std::left << std::setw(8) << size.name << std::right;
+            for (double rate : rates) {
+                TapeEffect effect;
+                for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = static_cast<uint8_t>(i * 7);
+
+                double currentTime = 10.0;
+                auto start = std::chrono::steady_clock::now();
+                effect.apply(frame, rate, currentTime);
+                effect.applyEdgeFade(frame);
+                double firstMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                start = std::chrono::steady_clock::now();
+                for (int f = 0; f < frames; ++f) {
+                    currentTime += 1.0 / 25.0;
+                    effect.apply(frame, rate, currentTime);
+                    effect.applyEdgeFade(frame);
+                }
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+                std::ostringstream cell;
+                cell << std::fixed << std::setprecision(2) << ms << " [" << std::setprecision(1) << firstMs << "]";
+                std::cout << std::setw(16) << cell.str();
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
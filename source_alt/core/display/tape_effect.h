@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "row_pool.h"
+
+// Small fast PRNG (PCG32) for per-frame effect randomness. One long-lived
+// instance replaces the per-frame std::random_device/mt19937 construction and
+// the global rand() calls, and makes the effect reproducible for a given seed.
+class TapeRng {
+public:
+    explicit TapeRng(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        state_ = 0;
+        next();
+        state_ += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state_;
+        state_ = old * 6364136223846793005ULL + kIncrement;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    // Uniform in [0, n), n > 0
+    int below(int n) { return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint32_t>(n)) >> 32); }
+    // Uniform in [0, 1)
+    double unit() { return next() * (1.0 / 4294967296.0); }
+    // Standard normal (Box-Muller, one value per call)
+    double normal();
+
+private:
+    static constexpr uint64_t kIncrement = 1442695040888963407ULL;
+    uint64_t state_ = 0;
+};
+
+// Texture layouts the software path locks. LumaOnly covers packed formats the
+// effect has no chroma handling for (RGB24/BGR24): only the first width bytes
+// of each row are touched, as before.
+enum class TapeLayout { I420, NV12, UYVY, LumaOnly };
+
+// Plane pointers and pitches of a locked streaming texture
+struct TapeFrame {
+    TapeLayout layout = TapeLayout::I420;
+    uint8_t* data[3] = {nullptr, nullptr, nullptr};
+    int pitch[3] = {0, 0, 0};
+    int width = 0;
+    int height = 0;
+};
+
+// Betacam shuttle effect (stripes, B&W zones, outlines, snow, scanline
+// duplication) and the edge fade, applied in place to a locked texture.
+//
+// Everything that depends only on the speed and the frame size lives in a
+// per-speed-bucket table, built once and kept in a small cache: the stripe
+// layout over a strip one pattern unit taller than the frame (in a few random
+// variants), the darken/fill/duplication masks derived from it, a ring of snow
+// flakes and the scroll period. A frame then only picks a scroll phase, a
+// variant and a snow offset, and the row kernels read the table at the shifted
+// row. Rows run over even-aligned tiles on a small worker pool, so the output
+// depends only on the seed and the inputs, not on scheduling.
+class TapeEffect {
+public:
+    static constexpr uint64_t kDefaultSeed = 0x54415045ULL; // "TAPE"
+    // Speeds are bucketed to 1/kBucketsPerX of a step
+    static constexpr int kBucketsPerX = 8;
+
+    explicit TapeEffect(uint64_t seed = kDefaultSeed);
+
+    // TAPEXPLAYER_EFFECT_SEED if set, kDefaultSeed otherwise
+    static uint64_t seedFromEnvironment();
+
+    void reseed(uint64_t seed) { rng_.reseed(seed); }
+    TapeRng& rng() { return rng_; }
+
+    void apply(const TapeFrame& frame, double absRate, double currentTime);
+    void applyEdgeFade(const TapeFrame& frame);
+
+    // Seeded output against a stored hash, then effect ms/frame against
+    // resolution and speed, printed as a table. Non-zero if the hash differs.
+    static int runBenchmark();
+    static bool checkGolden();
+
+private:
+    struct Flake { int x; int tail; };
+
+    // Stripe layout for one speed bucket and frame size. Rows are "virtual":
+    // visible row y reads virtual row y + shift, shift in [1, unit].
+    struct Variant {
+        std::vector<int16_t> fill;     // Fill value per virtual row, -1 for none
+        std::vector<uint8_t> darken;   // Number of 0.85 passes per virtual row
+        std::vector<int> runStart;     // Start of the clear run for duplication, -1 if masked or off
+        std::vector<int> stripeStart;  // Virtual [start, end) of each stripe, ascending
+        std::vector<int> stripeEnd;
+    };
+
+    struct SpeedTable {
+        int bucket = 0;
+        int width = 0;
+        int height = 0;
+        double cycleDuration = 1.0; // Seconds per scroll cycle
+        int unit = 1;               // Rows scrolled per cycle
+        bool chromaBlank = false;   // >= 10x: all chroma neutral (planar layouts)
+        int snowCount = 0;          // Flakes per stripe, 0 below 4x
+        std::vector<Variant> variants;
+        std::vector<Flake> snowRing;
+        uint64_t lastUse = 0;
+    };
+
+    // What a frame reads from its table
+    struct FramePick {
+        const SpeedTable* table = nullptr;
+        const Variant* variant = nullptr;
+        int shift = 0;
+        int snowBase = 0;
+    };
+
+    SpeedTable& tableFor(int bucket, int width, int height);
+    void buildTable(SpeedTable& table);
+    void runEffectRows(const TapeFrame& frame, const FramePick& pick, int begin, int end) const;
+    void runCopyRows(const TapeFrame& frame, const FramePick& pick, int begin, int end) const;
+    void ensureSnowTail(int length);
+
+    TapeRng rng_;
+    RowWorkerPool pool_;
+
+    std::vector<std::unique_ptr<SpeedTable>> tables_; // Small LRU cache
+    uint64_t useCounter_ = 0;
+    std::vector<uint8_t> snowTail_;      // Tail brightness by distance from the flake head
+    // Per frame: visible first row of each stripe that shows, and that stripe's index
+    std::vector<int> snowRowY_;
+    std::vector<int> snowStripe_;
+};
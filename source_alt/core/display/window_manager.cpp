@@ -2,6 +2,7 @@
 #include "display.h"
 #include "../common/common.h"
 #include "../common/fontdata.h"
+#include "../trace/metrics.h"
 #include <iostream>
 #include <thread>
 
@@ -23,9 +24,7 @@ WindowManager::WindowManager()
     , windowedHeight_(720)
     , lastTextureWidth_(0)
     , lastTextureHeight_(0)
-    , frameStartTime_(0)
     , targetFPS_(60)
-    , targetFrameTime_(1000 / 60)
     , useAdaptiveDelay_(true)
     , lastEventCheck_(std::chrono::steady_clock::now())
     , consecutiveNoEvents_(0)
@@ -38,6 +37,12 @@ WindowManager::~WindowManager() {
 }
 
 bool WindowManager::initialize(const std::string& title, int x, int y, int width, int height, bool fullscreen) {
+    if (headless_) {
+        // Offscreen: the dummy driver needs no display server (an explicit SDL_VIDEODRIVER still wins)
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        fullscreen = false;
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "SDL initialization error: " << SDL_GetError() << std::endl;
@@ -80,6 +85,9 @@ bool WindowManager::initialize(const std::string& title, int x, int y, int width
 #ifdef __APPLE__
     windowFlags |= SDL_WINDOW_METAL;
 #endif
+    if (headless_) {
+        windowFlags = SDL_WINDOW_HIDDEN;
+    }
     
     if (fullscreen) {
         windowFlags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
@@ -98,19 +106,33 @@ bool WindowManager::initialize(const std::string& title, int x, int y, int width
     SDL_EventState(SDL_DROPFILE, SDL_ENABLE);
     
     // Create renderer
-    renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (!renderer_) {
-        std::cerr << "Renderer creation error with VSync: " << SDL_GetError() << std::endl;
-        // Try without VSync
-        renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED);
+    if (headless_) {
+        // Software renderer into the window's offscreen framebuffer
+        renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_SOFTWARE);
         if (!renderer_) {
-            std::cerr << "Renderer creation error: " << SDL_GetError() << std::endl;
+            std::cerr << "Headless renderer creation error: " << SDL_GetError() << std::endl;
             SDL_DestroyWindow(window_);
             TTF_CloseFont(font_);
             TTF_Quit();
             SDL_Quit();
             return false;
         }
+        std::cout << "[WindowManager] Headless: " << width << "x" << height << " offscreen, software renderer" << std::endl;
+    } else {
+        renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        if (!renderer_) {
+            std::cerr << "Renderer creation error with VSync: " << SDL_GetError() << std::endl;
+            // Try without VSync
+            renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED);
+            if (!renderer_) {
+                std::cerr << "Renderer creation error: " << SDL_GetError() << std::endl;
+                SDL_DestroyWindow(window_);
+                TTF_CloseFont(font_);
+                TTF_Quit();
+                SDL_Quit();
+                return false;
+            }
+        }
     }
     
 #ifdef __APPLE__
@@ -122,6 +144,12 @@ bool WindowManager::initialize(const std::string& title, int x, int y, int width
     metalRenderer_ = nullptr;
 #endif
     
+    // Pace against the display; presents block on vblank only if vsync was granted
+    SDL_RendererInfo rendererInfo;
+    bool vsync = SDL_GetRendererInfo(renderer_, &rendererInfo) == 0 && (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC);
+    pacer_.setDisplay(getRefreshRate(), vsync);
+    frameStateSummary.setPublishListener(&FramePacer::notifyFrameReady);
+    
     return true;
 }
 
@@ -205,6 +233,21 @@ void WindowManager::getWindowSize(int& width, int& height) const {
     }
 }
 
+double WindowManager::getRefreshRate() const {
+    SDL_DisplayMode mode;
+    if (window_ && SDL_GetWindowDisplayMode(window_, &mode) == 0 && mode.refresh_rate > 0) {
+        return mode.refresh_rate;
+    }
+    return 60.0;
+}
+
+void WindowManager::getOutputSize(int& width, int& height) const {
+    if (renderer_ && SDL_GetRendererOutputSize(renderer_, &width, &height) == 0) {
+        return;
+    }
+    getWindowSize(width, height);
+}
+
 bool WindowManager::hasInputFocus() const {
     if (!window_) return false;
     return (SDL_GetWindowFlags(window_) & SDL_WINDOW_INPUT_FOCUS) != 0;
@@ -216,7 +259,8 @@ void WindowManager::beginFrame() {
 
 void WindowManager::endFrame() {
     if (renderer_) {
-        SDL_RenderPresent(renderer_);
+        presentRenderer(renderer_);
+        pacer_.markPresented();
     }
 }
 
@@ -260,6 +304,8 @@ void WindowManager::displayFrame(
                    jog_forward, jog_backward, ringBufferCapacity,
                    highResWindowSize, segmentSize, targetDisplayAspectRatio);
     
+    pacer_.markPresented(); // displayFrame ends with the present
+
     // Update last texture dimensions
     lastTextureWidth_ = get_last_texture_width();
     lastTextureHeight_ = get_last_texture_height();
@@ -349,45 +395,24 @@ void WindowManager::enableDropFile() {
 // Frame timing methods
 void WindowManager::setTargetFPS(int fps) {
     targetFPS_ = fps;
-    targetFrameTime_ = (fps > 0) ? (1000 / fps) : 16; // Default to ~60 FPS if invalid
+    pacer_.setTargetFps(fps > 0 ? fps : 60); // Default to 60 FPS if invalid
 }
 
 void WindowManager::beginFrameTiming() {
-    frameStartTime_ = SDL_GetTicks();
+    pacer_.markFrameStart();
 }
 
 void WindowManager::endFrameTiming() {
     if (!useAdaptiveDelay_) return;
     
-    Uint32 frameTime = SDL_GetTicks() - frameStartTime_;
-    if (frameTime < targetFrameTime_) {
-        // Use a more responsive delay approach
-        Uint32 delayTime = targetFrameTime_ - frameTime;
-        
-        // For short delays, use busy wait for better precision
-        if (delayTime < 5) {
-            Uint32 targetTime = frameStartTime_ + targetFrameTime_;
-            while (SDL_GetTicks() < targetTime) {
-                // Busy wait for precision
-            }
-        } else {
-            // For longer delays, use SDL_Delay but wake up a bit early
-            // to avoid overshooting
-            SDL_Delay(delayTime - 1);
-            
-            // Then busy wait for the remaining time
-            Uint32 targetTime = frameStartTime_ + targetFrameTime_;
-            while (SDL_GetTicks() < targetTime) {
-                // Busy wait for precision
-            }
-        }
-    }
+    // Sleeps until the next deadline (or input) instead of spinning
+    pacer_.waitForNextFrame();
 }
 
 bool WindowManager::shouldSkipFrame() const {
     // Can be used to implement frame skipping if running behind
-    Uint32 currentTime = SDL_GetTicks();
-    return (currentTime - frameStartTime_) > (targetFrameTime_ * 2);
+    FramePacer::Stats stats = pacer_.stats();
+    return stats.frames > 0 && stats.maxMs > stats.targetMs * 2;
 }
 
 int WindowManager::processEvents(std::function<void(SDL_Event&)> eventHandler, int maxEvents) {
@@ -442,6 +467,7 @@ WindowManager::FrameSelection WindowManager::selectFrame(
     const int TRANSITION_THRESHOLD = 1; // Reduced threshold for faster type switching
     
     if (currentFrameIndex < 0 || currentFrameIndex >= frameIndex.size()) {
+        playerMetrics.recordSelection(PlayerMetrics::Selection::Miss, FrameInfo::EMPTY);
         return result; // frameFound = false
     }
     
@@ -450,9 +476,12 @@ WindowManager::FrameSelection WindowManager::selectFrame(
     
     // Skip if frame is currently being decoded
     if (currentFrameInfo.is_decoding) {
+        playerMetrics.recordSelection(PlayerMetrics::Selection::Busy, FrameInfo::EMPTY);
         return result; // frameFound = false
     }
     
+    bool nearbyFrame = false; // Served a neighbour of the target (high-speed fallback)
+    
     double currentPlaybackRate = std::abs(playbackRate);
     
     if (currentPlaybackRate <= 1.1) {
@@ -565,11 +594,13 @@ WindowManager::FrameSelection WindowManager::selectFrame(
                             result.frame = frameIndex[checkFrameIdx].low_res_frame;
                             result.frameType = FrameInfo::LOW_RES;
                             result.frameFound = true;
+                            nearbyFrame = true;
                             break;
                         } else if (frameIndex[checkFrameIdx].cached_frame) {
                             result.frame = frameIndex[checkFrameIdx].cached_frame;
                             result.frameType = FrameInfo::CACHED;
                             result.frameFound = true;
+                            nearbyFrame = true;
                             break;
                         }
                     }
@@ -588,6 +619,21 @@ WindowManager::FrameSelection WindowManager::selectFrame(
         frameTypeTransitionCounter_ = 0;
     }
     
+    PlayerMetrics::Selection outcome = PlayerMetrics::Selection::Miss;
+    if (result.frameFound) {
+        switch (result.frameType) {
+            case FrameInfo::FULL_RES: outcome = PlayerMetrics::Selection::FullRes; break;
+            case FrameInfo::LOW_RES:
+                outcome = nearbyFrame ? PlayerMetrics::Selection::NearbyLowRes : PlayerMetrics::Selection::LowRes;
+                break;
+            case FrameInfo::CACHED:
+                outcome = nearbyFrame ? PlayerMetrics::Selection::NearbyCached : PlayerMetrics::Selection::Cached;
+                break;
+            default: break;
+        }
+    }
+    playerMetrics.recordSelection(outcome, result.frameType);
+    
     return result;
 }
 
@@ -3,6 +3,7 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include "frame_pacer.h"
 #include <string>
 #include <memory>
 #include <atomic>
@@ -35,6 +36,8 @@ public:
     void toggleFullscreen();
     bool isFullscreen() const;
     void getWindowSize(int& width, int& height) const;
+    void getOutputSize(int& width, int& height) const; // Drawable size in pixels (HiDPI aware)
+    double getRefreshRate() const; // Of the display the window is on, 60 if unknown
     bool hasInputFocus() const;
     
     // Frame rendering
@@ -106,11 +109,17 @@ public:
     int getLastTextureWidth() const { return lastTextureWidth_; }
     int getLastTextureHeight() const { return lastTextureHeight_; }
     
+    // Headless mode: hidden window on the dummy video driver with a software
+    // renderer. Must be set before initialize().
+    void setHeadless(bool headless) { headless_ = headless; }
+    bool isHeadless() const { return headless_; }
+    
     // Frame timing helpers
     void setTargetFPS(int fps);
     void beginFrameTiming();
     void endFrameTiming();
     bool shouldSkipFrame() const;
+    FramePacer& framePacer() { return pacer_; }
     
     // Event processing helpers
     int processEvents(std::function<void(SDL_Event&)> eventHandler, int maxEvents = 10);
@@ -166,10 +175,11 @@ private:
     WindowManager(const WindowManager&) = delete;
     WindowManager& operator=(const WindowManager&) = delete;
     
+    bool headless_ = false;
+    
     // Frame timing
-    Uint32 frameStartTime_;
+    FramePacer pacer_;
     int targetFPS_;
-    Uint32 targetFrameTime_;
     bool useAdaptiveDelay_;
     
     // Event processing timing
@@ -0,0 +1,376 @@
+#include "logger.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+std::atomic<int> Logger::minLevel_{static_cast<int>(LogLevel::Info)};
+
+namespace {
+
+constexpr size_t kQueueCapacity = 8192; // Power of two
+constexpr size_t kQueueMask = kQueueCapacity - 1;
+
+struct LogRecord {
+    int64_t timeUs = 0; // System clock, for the timestamp
+    uint32_t thread = 0;
+    LogLevel level = LogLevel::Info;
+    const char* tag = "";
+    uint32_t suppressed = 0;
+    std::string message;
+};
+
+// Bounded multi-producer queue (Vyukov): each cell's sequence number says
+// whether it is free for the producer at that position or ready for the
+// consumer. Only the writer thread dequeues.
+class RecordQueue {
+public:
+    RecordQueue() : cells_(new Cell[kQueueCapacity]) {
+        for (size_t i = 0; i < kQueueCapacity; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(LogRecord&& record) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & kQueueMask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->record = std::move(record);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Writer thread only: true if pop() would return a record
+    bool hasPending() const {
+        const Cell& cell = cells_[dequeuePos_ & kQueueMask];
+        return cell.seq.load(std::memory_order_acquire) == dequeuePos_ + 1;
+    }
+
+    bool pop(LogRecord& record) {
+        Cell& cell = cells_[dequeuePos_ & kQueueMask];
+        if (cell.seq.load(std::memory_order_acquire) != dequeuePos_ + 1) return false;
+        record = std::move(cell.record);
+        cell.seq.store(dequeuePos_ + kQueueCapacity, std::memory_order_release);
+        ++dequeuePos_;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq{0};
+        LogRecord record;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) size_t dequeuePos_ = 0;
+};
+
+struct LoggerState {
+    RecordQueue queue;
+    Logger::Options options;
+    FILE* file = nullptr;
+    size_t fileBytes = 0;
+
+    std::thread writer;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> dropped{0};
+    uint64_t droppedReported = 0;
+
+    // Sleeps the writer and waits for flush(). Producers take it only to wake a
+    // writer that went to sleep on an empty queue, once per empty -> non-empty
+    // transition; while it is awake they just read sleeping.
+    std::mutex waitMutex;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping{false};
+    std::condition_variable drained;
+    std::atomic<uint64_t> pushed{0};
+    std::atomic<uint64_t> written{0};
+};
+
+LoggerState& state() {
+    static LoggerState* instance = new LoggerState(); // Never destroyed: threads may log during exit
+    return *instance;
+}
+
+std::atomic<uint32_t> nextThreadId{1};
+
+uint32_t currentThreadId() {
+    thread_local uint32_t id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void appendQuoted(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c; break;
+        }
+    }
+    out += '"';
+}
+
+// ts=2024-06-07T12:00:00.123456Z level=info thread=3 tag=FullResDecoder msg="..."
+void formatRecord(const LogRecord& record, std::string& line) {
+    time_t seconds = static_cast<time_t>(record.timeUs / 1000000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char stamp[48];
+    snprintf(stamp, sizeof(stamp), "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ",
+             utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec,
+             static_cast<int>(record.timeUs % 1000000));
+
+    line.clear();
+    line += "ts=";
+    line += stamp;
+    line += " level=";
+    line += Logger::levelName(record.level);
+    line += " thread=";
+    line += std::to_string(record.thread);
+    line += " tag=";
+    line += record.tag;
+    line += " msg=";
+    appendQuoted(line, record.message);
+    if (record.suppressed > 0) {
+        line += " suppressed=";
+        line += std::to_string(record.suppressed);
+    }
+    line += '\n';
+}
+
+void writeConsole(const LogRecord& record) {
+    if (record.level >= LogLevel::Warn) {
+        fprintf(stderr, "[%s] %s: %s", record.tag, Logger::levelName(record.level), record.message.c_str());
+    } else {
+        fprintf(stderr, "[%s] %s", record.tag, record.message.c_str());
+    }
+    if (record.suppressed > 0) fprintf(stderr, " (%u similar suppressed)", record.suppressed);
+    fputc('\n', stderr);
+}
+
+void rotate(LoggerState& s) {
+    if (s.file) fclose(s.file);
+    s.file = nullptr;
+    const std::string& path = s.options.path;
+    for (int i = s.options.maxRotatedFiles - 1; i >= 1; --i) {
+        std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+    }
+    if (s.options.maxRotatedFiles > 0) {
+        std::rename(path.c_str(), (path + ".1").c_str());
+    } else {
+        std::remove(path.c_str());
+    }
+    s.file = fopen(path.c_str(), "a");
+    s.fileBytes = 0;
+}
+
+void writeFile(LoggerState& s, const std::string& line) {
+    if (!s.file) return;
+    if (s.fileBytes + line.size() > s.options.maxFileBytes && s.fileBytes > 0) rotate(s);
+    if (!s.file) return;
+    fwrite(line.data(), 1, line.size(), s.file);
+    s.fileBytes += line.size();
+}
+
+void writerLoop() {
+    LoggerState& s = state();
+    LogRecord record;
+    std::string line;
+    for (;;) {
+        bool any = false;
+        while (s.queue.pop(record)) {
+            any = true;
+            formatRecord(record, line);
+            writeFile(s, line);
+            if (record.level >= s.options.consoleLevel) writeConsole(record);
+            s.written.fetch_add(1, std::memory_order_release);
+        }
+
+        uint64_t dropped = s.dropped.load(std::memory_order_relaxed);
+        if (dropped != s.droppedReported) {
+            LogRecord note;
+            note.timeUs = nowUs();
+            note.level = LogLevel::Warn;
+            note.tag = "Logger";
+            note.message = std::to_string(dropped - s.droppedReported) + " records dropped (queue full)";
+            s.droppedReported = dropped;
+            formatRecord(note, line);
+            writeFile(s, line);
+            any = true;
+        }
+
+        if (any) {
+            if (s.file) fflush(s.file);
+            std::lock_guard<std::mutex> lock(s.waitMutex);
+            s.drained.notify_all();
+            continue;
+        }
+        if (s.stopping.load()) break;
+
+        // Announce the sleep, then look again: a producer either sees the flag
+        // and wakes us, or pushed early enough for the check below to see it
+        std::unique_lock<std::mutex> lock(s.waitMutex);
+        s.sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!s.queue.hasPending() && s.dropped.load(std::memory_order_relaxed) == s.droppedReported) {
+            s.wake.wait(lock, [&] { return !s.sleeping.load() || s.stopping.load(); });
+        }
+        s.sleeping.store(false);
+    }
+}
+
+void wakeWriter(LoggerState& s) {
+    std::atomic_thread_fence(std::memory_order_seq_cst); // Orders the push before the flag read
+    if (s.sleeping.load(std::memory_order_relaxed) && s.sleeping.exchange(false)) {
+        std::lock_guard<std::mutex> lock(s.waitMutex);
+        s.wake.notify_one();
+    }
+}
+
+} // namespace
+
+bool LogRateLimit::allow(uint32_t& suppressed) {
+    int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t windowStart = windowStartMs_.load(std::memory_order_relaxed);
+    if (nowMs - windowStart >= 1000 &&
+        windowStartMs_.compare_exchange_strong(windowStart, nowMs, std::memory_order_relaxed)) {
+        count_.store(0, std::memory_order_relaxed);
+    }
+    if (count_.fetch_add(1, std::memory_order_relaxed) >= kBurst) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool Logger::start(const Options& options) {
+    LoggerState& s = state();
+    if (s.running.load()) return true;
+
+    s.options = options;
+    s.file = fopen(options.path.c_str(), "a");
+    if (!s.file) {
+        fprintf(stderr, "[Logger] Could not open %s; logging to stderr only\n", options.path.c_str());
+    } else {
+        long size = ftell(s.file);
+        s.fileBytes = size > 0 ? static_cast<size_t>(size) : 0;
+        if (s.fileBytes >= options.maxFileBytes) rotate(s);
+    }
+
+    s.stopping.store(false);
+    s.writer = std::thread(writerLoop);
+    s.running.store(true);
+
+    static bool atexitRegistered = false;
+    if (!atexitRegistered) {
+        atexitRegistered = true;
+        std::atexit(Logger::stop);
+    }
+    return true;
+}
+
+void Logger::stop() {
+    LoggerState& s = state();
+    if (!s.running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(s.waitMutex); // The writer checks stopping under it
+        s.stopping.store(true);
+    }
+    s.wake.notify_all();
+    if (s.writer.joinable()) s.writer.join();
+    if (s.file) {
+        fclose(s.file);
+        s.file = nullptr;
+    }
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    static const struct { const char* name; LogLevel level; } kLevels[] = {
+        {"trace", LogLevel::Trace}, {"debug", LogLevel::Debug}, {"info", LogLevel::Info},
+        {"warn", LogLevel::Warn}, {"error", LogLevel::Error}, {"off", LogLevel::Off},
+    };
+    for (const auto& entry : kLevels) {
+        if (name == entry.name) {
+            level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "trace";
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+        case LogLevel::Off: return "off";
+    }
+    return "unknown";
+}
+
+void Logger::write(LogLevel level, const char* tag, std::string message, uint32_t suppressed) {
+    LoggerState& s = state();
+    LogRecord record;
+    record.timeUs = nowUs();
+    record.thread = currentThreadId();
+    record.level = level;
+    record.tag = tag;
+    record.suppressed = suppressed;
+    record.message = std::move(message);
+
+    if (!s.running.load(std::memory_order_acquire)) {
+        writeConsole(record);
+        return;
+    }
+    if (s.queue.push(std::move(record))) {
+        s.pushed.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        s.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeWriter(s);
+}
+
+void Logger::flush() {
+    LoggerState& s = state();
+    if (!s.running.load()) return;
+    uint64_t target = s.pushed.load(std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(s.waitMutex);
+    s.sleeping.store(false);
+    s.wake.notify_all();
+    s.drained.wait_for(lock, std::chrono::seconds(2), [&] {
+        return s.written.load(std::memory_order_acquire) >= target;
+    });
+}
+
+uint64_t Logger::droppedCount() {
+    return state().dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// Asynchronous structured logging.
+//
+// Callers format into a record and push it onto a bounded lock-free queue;
+// a background thread writes the records to the log file (logfmt lines:
+// ts, level, thread, tag, msg) and echoes those at or above the console
+// level to stderr. Decode threads therefore never touch the stream locks or
+// the file. When the queue is full records are dropped and counted rather
+// than blocking the caller.
+//
+// Filtering happens at three points: TX_LOG_COMPILE_LEVEL removes call sites
+// below it at compile time, Logger::setLevel() skips them at runtime before
+// anything is formatted, and each call site is limited to a burst of
+// messages per second (the next message that gets through says how many
+// were suppressed).
+//
+// The file is rotated by size: TapeXPlayer.log -> .log.1 -> ... -> .log.N.
+// Tags must be string literals; only the pointer is queued.
+enum class LogLevel : int { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+#ifndef TX_LOG_COMPILE_LEVEL
+#define TX_LOG_COMPILE_LEVEL 0 // LogLevel below which call sites are compiled out
+#endif
+
+class Logger {
+public:
+    struct Options {
+        std::string path = "/tmp/TapeXPlayer.log";
+        size_t maxFileBytes = 8 * 1024 * 1024;
+        int maxRotatedFiles = 3;
+        LogLevel consoleLevel = LogLevel::Info;
+    };
+
+    // Opens the file and starts the writer; stop() runs at exit
+    static bool start(const Options& options);
+    static bool start() { return start(Options()); }
+    // Drains the queue and joins the writer
+    static void stop();
+
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= minLevel_.load(std::memory_order_relaxed);
+    }
+    static void setLevel(LogLevel level) { minLevel_.store(static_cast<int>(level), std::memory_order_relaxed); }
+    static LogLevel level() { return static_cast<LogLevel>(minLevel_.load(std::memory_order_relaxed)); }
+    static bool parseLevel(const std::string& name, LogLevel& level);
+    static const char* levelName(LogLevel level);
+
+    // Queues one record; written synchronously to stderr if the writer is not running
+    static void write(LogLevel level, const char* tag, std::string message, uint32_t suppressed = 0);
+    // Blocks until everything queued so far has been written
+    static void flush();
+
+    static uint64_t droppedCount();
+
+private:
+    static std::atomic<int> minLevel_;
+};
+
+// Per-call-site rate limit: a burst of messages per one-second window
+class LogRateLimit {
+public:
+    static constexpr uint32_t kBurst = 20;
+
+    // True if this message may be logged; `suppressed` receives how many
+    // were dropped at this site since the last one that got through
+    bool allow(uint32_t& suppressed);
+
+private:
+    std::atomic<int64_t> windowStartMs_{0};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> suppressed_{0};
+};
+
+// TX_LOG(LogLevel::Info, "Tag", "value " << x): the stream expression is
+// only evaluated when the level passes both filters and the rate limit.
+// Variadic so template commas in the expression need no extra parentheses.
+#define TX_LOG(lvl, tag, ...) \
+    do { \
+        if (static_cast<int>(lvl) >= TX_LOG_COMPILE_LEVEL && Logger::enabled(lvl)) { \
+            static LogRateLimit txLogLimit_; \
+            uint32_t txLogSuppressed_ = 0; \
+            if (txLogLimit_.allow(txLogSuppressed_)) { \
+                std::ostringstream txLogStream_; \
+                txLogStream_ << __VA_ARGS__; \
+                Logger::write(lvl, tag, txLogStream_.str(), txLogSuppressed_); \
+            } \
+        } \
+    } while (0)
+
+#define TX_LOG_TRACE(tag, ...) TX_LOG(LogLevel::Trace, tag, __VA_ARGS__)
+#define TX_LOG_DEBUG(tag, ...) TX_LOG(LogLevel::Debug, tag, __VA_ARGS__)
+#define TX_LOG_INFO(tag, ...) TX_LOG(LogLevel::Info, tag, __VA_ARGS__)
+#define TX_LOG_WARN(tag, ...) TX_LOG(LogLevel::Warn, tag, __VA_ARGS__)
+#define TX_LOG_ERROR(tag, ...) TX_LOG(LogLevel::Error, tag, __VA_ARGS__)
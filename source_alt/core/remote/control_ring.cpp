@@ -0,0 +1,169 @@
+#include "control_ring.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+size_t ControlRing::bytesFor(uint32_t capacity) {
+    return sizeof(ControlRingHeader) + static_cast<size_t>(capacity) * sizeof(ControlRingSlot);
+}
+
+std::string ControlRing::doorbellPath(const std::string& controlPath) {
+    return controlPath + ".wake";
+}
+
+bool ControlRing::create(void* memory, uint32_t capacity, const std::string& doorbell) {
+    close();
+    if (!memory || capacity == 0 || (capacity & (capacity - 1)) != 0) return false;
+
+    std::memset(memory, 0, bytesFor(capacity));
+    header_ = new (memory) ControlRingHeader();
+    header_->capacity = capacity;
+    header_->slotSize = sizeof(ControlRingSlot);
+    header_->consumerPid = static_cast<uint32_t>(getpid());
+    header_->writeSeq.store(0, std::memory_order_relaxed);
+    header_->readSeq.store(0, std::memory_order_relaxed);
+    header_->consumerSleeping.store(0, std::memory_order_relaxed);
+    header_->version = ControlRingHeader::kVersion;
+    slots_ = reinterpret_cast<ControlRingSlot*>(static_cast<char*>(memory) + sizeof(ControlRingHeader));
+    // Magic last: a producer that sees it sees a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = ControlRingHeader::kMagic;
+
+    unlink(doorbell.c_str());
+    if (mkfifo(doorbell.c_str(), 0666) == -1 && errno != EEXIST) {
+        // Still works without the doorbell, at the consumer's polling interval
+        return true;
+    }
+    openDoorbell(doorbell, true);
+    return true;
+}
+
+bool ControlRing::attach(void* memory, size_t size, const std::string& doorbell) {
+    close();
+    if (!memory || size < sizeof(ControlRingHeader)) return false;
+
+    auto* header = static_cast<ControlRingHeader*>(memory);
+    if (header->magic != ControlRingHeader::kMagic || header->version != ControlRingHeader::kVersion ||
+        header->slotSize != sizeof(ControlRingSlot) || header->capacity == 0 ||
+        (header->capacity & (header->capacity - 1)) != 0 || size < bytesFor(header->capacity)) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    header_ = header;
+    slots_ = reinterpret_cast<ControlRingSlot*>(static_cast<char*>(memory) + sizeof(ControlRingHeader));
+    openDoorbell(doorbell, false);
+    return true;
+}
+
+void ControlRing::openDoorbell(const std::string& path, bool consumer) {
+    // The consumer opens read-write so the FIFO never reports EOF when the
+    // last producer goes away; producers open write-only and skip the
+    // doorbell if nobody is listening (ENXIO)
+    doorbellFd_ = open(path.c_str(), (consumer ? O_RDWR : O_WRONLY) | O_NONBLOCK | O_CLOEXEC);
+}
+
+void ControlRing::close() {
+    if (doorbellFd_ >= 0) ::close(doorbellFd_);
+    doorbellFd_ = -1;
+    header_ = nullptr;
+    slots_ = nullptr;
+}
+
+bool ControlRing::publish(const ControlRingSlot& slot, uint64_t& seq) {
+    if (!header_) return false;
+    uint64_t write = header_->writeSeq.load(std::memory_order_relaxed);
+    uint64_t read = header_->readSeq.load(std::memory_order_acquire);
+    if (write - read >= header_->capacity) return false; // Full: oldest command not executed yet
+
+    ControlRingSlot& target = slots_[write & (header_->capacity - 1)];
+    target = slot;
+    target.seq = write;
+    seq = write;
+    // seq_cst pairs with the consumer's store to consumerSleeping: either it
+    // sees this command before sleeping or we see that it sleeps
+    header_->writeSeq.store(write + 1, std::memory_order_seq_cst);
+    if (header_->consumerSleeping.load(std::memory_order_seq_cst) && doorbellFd_ >= 0) {
+        char byte = 1;
+        (void)!::write(doorbellFd_, &byte, 1); // EAGAIN: the FIFO is already full of wakeups
+    }
+    return true;
+}
+
+bool ControlRing::push(int32_t type, double value, uint64_t& seq) {
+    ControlRingSlot slot{};
+    slot.type = type;
+    slot.value = value;
+    return publish(slot, seq);
+}
+
+bool ControlRing::pushText(int32_t type, const char* text, uint64_t& seq) {
+    ControlRingSlot slot{};
+    slot.type = type;
+    std::memcpy(slot.text, text, strnlen(text, sizeof(slot.text))); // HHMMSSFF fills all 8 bytes, no terminator
+    return publish(slot, seq);
+}
+
+bool ControlRing::acknowledged(uint64_t seq) const {
+    return header_ && header_->readSeq.load(std::memory_order_acquire) > seq;
+}
+
+bool ControlRing::waitForAck(uint64_t seq, int timeoutMs) const {
+    // Acks come back within microseconds; spin briefly before sleeping
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (int spin = 0; !acknowledged(seq); ++spin) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        if (spin < 1000) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    return true;
+}
+
+bool ControlRing::peek(ControlRingSlot& slot) const {
+    if (!header_) return false;
+    uint64_t read = header_->readSeq.load(std::memory_order_relaxed);
+    if (header_->writeSeq.load(std::memory_order_acquire) == read) return false;
+    slot = slots_[read & (header_->capacity - 1)]; // slot.seq == read unless a producer broke the protocol
+    return true;
+}
+
+void ControlRing::ack() {
+    if (!header_) return;
+    header_->readSeq.fetch_add(1, std::memory_order_release);
+}
+
+void ControlRing::wait(int timeoutMs) {
+    if (!header_) return;
+    header_->consumerSleeping.store(1, std::memory_order_seq_cst);
+    if (header_->writeSeq.load(std::memory_order_seq_cst) != header_->readSeq.load(std::memory_order_relaxed)) {
+        header_->consumerSleeping.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    if (doorbellFd_ >= 0) {
+        pollfd pfd{doorbellFd_, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) > 0) {
+            char drain[64];
+            while (read(doorbellFd_, drain, sizeof(drain)) > 0) {
+            }
+        }
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    }
+    header_->consumerSleeping.store(0, std::memory_order_relaxed);
+}
+
+void ControlRing::wake() {
+    if (doorbellFd_ < 0) return;
+    char byte = 1;
+    (void)!::write(doorbellFd_, &byte, 1);
+}
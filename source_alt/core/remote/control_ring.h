@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Command ring shared between an external controller (producer) and the
+// player (consumer), living in the control file after the legacy
+// RemoteCommand slot.
+//
+// Commands get consecutive sequence numbers. The producer writes a slot and
+// then publishes writeSeq; the consumer executes slots in order and
+// publishes readSeq, which doubles as the acknowledgement: command N is done
+// once readSeq > N. Nothing is overwritten before it is acknowledged, so a
+// controller that sends faster than the player drains sees a full ring
+// instead of losing commands.
+//
+// The consumer sleeps on a FIFO next to the control file (the "doorbell")
+// and producers only write to it when the consumer says it is asleep, so a
+// command is picked up immediately without a syscall per command.
+//
+// Single producer: controllers hold flock(LOCK_EX) on the control file while
+// they send.
+struct ControlRingSlot {
+    uint64_t seq;     // Sequence number of the command in this slot
+    int32_t type;     // RemoteCommand::Type
+    int32_t reserved;
+    union {
+        double value; // Seek time, speed, ...
+        char text[8]; // SEEK_TIMECODE digits
+    };
+};
+static_assert(sizeof(ControlRingSlot) == 24, "ControlRingSlot layout is part of the protocol");
+
+struct ControlRingHeader {
+    static constexpr uint32_t kMagic = 0x52435854; // "TXCR"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;  // Slots, power of two
+    uint32_t slotSize;  // sizeof(ControlRingSlot)
+    uint32_t consumerPid;
+    uint32_t reserved[11];
+
+    alignas(64) std::atomic<uint64_t> writeSeq;       // Commands published
+    alignas(64) std::atomic<uint64_t> readSeq;        // Commands executed (acknowledged)
+    std::atomic<uint32_t> consumerSleeping;           // Producer rings the doorbell when set
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring counters must be lock-free to live in shared memory");
+
+class ControlRing {
+public:
+    static constexpr uint32_t kDefaultCapacity = 256;
+    // Offset of the ring in the control file; the legacy 48-byte slot comes first
+    static constexpr size_t kFileOffset = 64;
+
+    static size_t bytesFor(uint32_t capacity);
+    static std::string doorbellPath(const std::string& controlPath);
+
+    // Consumer: lays out a fresh ring in `memory` (bytesFor(capacity) bytes)
+    bool create(void* memory, uint32_t capacity, const std::string& doorbell);
+    // Producer: validates an existing ring; false if the version or layout differs
+    bool attach(void* memory, size_t size, const std::string& doorbell);
+    void close();
+
+    bool valid() const { return header_ != nullptr; }
+    uint32_t capacity() const { return header_ ? header_->capacity : 0; }
+
+    // --- Producer side ---
+    // False if the ring is full; `seq` receives the command's sequence number
+    bool push(int32_t type, double value, uint64_t& seq);
+    bool pushText(int32_t type, const char* text, uint64_t& seq);
+    // True once the consumer has executed command `seq`
+    bool acknowledged(uint64_t seq) const;
+    bool waitForAck(uint64_t seq, int timeoutMs) const;
+
+    // --- Consumer side ---
+    // Next unexecuted command, left in place until ack()
+    bool peek(ControlRingSlot& slot) const;
+    void ack();
+    // Sleeps until a producer rings or timeoutMs passes; returns at once if commands are pending
+    void wait(int timeoutMs);
+    // Wakes the consumer (e.g. for shutdown)
+    void wake();
+
+private:
+    bool publish(const ControlRingSlot& slot, uint64_t& seq);
+    void openDoorbell(const std::string& path, bool consumer);
+
+    ControlRingHeader* header_ = nullptr;
+    ControlRingSlot* slots_ = nullptr;
+    int doorbellFd_ = -1;
+};
@@ -0,0 +1,668 @@
+#include "control_socket.h"
+#include "remote_control.h"
+#include "../log/logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <sys/event.h>
+#else
+#include <sys/epoll.h>
+#endif
+
+namespace {
+
+constexpr size_t kMaxLine = 64 * 1024;          // Longest request; longer input drops the client
+constexpr size_t kMaxPending = 4 * 1024 * 1024; // Unsent output before a stalled client is dropped
+constexpr int kMaxEvents = 64;
+constexpr int kMaxBatch = 256;
+
+// --- Event loop backend ---
+
+struct PollEvent {
+    int fd;
+    bool readable;
+    bool writable;
+    bool hangup;
+};
+
+int pollerCreate() {
+#ifdef __APPLE__
+    return kqueue();
+#else
+    return epoll_create1(EPOLL_CLOEXEC);
+#endif
+}
+
+// Watches `fd` for input, and for output space while `writable` is set
+bool pollerWatch(int pollFd, int fd, bool writable, bool added) {
+#ifdef __APPLE__
+    (void)added;
+    struct kevent changes[2];
+    EV_SET(&changes[0], fd, EVFILT_READ, EV_ADD, 0, 0, nullptr);
+    EV_SET(&changes[1], fd, EVFILT_WRITE, writable ? EV_ADD : EV_DELETE, 0, 0, nullptr);
+    // Deleting a write filter that was never added fails with ENOENT, which is fine
+    kevent(pollFd, changes, 2, nullptr, 0, nullptr);
+    return true;
+#else
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.fd = fd;
+    return epoll_ctl(pollFd, added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev) == 0;
+#endif
+}
+
+int pollerWait(int pollFd, PollEvent* events, int timeoutMs) {
+#ifdef __APPLE__
+    struct kevent raw[kMaxEvents];
+    timespec timeout{timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    int n = kevent(pollFd, nullptr, 0, raw, kMaxEvents, timeoutMs < 0 ? nullptr : &timeout);
+    for (int i = 0; i < n; ++i) {
+        events[i].fd = static_cast<int>(raw[i].ident);
+        events[i].readable = raw[i].filter == EVFILT_READ;
+        events[i].writable = raw[i].filter == EVFILT_WRITE;
+        events[i].hangup = (raw[i].flags & EV_ERROR) != 0; // EOF shows up as a zero-byte read
+    }
+    return n;
+#else
+    epoll_event raw[kMaxEvents];
+    int n = epoll_wait(pollFd, raw, kMaxEvents, timeoutMs);
+    for (int i = 0; i < n; ++i) {
+        events[i].fd = raw[i].data.fd;
+        events[i].readable = (raw[i].events & EPOLLIN) != 0;
+        events[i].writable = (raw[i].events & EPOLLOUT) != 0;
+        events[i].hangup = (raw[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+    }
+    return n;
+#endif
+}
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+// --- Minimal JSON reader for request lines ---
+
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;   // String contents, or the literal of a number
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> members;
+
+    const JsonValue* get(const std::string& key) const {
+        auto it = members.find(key);
+        return it == members.end() ? nullptr : &it->second;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& s) : s_(s) {}
+
+    bool parse(JsonValue& out) {
+        if (!value(out, 0)) return false;
+        skipSpace();
+        return pos_ == s_.size();
+    }
+
+private:
+    static constexpr int kMaxDepth = 8;
+
+    void skipSpace() {
+        while (pos_ < s_.size() && std::isspace(static_cast<unsigned char>(s_[pos_]))) ++pos_;
+    }
+
+    bool literal(const char* word) {
+        size_t n = std::strlen(word);
+        if (s_.compare(pos_, n, word) != 0) return false;
+        pos_ += n;
+        return true;
+    }
+
+    bool value(JsonValue& out, int depth) {
+        if (depth > kMaxDepth) return false;
+        skipSpace();
+        if (pos_ >= s_.size()) return false;
+        char c = s_[pos_];
+        if (c == '{') return object(out, depth);
+        if (c == '[') return array(out, depth);
+        if (c == '"') {
+            out.type = JsonValue::Type::String;
+            return string(out.text);
+        }
+        if (literal("true")) { out.type = JsonValue::Type::Bool; out.boolean = true; return true; }
+        if (literal("false")) { out.type = JsonValue::Type::Bool; return true; }
+        if (literal("null")) return true;
+        return number(out);
+    }
+
+    bool number(JsonValue& out) {
+        const char* begin = s_.c_str() + pos_;
+        char* end = nullptr;
+        out.number = std::strtod(begin, &end);
+        if (end == begin) return false;
+        out.type = JsonValue::Type::Number;
+        out.text.assign(begin, static_cast<size_t>(end - begin));
+        pos_ += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    bool string(std::string& out) {
+        ++pos_; // Opening quote
+        while (pos_ < s_.size()) {
+            char c = s_[pos_++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= s_.size()) return false;
+            char e = s_[pos_++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    // Paths are the only free text; keep ASCII, replace the rest
+                    if (pos_ + 4 > s_.size()) return false;
+                    unsigned long code = std::strtoul(s_.substr(pos_, 4).c_str(), nullptr, 16);
+                    out += code < 0x80 ? static_cast<char>(code) : '?';
+                    pos_ += 4;
+                    break;
+                }
+                default: out += e; break; // \" \\ \/
+            }
+        }
+        return false;
+    }
+
+    bool array(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::Array;
+        ++pos_;
+        skipSpace();
+        if (pos_ < s_.size() && s_[pos_] == ']') { ++pos_; return true; }
+        for (;;) {
+            out.items.emplace_back();
+            if (!value(out.items.back(), depth + 1)) return false;
+            skipSpace();
+            if (pos_ >= s_.size()) return false;
+            char c = s_[pos_++];
+            if (c == ']') return true;
+            if (c != ',') return false;
+        }
+    }
+
+    bool object(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::Object;
+        ++pos_;
+        skipSpace();
+        if (pos_ < s_.size() && s_[pos_] == '}') { ++pos_; return true; }
+        for (;;) {
+            skipSpace();
+            std::string key;
+            if (pos_ >= s_.size() || s_[pos_] != '"' || !string(key)) return false;
+            skipSpace();
+            if (pos_ >= s_.size() || s_[pos_++] != ':') return false;
+            if (!value(out.members[key], depth + 1)) return false;
+            skipSpace();
+            if (pos_ >= s_.size()) return false;
+            char c = s_[pos_++];
+            if (c == '}') return true;
+            if (c != ',') return false;
+        }
+    }
+
+    const std::string& s_;
+    size_t pos_ = 0;
+};
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+// The request id echoed back as it was sent
+std::string idJson(const JsonValue* id) {
+    if (!id) return "null";
+    switch (id->type) {
+        case JsonValue::Type::Number: return id->text;
+        case JsonValue::Type::String: return "\"" + jsonEscape(id->text) + "\"";
+        default: return "null";
+    }
+}
+
+// --- Commands ---
+
+struct CommandName {
+    const char* name;
+    RemoteCommand::Type type;
+    enum Value { None, Number, Timecode, Flag } value;
+};
+
+const CommandName kCommands[] = {
+    {"seek", RemoteCommand::Type::SEEK, CommandName::Number},
+    {"seek_timecode", RemoteCommand::Type::SEEK_TIMECODE, CommandName::Timecode},
+    {"play", RemoteCommand::Type::PLAY, CommandName::None},
+    {"stop", RemoteCommand::Type::STOP, CommandName::None},
+    {"speed", RemoteCommand::Type::SET_SPEED, CommandName::Number},
+    {"adjust_speed", RemoteCommand::Type::ADJUST_SPEED, CommandName::Number},
+    {"reverse", RemoteCommand::Type::SET_REVERSE, CommandName::Flag},
+    {"screenshot", RemoteCommand::Type::SCREENSHOT, CommandName::None},
+    {"seek_screenshot", RemoteCommand::Type::SEEK_AND_SCREENSHOT, CommandName::Number},
+    {"ping", RemoteCommand::Type::PING, CommandName::None},
+};
+
+bool buildCommand(const JsonValue& request, RemoteCommand& cmd, std::string& error) {
+    const JsonValue* name = request.get("cmd");
+    if (request.type != JsonValue::Type::Object || !name || name->type != JsonValue::Type::String) {
+        error = "missing \"cmd\"";
+        return false;
+    }
+    const CommandName* found = nullptr;
+    for (const auto& c : kCommands) {
+        if (name->text == c.name) found = &c;
+    }
+    if (!found) {
+        error = "unknown command '" + name->text + "'";
+        return false;
+    }
+
+    cmd = RemoteCommand{};
+    cmd.command_type = found->type;
+    const JsonValue* value = request.get("value");
+    switch (found->value) {
+        case CommandName::None:
+            return true;
+        case CommandName::Number:
+            if (!value || value->type != JsonValue::Type::Number) break;
+            cmd.seek_time = value->number;
+            return true;
+        case CommandName::Flag:
+            if (value && value->type == JsonValue::Type::Bool) {
+                cmd.speed_value = value->boolean ? 1.0 : 0.0;
+                return true;
+            }
+            if (!value || value->type != JsonValue::Type::Number) break;
+            cmd.speed_value = value->number;
+            return true;
+        case CommandName::Timecode: {
+            if (!value || value->type != JsonValue::Type::String) break;
+            // HH:MM:SS:FF or HHMMSSFF, either possibly shortened from the left
+            std::string digits;
+            for (char c : value->text) {
+                if (std::isdigit(static_cast<unsigned char>(c))) digits += c;
+                else if (c != ':' && c != ';' && c != '.') digits = "x";
+            }
+            if (digits.empty() || digits.size() > 8 || digits.find('x') != std::string::npos) break;
+            digits.insert(0, 8 - digits.size(), '0');
+            std::memcpy(cmd.seek_timecode, digits.data(), 8);
+            return true;
+        }
+    }
+    error = std::string("bad \"value\" for ") + found->name;
+    return false;
+}
+
+std::string stateJson(const PlayerState& s) {
+    static const char* const kLoadStates[] = {"idle", "loading", "ready", "failed"};
+    static const char* const kTiers[] = {"none", "low_res", "cached", "full_res"};
+    int load = std::max(0, std::min(3, s.loadState));
+    int tier = std::max(0, std::min(3, s.displayedTier));
+    std::ostringstream out;
+    out.precision(17);
+    out << "{\"load\":\"" << kLoadStates[load] << "\",\"load_percent\":" << s.loadPercent
+        << ",\"file\":\"" << jsonEscape(s.filePath) << "\",\"timecode\":\"" << jsonEscape(s.timecode)
+        << "\",\"time\":" << s.currentTime << ",\"duration\":" << s.duration << ",\"fps\":" << s.fps
+        << ",\"frame\":" << s.frameIndex << ",\"frames\":" << s.frameCount
+        << ",\"rate\":" << s.playbackRate << ",\"target_rate\":" << s.targetRate
+        << ",\"playing\":" << ((s.flags & PlayerState::kPlaying) ? "true" : "false")
+        << ",\"reverse\":" << ((s.flags & PlayerState::kReverse) ? "true" : "false")
+        << ",\"seeking\":" << ((s.flags & PlayerState::kSeeking) ? "true" : "false")
+        << ",\"jog\":" << ((s.flags & PlayerState::kJog) ? "true" : "false")
+        << ",\"tier\":\"" << kTiers[tier] << "\",\"tier_frames\":{";
+    for (int t = 1; t < 4; ++t) { // framesByTier and kTiers both follow FrameInfo::FrameType
+        out << (t > 1 ? "," : "") << "\"" << kTiers[t] << "\":" << s.framesByTier[t];
+    }
+    out << "}}";
+    return out.str();
+}
+
+} // namespace
+
+// --- ControlSocketServer ---
+
+ControlSocketServer::~ControlSocketServer() {
+    stop();
+}
+
+bool ControlSocketServer::start(RemoteControl& remote, const std::string& path) {
+    if (thread_.joinable()) return true;
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        TX_LOG_ERROR("Control", "Socket path too long: " << path);
+        return false;
+    }
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        TX_LOG_ERROR("Control", "socket() failed: " << strerror(errno));
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str()); // Left over from a previous run
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd_, 16) < 0) {
+        TX_LOG_ERROR("Control", "Cannot listen on " << path << ": " << strerror(errno));
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    setNonBlocking(listenFd_);
+
+    pollFd_ = pollerCreate();
+    if (pollFd_ < 0 || pipe(wakePipe_) != 0) {
+        TX_LOG_ERROR("Control", "Cannot create the event loop: " << strerror(errno));
+        stop();
+        return false;
+    }
+    setNonBlocking(wakePipe_[0]);
+    setNonBlocking(wakePipe_[1]);
+    pollerWatch(pollFd_, listenFd_, false, false);
+    pollerWatch(pollFd_, wakePipe_[0], false, false);
+
+    remote_ = &remote;
+    path_ = path;
+    stopping_ = false;
+    thread_ = std::thread(&ControlSocketServer::run, this);
+    watcher_ = std::thread(&ControlSocketServer::watchState, this);
+    TX_LOG_INFO("Control", "Serving the control API on " << path_);
+    return true;
+}
+
+void ControlSocketServer::stop() {
+    stopping_ = true;
+    if (wakePipe_[1] >= 0) {
+        char byte = 1;
+        (void)!write(wakePipe_[1], &byte, 1);
+    }
+    if (thread_.joinable()) thread_.join();
+    if (watcher_.joinable()) watcher_.join();
+
+    for (auto& entry : clients_) close(entry.first);
+    clients_.clear();
+    subscribers_ = 0;
+    stateReader_.close();
+    for (int& fd : wakePipe_) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    if (pollFd_ >= 0) close(pollFd_);
+    pollFd_ = -1;
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(path_.c_str());
+    }
+    listenFd_ = -1;
+}
+
+void ControlSocketServer::run() {
+    PollEvent events[kMaxEvents];
+    while (!stopping_) {
+        int n = pollerWait(pollFd_, events, -1);
+        if (n < 0 && errno != EINTR) {
+            TX_LOG_ERROR("Control", "Event loop failed: " << strerror(errno));
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            const PollEvent& ev = events[i];
+            if (ev.fd == listenFd_) {
+                acceptClients();
+                continue;
+            }
+            if (ev.fd == wakePipe_[0]) {
+                char drain[64];
+                while (read(wakePipe_[0], drain, sizeof(drain)) > 0) {
+                }
+                if (subscribers_ > 0) publishState();
+                continue;
+            }
+            auto it = clients_.find(ev.fd);
+            if (it == clients_.end()) continue; // Closed earlier in this batch
+            Client& client = it->second;
+            if (ev.readable) handleReadable(client);
+            if (ev.writable && !client.closing) flush(client);
+            if (ev.hangup && !ev.readable) client.closing = true;
+            if (client.closing) closeClient(ev.fd);
+        }
+    }
+}
+
+void ControlSocketServer::watchState() {
+    PlayerStateReader reader;
+    uint64_t seen = 0;
+    while (!stopping_) {
+        if (!reader.isOpen() && !reader.open(PlayerStatePublisher::kDefaultPath)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200)); // Publication disabled or not up yet
+            continue;
+        }
+        if (!reader.waitForChange(seen, 200)) continue;
+        seen = reader.changeCount();
+        if (subscribers_ > 0) {
+            char byte = 1;
+            (void)!write(wakePipe_[1], &byte, 1); // EAGAIN: a wakeup is already pending
+        }
+    }
+}
+
+void ControlSocketServer::acceptClients() {
+    for (;;) {
+        int fd = ::accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) return; // EAGAIN: accepted everything pending
+        setNonBlocking(fd);
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (!pollerWatch(pollFd_, fd, false, false)) {
+            close(fd);
+            continue;
+        }
+        clients_[fd].fd = fd;
+    }
+}
+
+void ControlSocketServer::handleReadable(Client& client) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = recv(client.fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            client.closing = true; // Peer closed; requests already read were answered
+            break;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) client.closing = true;
+            break;
+        }
+        client.in.append(buf, static_cast<size_t>(n));
+    }
+
+    size_t start = 0;
+    for (size_t end; (end = client.in.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::string line = client.in.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) handleLine(client, line);
+    }
+    client.in.erase(0, start);
+    if (client.in.size() > kMaxLine) {
+        TX_LOG_WARN("Control", "Dropping a client that sent a request over " << kMaxLine << " bytes");
+        client.closing = true;
+    }
+    flush(client);
+}
+
+void ControlSocketServer::handleLine(Client& client, const std::string& line) {
+    JsonValue request;
+    if (!JsonParser(line).parse(request) || request.type != JsonValue::Type::Object) {
+        queue(client, "{\"id\":null,\"ok\":false,\"error\":\"malformed JSON\"}");
+        return;
+    }
+    const std::string id = idJson(request.get("id"));
+    auto fail = [&](const std::string& error) {
+        queue(client, "{\"id\":" + id + ",\"ok\":false,\"error\":\"" + jsonEscape(error) + "\"}");
+    };
+
+    // Queries
+    const JsonValue* cmd = request.get("cmd");
+    if (cmd && cmd->type == JsonValue::Type::String &&
+        (cmd->text == "state" || cmd->text == "subscribe" || cmd->text == "unsubscribe")) {
+        if (cmd->text == "unsubscribe") {
+            if (client.subscribed) --subscribers_;
+            client.subscribed = false;
+            queue(client, "{\"id\":" + id + ",\"ok\":true}");
+            return;
+        }
+        PlayerState state;
+        uint64_t changeCount = 0;
+        if (!readState(state, changeCount)) {
+            fail("player state is not published");
+            return;
+        }
+        if (cmd->text == "subscribe" && !client.subscribed) {
+            client.subscribed = true;
+            ++subscribers_;
+        }
+        queue(client, "{\"id\":" + id + ",\"ok\":true,\"state\":" + stateJson(state) + "}");
+        return;
+    }
+
+    // File requests
+    if (cmd && cmd->type == JsonValue::Type::String && (cmd->text == "open" || cmd->text == "prepare")) {
+        const JsonValue* value = request.get("value");
+        if (!value || value->type != JsonValue::Type::String || value->text.empty()) {
+            fail("\"" + cmd->text + "\" needs a file path as \"value\"");
+            return;
+        }
+        std::string error = fileHandler_ ? fileHandler_(cmd->text, value->text) : "file requests are not available";
+        if (!error.empty()) {
+            fail(error);
+            return;
+        }
+        queue(client, "{\"id\":" + id + ",\"ok\":true}");
+        return;
+    }
+
+    // Commands: one, or a batch that runs as a unit
+    std::vector<RemoteCommand> commands;
+    std::string error;
+    const JsonValue* batch = request.get("batch");
+    if (batch) {
+        if (batch->type != JsonValue::Type::Array || batch->items.empty() || batch->items.size() > kMaxBatch) {
+            fail("\"batch\" must be an array of 1 to " + std::to_string(kMaxBatch) + " commands");
+            return;
+        }
+        for (size_t i = 0; i < batch->items.size(); ++i) {
+            RemoteCommand c;
+            if (!buildCommand(batch->items[i], c, error)) {
+                fail("batch[" + std::to_string(i) + "]: " + error + "; nothing was run");
+                return;
+            }
+            commands.push_back(c);
+        }
+    } else {
+        RemoteCommand c;
+        if (!buildCommand(request, c, error)) {
+            fail(error);
+            return;
+        }
+        commands.push_back(c);
+    }
+
+    try {
+        remote_->execute_batch(commands);
+    }
+    catch (const std::exception& e) {
+        fail(e.what());
+        return;
+    }
+    queue(client, "{\"id\":" + id + ",\"ok\":true,\"executed\":" + std::to_string(commands.size()) + "}");
+}
+
+bool ControlSocketServer::readState(PlayerState& state, uint64_t& changeCount) {
+    if (!stateReader_.isOpen() && !stateReader_.open(PlayerStatePublisher::kDefaultPath)) return false;
+    return stateReader_.read(state, changeCount);
+}
+
+void ControlSocketServer::publishState() {
+    PlayerState state;
+    uint64_t changeCount = 0;
+    if (!readState(state, changeCount) || changeCount == stateSent_) return;
+    stateSent_ = changeCount;
+    const std::string line = "{\"event\":\"state\",\"state\":" + stateJson(state) + "}";
+    std::vector<int> stalled;
+    for (auto& entry : clients_) {
+        Client& client = entry.second;
+        if (!client.subscribed) continue;
+        queue(client, line);
+        flush(client);
+        if (client.closing) stalled.push_back(entry.first);
+    }
+    for (int fd : stalled) closeClient(fd);
+}
+
+void ControlSocketServer::queue(Client& client, const std::string& line) {
+    client.out += line;
+    client.out += '\n';
+}
+
+void ControlSocketServer::flush(Client& client) {
+    bool hadPending = !client.out.empty();
+    size_t sent = 0;
+    while (sent < client.out.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = ::send(client.fd, client.out.data() + sent, client.out.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = ::send(client.fd, client.out.data() + sent, client.out.size() - sent, 0);
+#endif
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) client.closing = true;
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    client.out.erase(0, sent);
+    if (client.out.size() > kMaxPending) {
+        TX_LOG_WARN("Control", "Dropping a client that stopped reading");
+        client.closing = true;
+    }
+    // Ask for output space only while something is waiting for it
+    if (!client.closing && hadPending) pollerWatch(pollFd_, client.fd, !client.out.empty(), true);
+}
+
+void ControlSocketServer::closeClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) return;
+    if (it->second.subscribed) --subscribers_;
+    close(fd); // Also drops it from the epoll/kqueue set
+    clients_.erase(it);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "player_state.h"
+
+class RemoteControl;
+
+// Local control API on a Unix-domain socket (/tmp/tapexplayer.sock).
+//
+// The protocol is JSON lines. Each request is one object on one line and is
+// answered by one line carrying the same "id":
+//
+//   {"id":1,"cmd":"seek","value":12.5}              -> {"id":1,"ok":true}
+//   {"id":2,"batch":[{"cmd":"seek_timecode","value":"01:00:10:00"},
+//                    {"cmd":"speed","value":2},{"cmd":"screenshot"}]}
+//   {"id":3,"cmd":"state"}                          -> {"id":3,"ok":true,"state":{...}}
+//   {"id":4,"cmd":"subscribe"}                      -> then {"event":"state","state":{...}} per change
+//   {"id":5,"cmd":"prepare","value":"/path/take2.mov"}
+//
+// Commands are the RemoteCommand types by name: seek, seek_timecode, play,
+// stop, speed, adjust_speed, reverse, screenshot, seek_screenshot, ping. A
+// batch is validated as a whole before anything runs, then executed under
+// the same lock the control file uses, so no other command lands in between.
+// State comes from the shared-memory publication (player_state.h). "open"
+// and "prepare" name a file and go to the file handler instead: the player
+// switches to it, or prepares it in the background for a later switch.
+//
+// One thread serves every client from an epoll (Linux) or kqueue (macOS)
+// event loop; a second thread waits for state changes and wakes the loop
+// when anyone is subscribed.
+class ControlSocketServer {
+public:
+    static constexpr const char* kDefaultPath = "/tmp/tapexplayer.sock";
+
+    ~ControlSocketServer();
+
+    // Handles "open" and "prepare" on the server thread; returns an error, empty on success
+    using FileHandler = std::function<std::string(const std::string& cmd, const std::string& path)>;
+
+    // Set before start()
+    void setFileHandler(FileHandler handler) { fileHandler_ = std::move(handler); }
+    bool start(RemoteControl& remote, const std::string& path = kDefaultPath);
+    void stop();
+
+private:
+    struct Client {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        bool subscribed = false;
+        bool closing = false;
+    };
+
+    void run();
+    void watchState();
+    void acceptClients();
+    void handleReadable(Client& client);
+    void handleLine(Client& client, const std::string& line);
+    void queue(Client& client, const std::string& line);
+    void flush(Client& client);
+    bool readState(PlayerState& state, uint64_t& changeCount);
+    void publishState();
+    void closeClient(int fd);
+
+    RemoteControl* remote_ = nullptr;
+    FileHandler fileHandler_;
+    std::string path_;
+    int listenFd_ = -1;
+    int pollFd_ = -1;        // epoll or kqueue descriptor
+    int wakePipe_[2] = {-1, -1};
+    std::unordered_map<int, Client> clients_;
+    PlayerStateReader stateReader_; // Server thread only
+    std::atomic<int> subscribers_{0};
+    std::atomic<bool> stopping_{false};
+    uint64_t stateSent_ = 0; // Change count of the last state sent to subscribers
+    std::thread thread_;
+    std::thread watcher_;
+};
@@ -0,0 +1,170 @@
+#include "hui_output.h"
+#include "rtmidi/RtMidi.h"
+#include "../log/logger.h"
+
+#include <algorithm>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t kControlChange = 0xB0; // Channel 1
+constexpr uint8_t kNoteOn = 0x90;
+
+} // namespace
+
+HuiOutput::~HuiOutput() {
+    stop();
+}
+
+void HuiOutput::start(RtMidiOut* port) {
+    if (thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(portMutex_);
+        port_ = port;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        cellWanted_.fill(kUnknown);
+        cellShown_.fill(kUnknown);
+        ledWanted_.fill(kUnknown);
+        ledShown_.fill(kUnknown);
+        cellsDirty_ = ledsDirty_ = false;
+        stopping_ = false;
+    }
+    thread_ = std::thread(&HuiOutput::run, this);
+}
+
+void HuiOutput::stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+
+    // Whatever was set last (the cleared display on shutdown) still goes out
+    std::vector<std::array<uint8_t, 3>> messages;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        collect(true, messages);
+    }
+    send(messages);
+    TX_LOG_DEBUG("HUI", "Output stopped after " << messagesSent() << " messages");
+
+    std::lock_guard<std::mutex> lock(portMutex_);
+    port_ = nullptr;
+}
+
+void HuiOutput::detach() {
+    std::lock_guard<std::mutex> lock(portMutex_);
+    port_ = nullptr;
+}
+
+void HuiOutput::attach(RtMidiOut* port) {
+    {
+        std::lock_guard<std::mutex> lock(portMutex_);
+        port_ = port;
+    }
+    invalidate();
+}
+
+void HuiOutput::setRefreshRate(int hz) {
+    hz = std::clamp(hz, 1, 1000);
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    refreshInterval_ = std::chrono::microseconds(1000000 / hz);
+}
+
+void HuiOutput::setCell(uint8_t position, uint8_t value) {
+    if (position < kFirstCell || position > kLastCell) return;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        int16_t& wanted = cellWanted_[position - kFirstCell];
+        if (wanted == value) return;
+        wanted = value;
+        cellsDirty_ = true;
+    }
+    cv_.notify_one();
+}
+
+void HuiOutput::setLed(uint8_t note, bool on) {
+    if (note > 0x7F) return;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        int16_t value = on ? 0x7F : 0x00;
+        if (ledWanted_[note] == value) return;
+        ledWanted_[note] = value;
+        ledsDirty_ = true;
+    }
+    cv_.notify_one();
+}
+
+void HuiOutput::invalidate() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        cellShown_.fill(kUnknown);
+        ledShown_.fill(kUnknown);
+        cellsDirty_ = ledsDirty_ = true;
+    }
+    cv_.notify_one();
+}
+
+void HuiOutput::collect(bool cells, std::vector<std::array<uint8_t, 3>>& out) {
+    if (ledsDirty_) {
+        for (int note = 0; note < 128; ++note) {
+            if (ledWanted_[note] == kUnknown || ledWanted_[note] == ledShown_[note]) continue;
+            out.push_back({kNoteOn, static_cast<uint8_t>(note), static_cast<uint8_t>(ledWanted_[note])});
+            ledShown_[note] = ledWanted_[note];
+        }
+        ledsDirty_ = false;
+    }
+    if (cells && cellsDirty_) {
+        for (int i = 0; i < kCells; ++i) {
+            if (cellWanted_[i] == kUnknown || cellWanted_[i] == cellShown_[i]) continue;
+            out.push_back({kControlChange, static_cast<uint8_t>(kFirstCell + i), static_cast<uint8_t>(cellWanted_[i])});
+            cellShown_[i] = cellWanted_[i];
+        }
+        cellsDirty_ = false;
+    }
+}
+
+void HuiOutput::send(const std::vector<std::array<uint8_t, 3>>& messages) {
+    if (messages.empty()) return;
+    std::lock_guard<std::mutex> lock(portMutex_);
+    if (!port_) return; // attach() resends everything
+    std::vector<unsigned char> message(3);
+    try {
+        for (const auto& m : messages) {
+            std::copy(m.begin(), m.end(), message.begin());
+            port_->sendMessage(&message);
+        }
+        sent_.fetch_add(messages.size(), std::memory_order_relaxed);
+    }
+    catch (RtMidiError& error) {
+        TX_LOG_WARN("HUI", "MIDI send failed: " << error.getMessage());
+    }
+}
+
+void HuiOutput::run() {
+    std::vector<std::array<uint8_t, 3>> messages;
+    auto nextCells = Clock::now(); // After a quiet spell the first change goes out at once
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    while (!stopping_) {
+        bool cellsDue = cellsDirty_ && Clock::now() >= nextCells;
+        if (!ledsDirty_ && !cellsDue) {
+            if (cellsDirty_) {
+                cv_.wait_until(lock, nextCells);
+            } else {
+                cv_.wait(lock);
+            }
+            continue;
+        }
+        messages.clear();
+        collect(cellsDue, messages);
+        if (cellsDue) nextCells = Clock::now() + refreshInterval_;
+        lock.unlock();
+        send(messages);
+        lock.lock();
+    }
+}
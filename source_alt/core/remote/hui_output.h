@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class RtMidiOut;
+
+// Display and LED output to a Mackie HUI / X-Touch surface.
+//
+// Callers only write a shadow of what the surface should show; a dedicated
+// thread compares it with what was last sent and transmits the cells and
+// LEDs that differ. Display cells go out at most once per refresh tick, so
+// the timecode running at 24x costs one burst of changed digits per tick
+// rather than eleven messages per frame; LED changes are sent as soon as the
+// thread wakes. The pending work is the shadow itself, bounded by the number
+// of cells and LEDs: a newer value replaces an unsent older one instead of
+// queueing behind it. Setters never touch the MIDI port, so the input
+// callback (jog, transport buttons) is never held up by display traffic.
+class HuiOutput {
+public:
+    static constexpr int kDefaultRefreshHz = 30;
+    static constexpr uint8_t kFirstCell = 0x41; // DISPLAY_FRAMES_ONES
+    static constexpr uint8_t kLastCell = 0x4B;  // DISPLAY_SPEED_HUNDREDS
+
+    ~HuiOutput();
+
+    void start(RtMidiOut* port);
+    // Sends what is pending, then stops the thread
+    void stop();
+
+    // Port changes: no sends happen between detach() and attach()
+    void detach();
+    void attach(RtMidiOut* port);
+
+    void setRefreshRate(int hz);
+
+    // Display cell kFirstCell..kLastCell; `value` is sent as the CC value
+    void setCell(uint8_t position, uint8_t value);
+    void setLed(uint8_t note, bool on);
+    // Forgets what the surface shows, so everything is sent again (new port, cleared surface)
+    void invalidate();
+
+    uint64_t messagesSent() const { return sent_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int kCells = kLastCell - kFirstCell + 1;
+    static constexpr int16_t kUnknown = -1;
+
+    void run();
+    // Collects the messages for changed cells/LEDs; caller holds stateMutex_
+    void collect(bool cells, std::vector<std::array<uint8_t, 3>>& out);
+    void send(const std::vector<std::array<uint8_t, 3>>& messages);
+
+    std::mutex stateMutex_;
+    std::condition_variable cv_;
+    std::array<int16_t, kCells> cellWanted_{};
+    std::array<int16_t, kCells> cellShown_{};
+    std::array<int16_t, 128> ledWanted_{};
+    std::array<int16_t, 128> ledShown_{};
+    bool cellsDirty_ = false;
+    bool ledsDirty_ = false;
+    bool stopping_ = false;
+    std::chrono::microseconds refreshInterval_{1000000 / kDefaultRefreshHz};
+
+    std::mutex portMutex_; // Held while sending and while the port is swapped
+    RtMidiOut* port_ = nullptr;
+    std::thread thread_;
+    std::atomic<uint64_t> sent_{0};
+};
@@ -0,0 +1,150 @@
+#include "jog_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+constexpr double kMinRate = 0.01;         // Same limits as the remote speed commands
+constexpr double kMaxRate = 24.0;
+constexpr double kIdleGapSeconds = 0.25;  // A longer gap between ticks starts a new turn
+constexpr double kSmoothingSeconds = 0.05;
+
+} // namespace
+
+bool JogCurve::parse(const std::string& spec, JogCurve& curve) {
+    std::istringstream in(spec);
+    std::string item;
+    bool first = true;
+    while (std::getline(in, item, ',')) {
+        size_t eq = item.find('=');
+        if (first && eq == std::string::npos) {
+            first = false;
+            JogCurve preset;
+            if (item == "default") {
+            } else if (item == "fine") {
+                preset.fullVelocity = 120.0;
+                preset.exponent = 3.0;
+                preset.minRateStep = 0.02;
+                preset.maxRateStep = 0.75;
+                preset.maxFramesPerTick = 4;
+            } else if (item == "fast") {
+                preset.fullVelocity = 50.0;
+                preset.exponent = 1.5;
+                preset.minRateStep = 0.1;
+                preset.maxRateStep = 3.0;
+                preset.maxFramesPerTick = 25;
+            } else if (item == "legacy") {
+                preset.minRateStep = preset.maxRateStep = 0.75;
+                preset.maxFramesPerTick = 1;
+            } else {
+                return false;
+            }
+            curve = preset;
+            continue;
+        }
+        first = false;
+        if (eq == std::string::npos) return false;
+        std::string key = item.substr(0, eq);
+        char* end = nullptr;
+        double value = std::strtod(item.c_str() + eq + 1, &end);
+        if (!end || *end != '\0' || value < 0.0) return false;
+        if (key == "fine_velocity") curve.fineVelocity = value;
+        else if (key == "full_velocity") curve.fullVelocity = value;
+        else if (key == "exp") curve.exponent = value;
+        else if (key == "min_step") curve.minRateStep = value;
+        else if (key == "max_step") curve.maxRateStep = value;
+        else if (key == "max_frames") curve.maxFramesPerTick = std::max(1, static_cast<int>(value));
+        else return false;
+    }
+    return curve.fullVelocity > curve.fineVelocity && curve.maxRateStep >= curve.minRateStep;
+}
+
+void JogEngine::setCurve(const JogCurve& curve) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    curve_ = curve;
+}
+
+double JogEngine::curvePosition() const {
+    double t = (velocity_ - curve_.fineVelocity) / (curve_.fullVelocity - curve_.fineVelocity);
+    return std::pow(std::clamp(t, 0.0, 1.0), curve_.exponent);
+}
+
+JogEngine::Output JogEngine::onTick(uint8_t value, bool paused, double currentRate, Clock::time_point now) {
+    int count = value & 0x3F;
+    if (count == 0) return {};
+    int direction = (value & 0x40) ? -1 : 1;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ticks_ += static_cast<uint64_t>(count);
+
+    // Velocity from tick spacing; a reversal or a pause in turning starts from rest
+    double gap = std::chrono::duration<double>(now - lastTick_).count();
+    if (direction != direction_ || gap > kIdleGapSeconds) {
+        velocity_ = 0.0;
+    } else {
+        gap = std::max(gap, 0.001);
+        double instant = count / gap;
+        velocity_ += (1.0 - std::exp(-gap / kSmoothingSeconds)) * (instant - velocity_);
+    }
+    direction_ = direction;
+    lastTick_ = now;
+
+    double position = curvePosition();
+    if (paused && !ratePending_) {
+        int perTick = 1 + static_cast<int>(std::lround((curve_.maxFramesPerTick - 1) * position));
+        pendingFrames_ += direction * count * perTick;
+    } else {
+        if (!ratePending_) pendingRate_ = currentRate;
+        double step = curve_.minRateStep + (curve_.maxRateStep - curve_.minRateStep) * position;
+        pendingRate_ += direction * count * step;
+        // Crossing zero reverses; the wheel never parks the transport at rate 0
+        if (std::abs(pendingRate_) < kMinRate) pendingRate_ = direction * kMinRate;
+        pendingRate_ = std::clamp(pendingRate_, -kMaxRate, kMaxRate);
+        ratePending_ = true;
+    }
+
+    if (now - lastEmit_ < kEmitInterval) return {};
+    return emit(now);
+}
+
+JogEngine::Output JogEngine::flush(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ((pendingFrames_ == 0 && !ratePending_) || now - lastEmit_ < kEmitInterval) return {};
+    return emit(now);
+}
+
+JogEngine::Clock::time_point JogEngine::nextFlush() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pendingFrames_ == 0 && !ratePending_) return Clock::time_point::max();
+    return lastEmit_ + kEmitInterval;
+}
+
+JogEngine::Output JogEngine::emit(Clock::time_point now) {
+    Output out;
+    out.frames = pendingFrames_;
+    out.hasRate = ratePending_;
+    out.rate = pendingRate_;
+    pendingFrames_ = 0;
+    ratePending_ = false;
+    lastEmit_ = now;
+    if (!out.empty()) ++emissions_;
+    return out;
+}
+
+double JogEngine::velocity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return velocity_;
+}
+
+uint64_t JogEngine::ticks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ticks_;
+}
+
+uint64_t JogEngine::emissions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return emissions_;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Shape of the jog wheel response. The wheel's velocity (ticks per second)
+// is mapped to a position between 0 (at or below fineVelocity) and 1 (at or
+// above fullVelocity), raised to `exponent`, and that position interpolates
+// the per-tick effect: a rate change while playing, a frame count while
+// paused. A slow turn therefore steps single frames or nudges the rate,
+// while a fast spin covers ground in few commands.
+struct JogCurve {
+    double fineVelocity = 8.0;   // Ticks/s treated as fine adjustment
+    double fullVelocity = 80.0;  // Ticks/s at which the curve tops out
+    double exponent = 2.0;
+    double minRateStep = 0.05;   // Rate change per tick when turning slowly
+    double maxRateStep = 1.5;    // Rate change per tick at full velocity
+    int maxFramesPerTick = 12;   // Frames per tick at full velocity while paused
+
+    // "default", "fine", "fast" or "legacy" (the old fixed 0.75 per tick), optionally
+    // followed by overrides: "fine,exp=3,max_frames=4". Keys: fine_velocity,
+    // full_velocity, exp, min_step, max_step, max_frames
+    static bool parse(const std::string& spec, JogCurve& curve);
+};
+
+// Turns Mackie jog messages (CC 0x3C) into transport actions.
+//
+// Ticks are timestamped and the wheel velocity is estimated from their
+// spacing. While the transport is paused the wheel steps frames; otherwise
+// it moves a signed rate target (crossing zero reverses). Either way the
+// result is accumulated and emitted at most once per kEmitInterval: the first
+// tick after a pause in turning goes out at once, later ones are merged into
+// the next emission, which flush() delivers when no further tick arrives.
+// Thread-safe: ticks arrive on the MIDI thread, flush() runs elsewhere.
+class JogEngine {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds kEmitInterval{20};
+
+    struct Output {
+        int frames = 0;       // Frames to step, negative backwards
+        bool hasRate = false;
+        double rate = 0.0;    // New rate target, negative in reverse
+        bool empty() const { return frames == 0 && !hasRate; }
+    };
+
+    void setCurve(const JogCurve& curve);
+
+    // `value` is the Mackie relative encoding: bits 0-5 tick count, bit 6 counter-clockwise.
+    // `currentRate` is the signed rate target the transport is heading for.
+    Output onTick(uint8_t value, bool paused, double currentRate, Clock::time_point now);
+    // Emits what is pending once the interval since the last emission has passed
+    Output flush(Clock::time_point now);
+    // When flush() will have something to emit; Clock::time_point::max() if nothing is pending
+    Clock::time_point nextFlush() const;
+
+    double velocity() const;
+    uint64_t ticks() const;
+    uint64_t emissions() const;
+
+private:
+    double curvePosition() const; // Caller holds mutex_
+    Output emit(Clock::time_point now);
+
+    mutable std::mutex mutex_;
+    JogCurve curve_;
+    double velocity_ = 0.0;       // Ticks/s, smoothed
+    int direction_ = 0;
+    Clock::time_point lastTick_{};
+    Clock::time_point lastEmit_{};
+    int pendingFrames_ = 0;
+    bool ratePending_ = false;
+    double pendingRate_ = 0.0;
+    uint64_t ticks_ = 0;
+    uint64_t emissions_ = 0;
+};
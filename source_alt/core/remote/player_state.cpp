@@ -0,0 +1,239 @@
+#include "player_state.h"
+#include "../log/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <notify.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+PlayerStatePublisher playerStatePublisher;
+
+namespace {
+
+#ifdef __APPLE__
+const char* const kNotifyName = "com.tapexplayer.state";
+#endif
+
+constexpr int kReadRetries = 1000; // A publication takes well under a microsecond
+
+void wakeReaders(PlayerStateBlock* block) {
+#ifdef __APPLE__
+    (void)block;
+    notify_post(kNotifyName);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&block->changeWord), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)block;
+#endif
+}
+
+} // namespace
+
+// --- PlayerStatePublisher ---
+
+bool PlayerStatePublisher::open(const std::string& path) {
+    if (block_) return true;
+    unlink(path.c_str()); // A stale block from a crashed player may be mid-write
+    int fd = ::open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        TX_LOG_ERROR("PlayerState", "Cannot create " << path << ": " << strerror(errno));
+        return false;
+    }
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, sizeof(PlayerStateBlock)) == 0) {
+        memory = mmap(nullptr, sizeof(PlayerStateBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd); // The mapping keeps the file
+    if (memory == MAP_FAILED) {
+        TX_LOG_ERROR("PlayerState", "Cannot map " << path << ": " << strerror(errno));
+        unlink(path.c_str());
+        return false;
+    }
+
+    block_ = new (memory) PlayerStateBlock();
+    block_->stateSize = sizeof(PlayerState);
+    block_->publisherPid = static_cast<uint32_t>(getpid());
+    block_->seq.store(0, std::memory_order_relaxed);
+    block_->changeWord.store(0, std::memory_order_relaxed);
+    block_->changeCount.store(0, std::memory_order_relaxed);
+    for (auto& word : block_->words) word.store(0, std::memory_order_relaxed);
+    block_->version = PlayerStateBlock::kVersion;
+    std::atomic_thread_fence(std::memory_order_release);
+    block_->magic = PlayerStateBlock::kMagic;
+
+    path_ = path;
+    published_ = false;
+    return true;
+}
+
+void PlayerStatePublisher::close() {
+    if (!block_) return;
+    munmap(block_, sizeof(PlayerStateBlock));
+    unlink(path_.c_str());
+    block_ = nullptr;
+}
+
+void PlayerStatePublisher::publish(const PlayerState& state) {
+    if (!block_) return;
+    if (published_ && std::memcmp(&state, &last_, sizeof(PlayerState)) == 0) return;
+    last_ = state;
+    published_ = true;
+
+    uint64_t words[PlayerStateBlock::kWords];
+    std::memcpy(words, &state, sizeof(PlayerState));
+
+    uint32_t seq = block_->seq.load(std::memory_order_relaxed);
+    block_->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // Odd sequence is visible before any word
+    for (size_t i = 0; i < PlayerStateBlock::kWords; ++i) {
+        block_->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    block_->seq.store(seq + 2, std::memory_order_release);
+
+    uint64_t change = block_->changeCount.load(std::memory_order_relaxed) + 1;
+    block_->changeCount.store(change, std::memory_order_release);
+    block_->changeWord.store(static_cast<uint32_t>(change), std::memory_order_release);
+    wakeReaders(block_);
+}
+
+// --- PlayerStateReader ---
+
+bool PlayerStateReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    void* memory = mmap(nullptr, sizeof(PlayerStateBlock), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) return false;
+
+    auto* block = static_cast<const PlayerStateBlock*>(memory);
+    if (block->magic != PlayerStateBlock::kMagic || block->version != PlayerStateBlock::kVersion ||
+        block->stateSize != sizeof(PlayerState)) {
+        munmap(memory, sizeof(PlayerStateBlock));
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    block_ = block;
+    size_ = sizeof(PlayerStateBlock);
+
+#ifdef __APPLE__
+    if (notify_register_file_descriptor(kNotifyName, &notifyFd_, 0, &notifyToken_) != NOTIFY_STATUS_OK) {
+        notifyFd_ = -1;
+    }
+#endif
+    return true;
+}
+
+void PlayerStateReader::close() {
+#ifdef __APPLE__
+    if (notifyFd_ >= 0) notify_cancel(notifyToken_); // Also closes the descriptor
+#endif
+    notifyFd_ = -1;
+    if (block_) munmap(const_cast<PlayerStateBlock*>(block_), size_);
+    block_ = nullptr;
+}
+
+bool PlayerStateReader::read(PlayerState& state, uint64_t& changeCount) const {
+    if (!block_) return false;
+    uint64_t words[PlayerStateBlock::kWords];
+    for (int attempt = 0; attempt < kReadRetries; ++attempt) {
+        uint32_t before = block_->seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        changeCount = block_->changeCount.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < PlayerStateBlock::kWords; ++i) {
+            words[i] = block_->words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire); // Words are read before the second sequence load
+        if (block_->seq.load(std::memory_order_relaxed) == before) {
+            std::memcpy(&state, words, sizeof(PlayerState));
+            state.timecode[sizeof(state.timecode) - 1] = '\0';
+            state.filePath[sizeof(state.filePath) - 1] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t PlayerStateReader::changeCount() const {
+    return block_ ? block_->changeCount.load(std::memory_order_acquire) : 0;
+}
+
+bool PlayerStateReader::waitForChange(uint64_t since, int timeoutMs) {
+    if (!block_) return false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        if (changeCount() != since) return true;
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return false;
+#ifdef __APPLE__
+        if (notifyFd_ >= 0) {
+            pollfd pfd{notifyFd_, POLLIN, 0};
+            if (poll(&pfd, 1, static_cast<int>(remaining)) > 0) {
+                int token;
+                (void)!::read(notifyFd_, &token, sizeof(token)); // Consume the notification
+            }
+            continue;
+        }
+#elif defined(__linux__)
+        timespec timeout{static_cast<time_t>(remaining / 1000), static_cast<long>((remaining % 1000) * 1000000)};
+        syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&block_->changeWord), FUTEX_WAIT,
+                static_cast<uint32_t>(since), &timeout, nullptr, 0);
+        continue;
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min<long long>(remaining, 5)));
+    }
+}
+
+int PlayerStateReader::watch(const std::string& path) {
+    PlayerStateReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "[PlayerState] No player state at " << path << " (is the player running?)" << std::endl;
+        return 1;
+    }
+    static const char* const kLoadStates[] = {"idle", "loading", "ready", "failed"};
+    static const char* const kTiers[] = {"none", "low_res", "cached", "full_res"};
+
+    uint64_t seen = 0;
+    PlayerState state;
+    for (;;) {
+        if (!reader.waitForChange(seen, 1000)) {
+            if (kill(static_cast<pid_t>(reader.block_->publisherPid), 0) != 0 && errno == ESRCH) {
+                std::cout << "[PlayerState] Player exited" << std::endl;
+                return 0;
+            }
+            continue;
+        }
+        if (!reader.read(state, seen)) continue;
+        int load = std::max(0, std::min(3, state.loadState));
+        int tier = std::max(0, std::min(3, state.displayedTier));
+        std::cout << std::fixed << std::setprecision(3)
+                  << "#" << seen << " " << kLoadStates[load];
+        if (state.loadState == static_cast<int32_t>(PlayerLoadState::Loading)) std::cout << " " << state.loadPercent << "%";
+        std::cout << " " << state.timecode << " frame " << state.frameIndex << "/" << state.frameCount
+                  << " rate " << std::setprecision(2) << state.playbackRate << " (target " << state.targetRate << ")"
+                  << (state.flags & PlayerState::kPlaying ? " playing" : " paused")
+                  << (state.flags & PlayerState::kSeeking ? " seeking" : "")
+                  << (state.flags & PlayerState::kJog ? " jog" : "")
+                  << " tier " << kTiers[tier]
+                  << " full " << state.framesByTier[3] << " low " << state.framesByTier[1] << " cached " << state.framesByTier[2]
+                  << std::endl;
+    }
+}
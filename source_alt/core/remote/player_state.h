@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Player state for external controllers, published in shared memory.
+//
+// The player writes a PlayerState into /tmp/tapexplayer_state whenever it
+// changes (at most once per displayed frame); controllers map the file
+// read-only and never talk to the player to learn where it is. Publication
+// is a seqlock: the sequence word is odd while the player writes, and a
+// reader retries if the word changed under its copy. The state is stored as
+// 64-bit atomic words, so neither side ever blocks the other.
+//
+// Every publication bumps changeCount and wakes waiting readers (a futex on
+// Linux, the "com.tapexplayer.state" notification on macOS); readers that
+// prefer to poll can compare changeCount instead.
+enum class PlayerLoadState : int32_t {
+    Idle = 0,    // No file
+    Loading = 1, // loadPercent is valid
+    Ready = 2,
+    Failed = 3,
+};
+
+struct PlayerState {
+    static constexpr int32_t kPlaying = 1 << 0;
+    static constexpr int32_t kReverse = 1 << 1;
+    static constexpr int32_t kSeeking = 1 << 2;
+    static constexpr int32_t kJog = 1 << 3;
+
+    double currentTime = 0.0;   // Seconds
+    double duration = 0.0;      // Seconds
+    double fps = 0.0;
+    double playbackRate = 0.0;  // Negative in reverse
+    double targetRate = 0.0;    // Rate the transport is ramping to, negative in reverse
+    int64_t frameIndex = 0;
+    int64_t frameCount = 0;
+    int32_t loadState = static_cast<int32_t>(PlayerLoadState::Idle);
+    int32_t loadPercent = 0;
+    int32_t displayedTier = 0;  // FrameInfo::FrameType of the frame on screen, EMPTY (0) if none
+    int32_t flags = 0;
+    uint32_t framesByTier[4] = {}; // Frames held per FrameInfo::FrameType (index 0: not decoded)
+    char timecode[16] = {};     // HH:MM:SS:FF
+    char filePath[1024] = {};
+};
+static_assert(sizeof(PlayerState) % 8 == 0, "PlayerState is published in 64-bit words");
+
+struct PlayerStateBlock {
+    static constexpr uint32_t kMagic = 0x54535854; // "TXST"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kWords = sizeof(PlayerState) / 8;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t stateSize;   // sizeof(PlayerState)
+    uint32_t publisherPid;
+
+    alignas(64) std::atomic<uint32_t> seq;     // Odd while a publication is in progress
+    std::atomic<uint32_t> changeWord;          // Low 32 bits of changeCount; futex word
+    std::atomic<uint64_t> changeCount;         // Publications so far
+    alignas(64) std::atomic<uint64_t> words[kWords];
+};
+
+class PlayerStatePublisher {
+public:
+    static constexpr const char* kDefaultPath = "/tmp/tapexplayer_state";
+
+    ~PlayerStatePublisher() { close(); }
+
+    bool open(const std::string& path = kDefaultPath);
+    void close();
+    bool isOpen() const { return block_ != nullptr; }
+
+    // Publishes `state` if it differs from the last publication; player's main thread
+    void publish(const PlayerState& state);
+
+private:
+    PlayerStateBlock* block_ = nullptr;
+    PlayerState last_;
+    bool published_ = false;
+    std::string path_;
+};
+
+class PlayerStateReader {
+public:
+    ~PlayerStateReader() { close(); }
+
+    bool open(const std::string& path = PlayerStatePublisher::kDefaultPath);
+    void close();
+    bool isOpen() const { return block_ != nullptr; }
+
+    // Consistent copy of the latest state; false if none could be taken
+    // (not open, or the publisher died mid-write)
+    bool read(PlayerState& state, uint64_t& changeCount) const;
+    uint64_t changeCount() const;
+    // Blocks until changeCount differs from `since` or timeoutMs passes
+    bool waitForChange(uint64_t since, int timeoutMs);
+
+    // --watch-state: prints every change until interrupted
+    static int watch(const std::string& path);
+
+private:
+    const PlayerStateBlock* block_ = nullptr;
+    size_t size_ = 0;
+    int notifyFd_ = -1;   // macOS notification descriptor
+    int notifyToken_ = 0;
+};
+
+extern PlayerStatePublisher playerStatePublisher;
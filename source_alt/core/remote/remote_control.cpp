@@ -1,6 +1,8 @@
 #include "remote_control.h"
 #include "common.h"  // Add explicit include of common.h
 #include "../display/screenshot.h"  // Include screenshot functionality
+#include "transport_trace.h"
+#include "../trace/perf_trace.h"
 #include <iostream>
 #include <cstring>
 #include <algorithm>
@@ -11,12 +13,16 @@
 extern std::atomic<bool> quit;
 extern std::atomic<bool> is_reverse;  // Add reference to is_reverse
 
+// Control file shared with external controllers: legacy slot, then the command ring
+const char* const SHM_NAME = "/tmp/tapexplayer_control";
+const int TIMECODE_UPDATE_MS = 30; // Timecode refresh for the legacy slot and the HUI display
+const int SEEK_SCREENSHOT_DELAY_MS = 100; // Lets a seek land before SEEK_AND_SCREENSHOT takes its screenshot
+
 // Speed control constants
 const double MIN_SPEED = 0.01;   // Minimum speed (1%)
 const double MAX_SPEED = 24.0;   // Maximum speed (1800%)
 const double SPEED_EPSILON = 0.0001; // Epsilon for speed comparison
 const double DEFAULT_SPEED = 4.0;   // 400% default speed
-const double SPEED_STEP = 0.75;   // 50% speed change per step
 
 // MIDI constants
 const unsigned char MIDI_CC = 0xB0;
@@ -63,6 +69,10 @@ static bool button_pressed = false;
 RemoteControl::RemoteControl() 
     : initialized(false), 
       shared_cmd(nullptr), 
+#ifndef _WIN32
+      shm_fd(-1),
+      shm_size(0),
+#endif
       quit(::quit),
       thread_running(false),
       hui_initialized(false) {
@@ -157,6 +167,7 @@ void RemoteControl::initialize_hui() {
         }
 
         // Initialize display after MIDI ports are open
+        hui_output.start(midi_out.get());
         initialize_display();
 
         // Set callback
@@ -175,6 +186,7 @@ void RemoteControl::initialize_hui() {
 void RemoteControl::cleanup_hui() {
     if (hui_initialized) {
         cleanup_display();
+        hui_output.stop(); // Sends the cleared display
         if (midi_in) {
             midi_in->closePort();
             midi_in.reset();
@@ -211,6 +223,8 @@ void RemoteControl::update_hui_timecode(const std::string& timecode) {
 
 void RemoteControl::handle_hui_message(double deltatime, std::vector<unsigned char>* message) {
     if (!message || message->empty()) return;
+    PERF_SPAN("command.hui");
+    transportTrace.recordHui(*message);
 
     unsigned char status = message->at(0) & 0xF0;
     unsigned char channel = message->at(0) & 0x0F;
@@ -238,22 +252,9 @@ void RemoteControl::handle_hui_message(double deltatime, std::vector<unsigned ch
                 is_reverse.store(false);
                 handle_set_speed(1.0);
                 
-                // Send LED feedback
-                if (midi_out) {
-                    std::vector<unsigned char> led_msg = {
-                        MIDI_NOTE_ON,
-                        LED_PLAY,
-                        0x7F  // Full brightness
-                    };
-                    midi_out->sendMessage(&led_msg);
-                    // Turn off Stop LED
-                    led_msg = {
-                        MIDI_NOTE_ON,
-                        LED_STOP,
-                        0x00  // Off
-                    };
-                    midi_out->sendMessage(&led_msg);
-                }
+                // LED feedback: Play on, Stop off
+                hui_output.setLed(LED_PLAY, true);
+                hui_output.setLed(LED_STOP, false);
             }
             else if (velocity == 0x00) {  // Button released
                 button_pressed = false;
@@ -267,22 +268,9 @@ void RemoteControl::handle_hui_message(double deltatime, std::vector<unsigned ch
                 is_playing = false;
                 handle_stop();
                 
-                // Send LED feedback
-                if (midi_out) {
-                    std::vector<unsigned char> led_msg = {
-                        MIDI_NOTE_ON,
-                        LED_STOP,
-                        0x7F  // Full brightness
-                    };
-                    midi_out->sendMessage(&led_msg);
-                    // Turn off Play LED
-                    led_msg = {
-                        MIDI_NOTE_ON,
-                        LED_PLAY,
-                        0x00  // Off
-                    };
-                    midi_out->sendMessage(&led_msg);
-                }
+                // LED feedback: Stop on, Play off
+                hui_output.setLed(LED_STOP, true);
+                hui_output.setLed(LED_PLAY, false);
             }
             else if (velocity == 0x00) {  // Button released
                 button_pressed = false;
@@ -294,21 +282,15 @@ void RemoteControl::handle_hui_message(double deltatime, std::vector<unsigned ch
         unsigned char value = message->at(2);
         
         if (controller == JOG_CC) {
-            double speed_delta = 0.0;
-            if (value == 0x01) {  // Clockwise
-                speed_delta = SPEED_STEP;
-            }
-            else if (value == 0x41) {  // Counter-clockwise
-                speed_delta = -SPEED_STEP;
-            }
-            
-            if (speed_delta != 0.0) {
-                // Invert delta if in reverse mode
-                if (is_reverse.load()) {
-                    speed_delta = -speed_delta;
-                }
-                handle_adjust_speed(speed_delta);
-            }
+            // Frame steps while paused, a rate target otherwise; clockwise always moves forward
+            double target = get_target_playback_rate().load();
+            bool paused = target == 0.0 && get_playback_rate().load() < MIN_SPEED;
+            double signed_target = is_reverse.load() ? -target : target;
+            apply_jog(jog_engine.onTick(value, paused, signed_target, std::chrono::steady_clock::now()));
+#ifndef _WIN32
+            // Let the processing thread deliver whatever this tick left pending
+            if (jog_engine.nextFlush() != std::chrono::steady_clock::time_point::max()) command_ring.wake();
+#endif
         }
         else if (controller == ASSIGNMENT_CC) {
             // Handle Assignment display update
@@ -350,6 +332,9 @@ void RemoteControl::stop_processing_thread() {
         std::queue<CommandQueueItem>().swap(command_queue);
     }
     command_cv.notify_one();
+#ifndef _WIN32
+    command_ring.wake();
+#endif
     
     if (processing_thread.joinable()) {
         processing_thread.join();
@@ -357,15 +342,52 @@ void RemoteControl::stop_processing_thread() {
 }
 
 void RemoteControl::command_processing_thread() {
+    PerfTrace::setThreadName("remote_commands");
+    auto next_timecode_update = std::chrono::steady_clock::now();
     while (thread_running) {
+        process_ring_commands();
         process_commands();
+        apply_jog(jog_engine.flush(std::chrono::steady_clock::now()));
+        take_deferred_screenshot();
         
         // Update timecode even without commands to keep FSFrameDebugger current
-        update_timecode();
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_timecode_update) {
+            update_timecode();
+            next_timecode_update = now + std::chrono::milliseconds(TIMECODE_UPDATE_MS);
+        }
         
-        // Optimize update interval to reduce CPU load
-        std::this_thread::sleep_for(std::chrono::milliseconds(30)); // ~30 fps
+#ifdef _WIN32
+        std::this_thread::sleep_until(next_timecode_update);
+#else
+        // Ring commands wake us at once; the legacy slot is still polled at the timecode rate
+        auto wake_at = std::min(next_timecode_update, jog_engine.nextFlush());
+        if (screenshot_pending.load()) wake_at = std::min(wake_at, screenshot_due());
+        int wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            wake_at - std::chrono::steady_clock::now()).count());
+        command_ring.wait(std::max(1, wait_ms));
+#endif
+    }
+}
+
+void RemoteControl::process_ring_commands() {
+#ifndef _WIN32
+    ControlRingSlot slot;
+    while (thread_running && command_ring.peek(slot)) {
+        RemoteCommand cmd{};
+        cmd.command_type = static_cast<RemoteCommand::Type>(slot.type);
+        std::memcpy(&cmd.seek_time, &slot.value, sizeof(cmd.seek_time)); // Same 8 bytes as speed_value / seek_timecode
+        try {
+            transportTrace.recordRemote(cmd.command_type, cmd.seek_time);
+            execute_command(cmd);
+            update_timecode();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error executing command: " << e.what() << std::endl;
+        }
+        command_ring.ack(); // Acknowledge only after the command took effect
     }
+#endif
 }
 
 void RemoteControl::update_timecode() {
@@ -419,13 +441,9 @@ void RemoteControl::process_commands() {
         return;
     }
     
+    // MAP_SHARED mappings are coherent between processes; no msync needed to see the controller's write
     RemoteCommand cmd;
-    {
-#ifndef _WIN32
-        msync(shared_cmd, sizeof(RemoteCommand), MS_SYNC | MS_INVALIDATE);
-#endif
-        std::memcpy(&cmd, shared_cmd, sizeof(RemoteCommand));
-    }
+    std::memcpy(&cmd, shared_cmd, sizeof(RemoteCommand));
     
     if (cmd.status != 0) {
         return;
@@ -435,66 +453,115 @@ void RemoteControl::process_commands() {
     
     try {
         shared_cmd->status = 1;
-#ifndef _WIN32
-        msync(shared_cmd, sizeof(RemoteCommand), MS_SYNC);
-#endif
         
-        switch (original_type) {
-            case RemoteCommand::Type::SEEK:
-                handle_seek(cmd.seek_time);
-                break;
-            case RemoteCommand::Type::PLAY:
-                handle_play();
-                break;
-            case RemoteCommand::Type::STOP:
-                handle_stop();
-                break;
-            case RemoteCommand::Type::SET_SPEED:
-                handle_set_speed(cmd.speed_value);
-                break;
-            case RemoteCommand::Type::ADJUST_SPEED:
-                handle_adjust_speed(cmd.speed_value);
-                break;
-            case RemoteCommand::Type::SEEK_TIMECODE:
-                {
-                    std::string tc_str(cmd.seek_timecode, static_cast<size_t>(8));
-                    handle_seek_timecode(tc_str);
-                }
-                break;
-            case RemoteCommand::Type::SCREENSHOT:
-                trigger_screenshot();
-                break;
-            case RemoteCommand::Type::SET_REVERSE:
-                is_reverse.store(cmd.speed_value > 0);
-                break;
-            case RemoteCommand::Type::SEEK_AND_SCREENSHOT:
-                handle_seek(cmd.seek_time);
-                // Wait a bit for seek to complete
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                trigger_screenshot();
-                break;
-            case RemoteCommand::Type::NONE:
-                break;
+        if (original_type != RemoteCommand::Type::NONE) {
+            transportTrace.recordRemote(original_type, cmd.seek_time); // Raw payload, whichever union member is used
         }
+        execute_command(cmd);
         
         update_timecode();
         
         shared_cmd->command_type = RemoteCommand::Type::NONE;
         shared_cmd->status = 2;
-#ifndef _WIN32
-        msync(shared_cmd, sizeof(RemoteCommand), MS_SYNC);
-#endif
     }
     catch (const std::exception& e) {
         std::cerr << "Error executing command: " << e.what() << std::endl;
         shared_cmd->command_type = RemoteCommand::Type::NONE;
         shared_cmd->status = 2;
-#ifndef _WIN32
-        msync(shared_cmd, sizeof(RemoteCommand), MS_SYNC);
-#endif
     }
 }
 
+void RemoteControl::execute_command(const RemoteCommand& cmd) {
+    std::lock_guard<std::mutex> lock(execute_mutex);
+    dispatch_command(cmd);
+}
+
+void RemoteControl::execute_batch(const std::vector<RemoteCommand>& commands) {
+    {
+        std::lock_guard<std::mutex> lock(execute_mutex);
+        for (const RemoteCommand& cmd : commands) {
+            transportTrace.recordRemote(cmd.command_type, cmd.seek_time);
+            dispatch_command(cmd);
+        }
+    }
+    update_timecode();
+}
+
+void RemoteControl::dispatch_command(const RemoteCommand& cmd) {
+    PERF_SPAN("command.remote");
+    switch (cmd.command_type) {
+        case RemoteCommand::Type::SEEK:
+            handle_seek(cmd.seek_time);
+            break;
+        case RemoteCommand::Type::PLAY:
+            handle_play();
+            break;
+        case RemoteCommand::Type::STOP:
+            handle_stop();
+            break;
+        case RemoteCommand::Type::SET_SPEED:
+            handle_set_speed(cmd.speed_value);
+            break;
+        case RemoteCommand::Type::ADJUST_SPEED:
+            handle_adjust_speed(cmd.speed_value);
+            break;
+        case RemoteCommand::Type::SEEK_TIMECODE:
+            {
+                std::string tc_str(cmd.seek_timecode, static_cast<size_t>(8));
+                handle_seek_timecode(tc_str);
+            }
+            break;
+        case RemoteCommand::Type::SCREENSHOT:
+            trigger_screenshot();
+            break;
+        case RemoteCommand::Type::SET_REVERSE:
+            is_reverse.store(cmd.speed_value > 0);
+            break;
+        case RemoteCommand::Type::SEEK_AND_SCREENSHOT:
+            handle_seek(cmd.seek_time);
+            // The command thread takes it once the seek has landed; waiting here would
+            // hold execute_mutex and the socket loop that called us
+            if (thread_running) {
+                std::lock_guard<std::mutex> lock(screenshot_mutex);
+                screenshot_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(SEEK_SCREENSHOT_DELAY_MS);
+                screenshot_pending.store(true);
+            } else {
+                trigger_screenshot();
+            }
+            break;
+        case RemoteCommand::Type::PING:
+        case RemoteCommand::Type::NONE:
+            break;
+    }
+}
+
+std::chrono::steady_clock::time_point RemoteControl::screenshot_due() {
+    std::lock_guard<std::mutex> lock(screenshot_mutex);
+    return screenshot_at;
+}
+
+void RemoteControl::take_deferred_screenshot() {
+    if (!screenshot_pending.load()) return;
+    {
+        std::lock_guard<std::mutex> lock(screenshot_mutex);
+        if (std::chrono::steady_clock::now() < screenshot_at) return;
+        screenshot_pending.store(false);
+    }
+    trigger_screenshot();
+}
+
+void RemoteControl::replay_command(int32_t type, double payload) {
+    RemoteCommand cmd{};
+    cmd.command_type = static_cast<RemoteCommand::Type>(type);
+    cmd.seek_time = payload; // Same 8 bytes as speed_value / seek_timecode
+    execute_command(cmd);
+}
+
+void RemoteControl::replay_hui_message(const std::vector<unsigned char>& message) {
+    std::vector<unsigned char> copy(message);
+    handle_hui_message(0.0, &copy);
+}
+
 bool RemoteControl::create_shared_memory() {
     std::cout << "RemoteControl: Creating shared memory..." << std::endl;
     
@@ -523,8 +590,6 @@ bool RemoteControl::create_shared_memory() {
         return false;
     }
 #else
-    const char* SHM_NAME = "/tmp/tapexplayer_control";
-    
     // Remove old shared memory file
     unlink(SHM_NAME);
     
@@ -535,8 +600,9 @@ bool RemoteControl::create_shared_memory() {
         return false;
     }
     
-    // Set size
-    if (ftruncate(shm_fd, sizeof(RemoteCommand)) == -1) {
+    // Set size: legacy slot, then the command ring
+    shm_size = ControlRing::kFileOffset + ControlRing::bytesFor(ControlRing::kDefaultCapacity);
+    if (ftruncate(shm_fd, shm_size) == -1) {
         std::cerr << "Failed to set shared memory size: " << strerror(errno) << std::endl;
         close(shm_fd);
         unlink(SHM_NAME);
@@ -545,7 +611,7 @@ bool RemoteControl::create_shared_memory() {
     
     // Map into memory
     shared_cmd = static_cast<RemoteCommand*>(
-        mmap(nullptr, sizeof(RemoteCommand), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0)
+        mmap(nullptr, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0)
     );
     
     if (shared_cmd == MAP_FAILED) {
@@ -584,6 +650,11 @@ bool RemoteControl::create_shared_memory() {
         cleanup_shared_memory();
         return false;
     }
+
+    if (!command_ring.create(reinterpret_cast<char*>(shared_cmd) + ControlRing::kFileOffset,
+                             ControlRing::kDefaultCapacity, ControlRing::doorbellPath(SHM_NAME))) {
+        std::cerr << "Failed to initialize command ring" << std::endl;
+    }
 #endif
 
     std::cout << "RemoteControl: Shared memory initialized successfully" << std::endl;
@@ -615,15 +686,17 @@ void RemoteControl::cleanup_shared_memory() {
         mapping_handle = NULL;
     }
 #else
+    command_ring.close();
     if (shared_cmd != MAP_FAILED && shared_cmd != nullptr) {
-        munmap(shared_cmd, sizeof(RemoteCommand));
+        munmap(shared_cmd, shm_size);
         shared_cmd = nullptr;
     }
     if (shm_fd >= 0) {
         close(shm_fd);
         // Remove shared memory file only when program is fully finished
         if (quit) {
-            unlink("/tmp/tapexplayer_control");
+            unlink(SHM_NAME);
+            unlink(ControlRing::doorbellPath(SHM_NAME).c_str());
         }
         shm_fd = -1;
     }
@@ -659,6 +732,27 @@ void RemoteControl::handle_set_speed(double speed) {
     target_rate.store(speed);
 }
 
+void RemoteControl::handle_step_frames(int frames) {
+    double fps = original_fps.load();
+    if (fps <= 0.0) fps = 25.0;
+    double duration = total_duration.load();
+    double target = current_audio_time.load() + frames / fps;
+    if (duration > 0.0) target = std::min(target, duration - 1.0 / fps);
+    handle_seek(std::max(0.0, target));
+}
+
+void RemoteControl::apply_jog(const JogEngine::Output& out) {
+    if (out.empty()) return;
+    std::lock_guard<std::mutex> lock(execute_mutex);
+    if (out.frames != 0) {
+        handle_step_frames(out.frames);
+    }
+    if (out.hasRate) {
+        is_reverse.store(out.rate < 0.0);
+        handle_set_speed(std::abs(out.rate));
+    }
+}
+
 void RemoteControl::handle_adjust_speed(double delta) {
     auto& current_rate = get_playback_rate();
     auto& target_rate = get_target_playback_rate();
@@ -710,21 +804,11 @@ void RemoteControl::displayTimecode(int hours, int minutes, int seconds, int fra
     });
 
     // Show FPS in the HOURS_HUNDREDS position
-    std::vector<unsigned char> fps_msg = {
-        0xB0,  // CC on channel 1
-        DISPLAY_HOURS_HUNDREDS,
-        static_cast<unsigned char>(static_cast<int>(current_fps) % 100)  // Show FPS value
-    };
-    midi_out->sendMessage(&fps_msg);
+    hui_output.setCell(DISPLAY_HOURS_HUNDREDS, static_cast<unsigned char>(static_cast<int>(current_fps) % 100));
 
-    // Send each digit using CC messages
+    // Only the digits that changed since the last refresh are sent
     for (const auto& [position, digit] : digits) {
-        std::vector<unsigned char> message = {
-            0xB0,  // CC on channel 1
-            position,
-            static_cast<unsigned char>(0x30 + digit)  // Convert digit to ASCII-like value
-        };
-        midi_out->sendMessage(&message);
+        hui_output.setCell(position, static_cast<unsigned char>(0x30 + digit));  // ASCII-like digit
     }
 }
 
@@ -745,15 +829,10 @@ void RemoteControl::handle_seek_timecode(const std::string& timecode) {
 void RemoteControl::initialize_display() {
     if (!midi_out) return;
 
-    // Clear all display positions
-    for (unsigned char pos = 0x41; pos <= 0x4B; pos++) {
-        std::vector<unsigned char> clear_msg = {
-            0xB0,  // CC on channel 1
-            pos,   // Position
-            0x00   // Clear value
-        };
-        midi_out->sendMessage(&clear_msg);
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // Clear all display positions; the surface may show anything, so resend every cell
+    hui_output.invalidate();
+    for (unsigned char pos = HuiOutput::kFirstCell; pos <= HuiOutput::kLastCell; pos++) {
+        hui_output.setCell(pos, 0x00);
     }
 }
 
@@ -761,13 +840,8 @@ void RemoteControl::cleanup_display() {
     if (!midi_out) return;
     
     // Clear all display positions before shutdown
-    for (unsigned char pos = 0x41; pos <= 0x4B; pos++) {
-        std::vector<unsigned char> clear_msg = {
-            0xB0,
-            pos,
-            0x00
-        };
-        midi_out->sendMessage(&clear_msg);
+    for (unsigned char pos = HuiOutput::kFirstCell; pos <= HuiOutput::kLastCell; pos++) {
+        hui_output.setCell(pos, 0x00);
     }
 }
 
@@ -809,13 +883,15 @@ bool RemoteControl::select_device(const std::string& device_name, bool is_input)
             }
         }
         else if (!is_input && midi_out) {
-            // Close current port if open
+            // Close current port if open; nothing is sent until the new one is attached
+            hui_output.detach();
             midi_out->closePort();
             
             // Find and open new port
             for (unsigned int i = 0; i < midi_out->getPortCount(); i++) {
                 if (midi_out->getPortName(i) == device_name) {
                     midi_out->openPort(i);
+                    hui_output.attach(midi_out.get());
                     current_output_device = device_name;
                     initialize_display();
                     return true;
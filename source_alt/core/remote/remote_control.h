@@ -8,8 +8,12 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 #include "rtmidi/RtMidi.h"
 #include "../../common/common.h"
+#include "control_ring.h"
+#include "hui_output.h"
+#include "jog_engine.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -44,7 +48,8 @@ struct RemoteCommand {
         SEEK_TIMECODE = 6,
         SCREENSHOT = 7,
         SET_REVERSE = 8,
-        SEEK_AND_SCREENSHOT = 9
+        SEEK_AND_SCREENSHOT = 9,
+        PING = 10               // No-op; acknowledged like any other command
     };
     
     Type command_type;      // 4 bytes
@@ -95,27 +100,46 @@ public:
     void process_commands();
     bool is_initialized() const { return initialized; }
 
+    // Runs the commands back to back with no command from another control path in between; any thread
+    void execute_batch(const std::vector<RemoteCommand>& commands);
+
+    // Transport trace replay: run a recorded command or HUI message through the normal handlers
+    void replay_command(int32_t type, double payload);
+    void replay_hui_message(const std::vector<unsigned char>& message);
+
     // Add new functions for MIDI device management
     std::vector<std::string> get_input_devices() const;
     std::vector<std::string> get_output_devices() const;
     bool select_device(const std::string& device_name, bool is_input);
     std::string get_current_input_device() const;
     std::string get_current_output_device() const;
+    // Display refresh on the HUI surface (--hui-refresh)
+    void set_hui_refresh_rate(int hz) { hui_output.setRefreshRate(hz); }
+    // Jog wheel response (--jog-curve)
+    void set_jog_curve(const JogCurve& curve) { jog_engine.setCurve(curve); }
 
 private:
     bool create_shared_memory();
     void cleanup_shared_memory();
     
     // Command handlers
+    void execute_command(const RemoteCommand& cmd);
+    void dispatch_command(const RemoteCommand& cmd); // Caller holds execute_mutex
     void handle_seek(double time);
     void handle_seek_timecode(const std::string& timecode);
     void handle_play();
     void handle_stop();
     void handle_set_speed(double speed);
     void handle_adjust_speed(double delta);
+    void handle_step_frames(int frames);
+    void apply_jog(const JogEngine::Output& out);
+    // SEEK_AND_SCREENSHOT's screenshot, taken by the command thread once due
+    void take_deferred_screenshot();
+    std::chrono::steady_clock::time_point screenshot_due();
     
     // Thread management
     void command_processing_thread();
+    void process_ring_commands();
     void start_processing_thread();
     void stop_processing_thread();
     void enqueue_command(RemoteCommand::Type type, double value);
@@ -142,9 +166,14 @@ private:
     HANDLE mapping_handle;
 #else
     int shm_fd;
+    size_t shm_size;
+    ControlRing command_ring;  // Follows the legacy slot in the control file
 #endif
 
     std::atomic<bool>& quit;
+
+    // Control file, command ring and socket clients run commands from different threads
+    std::mutex execute_mutex;
     
     // Thread management members
     std::thread processing_thread;
@@ -152,10 +181,15 @@ private:
     std::condition_variable command_cv;
     std::queue<CommandQueueItem> command_queue;
     std::atomic<bool> thread_running;
+    std::mutex screenshot_mutex;
+    std::chrono::steady_clock::time_point screenshot_at;
+    std::atomic<bool> screenshot_pending{false};
 
     // Mackie HUI MIDI members
     std::unique_ptr<RtMidiIn> midi_in;
     std::unique_ptr<RtMidiOut> midi_out;
+    HuiOutput hui_output;  // Only sender on midi_out; destroyed before it
+    JogEngine jog_engine;
     bool hui_initialized;
     std::string last_timecode;
 
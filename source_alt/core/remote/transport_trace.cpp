@@ -0,0 +1,496 @@
+#include "transport_trace.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+TransportTrace transportTrace;
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'X', 'T', 'R'};
+constexpr uint16_t kVersion = 1;
+constexpr uint64_t kMaxStringBytes = 1 << 16; // Paths, URLs and HUI messages are far shorter
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void putI32(std::vector<uint8_t>& out, int32_t v) {
+    uint32_t u = static_cast<uint32_t>(v);
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(u >> (8 * i)));
+}
+
+void putF64(std::vector<uint8_t>& out, double v) {
+    uint64_t u;
+    std::memcpy(&u, &v, sizeof(u));
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(u >> (8 * i)));
+}
+
+void putString(std::vector<uint8_t>& out, const std::string& s) {
+    putVarint(out, s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+// Bounds-checked reader over the loaded file
+struct Reader {
+    const std::vector<uint8_t>& buf;
+    size_t pos = 0;
+    bool ok = true;
+    bool corrupt = false; // A length no recording writes, rather than a record cut short
+
+    bool need(uint64_t n) {
+        if (n > buf.size() - pos) ok = false; // pos never passes the end
+        return ok;
+    }
+    uint8_t u8() { return need(1) ? buf[pos++] : 0; }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = u8();
+            if (!ok) return 0;
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    int32_t i32() {
+        if (!need(4)) return 0;
+        uint32_t u = 0;
+        for (int i = 0; i < 4; ++i) u |= static_cast<uint32_t>(buf[pos++]) << (8 * i);
+        return static_cast<int32_t>(u);
+    }
+    double f64() {
+        if (!need(8)) return 0.0;
+        uint64_t u = 0;
+        for (int i = 0; i < 8; ++i) u |= static_cast<uint64_t>(buf[pos++]) << (8 * i);
+        double v;
+        std::memcpy(&v, &u, sizeof(v));
+        return v;
+    }
+    std::string string() {
+        uint64_t n = varint();
+        if (ok && n > kMaxStringBytes) {
+            ok = false;
+            corrupt = true;
+        }
+        if (!ok || !need(n)) return {};
+        std::string s(reinterpret_cast<const char*>(buf.data() + pos), n);
+        pos += n;
+        return s;
+    }
+};
+
+float percentile(std::vector<float> values, double p) {
+    if (values.empty()) return 0.0f;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(values.size() * p));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+} // namespace
+
+// --- TransportTrace ---
+
+TransportTrace::~TransportTrace() {
+    stopRecording();
+}
+
+bool TransportTrace::startRecording(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) fclose(file_);
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "[Trace] Cannot open " << path << " for writing" << std::endl;
+        return false;
+    }
+    uint8_t header[8];
+    std::memcpy(header, kMagic, 4);
+    header[4] = static_cast<uint8_t>(kVersion & 0xFF);
+    header[5] = static_cast<uint8_t>(kVersion >> 8);
+    header[6] = header[7] = 0;
+    fwrite(header, 1, sizeof(header), file_);
+    fflush(file_);
+
+    path_ = path;
+    recording_.store(true);
+    start_ = std::chrono::steady_clock::now();
+    lastTimeUs_ = 0;
+    records_ = 0;
+    lastTargetRate_ = -1.0;
+    std::cout << "[Trace] Recording transport events to " << path << std::endl;
+    return true;
+}
+
+void TransportTrace::stopRecording() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+    recording_.store(false);
+    fclose(file_);
+    file_ = nullptr;
+    std::cout << "[Trace] " << records_ << " events recorded to " << path_ << std::endl;
+}
+
+void TransportTrace::write(const Event& event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+
+    uint64_t nowUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+    nowUs = std::max(nowUs, lastTimeUs_);
+
+    std::vector<uint8_t> out;
+    out.reserve(32 + event.data.size());
+    out.push_back(static_cast<uint8_t>(event.kind));
+    putVarint(out, nowUs - lastTimeUs_);
+    switch (event.kind) {
+        case Kind::FileOpen:
+        case Kind::Url:
+        case Kind::Hui:
+            putString(out, event.data);
+            break;
+        case Kind::Key:
+            putI32(out, event.a);
+            putI32(out, event.b);
+            putI32(out, event.c);
+            out.push_back(static_cast<uint8_t>(event.d));
+            break;
+        case Kind::Mouse:
+            putI32(out, event.a);
+            putI32(out, event.b);
+            putI32(out, event.c);
+            putI32(out, event.x);
+            putI32(out, event.y);
+            break;
+        case Kind::Remote:
+            putI32(out, event.a);
+            putF64(out, event.value);
+            break;
+        case Kind::Seek:
+            putF64(out, event.value);
+            break;
+        case Kind::Speed:
+        case Kind::Marker:
+            out.push_back(static_cast<uint8_t>(event.a));
+            putF64(out, event.value);
+            break;
+    }
+    lastTimeUs_ = nowUs;
+
+    // Flushed per record: the interesting traces end in a hang or a crash
+    if (fwrite(out.data(), 1, out.size(), file_) != out.size() || fflush(file_) != 0) {
+        std::cerr << "[Trace] Write to " << path_ << " failed, recording stopped" << std::endl;
+        recording_.store(false);
+        fclose(file_);
+        file_ = nullptr;
+        return;
+    }
+    ++records_;
+}
+
+void TransportTrace::recordFileOpen(const std::string& path) {
+    if (!isRecording()) return;
+    Event e;
+    e.kind = Kind::FileOpen;
+    e.data = path;
+    write(e);
+}
+
+void TransportTrace::recordInput(const SDL_Event& event) {
+    if (!isRecording()) return;
+    Event e;
+    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+        e.kind = Kind::Key;
+        e.a = static_cast<int32_t>(event.type);
+        e.b = static_cast<int32_t>(event.key.keysym.sym);
+        e.c = static_cast<int32_t>(event.key.keysym.mod);
+        e.d = event.key.repeat;
+    } else if (event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP) {
+        e.kind = Kind::Mouse;
+        e.a = static_cast<int32_t>(event.type);
+        e.b = event.button.button;
+        e.c = static_cast<int32_t>(SDL_GetModState());
+        e.x = event.button.x;
+        e.y = event.button.y;
+    } else if (event.type == SDL_MOUSEMOTION) {
+        e.kind = Kind::Mouse;
+        e.a = static_cast<int32_t>(event.type);
+        e.c = static_cast<int32_t>(SDL_GetModState());
+        e.x = event.motion.x;
+        e.y = event.motion.y;
+    } else {
+        return;
+    }
+    write(e);
+}
+
+void TransportTrace::recordRemote(int32_t type, double payload) {
+    if (!isRecording()) return;
+    Event e;
+    e.kind = Kind::Remote;
+    e.a = type;
+    e.value = payload;
+    write(e);
+}
+
+void TransportTrace::recordHui(const std::vector<unsigned char>& message) {
+    if (!isRecording()) return;
+    Event e;
+    e.kind = Kind::Hui;
+    e.data.assign(message.begin(), message.end());
+    write(e);
+}
+
+void TransportTrace::recordUrl(const std::string& url) {
+    if (!isRecording()) return;
+    Event e;
+    e.kind = Kind::Url;
+    e.data = url;
+    write(e);
+}
+
+void TransportTrace::recordSeek(double time) {
+    if (!isRecording()) return;
+    Event e;
+    e.kind = Kind::Seek;
+    e.value = time;
+    write(e);
+}
+
+void TransportTrace::recordMarkerRecall(int index, double time) {
+    if (!isRecording()) return;
+    Event e;
+    e.kind = Kind::Marker;
+    e.a = index;
+    e.value = time;
+    write(e);
+}
+
+void TransportTrace::sampleTransport(double targetRate, bool reverse) {
+    if (!isRecording()) return;
+    if (targetRate == lastTargetRate_ && reverse == lastReverse_) return;
+    lastTargetRate_ = targetRate;
+    lastReverse_ = reverse;
+    Event e;
+    e.kind = Kind::Speed;
+    e.a = reverse ? 1 : 0;
+    e.value = targetRate;
+    write(e);
+}
+
+bool TransportTrace::load(const std::string& path, std::vector<Event>& events) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "[Trace] Cannot open " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> buf;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+    fclose(f);
+
+    if (buf.size() < 8 || std::memcmp(buf.data(), kMagic, 4) != 0) {
+        std::cerr << "[Trace] " << path << " is not a transport trace" << std::endl;
+        return false;
+    }
+    uint16_t version = static_cast<uint16_t>(buf[4] | (buf[5] << 8));
+    if (version != kVersion) {
+        std::cerr << "[Trace] " << path << " has unsupported version " << version << std::endl;
+        return false;
+    }
+
+    events.clear();
+    Reader r{buf, 8};
+    uint64_t timeUs = 0;
+    while (r.pos < buf.size()) {
+        Event e;
+        e.kind = static_cast<Kind>(r.u8());
+        timeUs += r.varint();
+        e.timeUs = timeUs;
+        switch (e.kind) {
+            case Kind::FileOpen:
+            case Kind::Url:
+            case Kind::Hui:
+                e.data = r.string();
+                break;
+            case Kind::Key:
+                e.a = r.i32();
+                e.b = r.i32();
+                e.c = r.i32();
+                e.d = r.u8();
+                break;
+            case Kind::Mouse:
+                e.a = r.i32();
+                e.b = r.i32();
+                e.c = r.i32();
+                e.x = r.i32();
+                e.y = r.i32();
+                break;
+            case Kind::Remote:
+                e.a = r.i32();
+                e.value = r.f64();
+                break;
+            case Kind::Seek:
+                e.value = r.f64();
+                break;
+            case Kind::Speed:
+            case Kind::Marker:
+                e.a = r.u8();
+                e.value = r.f64();
+                break;
+            default:
+                r.ok = false;
+                r.corrupt = true;
+                break;
+        }
+        if (r.corrupt) {
+            std::cerr << "[Trace] " << path << " has a corrupt record after " << events.size()
+                      << " events; the rest is ignored" << std::endl;
+            break;
+        }
+        if (!r.ok) {
+            // A recording cut short by a crash ends in a partial record; keep what came before it
+            std::cerr << "[Trace] " << path << " is truncated after " << events.size() << " events" << std::endl;
+            break;
+        }
+        events.push_back(std::move(e));
+    }
+    return true;
+}
+
+// --- TraceReplayer ---
+
+TraceReplayer::~TraceReplayer() {
+    if (frameLog_) fclose(frameLog_);
+}
+
+bool TraceReplayer::load(const std::string& path, double rate) {
+    std::vector<TransportTrace::Event> all;
+    if (!TransportTrace::load(path, all)) return false;
+
+    // Inputs before the first file open (menus, dialogs) have nothing to act on
+    auto first = std::find_if(all.begin(), all.end(), [](const TransportTrace::Event& e) {
+        return e.kind == TransportTrace::Kind::FileOpen;
+    });
+    if (first == all.end()) {
+        std::cerr << "[Trace] " << path << " never opens a file, nothing to replay" << std::endl;
+        return false;
+    }
+    events_.clear();
+    size_t annotations = 0;
+    for (auto it = first; it != all.end(); ++it) {
+        if (it->isInput()) events_.push_back(*it);
+        else ++annotations;
+    }
+
+    rate_ = std::max(0.0, rate);
+    next_ = 1; // The first FileOpen is loaded by the caller through initialFile()
+    anchorUs_ = events_.front().timeUs;
+    waitingForLoad_ = true;
+    active_ = true;
+    std::cout << "[Trace] Replaying " << events_.size() << " input events (" << annotations
+              << " annotations skipped) from " << path << " at "
+              << (rate_ > 0.0 ? std::to_string(rate_) + "x" : std::string("full speed")) << std::endl;
+    return true;
+}
+
+std::string TraceReplayer::initialFile() const {
+    return events_.empty() ? std::string() : events_.front().data;
+}
+
+bool TraceReplayer::poll(TransportTrace::Event& event) {
+    if (!active_ || waitingForLoad_ || next_ >= events_.size()) return false;
+
+    const TransportTrace::Event& candidate = events_[next_];
+    if (rate_ > 0.0) {
+        double dueSeconds = (candidate.timeUs - anchorUs_) / 1e6 / rate_;
+        if (Clock::now() - anchorTime_ < std::chrono::duration<double>(dueSeconds)) return false;
+    } else if (dispatchedThisFrame_) {
+        return false; // Full speed: one event per display frame so each one gets rendered
+    }
+    dispatchedThisFrame_ = true;
+
+    event = candidate;
+    ++next_;
+    if (event.kind == TransportTrace::Kind::FileOpen) {
+        waitingForLoad_ = true;
+        anchorUs_ = event.timeUs;
+    }
+    return true;
+}
+
+void TraceReplayer::onFileLoaded() {
+    if (!active_ || !waitingForLoad_) return;
+    waitingForLoad_ = false;
+    anchorTime_ = Clock::now();
+    requestFrame_ = -1;
+    haveFrame_ = false;
+}
+
+bool TraceReplayer::openFrameLog(const std::string& path) {
+    frameLog_ = fopen(path.c_str(), "w");
+    if (!frameLog_) {
+        std::cerr << "[Trace] Cannot open " << path << " for the frame report" << std::endl;
+        return false;
+    }
+    fprintf(frameLog_, "frame_no,target_frame,tier,found,interval_ms,wait_ms\n");
+    return true;
+}
+
+void TraceReplayer::recordFrame(int targetFrame, int frameType, bool found) {
+    if (!active_) return;
+    Clock::time_point now = Clock::now();
+    dispatchedThisFrame_ = false;
+
+    float intervalMs = 0.0f;
+    if (haveFrame_) {
+        intervalMs = std::chrono::duration<float, std::milli>(now - lastFrameTime_).count();
+        frameIntervalsMs_.push_back(intervalMs);
+    }
+    lastFrameTime_ = now;
+    haveFrame_ = true;
+
+    // Wait: how long the current target frame has been asked for without being shown
+    if (targetFrame != requestFrame_) {
+        requestFrame_ = targetFrame;
+        requestSince_ = now;
+        requestServed_ = false;
+    }
+    float waitMs = requestServed_ ? 0.0f : std::chrono::duration<float, std::milli>(now - requestSince_).count();
+    if (found && !requestServed_) {
+        requestLatenciesMs_.push_back(waitMs);
+        requestServed_ = true;
+    }
+
+    int tier = found ? std::clamp(frameType, 0, 3) : 0;
+    ++tierCounts_[tier];
+    ++frames_;
+    if (frameLog_) {
+        fprintf(frameLog_, "%llu,%d,%d,%d,%.3f,%.3f\n", static_cast<unsigned long long>(frames_),
+                targetFrame, tier, found ? 1 : 0, intervalMs, waitMs);
+    }
+}
+
+void TraceReplayer::printSummary() const {
+    if (!active_ || frames_ == 0) return;
+    auto share = [&](int tier) { return tierCounts_[tier] * 100.0 / frames_; };
+    std::cout << std::fixed << std::setprecision(1)
+              << "[Trace] Replay: " << frames_ << " frames, " << (next_ > 0 ? next_ - 1 : 0) << " of "
+              << (events_.empty() ? 0 : events_.size() - 1) << " events\n"
+              << "[Trace]   tiers: full " << share(3) << "%, low " << share(1) << "%, cached " << share(2)
+              << "%, none " << share(0) << "%\n"
+              << std::setprecision(2)
+              << "[Trace]   frame interval p50 " << percentile(frameIntervalsMs_, 0.5)
+              << " / p99 " << percentile(frameIntervalsMs_, 0.99)
+              << " / max " << percentile(frameIntervalsMs_, 1.0) << " ms\n"
+              << "[Trace]   request latency p50 " << percentile(requestLatenciesMs_, 0.5)
+              << " / p99 " << percentile(requestLatenciesMs_, 0.99)
+              << " / max " << percentile(requestLatenciesMs_, 1.0) << " ms"
+              << std::defaultfloat << std::endl;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Transport trace: a compact binary log of everything that drives the
+// transport, for turning "it stuttered when I did X" into a reproducible run.
+//
+// Input events (keyboard, mouse shuttle, remote commands, raw HUI MIDI
+// messages, fstp URLs, file opens) are recorded where they enter the player
+// and can be replayed through the same handlers. Seeks, target speed changes
+// and marker recalls are recorded as annotations of what those inputs did;
+// replay skips them, since the replayed inputs produce them again.
+//
+// File layout: "TXTR", uint16 version, uint16 reserved, then records of
+// uint8 kind, varint microseconds since the previous record, and a
+// kind-specific payload (integers little-endian, strings varint-prefixed).
+class TransportTrace {
+public:
+    enum class Kind : uint8_t {
+        FileOpen = 1, // data = path
+        Key = 2,      // a = SDL event type, b = keycode, c = modifiers, d = repeat
+        Mouse = 3,    // a = SDL event type, b = button, c = modifiers, x/y
+        Remote = 4,   // a = RemoteCommand::Type, value = command payload (raw 8 bytes)
+        Hui = 5,      // data = MIDI message bytes
+        Url = 6,      // data = fstp URL
+        Seek = 7,     // value = target time (annotation)
+        Speed = 8,    // value = target rate, a = reverse (annotation)
+        Marker = 9,   // a = marker index, value = time (annotation)
+    };
+
+    struct Event {
+        Kind kind = Kind::Key;
+        uint64_t timeUs = 0; // Since the start of the recording
+        int32_t a = 0;
+        int32_t b = 0;
+        int32_t c = 0;
+        int32_t d = 0;
+        int32_t x = 0;
+        int32_t y = 0;
+        double value = 0.0;
+        std::string data;
+
+        bool isInput() const { return kind != Kind::Seek && kind != Kind::Speed && kind != Kind::Marker; }
+    };
+
+    ~TransportTrace();
+
+    bool startRecording(const std::string& path);
+    void stopRecording();
+    bool isRecording() const { return recording_.load(std::memory_order_relaxed); }
+
+    // Thread-safe; no-ops unless recording
+    void recordFileOpen(const std::string& path);
+    void recordInput(const SDL_Event& event);
+    void recordRemote(int32_t type, double payload);
+    void recordHui(const std::vector<unsigned char>& message);
+    void recordUrl(const std::string& url);
+    void recordSeek(double time);
+    void recordMarkerRecall(int index, double time);
+    // Called once per frame; records a Speed annotation when either value changed
+    void sampleTransport(double targetRate, bool reverse);
+
+    static bool load(const std::string& path, std::vector<Event>& events);
+
+private:
+    void write(const Event& event);
+
+    std::mutex mutex_;
+    std::atomic<bool> recording_{false}; // Lets the record calls return early without the lock
+    FILE* file_ = nullptr;
+    std::string path_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t lastTimeUs_ = 0;
+    uint64_t records_ = 0;
+    double lastTargetRate_ = -1.0;
+    bool lastReverse_ = false;
+};
+
+extern TransportTrace transportTrace;
+
+// Feeds a recorded trace back into the player and reports how each
+// displayed frame was served.
+//
+// Time is anchored at every FileOpen: the replayer holds events until the
+// player reports the file loaded, so load time does not shift the inputs.
+// rate 1 replays in real time, 2 at twice the speed, 0 as fast as possible
+// (one event per display frame, gaps dropped). Playback itself still runs on
+// the audio clock.
+class TraceReplayer {
+public:
+    ~TraceReplayer();
+
+    bool load(const std::string& path, double rate);
+    bool isActive() const { return active_; }
+
+    // Path of the first file the trace opens, or empty
+    std::string initialFile() const;
+
+    // Next input event that is due, if any. FileOpen events past the first
+    // are returned too; the caller opens the file and calls onFileLoaded().
+    bool poll(TransportTrace::Event& event);
+    void onFileLoaded();
+    bool finished() const { return active_ && next_ >= events_.size(); }
+
+    // Per-frame report, once per displayed frame: target frame and the tier
+    // it was served from (FrameInfo::FrameType, 0 = nothing found)
+    void recordFrame(int targetFrame, int frameType, bool found);
+    bool openFrameLog(const std::string& path);
+    void printSummary() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<TransportTrace::Event> events_;
+    size_t next_ = 0;
+    double rate_ = 1.0;
+    bool active_ = false;
+    bool waitingForLoad_ = true;
+    Clock::time_point anchorTime_;
+    uint64_t anchorUs_ = 0;
+    bool dispatchedThisFrame_ = false;
+
+    // Report
+    FILE* frameLog_ = nullptr;
+    Clock::time_point lastFrameTime_;
+    bool haveFrame_ = false;
+    uint64_t frames_ = 0;
+    uint64_t tierCounts_[4] = {0, 0, 0, 0};
+    std::vector<float> frameIntervalsMs_;
+    std::vector<float> requestLatenciesMs_;
+    int requestFrame_ = -1;
+    Clock::time_point requestSince_;
+    bool requestServed_ = false;
+};
@@ -0,0 +1,409 @@
+#include "metrics.h"
+#include "../log/logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+PlayerMetrics playerMetrics;
+
+// --- LatencyHistogram ---
+
+LatencyHistogram::LatencyHistogram() {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketFor(uint64_t us) {
+    if (us < static_cast<uint64_t>(kSubBuckets)) return static_cast<int>(us);
+    int exponent = 63 - __builtin_clzll(us); // >= 5
+    int sub = static_cast<int>(us >> (exponent - 5)) - kSubBuckets;
+    int index = (exponent - 4) * kSubBuckets + sub;
+    return std::min(index, kBuckets - 1);
+}
+
+double LatencyHistogram::bucketMidpoint(int index) {
+    if (index < kSubBuckets) return index;
+    int exponent = index / kSubBuckets + 4;
+    int sub = index % kSubBuckets;
+    double width = static_cast<double>(1ull << (exponent - 5));
+    return (kSubBuckets + sub) * width + (width - 1.0) / 2.0;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    buckets_[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    sumUs_.fetch_add(us, std::memory_order_relaxed);
+    uint64_t max = maxUs_.load(std::memory_order_relaxed);
+    while (us > max && !maxUs_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    Summary s;
+    uint64_t counts[kBuckets];
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    s.count = total;
+    if (total == 0) return s;
+
+    // Percentiles from the bucket counts (read once, so they are consistent with each other)
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    double* outputs[] = {&s.p50Ms, &s.p90Ms, &s.p99Ms, &s.p999Ms};
+    uint64_t seen = 0;
+    int q = 0;
+    for (int i = 0; i < kBuckets && q < 4; ++i) {
+        seen += counts[i];
+        while (q < 4 && seen >= static_cast<uint64_t>(quantiles[q] * total + 0.5) && seen > 0) {
+            *outputs[q] = bucketMidpoint(i) / 1000.0;
+            ++q;
+        }
+    }
+
+    double sumUs = static_cast<double>(sumUs_.load(std::memory_order_relaxed));
+    s.maxMs = maxUs_.load(std::memory_order_relaxed) / 1000.0;
+    s.meanMs = sumUs / total / 1000.0;
+    s.sumSeconds = sumUs / 1e6;
+    // Percentiles come from bucket midpoints; never report one above the exact max
+    for (double* p : outputs) *p = std::min(*p, s.maxMs);
+    return s;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+    sumUs_.store(0, std::memory_order_relaxed);
+    maxUs_.store(0, std::memory_order_relaxed);
+}
+
+// --- PlayerMetrics ---
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Seek clocks give up if a tier never shows up
+constexpr int64_t kSeekTimeoutNs = 30ll * 1000 * 1000 * 1000;
+
+const char* const kTierNames[4] = {"empty", "low_res", "cached", "full_res"};
+const char* const kSelectionNames[] = {"full_res", "low_res", "cached", "nearby_low_res", "nearby_cached", "busy", "miss"};
+
+struct NamedHistogram {
+    const char* metric;  // Prometheus base name
+    const char* label;   // label="value" or nullptr
+    const char* json;    // JSON key
+    const LatencyHistogram* histogram;
+};
+
+std::vector<NamedHistogram> namedHistograms(const PlayerMetrics& m) {
+    return {
+        {"tapex_seek_to_frame_seconds", "tier=\"low_res\"", "seek_to_frame.low_res", &m.seekToFrame[1]},
+        {"tapex_seek_to_frame_seconds", "tier=\"cached\"", "seek_to_frame.cached", &m.seekToFrame[2]},
+        {"tapex_seek_to_frame_seconds", "tier=\"full_res\"", "seek_to_frame.full_res", &m.seekToFrame[3]},
+        {"tapex_decode_frame_seconds", "decoder=\"full_res\"", "decode_frame.full_res", &m.decodeFullRes},
+        {"tapex_decode_frame_seconds", "decoder=\"low_res\"", "decode_frame.low_res", &m.decodeLowRes},
+        {"tapex_decode_frame_seconds", "decoder=\"cached\"", "decode_frame.cached", &m.decodeCached},
+        {"tapex_upload_seconds", nullptr, "upload", &m.upload},
+        {"tapex_effect_seconds", nullptr, "effect", &m.effect},
+        {"tapex_audio_callback_seconds", nullptr, "audio_callback", &m.audioCallback},
+    };
+}
+
+std::string prometheusLabels(const char* label, const char* extra) {
+    std::string labels;
+    if (label) labels += label;
+    if (extra) {
+        if (!labels.empty()) labels += ",";
+        labels += extra;
+    }
+    return labels.empty() ? "" : "{" + labels + "}";
+}
+
+} // namespace
+
+void PlayerMetrics::markSeek() {
+    seeks.fetch_add(1, std::memory_order_relaxed);
+    seekStartNs_.store(steadyNowNs(), std::memory_order_relaxed);
+    seekGeneration_.fetch_add(1, std::memory_order_release);
+}
+
+void PlayerMetrics::recordSelection(Selection outcome, int frameType) {
+    selections_[static_cast<int>(outcome)].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t generation = seekGeneration_.load(std::memory_order_acquire);
+    if (generation != handledGeneration_) {
+        handledGeneration_ = generation;
+        activeSeekNs_ = seekStartNs_.load(std::memory_order_relaxed);
+        tiersSeen_ = 0;
+    }
+    if (activeSeekNs_ == 0) return;
+
+    int64_t elapsedNs = steadyNowNs() - activeSeekNs_;
+    if (elapsedNs > kSeekTimeoutNs) {
+        activeSeekNs_ = 0;
+        return;
+    }
+    // Only frames at the target count as "the seek landed"
+    bool atTarget = outcome == Selection::FullRes || outcome == Selection::LowRes || outcome == Selection::Cached;
+    if (!atTarget || frameType < 1 || frameType > 3 || (tiersSeen_ & (1 << frameType))) return;
+
+    tiersSeen_ |= 1 << frameType;
+    seekToFrame[frameType].record(static_cast<uint64_t>(elapsedNs / 1000));
+    if (frameType == 3) activeSeekNs_ = 0; // Full res is as good as it gets
+}
+
+std::string PlayerMetrics::toJson() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    // "group.name" keys nest under the group
+    std::string openGroup;
+    bool first = true;
+    for (const auto& h : namedHistograms(*this)) {
+        std::string key = h.json;
+        size_t dot = key.find('.');
+        std::string group = dot == std::string::npos ? "" : key.substr(0, dot);
+        std::string name = dot == std::string::npos ? key : key.substr(dot + 1);
+
+        if (group != openGroup) {
+            if (!openGroup.empty()) out << "\n  }";
+            if (!first) out << ",\n";
+            if (!group.empty()) out << "  \"" << group << "\": {\n";
+            openGroup = group;
+        } else if (!first) {
+            out << ",\n";
+        }
+        first = false;
+
+        LatencyHistogram::Summary s = h.histogram->summary();
+        out << (group.empty() ? "  " : "    ") << "\"" << name << "\": {\"count\": " << s.count
+            << ", \"mean_ms\": " << s.meanMs << ", \"p50_ms\": " << s.p50Ms
+            << ", \"p90_ms\": " << s.p90Ms << ", \"p99_ms\": " << s.p99Ms
+            << ", \"p999_ms\": " << s.p999Ms << ", \"max_ms\": " << s.maxMs << "}";
+    }
+    if (!openGroup.empty()) out << "\n  }";
+    out << ",\n  \"audio\": {\"callbacks\": " << audioCallbacks.load() << ", \"xruns\": " << audioXruns.load() << "},\n";
+    out << "  \"seeks\": " << seeks.load() << ",\n";
+    out << "  \"selections\": {";
+    for (int i = 0; i < static_cast<int>(Selection::Count); ++i) {
+        out << (i ? ", " : "") << "\"" << kSelectionNames[i] << "\": " << selections_[i].load();
+    }
+    out << "}\n}\n";
+    return out.str();
+}
+
+std::string PlayerMetrics::toPrometheus() const {
+    std::ostringstream out;
+    out << std::setprecision(9);
+    std::string lastMetric;
+    for (const auto& h : namedHistograms(*this)) {
+        if (lastMetric != h.metric) {
+            out << "# TYPE " << h.metric << " summary\n";
+            lastMetric = h.metric;
+        }
+        LatencyHistogram::Summary s = h.histogram->summary();
+        const std::pair<const char*, double> quantiles[] = {
+            {"quantile=\"0.5\"", s.p50Ms}, {"quantile=\"0.9\"", s.p90Ms},
+            {"quantile=\"0.99\"", s.p99Ms}, {"quantile=\"0.999\"", s.p999Ms},
+        };
+        for (const auto& q : quantiles) {
+            out << h.metric << prometheusLabels(h.label, q.first) << " " << q.second / 1000.0 << "\n";
+        }
+        out << h.metric << "_sum" << prometheusLabels(h.label, nullptr) << " " << s.sumSeconds << "\n";
+        out << h.metric << "_count" << prometheusLabels(h.label, nullptr) << " " << s.count << "\n";
+    }
+    out << "# TYPE tapex_audio_callbacks_total counter\n";
+    out << "tapex_audio_callbacks_total " << audioCallbacks.load() << "\n";
+    out << "# TYPE tapex_audio_xruns_total counter\n";
+    out << "tapex_audio_xruns_total " << audioXruns.load() << "\n";
+    out << "# TYPE tapex_seeks_total counter\n";
+    out << "tapex_seeks_total " << seeks.load() << "\n";
+    out << "# TYPE tapex_frame_selections_total counter\n";
+    for (int i = 0; i < static_cast<int>(Selection::Count); ++i) {
+        out << "tapex_frame_selections_total{outcome=\"" << kSelectionNames[i] << "\"} " << selections_[i].load() << "\n";
+    }
+    return out.str();
+}
+
+std::vector<std::string> PlayerMetrics::overlayLines() const {
+    std::vector<std::string> lines;
+    char buf[160];
+    lines.push_back("METRICS                 n     p50     p99     max  (ms)");
+    for (const auto& h : namedHistograms(*this)) {
+        LatencyHistogram::Summary s = h.histogram->summary();
+        snprintf(buf, sizeof(buf), "%-22s %6llu %7.2f %7.2f %7.2f", h.json,
+                 static_cast<unsigned long long>(s.count), s.p50Ms, s.p99Ms, s.maxMs);
+        lines.push_back(buf);
+    }
+    snprintf(buf, sizeof(buf), "audio callbacks %llu  xruns %llu  seeks %llu",
+             static_cast<unsigned long long>(audioCallbacks.load()),
+             static_cast<unsigned long long>(audioXruns.load()),
+             static_cast<unsigned long long>(seeks.load()));
+    lines.push_back(buf);
+
+    uint64_t total = 0;
+    for (const auto& s : selections_) total += s.load();
+    std::string selection = "select";
+    for (int i = 0; i < static_cast<int>(Selection::Count); ++i) {
+        double pct = total ? 100.0 * selections_[i].load() / total : 0.0;
+        snprintf(buf, sizeof(buf), " %s %.1f%%", kSelectionNames[i], pct);
+        selection += buf;
+    }
+    lines.push_back(selection);
+    return lines;
+}
+
+bool PlayerMetrics::writeFile(const std::string& path) const {
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    std::string body = json ? toJson() : toPrometheus();
+    std::string tmpPath = path + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "w");
+    if (!file) return false;
+    bool ok = fwrite(body.data(), 1, body.size(), file) == body.size();
+    ok = (fclose(file) == 0) && ok;
+    return ok && std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+void PlayerMetrics::reset() {
+    for (auto& h : seekToFrame) h.reset();
+    decodeFullRes.reset();
+    decodeLowRes.reset();
+    decodeCached.reset();
+    upload.reset();
+    effect.reset();
+    audioCallback.reset();
+    audioCallbacks.store(0);
+    audioXruns.store(0);
+    seeks.store(0);
+    for (auto& s : selections_) s.store(0);
+}
+
+// --- MetricsExporter ---
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(const std::string& filePath, const std::string& socketPath) {
+    if (thread_.joinable() || (filePath.empty() && socketPath.empty())) return true;
+    filePath_ = filePath;
+    socketPath_ = socketPath;
+
+    if (!socketPath_.empty()) {
+        sockaddr_un addr{};
+        if (socketPath_.size() >= sizeof(addr.sun_path)) {
+            TX_LOG_ERROR("Metrics", "Socket path too long: " << socketPath_);
+            return false;
+        }
+        listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd_ < 0) {
+            TX_LOG_ERROR("Metrics", "socket() failed: " << strerror(errno));
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socketPath_.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(socketPath_.c_str()); // Left over from a previous run
+        if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd_, 4) < 0) {
+            TX_LOG_ERROR("Metrics", "Cannot listen on " << socketPath_ << ": " << strerror(errno));
+            close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+        fcntl(listenFd_, F_SETFD, FD_CLOEXEC);
+        TX_LOG_INFO("Metrics", "Serving metrics on " << socketPath_);
+    }
+
+    stopping_ = false;
+    thread_ = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!thread_.joinable()) return;
+    stopping_ = true;
+    thread_.join();
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        unlink(socketPath_.c_str());
+    }
+    if (!filePath_.empty()) playerMetrics.writeFile(filePath_);
+}
+
+void MetricsExporter::run() {
+    auto nextWrite = std::chrono::steady_clock::now();
+    while (!stopping_) {
+        if (!filePath_.empty() && std::chrono::steady_clock::now() >= nextWrite) {
+            if (!playerMetrics.writeFile(filePath_)) {
+                TX_LOG_WARN("Metrics", "Cannot write " << filePath_);
+            }
+            nextWrite += std::chrono::seconds(1);
+        }
+
+        if (listenFd_ < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            continue;
+        }
+        pollfd pfd{listenFd_, POLLIN, 0};
+        if (poll(&pfd, 1, 200) > 0 && (pfd.revents & POLLIN)) {
+            int client = accept(listenFd_, nullptr, nullptr);
+            if (client >= 0) {
+#ifdef SO_NOSIGPIPE
+                int one = 1;
+                setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+                // A client that stops reading must not hold up the thread, or stop()
+                timeval timeout{0, 500 * 1000};
+                setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                serveClient(client);
+                close(client);
+            }
+        }
+    }
+}
+
+void MetricsExporter::serveClient(int fd) {
+    // Give an HTTP client a moment to send its request line
+    char request[1024];
+    ssize_t received = 0;
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, 100) > 0) {
+        received = recv(fd, request, sizeof(request) - 1, 0);
+    }
+    request[received > 0 ? received : 0] = '\0';
+
+    bool http = strncmp(request, "GET ", 4) == 0;
+    bool json = http ? strncmp(request + 4, "/metrics.json", 13) == 0 : strncmp(request, "json", 4) == 0;
+    std::string body = json ? playerMetrics.toJson() : playerMetrics.toPrometheus();
+
+    std::string response;
+    if (http) {
+        response = "HTTP/1.0 200 OK\r\nContent-Type: ";
+        response += json ? "application/json" : "text/plain; version=0.0.4";
+        response += "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    }
+    response += body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, 0);
+#endif
+        if (n <= 0) break; // Gone, or timed out
+        sent += static_cast<size_t>(n);
+    }
+}
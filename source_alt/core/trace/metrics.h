@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Log-linear (HDR-style) latency histogram in microseconds.
+//
+// Values below 32 us get their own bucket; above that every power of two is
+// split into 32 sub-buckets, so a recorded value is off by at most ~3% and
+// percentiles come out of the buckets without keeping samples. Recording is
+// a few relaxed atomic adds and is safe from any thread, including the audio
+// callback.
+class LatencyHistogram {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kSubBuckets = 32;
+    static constexpr int kBuckets = 28 * kSubBuckets; // Up to 2^32 us (~71 minutes)
+
+    struct Summary {
+        uint64_t count = 0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p90Ms = 0.0;
+        double p99Ms = 0.0;
+        double p999Ms = 0.0;
+        double maxMs = 0.0;
+        double sumSeconds = 0.0;
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t us);
+    void recordSince(Clock::time_point start) {
+        record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count()));
+    }
+
+    Summary summary() const;
+    void reset();
+
+private:
+    static int bucketFor(uint64_t us);
+    static double bucketMidpoint(int index);
+
+    std::atomic<uint64_t> buckets_[kBuckets];
+    std::atomic<uint64_t> sumUs_{0};
+    std::atomic<uint64_t> maxUs_{0};
+};
+
+// Records the lifetime of the scope into a histogram
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram)
+        : histogram_(histogram), start_(LatencyHistogram::Clock::now()) {}
+    ~ScopedLatency() { histogram_.recordSince(start_); }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    LatencyHistogram::Clock::time_point start_;
+};
+
+// Player-wide latency histograms and counters: seek to first frame per tier,
+// per-frame decode time per decoder, texture upload, tape effect, audio
+// callback duration and xruns, and what WindowManager::selectFrame served.
+class PlayerMetrics {
+public:
+    enum class Selection {
+        FullRes,      // Frame at the target, by tier
+        LowRes,
+        Cached,
+        NearbyLowRes, // High-speed fallback to a neighbouring frame
+        NearbyCached,
+        Busy,         // Target frame was being decoded
+        Miss,         // Nothing to show
+        Count
+    };
+
+    // Indexed by FrameInfo::FrameType (LOW_RES = 1, CACHED = 2, FULL_RES = 3)
+    LatencyHistogram seekToFrame[4];
+    LatencyHistogram decodeFullRes; // Per stored frame, including reads and skipped frames before it
+    LatencyHistogram decodeLowRes;
+    LatencyHistogram decodeCached;
+    LatencyHistogram upload;
+    LatencyHistogram effect;
+    LatencyHistogram audioCallback;
+    std::atomic<uint64_t> audioCallbacks{0};
+    std::atomic<uint64_t> audioXruns{0};
+    std::atomic<uint64_t> seeks{0};
+
+    // Any thread; starts the seek-to-first-frame clocks
+    void markSeek();
+    // Display thread, once per selectFrame()
+    void recordSelection(Selection outcome, int frameType);
+
+    std::string toJson() const;
+    std::string toPrometheus() const;
+    // Short lines for the on-screen metrics page
+    std::vector<std::string> overlayLines() const;
+    // JSON if the path ends in .json, Prometheus text otherwise; replaced atomically
+    bool writeFile(const std::string& path) const;
+
+    void reset();
+
+private:
+    std::atomic<uint64_t> selections_[static_cast<int>(Selection::Count)]{};
+    std::atomic<int64_t> seekStartNs_{0};
+    std::atomic<uint32_t> seekGeneration_{0};
+
+    // Display thread only
+    uint32_t handledGeneration_ = 0;
+    int64_t activeSeekNs_ = 0;
+    int tiersSeen_ = 0;
+};
+
+extern PlayerMetrics playerMetrics;
+
+// Publishes playerMetrics outside the process: rewrites a file once a second
+// and/or answers on a Unix socket. A connection that sends an HTTP GET gets
+// an HTTP response (/metrics.json for JSON, anything else Prometheus text),
+// so `curl --unix-socket` works; one that sends nothing gets Prometheus text.
+class MetricsExporter {
+public:
+    ~MetricsExporter();
+
+    bool start(const std::string& filePath, const std::string& socketPath);
+    // Writes the file one last time
+    void stop();
+
+private:
+    void run();
+    void serveClient(int fd);
+
+    std::string filePath_;
+    std::string socketPath_;
+    int listenFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+};
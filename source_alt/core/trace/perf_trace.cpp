@@ -0,0 +1,222 @@
+#include "perf_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> PerfTrace::enabled_{false};
+
+namespace {
+
+enum class EventType : uint8_t { Span, Counter, Instant };
+
+struct TraceEvent {
+    const char* name;
+    uint64_t startNs;
+    uint64_t durNs;
+    double value;
+    EventType type;
+};
+
+constexpr uint64_t kRingCapacity = 1u << 15; // Events per thread (~1.3 MB)
+constexpr uint64_t kRingMask = kRingCapacity - 1;
+constexpr size_t kMaxRetiredRings = 32;      // Rings of exited threads kept for export
+
+} // namespace
+
+struct PerfTrace::Ring {
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[kRingCapacity]};
+    // Total events written; only the owning thread (or the ring's single writer) stores it
+    std::atomic<uint64_t> head{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<bool> retired{false};
+    uint32_t tid = 0;
+};
+
+namespace {
+
+using ThreadRing = PerfTrace::Ring;
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    uint32_t nextTid = 1;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry(); // Never destroyed: threads may record during exit
+    return *instance;
+}
+
+std::atomic<uint64_t> sessionStartNs{0};
+
+// Marks the ring retired when its thread exits, so the registry can drop it eventually
+struct ThreadSlot {
+    std::shared_ptr<ThreadRing> ring;
+    const char* name = nullptr;
+    ~ThreadSlot() {
+        if (ring) ring->retired.store(true, std::memory_order_relaxed);
+    }
+};
+
+thread_local ThreadSlot threadSlot;
+
+void registerRing(const std::shared_ptr<ThreadRing>& ring) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    ring->tid = reg.nextTid++;
+
+    // Decoder threads are recreated per file; forget the oldest exited ones
+    size_t retired = std::count_if(reg.rings.begin(), reg.rings.end(),
+                                   [](const std::shared_ptr<ThreadRing>& r) { return r->retired.load(); });
+    for (auto it = reg.rings.begin(); retired > kMaxRetiredRings && it != reg.rings.end();) {
+        if ((*it)->retired.load()) {
+            it = reg.rings.erase(it);
+            --retired;
+        } else {
+            ++it;
+        }
+    }
+
+    reg.rings.push_back(ring);
+}
+
+ThreadRing* threadRing() {
+    if (threadSlot.ring) return threadSlot.ring.get();
+
+    auto ring = std::make_shared<ThreadRing>();
+    ring->name.store(threadSlot.name, std::memory_order_relaxed);
+    registerRing(ring);
+    threadSlot.ring = std::move(ring);
+    return threadSlot.ring.get();
+}
+
+void push(ThreadRing* ring, const TraceEvent& event) {
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head & kRingMask] = event;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace
+
+uint64_t PerfTrace::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void PerfTrace::setEnabled(bool enabled) {
+    if (enabled && !isEnabled()) sessionStartNs.store(nowNs(), std::memory_order_relaxed);
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void PerfTrace::recordSpan(const char* name, uint64_t startNs, uint64_t endNs) {
+    if (!isEnabled()) return;
+    push(threadRing(), {name, startNs, endNs > startNs ? endNs - startNs : 0, 0.0, EventType::Span});
+}
+
+void PerfTrace::recordCounter(const char* name, double value) {
+    if (!isEnabled()) return;
+    push(threadRing(), {name, nowNs(), 0, value, EventType::Counter});
+}
+
+void PerfTrace::recordInstant(const char* name) {
+    if (!isEnabled()) return;
+    push(threadRing(), {name, nowNs(), 0, 0.0, EventType::Instant});
+}
+
+void PerfTrace::setThreadName(const char* name) {
+    if (threadSlot.name == name) return;
+    threadSlot.name = name;
+    if (threadSlot.ring) threadSlot.ring->name.store(name, std::memory_order_relaxed);
+}
+
+PerfTrace::Ring* PerfTrace::prepareRing(const char* name) {
+    auto ring = std::make_shared<Ring>();
+    ring->name.store(name, std::memory_order_relaxed);
+    registerRing(ring); // The registry keeps it alive; it is never retired
+    return ring.get();
+}
+
+void PerfTrace::recordSpan(Ring* ring, const char* name, uint64_t startNs, uint64_t endNs) {
+    if (!ring || !isEnabled()) return;
+    push(ring, {name, startNs, endNs > startNs ? endNs - startNs : 0, 0.0, EventType::Span});
+}
+
+bool PerfTrace::exportChromeJson(const std::string& path) {
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        rings = reg.rings;
+    }
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "[PerfTrace] Cannot write " << path << std::endl;
+        return false;
+    }
+
+    const uint64_t originNs = sessionStartNs.load(std::memory_order_relaxed);
+    size_t written = 0;
+    int wrappedThreads = 0;
+    bool first = true;
+    std::vector<TraceEvent> snapshot;
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (const auto& ring : rings) {
+        // The owner keeps writing while we copy. Copy first, then re-read head:
+        // any slot the writer may have reached in the meantime is discarded.
+        uint64_t headBefore = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = headBefore > kRingCapacity ? headBefore - kRingCapacity : 0;
+        snapshot.clear();
+        for (uint64_t i = begin; i < headBefore; ++i) snapshot.push_back(ring->events[i & kRingMask]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t headAfter = ring->head.load(std::memory_order_relaxed);
+        uint64_t validFrom = headAfter > kRingCapacity ? headAfter - kRingCapacity : 0;
+        size_t skip = static_cast<size_t>(std::min<uint64_t>(validFrom > begin ? validFrom - begin : 0, snapshot.size()));
+
+        bool any = false;
+        for (size_t i = skip; i < snapshot.size(); ++i) {
+            const TraceEvent& e = snapshot[i];
+            if (e.startNs < originNs) continue; // Left over from an earlier session
+            if (i == skip && begin > 0) ++wrappedThreads; // Oldest kept event is in session: some were lost
+
+            double tsUs = (e.startNs - originNs) / 1000.0;
+            std::fprintf(file, "%s", first ? "" : ",\n");
+            first = false;
+            any = true;
+            switch (e.type) {
+                case EventType::Span:
+                    std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                                 e.name, ring->tid, tsUs, e.durNs / 1000.0);
+                    break;
+                case EventType::Counter:
+                    std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%.6g}}",
+                                 e.name, ring->tid, tsUs, e.value);
+                    break;
+                case EventType::Instant:
+                    std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+                                 e.name, ring->tid, tsUs);
+                    break;
+            }
+            ++written;
+        }
+
+        if (any) {
+            const char* name = ring->name.load(std::memory_order_relaxed);
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         ring->tid, name ? name : "thread");
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    bool ok = std::fclose(file) == 0;
+
+    std::cout << "[PerfTrace] Wrote " << written << " events from " << rings.size() << " threads to " << path;
+    if (wrappedThreads > 0) std::cout << " (" << wrappedThreads << " thread rings wrapped; oldest events lost)";
+    std::cout << std::endl;
+    return ok;
+}
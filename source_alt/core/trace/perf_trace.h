@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Low-overhead performance tracing with Chrome trace-event export.
+//
+// Every thread that records gets its own ring of fixed-size events; the
+// owning thread is the only writer, so recording takes no lock. Rings are
+// allocated on the first event a thread records while tracing is on, so
+// threads that never trace cost nothing. When a ring is full the oldest
+// events are overwritten.
+//
+// A real-time thread (the audio callback) must not allocate or lock, so it
+// does not get a ring that way: a ring is made for it up front with
+// prepareRing() on another thread and recorded into with PERF_SPAN_RING.
+//
+// Disabled, a span is one relaxed atomic load and a branch at each end.
+// Enabled, it is two clock reads and one ring write.
+//
+// Span, counter and thread names must be string literals (or otherwise
+// outlive the trace): only the pointer is stored.
+//
+// exportChromeJson() writes what the rings hold from the current session
+// (since the last setEnabled(true)) as JSON for chrome://tracing or Perfetto.
+// It may run while other threads are still recording.
+class PerfTrace {
+public:
+    struct Ring;
+
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    static uint64_t nowNs();
+
+    static void recordSpan(const char* name, uint64_t startNs, uint64_t endNs);
+    static void recordCounter(const char* name, double value);
+    static void recordInstant(const char* name);
+
+    // Label for the calling thread in the exported trace
+    static void setThreadName(const char* name);
+
+    // A named ring that is not tied to the calling thread; kept for the life
+    // of the process. Allocates and locks: call it off the thread that records.
+    // Whoever records into it must be its only writer at any time.
+    static Ring* prepareRing(const char* name);
+    static void recordSpan(Ring* ring, const char* name, uint64_t startNs, uint64_t endNs);
+
+    static bool exportChromeJson(const std::string& path);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+// Scoped span: records [construction, destruction) when tracing was on at construction
+class PerfSpan {
+public:
+    explicit PerfSpan(const char* name)
+        : name_(name), startNs_(PerfTrace::isEnabled() ? PerfTrace::nowNs() : 0) {}
+    // Records into `ring` instead of the calling thread's; nothing when it is null
+    PerfSpan(PerfTrace::Ring* ring, const char* name)
+        : ring_(ring), name_(name), startNs_(ring && PerfTrace::isEnabled() ? PerfTrace::nowNs() : 0) {}
+    ~PerfSpan() {
+        if (!startNs_) return;
+        if (ring_) PerfTrace::recordSpan(ring_, name_, startNs_, PerfTrace::nowNs());
+        else PerfTrace::recordSpan(name_, startNs_, PerfTrace::nowNs());
+    }
+
+    PerfSpan(const PerfSpan&) = delete;
+    PerfSpan& operator=(const PerfSpan&) = delete;
+
+private:
+    PerfTrace::Ring* ring_ = nullptr;
+    const char* name_;
+    uint64_t startNs_;
+};
+
+#define PERF_TRACE_CONCAT_INNER(a, b) a##b
+#define PERF_TRACE_CONCAT(a, b) PERF_TRACE_CONCAT_INNER(a, b)
+
+#define PERF_SPAN(name) PerfSpan PERF_TRACE_CONCAT(perfSpan_, __LINE__)(name)
+#define PERF_SPAN_RING(ring, name) PerfSpan PERF_TRACE_CONCAT(perfSpan_, __LINE__)((ring), (name))
+#define PERF_COUNTER(name, value) \
+    do { if (PerfTrace::isEnabled()) PerfTrace::recordCounter((name), static_cast<double>(value)); } while (0)
+#define PERF_INSTANT(name) \
+    do { if (PerfTrace::isEnabled()) PerfTrace::recordInstant(name); } while (0)
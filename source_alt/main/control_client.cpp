@@ -0,0 +1,209 @@
+#include "control_client.h"
+#include "core/remote/control_socket.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kPipelineWindow = 1000; // Requests in flight; keeps the replies within the server's output limit
+
+int connectToPlayer() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, ControlSocketServer::kDefaultPath, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "[ControlClient] Cannot connect to " << ControlSocketServer::kDefaultPath << ": "
+                  << strerror(errno) << " (is the player running?)" << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Buffered line reader over the socket
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd_(fd) {}
+
+    bool next(std::string& line) {
+        for (;;) {
+            size_t end = buffer_.find('\n', start_);
+            if (end != std::string::npos) {
+                line.assign(buffer_, start_, end - start_);
+                start_ = end + 1;
+                return true;
+            }
+            buffer_.erase(0, start_);
+            start_ = 0;
+            char chunk[4096];
+            ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            buffer_.append(chunk, static_cast<size_t>(n));
+        }
+    }
+
+private:
+    int fd_;
+    std::string buffer_;
+    size_t start_ = 0;
+};
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return "";
+    return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+// "speed 2" -> {"cmd":"speed","value":2}; numbers and true/false go unquoted.
+// The value is the rest of the command, so a file path may contain spaces.
+std::string commandJson(const std::string& command) {
+    std::istringstream in(command);
+    std::string name, value;
+    in >> name;
+    std::getline(in >> std::ws, value);
+    if ((name == "open" || name == "prepare") && !value.empty()) {
+        value = std::filesystem::absolute(value).lexically_normal().string(); // The player has its own working directory
+    }
+    std::string json = "{\"cmd\":\"" + name + "\"";
+    if (!value.empty()) {
+        char* end = nullptr;
+        std::strtod(value.c_str(), &end);
+        bool bare = (end && *end == '\0') || value == "true" || value == "false";
+        std::string quoted = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') quoted += '\\';
+            quoted += c;
+        }
+        json += ",\"value\":" + (bare ? value : quoted + "\"");
+    }
+    return json + "}";
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(values.size() * p));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+} // namespace
+
+int ControlClient::run(const std::string& script) {
+    std::string request;
+    std::string first; // Command name of a single-command script
+    if (!script.empty() && script[0] == '{') {
+        request = script;
+    } else {
+        std::vector<std::string> commands;
+        std::istringstream in(script);
+        for (std::string part; std::getline(in, part, ';');) {
+            part = trim(part);
+            if (!part.empty()) commands.push_back(part);
+        }
+        if (commands.empty()) {
+            std::cerr << "[ControlClient] Nothing to send" << std::endl;
+            return 1;
+        }
+        if (commands.size() == 1) {
+            request = commandJson(commands[0]);
+            request.insert(1, "\"id\":1,");
+            first = commands[0].substr(0, commands[0].find(' '));
+        } else {
+            request = "{\"id\":1,\"batch\":[";
+            for (size_t i = 0; i < commands.size(); ++i) {
+                request += (i ? "," : "") + commandJson(commands[i]);
+            }
+            request += "]}";
+        }
+    }
+
+    int fd = connectToPlayer();
+    if (fd < 0) return 1;
+    if (!sendAll(fd, request + "\n")) {
+        std::cerr << "[ControlClient] Send failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return 1;
+    }
+
+    LineReader reader(fd);
+    std::string line;
+    bool ok = false;
+    if (reader.next(line)) {
+        std::cout << line << std::endl;
+        ok = line.find("\"ok\":true") != std::string::npos;
+    }
+    if (ok && first == "subscribe") {
+        while (reader.next(line)) std::cout << line << std::endl;
+    }
+    close(fd);
+    return ok ? 0 : 1;
+}
+
+int ControlClient::runBenchmark(int count) {
+    int fd = connectToPlayer();
+    if (fd < 0) return 1;
+    LineReader reader(fd);
+    std::string line;
+
+    // One at a time: each PING waits for its reply
+    std::vector<double> latenciesUs;
+    latenciesUs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        auto sentAt = Clock::now();
+        if (!sendAll(fd, "{\"id\":" + std::to_string(i) + ",\"cmd\":\"ping\"}\n") || !reader.next(line) ||
+            line.find("\"ok\":true") == std::string::npos) {
+            std::cerr << "[ControlClient] PING " << i << " failed: " << line << std::endl;
+            close(fd);
+            return 1;
+        }
+        latenciesUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sentAt).count());
+    }
+
+    // Pipelined: a window of requests is written before its replies are read
+    auto start = Clock::now();
+    int replies = 0;
+    for (int base = 0; base < count; base += kPipelineWindow) {
+        int window = std::min(kPipelineWindow, count - base);
+        std::string burst;
+        for (int i = base; i < base + window; ++i) burst += "{\"id\":" + std::to_string(i) + ",\"cmd\":\"ping\"}\n";
+        if (!sendAll(fd, burst)) break;
+        int expected = replies + window;
+        while (replies < expected && reader.next(line)) ++replies;
+        if (replies < expected) break;
+    }
+    double burstSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    close(fd);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "[ControlClient] Round trip (us) over " << count << " PINGs: p50 " << percentile(latenciesUs, 0.50)
+              << "  p90 " << percentile(latenciesUs, 0.90)
+              << "  p99 " << percentile(latenciesUs, 0.99)
+              << "  max " << percentile(latenciesUs, 1.0) << std::endl;
+    std::cout << "[ControlClient] Pipelined: " << replies << "/" << count << " replies in " << burstSeconds * 1000.0
+              << " ms (" << (burstSeconds > 0.0 ? replies / burstSeconds : 0.0) << " cmd/s)" << std::endl;
+    return replies == count ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+// Command-line client for the control socket (--ctl, --ctl-bench).
+//
+// --ctl takes a script of commands separated by ';', e.g.
+// "seek_timecode 01:00:10:00; speed 2; screenshot". More than one command
+// is sent as a single batch. "state" prints the current state once;
+// "subscribe" keeps printing every change. A script that starts with '{' is
+// sent unchanged as a raw request line.
+//
+// --ctl-bench measures PING round trips to a running player one at a time,
+// then pipelined, and reports latency percentiles and throughput.
+class ControlClient {
+public:
+    static int run(const std::string& script);
+    static int runBenchmark(int count);
+};
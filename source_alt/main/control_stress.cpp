@@ -0,0 +1,228 @@
+#include "control_stress.h"
+#include "core/remote/control_ring.h"
+#include "core/remote/remote_control.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const kLiveControlPath = "/tmp/tapexplayer_control";
+constexpr uint32_t kStressCapacity = 64; // Small, so the burst runs into a full ring
+constexpr int kLatencySamples = 2000;
+constexpr int kAckTimeoutMs = 5000;
+
+// Written by the consumer process where the player keeps its legacy slot
+struct ConsumerReport {
+    std::atomic<uint64_t> received;
+    std::atomic<uint64_t> outOfOrder; // Sequence number or payload not the expected next one
+    std::atomic<uint64_t> wrongType;
+    std::atomic<uint32_t> done;
+};
+static_assert(sizeof(ConsumerReport) <= ControlRing::kFileOffset, "Report must fit before the ring");
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(values.size() * p));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Consumer loop of the forked process: same peek/execute/ack/wait cycle as RemoteControl
+void consume(ControlRing& ring, ConsumerReport* report, uint64_t total) {
+    uint64_t expected = 0;
+    auto deadline = Clock::now() + std::chrono::seconds(60);
+    while (expected < total && Clock::now() < deadline) {
+        ControlRingSlot slot;
+        while (ring.peek(slot)) {
+            if (slot.seq != expected || slot.value != static_cast<double>(expected)) {
+                report->outOfOrder.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (slot.type != RemoteCommand::Type::PING) report->wrongType.fetch_add(1, std::memory_order_relaxed);
+            expected = slot.seq + 1;
+            report->received.fetch_add(1, std::memory_order_relaxed);
+            ring.ack();
+        }
+        ring.wait(30);
+    }
+    report->done.store(1, std::memory_order_release);
+}
+
+struct SendResult {
+    uint64_t sent = 0;
+    uint64_t fullWaits = 0; // Pushes that found the ring full and had to wait for acks
+    double burstSeconds = 0.0;
+    bool allAcked = false;
+    std::vector<double> latenciesUs;
+};
+
+// Burst of `count` commands, then kLatencySamples one at a time; payload is the command index
+SendResult send(ControlRing& ring, int count, uint64_t firstValue) {
+    SendResult r;
+    uint64_t seq = 0;
+    uint64_t value = firstValue;
+
+    auto start = Clock::now();
+    for (int i = 0; i < count; ++i, ++value) {
+        bool waited = false;
+        while (!ring.push(RemoteCommand::Type::PING, static_cast<double>(value), seq)) {
+            waited = true;
+            std::this_thread::yield();
+        }
+        if (waited) ++r.fullWaits;
+        ++r.sent;
+    }
+    r.allAcked = count == 0 || ring.waitForAck(seq, kAckTimeoutMs);
+    r.burstSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (!r.allAcked) return r;
+
+    r.latenciesUs.reserve(kLatencySamples);
+    for (int i = 0; i < kLatencySamples; ++i, ++value) {
+        auto sentAt = Clock::now();
+        if (!ring.push(RemoteCommand::Type::PING, static_cast<double>(value), seq) || !ring.waitForAck(seq, kAckTimeoutMs)) {
+            r.allAcked = false;
+            return r;
+        }
+        ++r.sent;
+        r.latenciesUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sentAt).count());
+        // Let the consumer go back to sleep so the doorbell path is measured, not a busy consumer
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return r;
+}
+
+void printResult(const SendResult& r) {
+    std::cout << std::fixed << std::setprecision(1)
+              << "[ControlStress] Burst: " << (r.sent - r.latenciesUs.size()) << " commands in " << r.burstSeconds * 1000.0
+              << " ms (" << (r.burstSeconds > 0.0 ? (r.sent - r.latenciesUs.size()) / r.burstSeconds : 0.0)
+              << " cmd/s), ring full " << r.fullWaits << " times" << std::endl;
+    std::cout << "[ControlStress] Send-to-ack latency (us): p50 " << percentile(r.latenciesUs, 0.50)
+              << "  p90 " << percentile(r.latenciesUs, 0.90)
+              << "  p99 " << percentile(r.latenciesUs, 0.99)
+              << "  max " << percentile(r.latenciesUs, 1.0) << std::endl;
+}
+
+} // namespace
+
+int ControlStress::run(int count) {
+    char path[] = "/tmp/tapexplayer_stress_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::cerr << "[ControlStress] Cannot create control file: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    const std::string doorbell = ControlRing::doorbellPath(path);
+    const size_t size = ControlRing::kFileOffset + ControlRing::bytesFor(kStressCapacity);
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "[ControlStress] Cannot map control file: " << strerror(errno) << std::endl;
+        close(fd);
+        unlink(path);
+        return 1;
+    }
+
+    auto* report = new (memory) ConsumerReport{};
+    char* ringMemory = static_cast<char*>(memory) + ControlRing::kFileOffset;
+    ControlRing consumerRing;
+    consumerRing.create(ringMemory, kStressCapacity, doorbell); // Before fork: the FIFO must exist for the producer
+    const uint64_t total = static_cast<uint64_t>(count) + kLatencySamples;
+
+    std::cout << "[ControlStress] Sending " << count << " commands through a " << kStressCapacity
+              << "-slot ring to a separate process" << std::endl;
+    pid_t child = fork();
+    if (child < 0) {
+        std::cerr << "[ControlStress] fork failed: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    if (child == 0) {
+        consume(consumerRing, report, total);
+        _exit(0);
+    }
+    consumerRing.close(); // The parent only produces
+
+    ControlRing producerRing;
+    producerRing.attach(ringMemory, size - ControlRing::kFileOffset, doorbell);
+    SendResult result = send(producerRing, count, 0);
+    producerRing.close();
+
+    if (!result.allAcked) kill(child, SIGKILL);
+    int status = 0;
+    waitpid(child, &status, 0);
+
+    uint64_t received = report->received.load();
+    uint64_t outOfOrder = report->outOfOrder.load();
+    uint64_t wrongType = report->wrongType.load();
+    munmap(memory, size);
+    close(fd);
+    unlink(path);
+    unlink(doorbell.c_str());
+
+    printResult(result);
+    uint64_t lost = result.sent > received ? result.sent - received : 0;
+    std::cout << "[ControlStress] Sent " << result.sent << ", received " << received << ", lost " << lost
+              << ", out of order " << outOfOrder << ", corrupted " << wrongType << std::endl;
+    bool ok = result.allAcked && result.sent == total && received == total && outOfOrder == 0 && wrongType == 0;
+    std::cout << "[ControlStress] " << (ok ? "PASS" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+
+int ControlStress::runLive(int count) {
+    int fd = open(kLiveControlPath, O_RDWR);
+    if (fd < 0) {
+        std::cerr << "[ControlStress] No player control file at " << kLiveControlPath << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) <= ControlRing::kFileOffset) {
+        std::cerr << "[ControlStress] The running player has no command ring (older version?)" << std::endl;
+        close(fd);
+        return 1;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "[ControlStress] Cannot map control file: " << strerror(errno) << std::endl;
+        close(fd);
+        return 1;
+    }
+
+    ControlRing ring;
+    if (!ring.attach(static_cast<char*>(memory) + ControlRing::kFileOffset, size - ControlRing::kFileOffset,
+                     ControlRing::doorbellPath(kLiveControlPath))) {
+        std::cerr << "[ControlStress] Command ring version or layout mismatch" << std::endl;
+        munmap(memory, size);
+        close(fd);
+        return 1;
+    }
+
+    flock(fd, LOCK_EX); // One producer at a time
+    std::cout << "[ControlStress] Sending " << count << " PING commands to the running player ("
+              << ring.capacity() << "-slot ring)" << std::endl;
+    SendResult result = send(ring, count, 0);
+    flock(fd, LOCK_UN);
+    ring.close();
+    munmap(memory, size);
+    close(fd);
+
+    printResult(result);
+    std::cout << "[ControlStress] " << (result.allAcked ? "PASS: every command acknowledged in order"
+                                                        : "FAIL: acknowledgements stopped") << std::endl;
+    return result.allAcked ? 0 : 1;
+}
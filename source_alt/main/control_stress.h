@@ -0,0 +1,16 @@
+#pragma once
+
+// Stress client for the shared-memory command ring (--control-stress,
+// --control-stress-live).
+//
+// Self-contained mode forks a consumer process on a private control file
+// that drains the ring the way the player does and checks that every command
+// arrives exactly once and in order; the parent sends a burst (hitting the
+// full-ring backpressure) and then measures send-to-acknowledge latency one
+// command at a time. Live mode sends no-op PING commands to a running
+// player's /tmp/tapexplayer_control and checks that all are acknowledged.
+class ControlStress {
+public:
+    static int run(int count);
+    static int runLive(int count);
+};
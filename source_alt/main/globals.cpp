@@ -52,6 +52,15 @@ std::atomic<bool> speed_reset_requested(false);
 float currentDisplayAspectRatio = 16.0f / 9.0f;
 std::atomic<bool> window_has_focus(true); // Track window focus state
 
+// Headless mode
+std::atomic<bool> headless_mode(false);
+std::string headless_output = "null";
+int headless_width = 1280;
+int headless_height = 720;
+
+// Performance trace
+std::string perf_trace_path;
+
 // Zoom control
 std::atomic<bool> zoom_enabled(false);
 std::atomic<float> zoom_factor(1.0f);
@@ -62,6 +71,9 @@ std::atomic<bool> show_zoom_thumbnail(true);
 // Betacam effect control
 std::atomic<bool> betacam_effect_enabled(false);
 
+// Latency metrics page (Alt+M)
+std::atomic<bool> show_metrics_overlay(false);
+
 // MCP sound feedback control
 std::atomic<bool> mcp_command_beep_requested(false);
 std::atomic<bool> screenshot_click_requested(false);
@@ -29,6 +29,7 @@ std::string generateTXTimecode(double time);
 void smooth_speed_change();
 void check_and_reset_threshold();
 extern void cleanup_audio();
+extern void release_audio_source();
 
 // Pending FSTP URL processing globals
 extern std::string g_pendingFstpUrlPath;
@@ -79,6 +80,15 @@ extern std::atomic<bool> speed_reset_requested;
 extern float currentDisplayAspectRatio;
 extern std::atomic<bool> window_has_focus;
 
+// Headless mode (--headless): offscreen rendering, null audio sink
+extern std::atomic<bool> headless_mode;
+extern std::string headless_output; // "null", "file:<path>" or "shm:<name>"
+extern int headless_width;
+extern int headless_height;
+
+// Performance trace (--perf-trace, Ctrl+T): Chrome trace JSON output path
+extern std::string perf_trace_path;
+
 // Zoom control
 extern std::atomic<bool> zoom_enabled;
 extern std::atomic<float> zoom_factor;
@@ -89,6 +99,9 @@ extern std::atomic<bool> show_zoom_thumbnail;
 // Betacam effect control
 extern std::atomic<bool> betacam_effect_enabled;
 
+// Latency metrics page (Alt+M)
+extern std::atomic<bool> show_metrics_overlay;
+
 // MCP sound feedback control
 extern std::atomic<bool> mcp_command_beep_requested;
 extern std::atomic<bool> screenshot_click_requested;
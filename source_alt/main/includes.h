@@ -38,15 +38,27 @@
 #include "core/decode/low_res_decoder.h"
 #include "core/decode/cached_decoder.h"
 #include "../core/decode/cached_decoder_manager.h"
+#include "core/decode/file_preparer.h"
+#include "core/decode/session_cache.h"
+#include "core/decode/cache_manager.h"
 
 // Project core headers - display
 #include "core/display/display.h"
 #include "core/display/screenshot.h"
 #include "core/display/window_manager.h"
+#include "core/display/tape_effect.h"
+#include "core/display/osd_text.h"
+#include "core/display/frame_sink.h"
 
 // Project core headers - remote
 #include "core/remote/remote_control.h"
 #include "core/remote/url_handler.h"
+#include "core/remote/transport_trace.h"
+#include "core/remote/player_state.h"
+#include "core/remote/control_socket.h"
+#include "core/trace/perf_trace.h"
+#include "core/log/logger.h"
+#include "core/trace/metrics.h"
 
 // Project core headers - menu
 #include "core/menu/menu_system.h"
@@ -60,6 +72,10 @@
 #include "keyboard_manager.h"
 #include "main.h"
 #include "initmanager.h"
+#include "scrub_bench.h"
+#include "log_bench.h"
+#include "control_stress.h"
+#include "control_client.h"
 #include "globals.h"
 
 #endif // INCLUDES_H
\ No newline at end of file
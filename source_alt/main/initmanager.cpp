@@ -12,6 +12,9 @@
 #include "../common/common.h" // Still needed for SeekInfo definition
 #include "main.h"       // Include main header for global variables and types
 #include "core/decode/decode.h" // Needed for createFrameIndex, FrameInfo, get_video_dimensions, get_video_fps, get_file_duration
+#include "core/decode/file_preparer.h" // Needed for FilePreparer, PreparedFile
+#include "core/decode/session_cache.h" // Needed for sessionCache
+#include "core/decode/cache_manager.h" // Needed for cacheManager
 #include "core/decode/low_res_decoder.h" // Needed for LowResDecoder::convertToLowRes
 #include "core/decode/full_res_decoder_manager.h" // Needed for FullResDecoderManager
 #include "core/decode/low_cached_decoder_manager.h" // Needed for LowCachedDecoderManager
@@ -22,6 +25,8 @@
 #include <unistd.h> // Needed for getcwd
 #include <limits.h> // Needed for PATH_MAX
 
+extern std::atomic<bool> headless_mode; // globals.cpp
+
 // Function to get config file path depending on OS
 std::string getConfigFilePath() {
     std::string configPath;
@@ -78,6 +83,8 @@ WindowSettings loadWindowSettings() {
 
 // Function to save window settings - updated
 void saveWindowSettings(SDL_Window* window) {
+    if (headless_mode.load()) return; // The offscreen window says nothing about the user's layout
+
     int x, y, width, height;
     SDL_GetWindowPosition(window, &x, &y);
     SDL_GetWindowSize(window, &width, &height);
@@ -138,6 +145,7 @@ std::future<bool> mainLoadingSequence(
     const std::string& fileToLoad,
     std::string& currentFilename_out,
     std::vector<FrameInfo>& frameIndex_out,
+    PreparedFile& file_out,
     std::unique_ptr<FullResDecoderManager>& fullResMgr_out,
     std::unique_ptr<LowCachedDecoderManager>& lowCachedMgr_out,
     std::unique_ptr<CachedDecoderManager>& cachedMgr_out,
@@ -152,8 +160,8 @@ std::future<bool> mainLoadingSequence(
             { std::lock_guard<std::mutex> lock(loading_status_ref.stage_mutex); loading_status_ref.stage = "Initializing..."; }
             loading_status_ref.percent.store(0);
 
-            // Ensure audio is completely stopped (using global function cleanup_audio)
-            cleanup_audio();
+            // Ensure the previous file's audio is released; the output device stays open
+            release_audio_source();
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
             // Process media source (file or URL)
@@ -174,18 +182,8 @@ std::future<bool> mainLoadingSequence(
                 return false;
             }
 
-            // Handle file path for macOS
-            if (currentFilename_out.find("/Volumes/") == 0) { 
-                /* aabsolute path */
-            } else if (currentFilename_out[0] != '/') {
-                char cwd[PATH_MAX];
-                if (getcwd(cwd, sizeof(cwd)) != NULL) {
-                    currentFilename_out = std::string(cwd) + "/" + currentFilename_out;
-                } else {
-                    std::cerr << "Error getting current directory" << std::endl;
-                    return false;
-                }
-            }
+            // Absolute path, the form the background preparer keys on
+            currentFilename_out = FilePreparer::normalizePath(currentFilename_out);
 
             std::cout << "Loading file: " << currentFilename_out << std::endl;
             log("Loading file: " + currentFilename_out);
@@ -204,37 +202,61 @@ std::future<bool> mainLoadingSequence(
             // For now, we risk potential issues calling this from a different thread.
             // SDL_SetWindowTitle(window, windowTitle.c_str()); // Moved to main thread after load
 
-            std::string lowResFilename = "low_res_output.mp4"; 
-
-            // Create frame index
-            { std::lock_guard<std::mutex> lock(loading_status_ref.stage_mutex); loading_status_ref.stage = "Creating frame index..."; }
-            loading_status_ref.percent.store(15);
-            frameIndex_out = createFrameIndex(currentFilename_out.c_str());
-            std::cout << "Frame index created. Total frames: " << frameIndex_out.size() << std::endl;
-
-            // Convert to low-res
-            { std::lock_guard<std::mutex> lock(loading_status_ref.stage_mutex); loading_status_ref.stage = "Converting to low-res..."; }
-            loading_status_ref.percent.store(25);
-            // Create callback lambda for convertToLowRes progress
-            auto convertProgressCallback = [&](int progress) {
-                loading_status_ref.percent.store(25 + (progress * 40 / 100)); // Scale 0-100 to 25-65%
-            };
-            if (!LowResDecoder::convertToLowRes(currentFilename_out.c_str(), lowResFilename, convertProgressCallback)) {
+            // Index, proxy and probe: kept by the session cache when the file was open
+            // earlier, handed over by the background preparer when it was prepared ahead
+            // of the switch, done here otherwise
+            PreparedFile prepared;
+            bool restored = false;
+            if (sessionCache.take(currentFilename_out, prepared)) {
+                restored = true;
+                std::cout << "Returning to " << currentFilename_out << " at " << prepared.resumeTime << "s" << std::endl;
+            } else if (filePreparer.take(currentFilename_out, prepared)) {
+                std::cout << "Using the prepared index and proxy for " << currentFilename_out << std::endl;
+            } else {
+                auto prepareProgress = [&](const char* stage, int percent) {
+                    { std::lock_guard<std::mutex> lock(loading_status_ref.stage_mutex); loading_status_ref.stage = stage; }
+                    loading_status_ref.percent.store(15 + percent / 2); // 15-65%
+                };
+                if (!FilePreparer::prepareNow(currentFilename_out, prepared, prepareProgress)) {
+                    std::cerr << "Error preparing " << currentFilename_out << std::endl;
+                    return false;
+                }
+            }
+            // A kept or prepared file's proxy may have been evicted from the cache directory since
+            if (!std::filesystem::exists(prepared.lowResPath) &&
+                !LowResDecoder::convertToLowRes(currentFilename_out, prepared.lowResPath)) {
                 std::cerr << "Error converting video to low resolution" << std::endl;
                 return false;
             }
+            // The open file's cache artifacts are recently used and not to be evicted
+            cacheManager.touch(prepared.lowResPath, currentFilename_out);
+            cacheManager.touch(currentFilename_out, fileToLoad); // A download lives in the cache directory too
+            cacheManager.setInUse({prepared.lowResPath, currentFilename_out});
+            frameIndex_out = std::move(prepared.frameIndex);
+            frameStateSummary.reset(static_cast<int>(frameIndex_out.size()));
+            // Full-res frames kept with a restored index; the full-res decoder adopts them
+            int restoredFullResFirst = -1;
+            int restoredFullResLast = -1;
+            if (restored) {
+                // The kept frames are already in the index
+                for (size_t i = 0; i < frameIndex_out.size(); ++i) {
+                    if (frameIndex_out[i].type != FrameInfo::EMPTY) {
+                        frameStateSummary.transition(static_cast<int>(i), FrameInfo::EMPTY, frameIndex_out[i].type);
+                    }
+                    if (frameIndex_out[i].type == FrameInfo::FULL_RES) {
+                        if (restoredFullResFirst < 0) restoredFullResFirst = static_cast<int>(i);
+                        restoredFullResLast = static_cast<int>(i);
+                    }
+                }
+            }
+            std::cout << "Frame index ready. Total frames: " << frameIndex_out.size() << std::endl;
+            file_out = std::move(prepared); // Everything but the index, which is in frameIndex_out
+            const std::string lowResFilename = file_out.lowResPath;
 
-            // Get video dimensions
-            int videoWidth, videoHeight;
-            get_video_dimensions(currentFilename_out.c_str(), &videoWidth, &videoHeight);
-
-            // Async get FPS and duration
-            std::future<double> fps_future = std::async(std::launch::async, get_video_fps, currentFilename_out.c_str());
-            // Duration future is handled in main loop now
-
-            // Store FPS
-            original_fps.store(fps_future.get());
-            double fps = original_fps.load();
+            // Store FPS and duration
+            original_fps.store(file_out.fps);
+            total_duration.store(file_out.duration);
+            double fps = file_out.fps;
 
             // Calculate adaptive sizes
             int highResWindowSize;
@@ -288,18 +310,36 @@ std::future<bool> mainLoadingSequence(
             const size_t ringBufferCapacity = 2000;
 
             try {
-                fullResMgr_out = std::make_unique<FullResDecoderManager>(
-                    currentFilename_out, frameIndex_out, currentFrame_ref, playback_rate,
-                    highResWindowSize, isPlaying_ref, is_reverse
-                );
-                lowCachedMgr_out = std::make_unique<LowCachedDecoderManager>(
-                    lowResFilename, frameIndex_out, currentFrame_ref, ringBufferCapacity,
-                    highResWindowSize, isPlaying_ref, playback_rate, is_reverse
-                );
-                cachedMgr_out = std::make_unique<CachedDecoderManager>(
-                    lowResFilename, frameIndex_out, currentFrame_ref, is_reverse,
-                    adaptiveCachedSegmentSize
-                );
+                // Managers kept from the previous file (suspended by the main loop) are
+                // rebound to this one: their threads stay, only the decoders are replaced
+                if (fullResMgr_out) {
+                    fullResMgr_out->setFile(currentFilename_out, highResWindowSize);
+                } else {
+                    fullResMgr_out = std::make_unique<FullResDecoderManager>(
+                        currentFilename_out, frameIndex_out, currentFrame_ref, playback_rate,
+                        highResWindowSize, isPlaying_ref, is_reverse
+                    );
+                }
+                if (restoredFullResFirst >= 0) {
+                    // Otherwise its window maintenance never releases them
+                    fullResMgr_out->getDecoder()->adoptResident(frameIndex_out, restoredFullResFirst, restoredFullResLast);
+                }
+                if (lowCachedMgr_out) {
+                    lowCachedMgr_out->setFile(lowResFilename, highResWindowSize);
+                } else {
+                    lowCachedMgr_out = std::make_unique<LowCachedDecoderManager>(
+                        lowResFilename, frameIndex_out, currentFrame_ref, ringBufferCapacity,
+                        highResWindowSize, isPlaying_ref, playback_rate, is_reverse
+                    );
+                }
+                if (cachedMgr_out) {
+                    cachedMgr_out->setFile(lowResFilename, adaptiveCachedSegmentSize);
+                } else {
+                    cachedMgr_out = std::make_unique<CachedDecoderManager>(
+                        lowResFilename, frameIndex_out, currentFrame_ref, is_reverse,
+                        adaptiveCachedSegmentSize
+                    );
+                }
 
                 // Start the managers' internal threads - MOVED TO MAIN THREAD
                 // if (fullResMgr_out) fullResMgr_out->run(); 
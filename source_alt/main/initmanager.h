@@ -16,6 +16,7 @@
 class FullResDecoderManager;
 class LowCachedDecoderManager;
 class CachedDecoderManager;
+struct PreparedFile;
 
 // Structure for storing window settings
 struct WindowSettings {
@@ -51,10 +52,11 @@ std::future<bool> mainLoadingSequence(
     LoadingStatus& loading_status_ref, // Add reference to loading status
     const std::string& fileToLoad,
     std::string& currentFilename_out,          // Output: Actual filename used
-    std::vector<FrameInfo>& frameIndex_out,      // Output: Frame index data
-    std::unique_ptr<FullResDecoderManager>& fullResMgr_out, // Output: Initialized manager
-    std::unique_ptr<LowCachedDecoderManager>& lowCachedMgr_out, // Output: Initialized manager
-    std::unique_ptr<CachedDecoderManager>& cachedMgr_out, // Output: Initialized manager
+    std::vector<FrameInfo>& frameIndex_out,      // Output: Frame index data (the vector the managers reference)
+    PreparedFile& file_out,                      // Output: Proxy, probe and resume position (index moved out)
+    std::unique_ptr<FullResDecoderManager>& fullResMgr_out, // In/out: suspended manager to rebind, or created
+    std::unique_ptr<LowCachedDecoderManager>& lowCachedMgr_out, // In/out: suspended manager to rebind, or created
+    std::unique_ptr<CachedDecoderManager>& cachedMgr_out, // In/out: suspended manager to rebind, or created
     std::atomic<int>& currentFrame_ref,         // Ref to main's currentFrame
     std::atomic<bool>& isPlaying_ref            // Ref to main's isPlaying
 );
@@ -4,10 +4,13 @@
 #include "deep_pause_manager.h"
 #include "core/display/window_manager.h"
 #include "core/menu/menu_system.h"
+#include "core/remote/transport_trace.h"
+#include "core/trace/perf_trace.h"
 #include <iostream>
 #include <string>
 #include <cstring>
 #include <cstdlib>
+#include <ctime>
 
 // Forward declarations for functions used by KeyboardManager
 extern void restartPlayerWithFile(const std::string& filename, double seekTime);
@@ -99,6 +102,7 @@ void KeyboardManager::enableTimecodeInput() {
 }
 
 void KeyboardManager::handleKeyboardEvent(const SDL_Event& event) {
+    PERF_SPAN("command.key");
     if (event.type == SDL_KEYDOWN) {
         if (waiting_for_timecode) {
             handleTimecodeInput(event);
@@ -226,7 +230,11 @@ void KeyboardManager::handleNormalKeyInput(const SDL_Event& event) {
             handleZoomToggle(event);
             break;
         case SDLK_t:
-            toggle_zoom_thumbnail();
+            if (event.key.keysym.mod & KMOD_CTRL) {
+                togglePerfTrace();
+            } else {
+                toggle_zoom_thumbnail();
+            }
             break;
         case SDLK_c:
             if (event.key.keysym.mod & KMOD_GUI) {
@@ -234,7 +242,11 @@ void KeyboardManager::handleNormalKeyInput(const SDL_Event& event) {
             }
             break;
         case SDLK_m:
-            handleMenuKey(event);
+            if (event.key.keysym.mod & KMOD_ALT) {
+                show_metrics_overlay = !show_metrics_overlay;
+            } else {
+                handleMenuKey(event);
+            }
             break;
     }
 }
@@ -266,6 +278,7 @@ void KeyboardManager::handleMarkerKeys(const SDL_Event& event) {
                       << generateTXTimecode(memoryMarkers[markerIndex]) << std::endl;
         } else {
             if (memoryMarkers[markerIndex] >= 0) {
+                transportTrace.recordMarkerRecall(markerIndex, memoryMarkers[markerIndex]);
                 seek_to_time(memoryMarkers[markerIndex]);
             }
         }
@@ -295,7 +308,23 @@ void KeyboardManager::handleMenuKey(const SDL_Event& event) {
     }
 }
 
+// Ctrl+T: first press starts tracing, second press stops it and writes the trace
+void KeyboardManager::togglePerfTrace() {
+    if (!PerfTrace::isEnabled()) {
+        PerfTrace::setEnabled(true);
+        std::cout << "[PerfTrace] Tracing started" << std::endl;
+        return;
+    }
+    PerfTrace::setEnabled(false);
+    std::string path = perf_trace_path;
+    if (path.empty()) {
+        path = "/tmp/TapeXPlayer-trace-" + std::to_string(static_cast<long long>(time(nullptr))) + ".json";
+    }
+    PerfTrace::exportChromeJson(path);
+}
+
 void KeyboardManager::handleMouseEvent(const SDL_Event& event) {
+    PERF_SPAN("command.mouse");
     switch (event.type) {
         case SDL_MOUSEBUTTONDOWN:
             if (event.button.button == SDL_BUTTON_LEFT && (SDL_GetModState() & KMOD_SHIFT)) {
@@ -26,6 +26,7 @@ private:
     void handleMarkerKeys(const SDL_Event& event);
     void handleZoomToggle(const SDL_Event& event);
     void handleMenuKey(const SDL_Event& event);
+    void togglePerfTrace();
     
     void startMouseShuttle(int x);
     void updateMouseShuttle(int x);
@@ -0,0 +1,96 @@
+#include "log_bench.h"
+#include "core/decode/decode.h"
+#include "core/decode/frame_state_summary.h"
+#include "core/decode/full_res_decoder.h"
+#include "core/decode/low_res_decoder.h"
+#include "core/log/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kMaxFrames = 600;
+constexpr int kRounds = 3;
+
+// Best of kRounds per level, alternating so both see the same cache state
+void measure(const char* name, int frames, const std::function<bool()>& decode, const std::function<void()>& reset) {
+    const LogLevel levels[] = {LogLevel::Warn, LogLevel::Trace};
+    double bestFps[2] = {0.0, 0.0};
+    for (int round = 0; round < kRounds; ++round) {
+        for (int l = 0; l < 2; ++l) {
+            reset();
+            Logger::setLevel(levels[l]);
+            auto start = Clock::now();
+            bool ok = decode();
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            Logger::flush();
+            if (ok && seconds > 0.0) bestFps[l] = std::max(bestFps[l], frames / seconds);
+        }
+    }
+    Logger::setLevel(LogLevel::Info);
+
+    double overhead = bestFps[0] > 0.0 ? (1.0 - bestFps[1] / bestFps[0]) * 100.0 : 0.0;
+    std::cout << std::left << std::setw(10) << name << std::right
+              << std::setw(8) << frames
+              << std::setw(14) << std::fixed << std::setprecision(1) << bestFps[0]
+              << std::setw(14) << bestFps[1]
+              << std::setw(11) << std::setprecision(1) << overhead << "%" << std::endl;
+}
+
+} // namespace
+
+int LogBenchmark::run(const std::string& filename) {
+    // Keep the benchmark's records out of the player log
+    Logger::stop();
+    Logger::Options options;
+    options.path = "/tmp/TapeXPlayer-logbench.log";
+    options.consoleLevel = LogLevel::Off;
+    Logger::start(options);
+
+    std::cout << "[LogBench] Preparing " << filename << std::endl;
+    std::vector<FrameInfo> frameIndex = createFrameIndex(filename.c_str());
+    if (frameIndex.empty()) {
+        std::cerr << "[LogBench] Failed to index " << filename << std::endl;
+        return 1;
+    }
+    frameStateSummary.reset(static_cast<int>(frameIndex.size()));
+    const int frames = std::min(static_cast<int>(frameIndex.size()), kMaxFrames);
+
+    std::string lowResFilename = "low_res_output.mp4";
+    if (!LowResDecoder::convertToLowRes(filename.c_str(), lowResFilename)) {
+        std::cerr << "[LogBench] Failed to create proxies" << std::endl;
+        return 1;
+    }
+
+    FullResDecoder fullRes(filename);
+    LowResDecoder lowRes(lowResFilename);
+    if (!fullRes.isInitialized() || !lowRes.isInitialized()) {
+        std::cerr << "[LogBench] Failed to open decoders" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(10) << "decoder" << std::right
+              << std::setw(8) << "frames" << std::setw(14) << "warn fps"
+              << std::setw(14) << "trace fps" << std::setw(12) << "overhead" << std::endl;
+
+    measure("full-res", frames,
+            [&] { return fullRes.decodeFrameRange(frameIndex, 0, frames - 1); },
+            [&] { fullRes.clearHighResFrames(frameIndex); });
+    measure("low-res", frames,
+            [&] { return lowRes.decodeLowResRange(frameIndex, 0, frames - 1, -1, -1, false); },
+            [&] { lowRes.removeLowResFrames(frameIndex, 0, frames - 1); });
+
+    fullRes.clearHighResFrames(frameIndex);
+    lowRes.removeLowResFrames(frameIndex, 0, frames - 1);
+
+    std::cout << std::endl << "[LogBench] Log records dropped: " << Logger::droppedCount()
+              << " (log written to " << options.path << ")" << std::endl;
+    return 0;
+}
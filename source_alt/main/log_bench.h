@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+// Logging overhead benchmark (--bench-logging).
+//
+// Decodes the same frame range with the full-res and low-res decoders,
+// alternating between logging at warn level and at trace level (every
+// per-frame diagnostic enabled), and reports decode throughput for both so
+// the cost of verbose logging on the decode threads is visible.
+class LogBenchmark {
+public:
+    static int run(const std::string& filename);
+};
@@ -12,12 +12,7 @@ std::atomic<double>& get_target_playback_rate() {
 }
 
 void log(const std::string& message) {
-    static std::ofstream logFile("/tmp/TapeXPlayer.log", std::ios::app);
-    if (logFile.is_open()) {
-    logFile << message << std::endl;
-    } else {
-        std::cerr << "[LOG ERROR] Could not open /tmp/TapeXPlayer.log. Message: " << message << std::endl;
-    }
+    Logger::write(LogLevel::Info, "App", message);
 }
 
 std::string get_current_timecode() {
@@ -55,6 +50,64 @@ std::string get_current_timecode() {
     return std::string(timecode);
 }
 
+// Publishes the transport state for external controllers; a no-op unless something changed
+static void publishPlayerState(PlayerLoadState loadState, const std::string& path, int loadPercent = 0,
+                               int frame = 0, int frameCount = 0, int displayedTier = FrameInfo::EMPTY,
+                               bool playing = false) {
+    if (!playerStatePublisher.isOpen()) return;
+    PlayerState state;
+    state.loadState = static_cast<int32_t>(loadState);
+    state.loadPercent = loadPercent;
+    std::strncpy(state.filePath, path.c_str(), sizeof(state.filePath) - 1);
+    if (loadState == PlayerLoadState::Ready) {
+        bool reverse = is_reverse.load();
+        state.currentTime = current_audio_time.load();
+        state.duration = total_duration.load();
+        state.fps = original_fps.load();
+        state.playbackRate = reverse ? -playback_rate.load() : playback_rate.load();
+        state.targetRate = reverse ? -target_playback_rate.load() : target_playback_rate.load();
+        state.frameIndex = frame;
+        state.frameCount = frameCount;
+        state.displayedTier = displayedTier;
+        state.flags = (playing ? PlayerState::kPlaying : 0) |
+                      (reverse ? PlayerState::kReverse : 0) |
+                      (is_seeking.load() ? PlayerState::kSeeking : 0) |
+                      (jog_forward.load() || jog_backward.load() ? PlayerState::kJog : 0);
+        for (int tier = 0; tier < 4; ++tier) {
+            state.framesByTier[tier] = frameStateSummary.total(tier);
+        }
+        std::string timecode = get_current_timecode();
+        std::strncpy(state.timecode, timecode.c_str(), sizeof(state.timecode) - 1);
+    }
+    playerStatePublisher.publish(state);
+}
+
+// File to switch to, requested over the control socket; the main loop picks it up
+static std::mutex pendingOpenMutex;
+static std::string pendingOpenPath;
+
+// Control socket "open" / "prepare"; runs on the socket thread
+static std::string handleFileRequest(const std::string& cmd, const std::string& path) {
+    std::error_code ec;
+    if (path[0] != '/') return "path must be absolute: " + path;
+    if (!std::filesystem::is_regular_file(path, ec)) return "no such file: " + path;
+    if (cmd == "prepare") {
+        if (!sessionCache.contains(path)) filePreparer.prepare(path); // A kept file needs no preparing
+    } else {
+        std::lock_guard<std::mutex> lock(pendingOpenMutex);
+        pendingOpenPath = path;
+    }
+    return "";
+}
+
+static bool takePendingOpen(std::string& path) {
+    std::lock_guard<std::mutex> lock(pendingOpenMutex);
+    if (pendingOpenPath.empty()) return false;
+    path.swap(pendingOpenPath);
+    pendingOpenPath.clear();
+    return true;
+}
+
 // Function to reset speed
 void reset_to_normal_speed() {
     // First set flag for decoder
@@ -237,6 +290,59 @@ void restartPlayerWithFile(const std::string& filename, double seek_after_load_t
     restart_requested = false; 
 }
 
+// Runs a replayed transport trace event through the handler that received it live
+static void dispatchTraceEvent(const TransportTrace::Event& event, KeyboardManager& keyboardManager, TraceReplayer& replayer) {
+    switch (event.kind) {
+        case TransportTrace::Kind::Key: {
+            SDL_Event e;
+            SDL_zero(e);
+            e.type = static_cast<Uint32>(event.a);
+            e.key.state = e.type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+            e.key.repeat = static_cast<Uint8>(event.d);
+            e.key.keysym.sym = static_cast<SDL_Keycode>(event.b);
+            e.key.keysym.mod = static_cast<Uint16>(event.c);
+            SDL_SetModState(static_cast<SDL_Keymod>(event.c)); // Some handlers query the live state
+            keyboardManager.handleKeyboardEvent(e);
+            break;
+        }
+        case TransportTrace::Kind::Mouse: {
+            SDL_Event e;
+            SDL_zero(e);
+            e.type = static_cast<Uint32>(event.a);
+            if (e.type == SDL_MOUSEMOTION) {
+                e.motion.x = event.x;
+                e.motion.y = event.y;
+            } else {
+                e.button.button = static_cast<Uint8>(event.b);
+                e.button.state = e.type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+                e.button.x = event.x;
+                e.button.y = event.y;
+            }
+            SDL_SetModState(static_cast<SDL_Keymod>(event.c));
+            keyboardManager.handleMouseEvent(e);
+            break;
+        }
+        case TransportTrace::Kind::Remote:
+            if (g_remote_control) g_remote_control->replay_command(event.a, event.value);
+            break;
+        case TransportTrace::Kind::Hui:
+            if (g_remote_control) g_remote_control->replay_hui_message(std::vector<unsigned char>(event.data.begin(), event.data.end()));
+            break;
+        case TransportTrace::Kind::Url:
+            processIncomingFstpUrl(event.data.c_str());
+            break;
+        case TransportTrace::Kind::FileOpen:
+            if (event.data == g_currentOpenFilePath) {
+                replayer.onFileLoaded(); // Already open, nothing to wait for
+            } else {
+                restartPlayerWithFile(event.data, -1.0);
+            }
+            break;
+        default:
+            break; // Annotations are not replayed
+    }
+}
+
 int main(int argc, char* argv[]) {
     // Store the program path for potential relaunch
     argv0 = argv[0];
@@ -255,9 +361,179 @@ int main(int argc, char* argv[]) {
 
     std::string initialPathFromArgs; 
 
+    // --- Logging options ---
+    {
+        Logger::Options logOptions;
+        for (int i = 1; i + 1 < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--log-file") {
+                logOptions.path = argv[++i];
+            } else if (arg == "--log-level") {
+                LogLevel level;
+                if (!Logger::parseLevel(argv[++i], level)) {
+                    std::cerr << "Invalid --log-level '" << argv[i] << "', expected trace, debug, info, warn, error or off" << std::endl;
+                    return 1;
+                }
+                Logger::setLevel(level);
+            }
+        }
+        Logger::start(logOptions);
+    }
+
+    // --- Cache directory limits ---
+    CacheManager::Limits cacheLimits;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cache-max-gb") {
+            cacheLimits.maxBytes = static_cast<uint64_t>(std::max(0.0, std::atof(argv[++i])) * (1ull << 30));
+        } else if (arg == "--cache-max-days") {
+            cacheLimits.maxAgeSeconds = static_cast<int64_t>(std::max(0.0, std::atof(argv[++i])) * 86400);
+        }
+    }
+
+    // --- Headless utility modes (no window) ---
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--bench-effect") {
+            return TapeEffect::runBenchmark();
+        }
+        if (std::string(argv[i]) == "--bench-osd") {
+            return OsdText::runBenchmark(font_otf, sizeof(font_otf));
+        }
+        if (std::string(argv[i]) == "--watch-state") {
+            return PlayerStateReader::watch(PlayerStatePublisher::kDefaultPath);
+        }
+        if (std::string(argv[i]) == "--cache-stats") {
+            return CacheManager::runStats(cacheLimits);
+        }
+        if (std::string(argv[i]) == "--cache-prune") {
+            return CacheManager::runPrune(cacheLimits);
+        }
+    }
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--bench-proxies") {
+            return ProxyPyramid::runDecodeBenchmark(argv[i + 1]);
+        }
+        if (std::string(argv[i]) == "--bench-profiles") {
+            return ProxyPyramid::runProfileBenchmark(argv[i + 1]);
+        }
+        if (std::string(argv[i]) == "--bench-scrub") {
+            // Optional --bench-json <path>, otherwise JSON goes to stdout
+            std::string jsonPath;
+            for (int j = 1; j + 1 < argc; ++j) {
+                if (std::string(argv[j]) == "--bench-json") jsonPath = argv[j + 1];
+            }
+            return ScrubBenchmark::run(argv[i + 1], jsonPath);
+        }
+        if (std::string(argv[i]) == "--bench-logging") {
+            return LogBenchmark::run(argv[i + 1]);
+        }
+        if (std::string(argv[i]) == "--control-stress") {
+            return ControlStress::run(std::max(1, std::atoi(argv[i + 1])));
+        }
+        if (std::string(argv[i]) == "--control-stress-live") {
+            return ControlStress::runLive(std::max(1, std::atoi(argv[i + 1])));
+        }
+        if (std::string(argv[i]) == "--ctl") {
+            return ControlClient::run(argv[i + 1]);
+        }
+        if (std::string(argv[i]) == "--ctl-bench") {
+            return ControlClient::runBenchmark(std::max(1, std::atoi(argv[i + 1])));
+        }
+    }
+
+    // --- Headless options ---
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless_mode.store(true);
+        } else if (arg == "--headless-output" && i + 1 < argc) {
+            headless_mode.store(true);
+            headless_output = argv[++i];
+        } else if (arg == "--headless-size" && i + 1 < argc) {
+            int w = 0, h = 0;
+            if (sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                headless_width = w;
+                headless_height = h;
+            } else {
+                std::cerr << "Invalid --headless-size '" << argv[i] << "', expected WxH" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // --- Transport trace options ---
+    TraceReplayer traceReplayer;
+    {
+        std::string recordPath, replayPath, replayReport;
+        double replayRate = 1.0;
+        for (int i = 1; i + 1 < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--record-trace") recordPath = argv[++i];
+            else if (arg == "--replay-trace") replayPath = argv[++i];
+            else if (arg == "--replay-rate") replayRate = atof(argv[++i]);
+            else if (arg == "--replay-report") replayReport = argv[++i];
+        }
+        if (!recordPath.empty() && !transportTrace.startRecording(recordPath)) {
+            return 1;
+        }
+        if (!replayPath.empty()) {
+            if (!traceReplayer.load(replayPath, replayRate)) {
+                return 1;
+            }
+            if (!replayReport.empty() && !traceReplayer.openFrameLog(replayReport)) {
+                return 1;
+            }
+        }
+    }
+
+    // --- Performance trace option ---
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--perf-trace") {
+            perf_trace_path = argv[++i];
+            PerfTrace::setEnabled(true);
+        }
+    }
+    PerfTrace::setThreadName("main");
+
+    // --- Metrics export options ---
+    std::string metricsFilePath;
+    std::string metricsSocketPath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--metrics-file") {
+            metricsFilePath = argv[++i];
+        } else if (arg == "--metrics-socket") {
+            metricsSocketPath = argv[++i];
+        }
+    }
+    MetricsExporter metricsExporter;
+    metricsExporter.start(metricsFilePath, metricsSocketPath);
+    playerStatePublisher.open();
+
+    cacheManager.setLimits(cacheLimits);
+    cacheManager.start();
+
+    // --- Session cache option ---
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--session-cache-mb") {
+            sessionCache.setBudgetMb(static_cast<size_t>(std::max(0, std::atoi(argv[++i]))));
+        }
+    }
+
     if (argc > 1) {
         for (int i = 1; i < argc; ++i) {
             std::string arg_str = argv[i];
+            // Skip the values of options that take one
+            if (arg_str == "--headless-output" || arg_str == "--headless-size" ||
+                arg_str == "--record-trace" || arg_str == "--replay-trace" ||
+                arg_str == "--replay-rate" || arg_str == "--replay-report" ||
+                arg_str == "--perf-trace" || arg_str == "--log-file" || arg_str == "--log-level" ||
+                arg_str == "--metrics-file" || arg_str == "--metrics-socket" || arg_str == "--hui-refresh" ||
+                arg_str == "--jog-curve" || arg_str == "--session-cache-mb" ||
+                arg_str == "--cache-max-gb" || arg_str == "--cache-max-days") {
+                ++i;
+                continue;
+            }
             // Using g_currentOpenFilePath, but it's still empty at startup.
             // original_fps.load() will also be 0.0 at startup.
             if (handleFstpUrlArgument(arg_str, g_currentOpenFilePath, original_fps.load(), pathFromUrl, timeFromUrl, openFileFromUrl, seekFromFileUrl)) {
@@ -280,6 +556,10 @@ int main(int argc, char* argv[]) {
             }
         }
     }
+    if (!fstpUrlProcessed && initialPathFromArgs.empty() && traceReplayer.isActive()) {
+        // Replaying without an explicit file: open the one the trace was recorded on
+        initialPathFromArgs = traceReplayer.initialFile();
+    }
     
     std::string video_path_to_load;
     double time_to_seek = -1.0;
@@ -322,9 +602,27 @@ int main(int argc, char* argv[]) {
 
     // Initialize remote control
     g_remote_control = new RemoteControl();
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hui-refresh") {
+            g_remote_control->set_hui_refresh_rate(std::atoi(argv[i + 1]));
+        } else if (arg == "--jog-curve") {
+            JogCurve curve;
+            if (!JogCurve::parse(argv[i + 1], curve)) {
+                std::cerr << "Invalid --jog-curve '" << argv[i + 1] << "', expected default, fine, fast or legacy"
+                          << " with optional overrides, e.g. fine,exp=3,max_frames=4" << std::endl;
+                return 1;
+            }
+            g_remote_control->set_jog_curve(curve);
+        }
+    }
+    ControlSocketServer controlSocket;
     if (!g_remote_control->initialize()) {
         std::cerr << "Warning: Failed to initialize remote control" << std::endl;
         log("Warning: Failed to initialize remote control");
+    } else {
+        controlSocket.setFileHandler(handleFileRequest);
+        controlSocket.start(*g_remote_control);
     }
 
 #ifdef __APPLE__
@@ -357,12 +655,28 @@ int main(int argc, char* argv[]) {
     int windowX = windowSettings.isValid ? windowSettings.x : SDL_WINDOWPOS_CENTERED;
     int windowY = windowSettings.isValid ? windowSettings.y : SDL_WINDOWPOS_CENTERED;
     bool isFullscreen = windowSettings.isValid && windowSettings.isFullscreen;
+    if (headless_mode.load()) {
+        windowManager.setHeadless(true);
+        windowWidth = headless_width;
+        windowHeight = headless_height;
+        isFullscreen = false;
+    }
     
     // Initialize window manager
     if (!windowManager.initialize("TapeXPlayer", windowX, windowY, windowWidth, windowHeight, isFullscreen)) {
         std::cerr << "Failed to initialize window manager" << std::endl;
         return 1;
     }
+
+    // In headless mode every present goes to the output sink
+    FrameSink headlessSink;
+    if (headless_mode.load()) {
+        if (!headlessSink.open(headless_output, windowWidth, windowHeight)) {
+            std::cerr << "Failed to open headless output '" << headless_output << "'" << std::endl;
+            return 1;
+        }
+        setDisplayFrameSink(&headlessSink);
+    }
     
     // Initialize deep pause manager
     deepPauseManager.setThreshold(std::chrono::seconds(5)); // 5 second threshold
@@ -378,11 +692,23 @@ int main(int argc, char* argv[]) {
     // Main file loading loop
     std::string currentFilename; // Используется для передачи имени файла в/из mainLoadingSequence
     // g_currentOpenFilePath будет обновляться после успешной загрузки
-    
+    std::string failedLoadPath; // Published as Failed until the next load attempt
+
     bool firstRun = true;
     // bool fileProvided = (argc > 1); // Эта логика теперь сложнее из-за fstp
     bool fileArgProcessed = false; // Флаг, что аргумент командной строки (URL или путь) обработан
 
+    // Per-session playback state. It outlives each file so that a switch keeps the
+    // decoder managers (threads, proxy levels, thumbnail strip encoder): they are
+    // suspended at the end of a file and rebound by the next mainLoadingSequence.
+    // The managers reference the others and are declared last, destroyed first.
+    std::vector<FrameInfo> frameIndex; // Refilled by each loading sequence
+    std::atomic<int> currentFrame(0); // Reset inside loading sequence
+    std::atomic<bool> isPlaying(false); // Set inside loading sequence
+    std::unique_ptr<FullResDecoderManager> fullResManagerPtr;
+    std::unique_ptr<LowCachedDecoderManager> lowCachedManagerPtr;
+    std::unique_ptr<CachedDecoderManager> cachedManagerPtr;
+
     // --- Define fixed speed steps ---
     const std::vector<double> speed_steps = {0.5, 1.0, 3.0, 10.0, 24.0};
     static int current_speed_index = 1; // Start at 1.0x (index 1)
@@ -454,12 +780,15 @@ int main(int argc, char* argv[]) {
                 }
 
                 windowManager.beginFrameTiming();
-                Uint32 frameStart = SDL_GetTicks(); // Keep for compatibility
                 
                 // Process remote commands at the start of each frame
                 if (g_remote_control->is_initialized()) {
                     g_remote_control->process_commands();
                 }
+                std::string requestedPath;
+                if (takePendingOpen(requestedPath)) {
+                    restartPlayerWithFile(requestedPath, -1.0); // Leaves this loop through shouldExit
+                }
                 
                 // Handle fullscreen toggle request from menu
                 if (toggle_fullscreen_requested.load()) {
@@ -474,22 +803,27 @@ int main(int argc, char* argv[]) {
                         shouldExit = true;
                         restart_requested = false; // Cancel restart on window close
                     } else if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) {
+                        transportTrace.recordInput(e);
                         keyboardManager.handleKeyboardEvent(e);
                     } else if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP || e.type == SDL_MOUSEMOTION) {
+                        // Motion only matters to the transport while mouse shuttle is active
+                        if (e.type != SDL_MOUSEMOTION || mouse_shuttle_active.load()) {
+                            transportTrace.recordInput(e);
+                        }
                         keyboardManager.handleMouseEvent(e);
                     }
                 });
                 
+                publishPlayerState(failedLoadPath.empty() ? PlayerLoadState::Idle : PlayerLoadState::Failed, failedLoadPath);
+
                 // Render no file screen
                 windowManager.renderNoFileScreen();
                 windowManager.renderOSD(false, 0.0, false, 0.0, 0, true, false, "", 25.0, false, false, FrameInfo::EMPTY);
                 windowManager.endFrame();
                 
                 // Cap the frame rate
-                Uint32 frameTime = SDL_GetTicks() - frameStart;
-                if (frameTime < FRAME_DELAY) {
-                    SDL_Delay(FRAME_DELAY - frameTime);
-                }
+                windowManager.setTargetFPS(TARGET_FPS);
+                windowManager.endFrameTiming();
             }
 
             // If the user requested to exit from the 'no file loaded' state,
@@ -506,12 +840,7 @@ int main(int argc, char* argv[]) {
             // g_currentOpenFilePath будет обновлен *после* успешной загрузки
             
             // Initialize variables for the playback loop that need to be passed to/from loading sequence
-            std::vector<FrameInfo> frameIndex; // Needs to be populated by loading sequence
-            std::unique_ptr<FullResDecoderManager> fullResManagerPtr;
-            std::unique_ptr<LowCachedDecoderManager> lowCachedManagerPtr;
-            std::unique_ptr<CachedDecoderManager> cachedManagerPtr;
-            std::atomic<int> currentFrame(0); // Will be reset inside loading sequence
-            std::atomic<bool> isPlaying(false); // Will be set inside loading sequence
+            PreparedFile loadedFile; // Proxy, probe and resume position; goes to the session cache on a switch
 
             // Create LoadingStatus object for this loading operation
             LoadingStatus loadingStatus;
@@ -522,7 +851,7 @@ int main(int argc, char* argv[]) {
                 loadingStatus, 
                 fileToLoadPath, // Используем fileToLoadPath
                 currentFilename, // currentFilename будет ЗАПОЛНЕН функцией
-                frameIndex, fullResManagerPtr, lowCachedManagerPtr, cachedManagerPtr,
+                frameIndex, loadedFile, fullResManagerPtr, lowCachedManagerPtr, cachedManagerPtr,
                 currentFrame, isPlaying
             );
 
@@ -531,6 +860,7 @@ int main(int argc, char* argv[]) {
             while (loading_future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
                 // Render loading screen
                 windowManager.renderLoadingScreen(const_cast<const LoadingStatus&>(loadingStatus));
+                publishPlayerState(PlayerLoadState::Loading, fileToLoadPath, loadingStatus.percent.load());
 
                 // Handle essential events (like SDL_QUIT) during loading
                 windowManager.processEvents([&](SDL_Event& e) {
@@ -561,12 +891,16 @@ int main(int argc, char* argv[]) {
             bool loading_success = loading_future.get();
 
              if (!loading_success) {
+                  failedLoadPath = fileToLoadPath;
                   // Loading failed, let the outer loop handle showing the "Press Ctrl+O" screen
                    continue; // Go to the start of the outer while(true) loop
               }
 
             // --- Loading successful, update window title --- 
             g_currentOpenFilePath = currentFilename; // <--- ОБНОВЛЯЕМ путь к текущему открытому файлу
+            failedLoadPath.clear();
+            transportTrace.recordFileOpen(g_currentOpenFilePath);
+            traceReplayer.onFileLoaded();
             std::string filename_only = std::filesystem::path(g_currentOpenFilePath).filename().string();
             std::string windowTitle = "TapeXPlayer - " + filename_only;
             windowManager.setTitle(windowTitle);
@@ -586,14 +920,17 @@ int main(int argc, char* argv[]) {
                     windowManager.getWindowSize(initialWidth, initialHeight);
                     fullResManagerPtr->checkWindowSizeAndToggleActivity(initialWidth, initialHeight);
                 }
-                if (lowCachedManagerPtr) lowCachedManagerPtr->run(); 
+                if (lowCachedManagerPtr) {
+                    lowCachedManagerPtr->run();
+                    int outputWidth, outputHeight;
+                    windowManager.getOutputSize(outputWidth, outputHeight);
+                    lowCachedManagerPtr->setOutputSize(outputWidth, outputHeight);
+                    lowCachedManagerPtr->setDisplayRefreshRate(windowManager.getRefreshRate());
+                }
              if (cachedManagerPtr) cachedManagerPtr->run();
              // -------------------------------------------------------------------------
 
-             // --- Duration handling moved outside loading sequence for simplicity ---
-             // Let's get duration after successful load if needed immediately
-             double duration = get_file_duration(currentFilename.c_str());
-             total_duration.store(duration);
+             // Duration comes with the prepared file (stored by the loading sequence)
              std::cout << "Total duration: " << total_duration.load() << " seconds" << std::endl;
 
             // Start playback after a short delay and manager setup
@@ -602,7 +939,10 @@ int main(int argc, char* argv[]) {
             target_playback_rate.store(0.0); 
             playback_rate.store(0.0); // Ensure current rate is also 0
 
-            // Perform initial seek if requested (e.g., from URL)
+            // Perform initial seek if requested (e.g., from URL), else return to where a kept file was left
+            if (initialSeekTimeForThisLoad < 0.0 && loadedFile.resumeTime >= 0.0) {
+                initialSeekTimeForThisLoad = loadedFile.resumeTime;
+            }
             if (initialSeekTimeForThisLoad >= 0.0) {
                 std::cout << "[main.cpp] Performing initial seek to: " << initialSeekTimeForThisLoad << "s after successful load." << std::endl;
                 log("[main.cpp] Performing initial seek to: " + std::to_string(initialSeekTimeForThisLoad) + "s after successful load.");
@@ -611,6 +951,7 @@ int main(int argc, char* argv[]) {
 
              // Frame selection state
             bool forceFrameUpdate = false; // Force frame selection after seek
+            std::chrono::steady_clock::time_point replayFinishedAt; // Set once the replayed trace runs out
             
              // --- Start of the inner playback loop ---
             while (!shouldExit) {
@@ -618,14 +959,16 @@ int main(int argc, char* argv[]) {
                 if (g_remote_control->is_initialized()) {
                     g_remote_control->process_commands();
                 }
+                std::string requestedPath;
+                if (takePendingOpen(requestedPath)) {
+                    restartPlayerWithFile(requestedPath, -1.0);
+                }
                 
                 // Update deep pause manager
                 deepPauseManager.update(playback_rate.load(), target_playback_rate.load(), window_has_focus.load());
                 
-                // Add delay when in Deep Pause to reduce CPU usage
-                if (deepPauseManager.isActive() && !deepPauseManager.shouldInterruptForRefresh()) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(deepPauseManager.getDeepPauseSleepTime()));
-                }
+                // Deep Pause needs no extra sleep here: it lowers the paced frame rate below,
+                // and the pacer's wait still returns on input
                 
                 // Check if we need to reset the speed threshold
                 check_and_reset_threshold();
@@ -637,7 +980,6 @@ int main(int argc, char* argv[]) {
                 }
 
                 windowManager.beginFrameTiming();
-                Uint32 frameStart = SDL_GetTicks(); // Keep for compatibility
 
                 windowManager.processEvents([&](SDL_Event& e) {
                     if (e.type == SDL_QUIT) {
@@ -647,8 +989,13 @@ int main(int argc, char* argv[]) {
                         restart_requested = false; // Cancel restart on window close
                         if(deepPauseManager.isActive()) deepPauseManager.forceExit();
                     } else if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) {
+                        transportTrace.recordInput(e);
                         keyboardManager.handleKeyboardEvent(e);
                     } else if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP || e.type == SDL_MOUSEMOTION) {
+                        // Motion only matters to the transport while mouse shuttle is active
+                        if (e.type != SDL_MOUSEMOTION || mouse_shuttle_active.load()) {
+                            transportTrace.recordInput(e);
+                        }
                         keyboardManager.handleMouseEvent(e);
                     } else if (e.type == SDL_WINDOWEVENT) {
                         if (e.window.event == SDL_WINDOWEVENT_RESIZED) {
@@ -658,6 +1005,23 @@ int main(int argc, char* argv[]) {
                             if (fullResManagerPtr) {
                                 fullResManagerPtr->checkWindowSizeAndToggleActivity(windowWidth, windowHeight);
                             }
+                            // Proxy pyramid level follows the drawable size
+                            if (lowCachedManagerPtr) {
+                                int outputWidth, outputHeight;
+                                windowManager.getOutputSize(outputWidth, outputHeight);
+                                lowCachedManagerPtr->setOutputSize(outputWidth, outputHeight);
+                                lowCachedManagerPtr->setDisplayRefreshRate(windowManager.getRefreshRate());
+                            }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+                        } else if (e.window.event == SDL_WINDOWEVENT_DISPLAY_CHANGED) {
+                            // Moved to a display with a different refresh rate / scale
+                            if (lowCachedManagerPtr) {
+                                int outputWidth, outputHeight;
+                                windowManager.getOutputSize(outputWidth, outputHeight);
+                                lowCachedManagerPtr->setOutputSize(outputWidth, outputHeight);
+                                lowCachedManagerPtr->setDisplayRefreshRate(windowManager.getRefreshRate());
+                            }
+#endif
                         } else if (e.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) {
                             window_has_focus.store(true);
                             // Exit deep pause when window gets focus
@@ -708,6 +1072,27 @@ int main(int argc, char* argv[]) {
                     }
                 });
 
+                // Transport trace: note speed changes, feed replayed events through the same handlers
+                transportTrace.sampleTransport(target_playback_rate.load(), is_reverse.load());
+                PERF_COUNTER("playback_rate", is_reverse.load() ? -playback_rate.load() : playback_rate.load());
+                if (traceReplayer.isActive()) {
+                    TransportTrace::Event traceEvent;
+                    while (traceReplayer.poll(traceEvent)) {
+                        dispatchTraceEvent(traceEvent, keyboardManager, traceReplayer);
+                    }
+                    // Give the last event a moment to play out, then quit
+                    if (traceReplayer.finished()) {
+                        if (replayFinishedAt == std::chrono::steady_clock::time_point()) {
+                            replayFinishedAt = std::chrono::steady_clock::now();
+                        } else if (std::chrono::steady_clock::now() - replayFinishedAt > std::chrono::seconds(2)) {
+                            std::cout << "[Trace] Replay finished" << std::endl;
+                            quit = true;
+                            shouldExit = true;
+                            restart_requested = false;
+                        }
+                    }
+                }
+
                 // Update currentFrame based on current audio time
                 double currentTime = current_audio_time.load();
                 int64_t target_time_ms = static_cast<int64_t>(currentTime * 1000.0);
@@ -730,11 +1115,19 @@ int main(int argc, char* argv[]) {
                 auto frameSelection = windowManager.selectFrame(frameIndex, newCurrentFrame, playback_rate.load(), forceFrameUpdate);
                 std::shared_ptr<AVFrame> frameToDisplay = frameSelection.frame;
                 FrameInfo::FrameType frameTypeToDisplay = frameSelection.frameType;
+                traceReplayer.recordFrame(newCurrentFrame, frameTypeToDisplay, frameSelection.frameFound);
+                publishPlayerState(PlayerLoadState::Ready, g_currentOpenFilePath, 100, newCurrentFrame,
+                                   static_cast<int>(frameIndex.size()),
+                                   frameSelection.frameFound ? frameTypeToDisplay : FrameInfo::EMPTY, isPlaying.load());
+                // Download a hardware frame in the background while the rest of the iteration runs
+                stageFrameForDisplay(frameToDisplay);
                 
                 // Reset force update flag after successful frame selection
                 if (forceFrameUpdate && frameSelection.frameFound) {
                     forceFrameUpdate = false;
                 }
+                // Let a decoder publishing the missing frame cut the pacing wait short
+                windowManager.framePacer().setWaitingForFrame(!frameSelection.frameFound || forceFrameUpdate);
 
                 // Check if seek is complete
                 if (seekInfo.completed.load()) {
@@ -844,11 +1237,32 @@ int main(int argc, char* argv[]) {
             updateCopyScreenshotMenuState(false); // <--- ВЫКЛЮЧИТЬ скриншот перед очисткой
             std::cout << "[main.cpp] After updateCopyLinkMenuState(false) in playback loop cleanup" << std::endl;
 #endif
-            std::cout << "[Cleanup] Stopping managers..." << std::endl;
-            if (fullResManagerPtr) fullResManagerPtr->stop();
-            if (lowCachedManagerPtr) lowCachedManagerPtr->stop();
-            if (cachedManagerPtr) cachedManagerPtr->stop();
-            std::cout << "[Cleanup] Managers stopped." << std::endl; // Debug log
+            windowManager.framePacer().logStats("Playback");
+            traceReplayer.printSummary();
+            // Switching files: the full-res frames at the playhead go to the session
+            // cache with the file, so they are taken before the manager releases them
+            const bool keepInSession = reload_file_requested.load();
+            SessionCache::FullResWindow keptFullRes;
+            double keptTime = current_audio_time.load();
+            if (keepInSession) keptFullRes = SessionCache::captureFullRes(frameIndex, currentFrame.load());
+
+            if (keepInSession) {
+                // The managers park until the next file is bound to them
+                std::cout << "[Cleanup] Suspending managers..." << std::endl;
+                if (fullResManagerPtr) fullResManagerPtr->suspend();
+                if (lowCachedManagerPtr) lowCachedManagerPtr->suspend();
+                if (cachedManagerPtr) cachedManagerPtr->suspend();
+                std::cout << "[Cleanup] Managers suspended." << std::endl; // Debug log
+                loadedFile.frameIndex = std::move(frameIndex);
+                frameIndex.clear(); // Moved-from; the managers keep referencing it
+                sessionCache.store(std::move(loadedFile), std::move(keptFullRes), keptTime);
+            } else {
+                std::cout << "[Cleanup] Stopping managers..." << std::endl;
+                if (fullResManagerPtr) fullResManagerPtr->stop();
+                if (lowCachedManagerPtr) lowCachedManagerPtr->stop();
+                if (cachedManagerPtr) cachedManagerPtr->stop();
+                std::cout << "[Cleanup] Managers stopped." << std::endl; // Debug log
+            }
             
             std::cout << "[Cleanup] Joining speed change thread..." << std::endl; // Debug log
             if (speed_change_thread.joinable()) {
@@ -863,9 +1277,13 @@ int main(int argc, char* argv[]) {
             }
             
 
-            // Cleanup audio resources
+            // Cleanup audio resources; a switch keeps the output device open for the next file
             std::cout << "[Cleanup] Cleaning audio..." << std::endl; // Debug log
-            cleanup_audio();
+            if (keepInSession) {
+                release_audio_source();
+            } else {
+                cleanup_audio();
+            }
             
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
@@ -884,9 +1302,25 @@ int main(int argc, char* argv[]) {
         } // End if (shouldAttemptFileLoadThisIteration)
     } // End outer while(true) loop
 
+    // A switch whose load failed leaves the managers suspended and the audio output open
+    fullResManagerPtr.reset();
+    lowCachedManagerPtr.reset();
+    cachedManagerPtr.reset();
+    cleanup_audio();
+
     // Save final window settings before closing
     saveWindowSettings(window);
 
+    transportTrace.stopRecording();
+    if (PerfTrace::isEnabled() && !perf_trace_path.empty()) {
+        PerfTrace::setEnabled(false);
+        PerfTrace::exportChromeJson(perf_trace_path);
+    }
+    metricsExporter.stop();
+    playerStatePublisher.close();
+    setDisplayFrameSink(nullptr);
+    headlessSink.close();
+
     // Cleanup display resources (including Metal) BEFORE destroying SDL renderer/window
     cleanupDisplayResources();
 
@@ -900,6 +1334,10 @@ int main(int argc, char* argv[]) {
 #endif
 
     // Before exiting, cleanup remote control
+    controlSocket.stop(); // Runs commands through g_remote_control
+    filePreparer.stop(); // After the socket, which can queue files
+    sessionCache.clear();
+    cacheManager.stop();
     if (g_remote_control) {
         delete g_remote_control;
         g_remote_control = nullptr;
@@ -915,6 +1353,8 @@ int main(int argc, char* argv[]) {
         args.push_back(const_cast<char*>(argv0.c_str())); // Program path
         args.push_back(const_cast<char*>(restart_filename.c_str())); // New file
         args.push_back(nullptr); // Terminating nullptr
+
+        Logger::stop(); // exec does not run atexit handlers; write out what is queued
         
         // Perform restart
 #ifdef _WIN32
@@ -947,6 +1387,7 @@ void processIncomingFstpUrl(const char* url_c_str) {
     log("[FSTP Event] processIncomingFstpUrl called with URL: " + std::string(url_c_str));
 
     std::string urlString(url_c_str);
+    transportTrace.recordUrl(urlString);
     std::cout << "[main.cpp] processIncomingFstpUrl received: " << urlString << std::endl;
     log("[main.cpp] processIncomingFstpUrl received: " + urlString);
 
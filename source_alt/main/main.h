@@ -64,6 +64,7 @@ extern void start_audio(const char* filename); // Defined in mainau.cpp? Needs c
 extern std::string generateTXTimecode(double time);
 extern void smooth_speed_change();
 extern void cleanup_audio(); // Defined in mainau.cpp? Needs confirmation.
+extern void release_audio_source(); // mainau.cpp; file switch, the output stays open
 extern void log(const std::string& message); // Defined in main.cpp
 extern void takeCurrentFrameScreenshot(); // Function to take screenshot of current frame
 
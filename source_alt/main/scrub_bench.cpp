@@ -0,0 +1,346 @@
+#include "scrub_bench.h"
+#include "main.h"
+#include "../common/common.h"
+#include "core/decode/decode.h"
+#include "core/decode/low_res_decoder.h"
+#include "core/decode/full_res_decoder_manager.h"
+#include "core/decode/low_cached_decoder_manager.h"
+#include "core/decode/cached_decoder_manager.h"
+#include "core/display/window_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Profile {
+    const char* name;
+    double seconds;
+    double startFraction;                  // Start position as a fraction of the duration
+    std::function<double(double)> rateAt;  // Signed rate at profile time t
+    double jumpEverySeconds;               // 0 = no jumps
+};
+
+struct ProfileResult {
+    std::string name;
+    double wallSeconds = 0.0;
+    double cpuSeconds = 0.0;
+    long ticks = 0;
+    long expectedFrames = 0;  // Ticks whose target frame differs from the previous tick's
+    long displayedFrames = 0; // Of those, ticks where the target frame was on screen
+    long tierFull = 0;
+    long tierLow = 0;
+    long tierCached = 0;
+    long tierMiss = 0;
+    long requestsServed = 0;
+    long requestsDropped = 0; // Target moved on before the frame became ready
+    std::vector<double> latenciesMs;
+    long maxRssKb = 0;
+};
+
+double cpuSecondsNow() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+long maxRssKbNow() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<long>(usage.ru_maxrss / 1024); // Bytes on macOS
+#else
+    return static_cast<long>(usage.ru_maxrss);        // Kilobytes elsewhere
+#endif
+}
+
+bool frameReady(const FrameInfo& info) {
+    std::lock_guard<std::mutex> lock(info.mutex);
+    return info.frame || info.low_res_frame || info.cached_frame;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(values.size() * p));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+// With the report on stdout, everything else the run prints (progress, decoder
+// output through iostreams or stdio) goes to stderr so the JSON stays parseable
+class StdoutToStderr {
+public:
+    StdoutToStderr() {
+        std::cout.flush();
+        fflush(stdout);
+        saved_ = dup(STDOUT_FILENO);
+        if (saved_ >= 0) dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+    ~StdoutToStderr() { restore(); }
+
+    void restore() {
+        if (saved_ < 0) return;
+        std::cout.flush();
+        fflush(stdout);
+        dup2(saved_, STDOUT_FILENO);
+        close(saved_);
+        saved_ = -1;
+    }
+
+private:
+    int saved_ = -1;
+};
+
+} // namespace
+
+int ScrubBenchmark::run(const std::string& filename, const std::string& jsonPath) {
+    std::optional<StdoutToStderr> redirect;
+    if (jsonPath.empty()) redirect.emplace();
+    std::cout << "[ScrubBench] Preparing " << filename << std::endl;
+
+    std::vector<FrameInfo> frameIndex = createFrameIndex(filename.c_str());
+    if (frameIndex.empty()) {
+        std::cerr << "[ScrubBench] Failed to index " << filename << std::endl;
+        return 1;
+    }
+    frameStateSummary.reset(static_cast<int>(frameIndex.size()));
+
+    std::string lowResFilename = "low_res_output.mp4";
+    if (!LowResDecoder::convertToLowRes(filename.c_str(), lowResFilename)) {
+        std::cerr << "[ScrubBench] Failed to create proxies" << std::endl;
+        return 1;
+    }
+
+    int videoWidth = 0, videoHeight = 0;
+    get_video_dimensions(filename.c_str(), &videoWidth, &videoHeight);
+    original_fps.store(get_video_fps(filename.c_str()));
+    const double fps = original_fps.load() > 0 ? original_fps.load() : 25.0;
+    const double duration = get_file_duration(filename.c_str());
+    if (duration <= 0.0) {
+        std::cerr << "[ScrubBench] Unknown duration for " << filename << std::endl;
+        return 1;
+    }
+
+    // Same manager setup as the loading sequence, sized for a native-size output
+    auto decoderParams = WindowManager::calculateDecoderParams(fps);
+    int highResWindowSize = decoderParams.highResWindowSize; // Referenced by FullResDecoderManager
+    int cachedSegmentSize = fps > 55.0 ? 3000 : fps > 45.0 ? 2500 : fps > 28.0 ? 1500 : 1250;
+    std::atomic<int> currentFrame(0);
+    std::atomic<bool> isPlaying(true);
+    playback_rate.store(0.0);
+    is_reverse.store(false);
+
+    auto fullResManager = std::make_unique<FullResDecoderManager>(
+        filename, frameIndex, currentFrame, playback_rate, highResWindowSize, isPlaying, is_reverse);
+    auto lowCachedManager = std::make_unique<LowCachedDecoderManager>(
+        lowResFilename, frameIndex, currentFrame, static_cast<int>(decoderParams.ringBufferCapacity),
+        highResWindowSize, isPlaying, playback_rate, is_reverse);
+    auto cachedManager = std::make_unique<CachedDecoderManager>(
+        lowResFilename, frameIndex, currentFrame, is_reverse, cachedSegmentSize);
+
+    fullResManager->run();
+    fullResManager->checkWindowSizeAndToggleActivity(videoWidth, videoHeight);
+    lowCachedManager->run();
+    lowCachedManager->setOutputSize(videoWidth, videoHeight);
+    lowCachedManager->setDisplayRefreshRate(60.0);
+    cachedManager->run();
+
+    auto notifyManagers = [&]() {
+        fullResManager->notifyFrameChange();
+        lowCachedManager->notifyFrameChange();
+        cachedManager->notifyFrameChange();
+    };
+
+    // Let the sparse tier come up before the first profile, as it would while the user reads the screen
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+
+    std::mt19937 rng(20240607); // Fixed seed: jump targets are identical between runs
+    std::uniform_real_distribution<double> jumpTarget(0.0, 1.0);
+
+    const std::vector<Profile> profiles = {
+        {"play_1x",      10.0, 0.10, [](double) { return 1.0; }, 0.0},
+        {"shuttle_3x",   10.0, 0.10, [](double) { return 3.0; }, 0.0},
+        {"shuttle_10x",  10.0, 0.10, [](double) { return 10.0; }, 0.0},
+        {"shuttle_24x",  10.0, 0.05, [](double) { return 24.0; }, 0.0},
+        {"random_jumps", 10.0, 0.50, [](double) { return 1.0; }, 0.5},
+        // Jog wheel in reverse: short bursts at rising speed with pauses between them
+        {"reverse_jog",  10.0, 0.90, [](double t) {
+            double phase = std::fmod(t, 1.0);
+            if (phase >= 0.75) return 0.0;
+            static const double speeds[] = {-0.25, -0.5, -1.0, -2.0};
+            return speeds[static_cast<int>(t) % 4];
+        }, 0.0},
+    };
+
+    WindowManager selector; // Only selectFrame() is used; no window is created
+    const Clock::duration tickInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60.0));
+    const Clock::duration pollInterval = std::chrono::milliseconds(1);
+    const int lastFrame = static_cast<int>(frameIndex.size()) - 1;
+
+    std::vector<ProfileResult> results;
+    for (const Profile& profile : profiles) {
+        std::cout << "[ScrubBench] Running " << profile.name << std::endl;
+        ProfileResult r;
+        r.name = profile.name;
+
+        double position = profile.startFraction * duration;
+        double rate = profile.rateAt(0.0);
+        playback_rate.store(std::abs(rate));
+        is_reverse.store(rate < 0.0);
+        int target = std::clamp(findClosestFrameIndexByTime(frameIndex, static_cast<int64_t>(position * 1000.0)), 0, lastFrame);
+        currentFrame.store(target);
+        notifyManagers();
+
+        int pendingFrame = target;
+        Clock::time_point pendingSince = Clock::now();
+        int previousTickTarget = -1;
+        double nextJump = profile.jumpEverySeconds;
+
+        const double cpuStart = cpuSecondsNow();
+        const Clock::time_point start = Clock::now();
+        Clock::time_point last = start;
+        Clock::time_point nextTick = start;
+
+        for (;;) {
+            Clock::time_point now = Clock::now();
+            double t = std::chrono::duration<double>(now - start).count();
+            if (t >= profile.seconds) break;
+
+            // Advance the virtual transport
+            rate = profile.rateAt(t);
+            position += rate * std::chrono::duration<double>(now - last).count();
+            last = now;
+            if (profile.jumpEverySeconds > 0.0 && t >= nextJump) {
+                position = jumpTarget(rng) * duration;
+                nextJump += profile.jumpEverySeconds;
+            }
+            position = std::clamp(position, 0.0, duration);
+            playback_rate.store(std::abs(rate));
+            if (rate != 0.0) is_reverse.store(rate < 0.0);
+
+            int frame = std::clamp(findClosestFrameIndexByTime(frameIndex, static_cast<int64_t>(position * 1000.0)), 0, lastFrame);
+            if (frame != currentFrame.load()) {
+                currentFrame.store(frame);
+                notifyManagers();
+            }
+
+            // Request latency: from a frame becoming the target until any tier holds it
+            if (frame != pendingFrame) {
+                if (pendingFrame >= 0) ++r.requestsDropped;
+                pendingFrame = frame;
+                pendingSince = now;
+            }
+            if (pendingFrame >= 0 && frameReady(frameIndex[pendingFrame])) {
+                r.latenciesMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - pendingSince).count());
+                ++r.requestsServed;
+                pendingFrame = -1;
+            }
+
+            if (now >= nextTick) {
+                auto selection = selector.selectFrame(frameIndex, frame, std::abs(rate), false);
+                ++r.ticks;
+                if (frame != previousTickTarget) {
+                    ++r.expectedFrames;
+                    if (selection.frameFound) ++r.displayedFrames;
+                    previousTickTarget = frame;
+                }
+                if (!selection.frameFound) ++r.tierMiss;
+                else if (selection.frameType == FrameInfo::FULL_RES) ++r.tierFull;
+                else if (selection.frameType == FrameInfo::LOW_RES) ++r.tierLow;
+                else if (selection.frameType == FrameInfo::CACHED) ++r.tierCached;
+                else ++r.tierMiss;
+                nextTick += tickInterval;
+                if (nextTick < now) nextTick = now + tickInterval; // Don't replay missed ticks
+            }
+
+            std::this_thread::sleep_until(std::min(nextTick, Clock::now() + pollInterval));
+        }
+
+        r.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        r.cpuSeconds = cpuSecondsNow() - cpuStart;
+        r.maxRssKb = maxRssKbNow();
+        results.push_back(std::move(r));
+
+        // Pause between profiles
+        playback_rate.store(0.0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+
+    cachedManager->stop();
+    lowCachedManager->stop();
+    fullResManager->stop();
+
+    // --- Report ---
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\n"
+         << "  \"file\": \"" << jsonEscape(filename) << "\",\n"
+         << "  \"frames\": " << frameIndex.size() << ",\n"
+         << "  \"fps\": " << fps << ",\n"
+         << "  \"width\": " << videoWidth << ",\n"
+         << "  \"height\": " << videoHeight << ",\n"
+         << "  \"duration_s\": " << duration << ",\n"
+         << "  \"profiles\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ProfileResult& r = results[i];
+        double ticks = r.ticks > 0 ? static_cast<double>(r.ticks) : 1.0;
+        json << "    {\n"
+             << "      \"name\": \"" << r.name << "\",\n"
+             << "      \"wall_s\": " << r.wallSeconds << ",\n"
+             << "      \"cpu_s\": " << r.cpuSeconds << ",\n"
+             << "      \"cpu_percent\": " << (r.wallSeconds > 0 ? r.cpuSeconds * 100.0 / r.wallSeconds : 0.0) << ",\n"
+             << "      \"ticks\": " << r.ticks << ",\n"
+             << "      \"frames_expected\": " << r.expectedFrames << ",\n"
+             << "      \"frames_displayed\": " << r.displayedFrames << ",\n"
+             << "      \"tiers\": {\"full\": " << r.tierFull / ticks << ", \"low\": " << r.tierLow / ticks
+             << ", \"cached\": " << r.tierCached / ticks << ", \"miss\": " << r.tierMiss / ticks << "},\n"
+             << "      \"requests_served\": " << r.requestsServed << ",\n"
+             << "      \"requests_dropped\": " << r.requestsDropped << ",\n"
+             << "      \"latency_ms\": {\"p50\": " << percentile(r.latenciesMs, 0.50)
+             << ", \"p90\": " << percentile(r.latenciesMs, 0.90)
+             << ", \"p99\": " << percentile(r.latenciesMs, 0.99)
+             << ", \"max\": " << percentile(r.latenciesMs, 1.0) << "},\n"
+             << "      \"max_rss_kb\": " << r.maxRssKb << "\n"
+             << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    if (jsonPath.empty()) {
+        redirect->restore();
+        std::cout << json.str() << std::flush;
+    } else {
+        std::ofstream out(jsonPath);
+        if (!out) {
+            std::cerr << "[ScrubBench] Cannot write " << jsonPath << std::endl;
+            return 1;
+        }
+        out << json.str();
+        std::cout << "[ScrubBench] Results written to " << jsonPath << std::endl;
+    }
+    return 0;
+}
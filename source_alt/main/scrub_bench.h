@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+// Headless transport benchmark (--bench-scrub).
+//
+// Opens a file the way the player does (frame index, proxies, the three
+// decoder managers), then replays fixed transport profiles against them on
+// a virtual clock: 1x play, 3x/10x/24x shuttle, random jumps and reverse jog.
+// Display ticks run at 60 Hz and pick frames through the same selection as
+// the player, so the results show what would have reached the screen.
+//
+// Per profile it reports frames displayed against expected, the tier each
+// tick was served from, request-to-ready latency percentiles, CPU time and
+// the memory high-water mark, as JSON on stdout or in `jsonPath`. With the
+// JSON on stdout, progress and decoder output go to stderr.
+class ScrubBenchmark {
+public:
+    static int run(const std::string& filename, const std::string& jsonPath);
+};